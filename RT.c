@@ -25,6 +25,11 @@
  *        deletion and returning of list elements such as routing table
  *        entries and precursors.
  *
+ *        In multipath mode an entry also keeps up to RT_ALT_HOPS
+ *        alternate next hops, each at most as many hops away as the
+ *        route. One takes over without a new route discovery when the
+ *        next hop breaks.
+ *
  *	Internal procedures: 
  *        find_precursor
  *	
@@ -34,10 +39,17 @@
  *        insert_entry
  *        get_entry
  *        delete_entry
+ *        free_rt
  *        add_precursor
  *        delete_precursor
  *        delete_precursors_from_all
  *        clear_precursors
+ *        add_alt_hop
+ *        delete_alt_hop
+ *        delete_alt_hop_from_all
+ *        trim_alt_hops
+ *        clear_alt_hops
+ *        switch_alt_hop
  *        print_rt
  ********************************
  *
@@ -47,8 +59,6 @@
 
 #include "RT.h"
 
-struct rt_entry_list  *rt;
-
 /* Declaration of internal procedures */
 struct precursor* find_precursor(struct artentry* tmp_artentry,
 				 u_int32_t tmp_ip);
@@ -60,21 +70,19 @@ struct precursor* find_precursor(struct artentry* tmp_artentry,
  *   Initializes the main routing table by creating a 
  *   head for the list.
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Return: void
  */
 int
-init_rt()
+init_rt(struct aodv_node *node)
 {
-  if((rt = malloc(sizeof(struct rt_entry_list))) != NULL)
+  if((node->rt = malloc(sizeof(struct rt_entry_list))) != NULL)
     {
-      rt->ishead = 1;
-      rt->next = rt;
-      rt->prev = rt;
-      
-      if ((krt = init_rtsocket()) < 0) /* for the krt socket */
-	return -1; /* Unable to create socket */
+      node->rt->ishead = 1;
+      node->rt->next = node->rt;
+      node->rt->prev = node->rt;
 
       return 0;
     }
@@ -89,15 +97,16 @@ init_rt()
  * Description: 
  *   Returns the first entry in the routing table
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Return: 
  *  struct rt_entry* - Pointer to the first list entry of the routing table.
  */
 struct rt_entry_list*
-get_first_entry()
+get_first_entry(struct aodv_node *node)
 {
-  return rt->next;
+  return node->rt->next;
 }
 
 
@@ -109,13 +118,14 @@ get_first_entry()
  *   rt_entry_list-element pointing to it. The list-element
  *   is inserted in the routing table.
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Returns: 
  *   struct artentry* - A pointer to the new routing table entry. 
  */
 struct artentry*
-insert_entry()
+insert_entry(struct aodv_node *node)
 {
   struct rt_entry_list *tmp_rt_entry_list;
   struct precursor *tmp_precursor;
@@ -140,11 +150,13 @@ insert_entry()
   tmp_precursor->ip = 0;
 
   tmp_artentry->precursors = tmp_precursor;
+  tmp_artentry->rt_flags = 0;
+  tmp_artentry->alt_cnt = 0;
   tmp_rt_entry_list->entry = tmp_artentry;
   tmp_rt_entry_list->ishead = 0;
 
-  tmp_rt_entry_list->prev = rt;
-  tmp_rt_entry_list->next = rt->next;
+  tmp_rt_entry_list->prev = node->rt;
+  tmp_rt_entry_list->next = node->rt->next;
   tmp_rt_entry_list->next->prev = tmp_rt_entry_list;
   tmp_rt_entry_list->prev->next = tmp_rt_entry_list;
   
@@ -160,6 +172,7 @@ insert_entry()
  *   the argument ip-address as destination.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   u_int32_t tmp_ip - IP address for the destination
  *
  * Returns: 
@@ -167,12 +180,12 @@ insert_entry()
  *                      Otherwise NULL.
  */
 struct artentry*
-getentry(u_int32_t tmp_ip)
+getentry(struct aodv_node *node, u_int32_t tmp_ip)
 {
   struct rt_entry_list *tmp_rt_entry_list;
   struct in_addr tmp_in_addr;
 
-  for(tmp_rt_entry_list = rt->next;
+  for(tmp_rt_entry_list = node->rt->next;
       tmp_rt_entry_list->ishead != 1;
       tmp_rt_entry_list = tmp_rt_entry_list->next)
     {
@@ -195,21 +208,24 @@ getentry(u_int32_t tmp_ip)
  *   address as destination.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   u_int32_t tmp_ip - Destination IP address
  *
  * Returns: void
  */
 void
-delete_entry(u_int32_t tmp_ip)
+delete_entry(struct aodv_node *node, u_int32_t tmp_ip)
 {
   struct rt_entry_list *tmp_rt_entry_list;
 
-  for(tmp_rt_entry_list = rt->next;
+  for(tmp_rt_entry_list = node->rt->next;
       tmp_rt_entry_list->ishead != 1;
       tmp_rt_entry_list = tmp_rt_entry_list->next)
     {
       if(tmp_rt_entry_list->entry->dst_ip == tmp_ip)
 	{
+	  flight_event(FLIGHT_RT_DELETE, tmp_rt_entry_list->entry->dst_ip,
+		       tmp_rt_entry_list->entry->nxt_hop, 0, 0);
 	  del_kroute(tmp_rt_entry_list->entry->dst_ip,
 		    tmp_rt_entry_list->entry->nxt_hop);
 	  
@@ -231,16 +247,17 @@ delete_entry(u_int32_t tmp_ip)
  *   Removes all routes that exist in the AODV routing table
  *   from the kernel's routing table.
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Returns: void
  */
 void
-krt_cleanup()
+krt_cleanup(struct aodv_node *node)
 {
   struct rt_entry_list *tmp_rt_entry_list;
 
-  for(tmp_rt_entry_list = get_first_entry();
+  for(tmp_rt_entry_list = get_first_entry(node);
       tmp_rt_entry_list->ishead != 1;
       tmp_rt_entry_list = tmp_rt_entry_list->next)
 
@@ -254,6 +271,40 @@ krt_cleanup()
 }
 
 
+/*
+ * free_rt
+ *
+ * Description: 
+ *   Frees every entry of the routing table and its head. The
+ *   kernel's routing table is not changed.
+ *
+ * Arguments: 
+ *   struct aodv_node *node - The node.
+ *
+ * Returns: void
+ */
+void
+free_rt(struct aodv_node *node)
+{
+  struct rt_entry_list *tmp_rt_entry_list;
+
+  if(node->rt == NULL)
+    return;
+
+  while((tmp_rt_entry_list = node->rt->next) != node->rt)
+    {
+      node->rt->next = tmp_rt_entry_list->next;
+      clear_precursors(tmp_rt_entry_list->entry);
+      free(tmp_rt_entry_list->entry->precursors);
+      free(tmp_rt_entry_list->entry);
+      free(tmp_rt_entry_list);
+    }
+
+  free(node->rt);
+  node->rt = NULL;
+}
+
+
 /*
  * add_precursor
  *
@@ -286,6 +337,7 @@ add_precursor(struct artentry *tmp_artentry, u_int32_t tmp_ip)
       tmp_precursor->ip = tmp_ip;
       tmp_precursor->ishead = 0;
       tmp_artentry->precursors->next = tmp_precursor;
+      flight_event(FLIGHT_PREC_ADD, tmp_artentry->dst_ip, tmp_ip, 0, 0);
     }
   
   return 0;
@@ -312,6 +364,7 @@ delete_precursor(struct artentry *tmp_artentry, u_int32_t tmp_ip)
 
   if((tmp_precursor = find_precursor(tmp_artentry, tmp_ip)) != NULL)
     {
+      flight_event(FLIGHT_PREC_DEL, tmp_artentry->dst_ip, tmp_ip, 0, 0);
       tmp_precursor->prev->next = tmp_precursor->next;
       tmp_precursor->next->prev = tmp_precursor->prev;
       free(tmp_precursor);
@@ -327,23 +380,26 @@ delete_precursor(struct artentry *tmp_artentry, u_int32_t tmp_ip)
  *   routing table.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   u_int32_t tmp_ip - IP address for the precursor to delete.
  *
  * Returns: void
  */
 void
-delete_precursor_from_all(u_int32_t tmp_ip)
+delete_precursor_from_all(struct aodv_node *node, u_int32_t tmp_ip)
 {
   struct rt_entry_list *tmp_rt_entry_list;
   struct precursor *tmp_precursor;
 
-  for(tmp_rt_entry_list = rt->next;
+  for(tmp_rt_entry_list = node->rt->next;
       tmp_rt_entry_list->ishead != 1;
       tmp_rt_entry_list = tmp_rt_entry_list->next)
     {
       if((tmp_precursor = find_precursor(tmp_rt_entry_list->entry,
 					 tmp_ip)) != NULL)
 	{
+	  flight_event(FLIGHT_PREC_DEL, tmp_rt_entry_list->entry->dst_ip,
+		       tmp_ip, 0, 0);
 	  tmp_precursor->prev->next = tmp_precursor->next;
 	  tmp_precursor->next->prev = tmp_precursor->prev;
 	  free(tmp_precursor);
@@ -403,10 +459,11 @@ clear_precursors(struct artentry *tmp_artentry)
 {
   struct precursor *tmp_precursor;
 
-  for(tmp_precursor = tmp_artentry->precursors->next;
-      tmp_precursor->ishead == 0;
-      tmp_precursor = tmp_precursor->next)
+  /* Always take the first one, the freed entry can't be stepped from */
+  while ((tmp_precursor = tmp_artentry->precursors->next)->ishead == 0)
     {
+      flight_event(FLIGHT_PREC_DEL, tmp_artentry->dst_ip,
+		   tmp_precursor->ip, 0, 0);
       tmp_precursor->prev->next = tmp_precursor->next;
       tmp_precursor->next->prev = tmp_precursor->prev;
       free(tmp_precursor);
@@ -414,18 +471,238 @@ clear_precursors(struct artentry *tmp_artentry)
 }
 
 
+/* 
+ * add_alt_hop
+ *
+ * Description: 
+ *   Keeps a next hop as an alternate to the one a routing table entry
+ *   uses, in multipath mode. Only hops no longer than the route are
+ *   kept, so switching to one never makes the route longer and no loop
+ *   is formed. When all RT_ALT_HOPS are taken the longest gives way to
+ *   a shorter one.
+ *
+ * Arguments: 
+ *   struct artentry *tmp_artentry - Routing table entry, a valid route
+ *   u_int32_t tmp_ip - IP address of the next hop
+ *   u_int8_t hop_cnt - Hops to the destination through it
+ *   u_int64_t lifetime - When the hop expires, see getcurrtime
+ *
+ * Returns: 
+ *   int - 0 if the hop was added
+ *         1 if it was known already, its lifetime is updated
+ *        -1 if it was refused
+ */
+int
+add_alt_hop(struct artentry *tmp_artentry, u_int32_t tmp_ip,
+	    u_int8_t hop_cnt, u_int64_t lifetime)
+{
+  struct rt_alt *tmp_alt;
+  struct rt_alt *longest = NULL;
+  int i;
+
+  if(tmp_artentry->hop_cnt == 255 || tmp_ip == tmp_artentry->nxt_hop ||
+     hop_cnt > tmp_artentry->hop_cnt)
+    return -1;
+
+  for(i = 0; i < tmp_artentry->alt_cnt; i++)
+    {
+      tmp_alt = &tmp_artentry->alt[i];
+      if(tmp_alt->nxt_hop == tmp_ip)
+	{
+	  tmp_alt->hop_cnt = hop_cnt;
+	  if(tmp_alt->lifetime < lifetime)
+	    tmp_alt->lifetime = lifetime;
+	  return 1;
+	}
+
+      if(longest == NULL || tmp_alt->hop_cnt > longest->hop_cnt)
+	longest = tmp_alt;
+    }
+
+  if(tmp_artentry->alt_cnt < RT_ALT_HOPS)
+    tmp_alt = &tmp_artentry->alt[tmp_artentry->alt_cnt++];
+  else if(longest->hop_cnt > hop_cnt)
+    tmp_alt = longest;
+  else
+    return -1;
+
+  tmp_alt->nxt_hop = tmp_ip;
+  tmp_alt->hop_cnt = hop_cnt;
+  tmp_alt->lifetime = lifetime;
+  flight_event(FLIGHT_RT_ALT, tmp_artentry->dst_ip, tmp_ip, hop_cnt,
+	       tmp_artentry->dst_seq);
+
+  return 0;
+}
+
+
+/* 
+ * delete_alt_hop
+ *
+ * Description: 
+ *   Removes an alternate next hop from a routing table entry.
+ *
+ * Arguments: 
+ *   struct artentry *tmp_artentry - The routing table entry
+ *   u_int32_t tmp_ip - IP address of the next hop
+ *
+ * Returns: void
+ */
+void
+delete_alt_hop(struct artentry *tmp_artentry, u_int32_t tmp_ip)
+{
+  int i;
+
+  for(i = 0; i < tmp_artentry->alt_cnt; i++)
+    if(tmp_artentry->alt[i].nxt_hop == tmp_ip)
+      {
+	tmp_artentry->alt[i] = tmp_artentry->alt[--tmp_artentry->alt_cnt];
+	break;
+      }
+}
+
+
+/* 
+ * delete_alt_hop_from_all
+ *
+ * Description: 
+ *   Removes a next hop from the alternates of every routing table
+ *   entry, when the link to it has broken.
+ *
+ * Arguments: 
+ *   struct aodv_node *node - The node.
+ *   u_int32_t tmp_ip - IP address of the next hop
+ *
+ * Returns: void
+ */
+void
+delete_alt_hop_from_all(struct aodv_node *node, u_int32_t tmp_ip)
+{
+  struct rt_entry_list *tmp_rt_entry_list;
+
+  for(tmp_rt_entry_list = node->rt->next;
+      tmp_rt_entry_list->ishead != 1;
+      tmp_rt_entry_list = tmp_rt_entry_list->next)
+    delete_alt_hop(tmp_rt_entry_list->entry, tmp_ip);
+}
+
+
+/* 
+ * trim_alt_hops
+ *
+ * Description: 
+ *   Removes the alternates that no longer fit a routing table entry
+ *   after its next hop or hop count changed: the new next hop itself
+ *   and those longer than the route. A route with a newer destination
+ *   sequence number or a broken route keeps none.
+ *
+ * Arguments: 
+ *   struct artentry *tmp_artentry - The routing table entry
+ *
+ * Returns: void
+ */
+void
+trim_alt_hops(struct artentry *tmp_artentry)
+{
+  int i = 0;
+
+  while(i < tmp_artentry->alt_cnt)
+    {
+      if(tmp_artentry->alt[i].nxt_hop == tmp_artentry->nxt_hop ||
+	 tmp_artentry->alt[i].hop_cnt > tmp_artentry->hop_cnt)
+	tmp_artentry->alt[i] = tmp_artentry->alt[--tmp_artentry->alt_cnt];
+      else
+	i++;
+    }
+}
+
+
+/* 
+ * clear_alt_hops
+ *
+ * Description: 
+ *   Removes all alternate next hops from a routing table entry.
+ *
+ * Arguments: 
+ *   struct artentry *tmp_artentry - The routing table entry
+ *
+ * Returns: void
+ */
+void
+clear_alt_hops(struct artentry *tmp_artentry)
+{
+  tmp_artentry->alt_cnt = 0;
+}
+
+
+/* 
+ * switch_alt_hop
+ *
+ * Description: 
+ *   Replaces the next hop of a routing table entry by its shortest
+ *   alternate that has not expired, in the kernel's routing table too.
+ *   Used when the link to the next hop breaks, no route discovery is
+ *   needed then. The hop count of the entry is what the node has told
+ *   others and stays, the other alternates are no longer than it.
+ *
+ * Arguments: 
+ *   struct artentry *tmp_artentry - The routing table entry
+ *
+ * Returns: 
+ *   int - 0 if the next hop was replaced
+ *        -1 if there was no alternate left
+ */
+int
+switch_alt_hop(struct artentry *tmp_artentry)
+{
+  struct rt_alt *best = NULL;
+  struct rt_alt tmp_alt;
+  u_int64_t curr_time;
+  int i;
+
+  curr_time = getcurrtime();
+  for(i = 0; i < tmp_artentry->alt_cnt; i++)
+    if(tmp_artentry->alt[i].lifetime > curr_time &&
+       (best == NULL || tmp_artentry->alt[i].hop_cnt < best->hop_cnt))
+      best = &tmp_artentry->alt[i];
+
+  if(best == NULL)
+    {
+      clear_alt_hops(tmp_artentry);
+      return -1;
+    }
+
+  tmp_alt = *best;
+  *best = tmp_artentry->alt[--tmp_artentry->alt_cnt];
+
+  flight_event(FLIGHT_RT_SWITCH, tmp_artentry->dst_ip, tmp_artentry->nxt_hop,
+	       tmp_alt.nxt_hop, tmp_artentry->dst_seq);
+  del_kroute(tmp_artentry->dst_ip, tmp_artentry->nxt_hop);
+  tmp_artentry->nxt_hop = tmp_alt.nxt_hop;
+  if(tmp_artentry->lifetime < tmp_alt.lifetime)
+    tmp_artentry->lifetime = tmp_alt.lifetime;
+  if(add_kroute(tmp_artentry->dst_ip, tmp_artentry->nxt_hop))
+    {
+      /* add_kroute failed, ignore and continue */
+    }
+
+  return 0;
+}
+
+
 /* 
  * print_rt
  *
  * Description: 
  *   Prints the routing table
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Returns: void
  */
 void
-print_rt()
+print_rt(struct aodv_node *node)
 {
   struct in_addr tmp_in_addr1, tmp_in_addr2, tmp_in_addr3;
   struct rt_entry_list *tmp_rt_entry_list;
@@ -434,11 +711,12 @@ print_rt()
   char ip_str1[24];
   char ip_str2[24];
   char ip_str3[24];
+  int i;
 
   printf("Dst ip\t\tDst seq\tBcst id\tHop cnt\tLast hop cnt"
 	 "\tNext hop\tPrecursors\tLifetime\n");
 
-  for(tmp_rt_entry_list = rt->next;
+  for(tmp_rt_entry_list = node->rt->next;
       tmp_rt_entry_list->ishead != 1;
       tmp_rt_entry_list = tmp_rt_entry_list->next)
     {
@@ -475,5 +753,12 @@ print_rt()
 	  strcpy(ip_str3, inet_ntoa(tmp_in_addr3));
 	  printf("%s\n", ip_str3);
 	}
+      for(i = 0; i < tmp_artentry->alt_cnt; i++)
+	{
+	  /* Alternate next hops, under their hop count and next hop */
+	  tmp_in_addr2.s_addr = tmp_artentry->alt[i].nxt_hop;
+	  printf("\t\t\t\t%d\t\t\t%s\n", tmp_artentry->alt[i].hop_cnt,
+		 inet_ntoa(tmp_in_addr2));
+	}
     }
 }
@@ -25,6 +25,11 @@
  *        deletion and returning of list elements such as routing table
  *        entries and precursors.
  *
+ *        In multipath mode an entry also keeps up to RT_ALT_HOPS
+ *        alternate next hops, each at most as many hops away as the
+ *        route. One takes over without a new route discovery when the
+ *        next hop breaks.
+ *
  *	Internal procedures: 
  *        find_precursor
  *	
@@ -34,10 +39,17 @@
  *        insert_entry
  *        get_entry
  *        delete_entry
+ *        free_rt
  *        add_precursor
  *        delete_precursor
  *        delete_precursors_from_all
  *        clear_precursors
+ *        add_alt_hop
+ *        delete_alt_hop
+ *        delete_alt_hop_from_all
+ *        trim_alt_hops
+ *        clear_alt_hops
+ *        switch_alt_hop
  *        print_rt
  ********************************
  *
@@ -56,6 +68,9 @@
 
 #include "rt_entry_list.h"
 #include "krtable.h"
+#include "flight.h"
+#include "clock.h"
+#include "node.h"
 
 /*
  * get_first_entry
@@ -63,12 +78,13 @@
  * Description: 
  *   Returns the first entry in the routing table
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Return: 
  *  struct rt_entry* - Pointer to the first list entry of the routing table.
  */
-struct rt_entry_list* get_first_entry();
+struct rt_entry_list* get_first_entry(struct aodv_node *node);
 
 /*
  * getentry
@@ -78,13 +94,14 @@ struct rt_entry_list* get_first_entry();
  *   the argument ip-address as destination.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   u_int32_t tmp_ip - IP address for the destination
  *
  * Returns: 
  *   struct artentry* - Pointer to the routing table entry, if existing. 
  *                      Otherwise NULL.
  */
-struct artentry* getentry(u_int32_t);
+struct artentry* getentry(struct aodv_node *node, u_int32_t);
 
 /*
  * delete_entry
@@ -94,11 +111,12 @@ struct artentry* getentry(u_int32_t);
  *   address as destination.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   u_int32_t tmp_ip - Destination IP address
  *
  * Returns: void
  */
-void delete_entry(u_int32_t);
+void delete_entry(struct aodv_node *node, u_int32_t);
 
 /*
  * krt_cleanup
@@ -107,11 +125,27 @@ void delete_entry(u_int32_t);
  *   Removes all routes that exist in the AODV routing table
  *   from the kernel's routing table.
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Returns: void
  */
-void krt_cleanup();
+void krt_cleanup(struct aodv_node *node);
+
+
+/*
+ * free_rt
+ *
+ * Description: 
+ *   Frees every entry of the routing table and its head. The
+ *   kernel's routing table is not changed.
+ *
+ * Arguments: 
+ *   struct aodv_node *node - The node.
+ *
+ * Returns: void
+ */
+void free_rt(struct aodv_node *node);
 
 
 /*
@@ -122,12 +156,13 @@ void krt_cleanup();
  *   rt_entry_list-element pointing to it. The list-element
  *   is inserted in the routing table.
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Returns: 
  *   struct artentry* - A pointer to the new routing table entry. 
  */
-struct artentry* insert_entry();
+struct artentry* insert_entry(struct aodv_node *node);
 
 /*
  * add_precursor
@@ -184,11 +219,12 @@ void clear_precursors(struct artentry* tmp_artentry);
  *   routing table.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   u_int32_t tmp_ip - IP address for the precursor to delete.
  *
  * Returns: void
  */
-void delete_precursor_from_all(u_int32_t tmp_ip);
+void delete_precursor_from_all(struct aodv_node *node, u_int32_t tmp_ip);
 
 /*
  * init_rt
@@ -197,11 +233,113 @@ void delete_precursor_from_all(u_int32_t tmp_ip);
  *   Initializes the main routing table by creating a 
  *   head for the list.
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Return: void
  */
-int init_rt();
+int init_rt(struct aodv_node *node);
+
+/* 
+ * add_alt_hop
+ *
+ * Description: 
+ *   Keeps a next hop as an alternate to the one a routing table entry
+ *   uses, in multipath mode. Only hops no longer than the route are
+ *   kept, so switching to one never makes the route longer and no loop
+ *   is formed. When all RT_ALT_HOPS are taken the longest gives way to
+ *   a shorter one.
+ *
+ * Arguments: 
+ *   struct artentry *tmp_artentry - Routing table entry, a valid route
+ *   u_int32_t tmp_ip - IP address of the next hop
+ *   u_int8_t hop_cnt - Hops to the destination through it
+ *   u_int64_t lifetime - When the hop expires, see getcurrtime
+ *
+ * Returns: 
+ *   int - 0 if the hop was added
+ *         1 if it was known already, its lifetime is updated
+ *        -1 if it was refused
+ */
+int add_alt_hop(struct artentry *tmp_artentry, u_int32_t tmp_ip,
+		u_int8_t hop_cnt, u_int64_t lifetime);
+
+/* 
+ * delete_alt_hop
+ *
+ * Description: 
+ *   Removes an alternate next hop from a routing table entry.
+ *
+ * Arguments: 
+ *   struct artentry *tmp_artentry - The routing table entry
+ *   u_int32_t tmp_ip - IP address of the next hop
+ *
+ * Returns: void
+ */
+void delete_alt_hop(struct artentry *tmp_artentry, u_int32_t tmp_ip);
+
+/* 
+ * delete_alt_hop_from_all
+ *
+ * Description: 
+ *   Removes a next hop from the alternates of every routing table
+ *   entry, when the link to it has broken.
+ *
+ * Arguments: 
+ *   struct aodv_node *node - The node.
+ *   u_int32_t tmp_ip - IP address of the next hop
+ *
+ * Returns: void
+ */
+void delete_alt_hop_from_all(struct aodv_node *node, u_int32_t tmp_ip);
+
+/* 
+ * trim_alt_hops
+ *
+ * Description: 
+ *   Removes the alternates that no longer fit a routing table entry
+ *   after its next hop or hop count changed: the new next hop itself
+ *   and those longer than the route. A route with a newer destination
+ *   sequence number or a broken route keeps none.
+ *
+ * Arguments: 
+ *   struct artentry *tmp_artentry - The routing table entry
+ *
+ * Returns: void
+ */
+void trim_alt_hops(struct artentry *tmp_artentry);
+
+/* 
+ * clear_alt_hops
+ *
+ * Description: 
+ *   Removes all alternate next hops from a routing table entry.
+ *
+ * Arguments: 
+ *   struct artentry *tmp_artentry - The routing table entry
+ *
+ * Returns: void
+ */
+void clear_alt_hops(struct artentry *tmp_artentry);
+
+/* 
+ * switch_alt_hop
+ *
+ * Description: 
+ *   Replaces the next hop of a routing table entry by its shortest
+ *   alternate that has not expired, in the kernel's routing table too.
+ *   Used when the link to the next hop breaks, no route discovery is
+ *   needed then. The hop count of the entry is what the node has told
+ *   others and stays, the other alternates are no longer than it.
+ *
+ * Arguments: 
+ *   struct artentry *tmp_artentry - The routing table entry
+ *
+ * Returns: 
+ *   int - 0 if the next hop was replaced
+ *        -1 if there was no alternate left
+ */
+int switch_alt_hop(struct artentry *tmp_artentry);
 
 /* 
  * print_rt
@@ -209,10 +347,11 @@ int init_rt();
  * Description: 
  *   Prints the routing table
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Returns: void
  */
-void print_rt();
+void print_rt(struct aodv_node *node);
 
 #endif
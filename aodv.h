@@ -10,15 +10,14 @@
 #define ALLOWED_HELLO_LOSS     2
 #define HELLO_INTERVAL         3000
 #define NODE_TRAVERSAL_TIME    100
+#define NODE_TRAVERSAL_MIN     10
+#define NODE_TRAVERSAL_MAX     1000
 #define NET_DIAMETER           35
-#define RREP_WAIT_TIME         (3 * (NODE_TRAVERSAL_TIME) * (NET_DIAMETER))/2
-#define BAD_LINK_LIFEIME       2 * (RREP_WAIT_TIME)
-#define BCAST_ID_SAVE          30000
-#define BROADCAST_RECORD_TIME  (RREP_WAIT_TIME)
+/* The time to wait for a RREP follows the measured node traversal time,
+   reverse routes and RREQs are kept at least RREP_WAIT_TIME, see rtt.h */
+#define RREP_WAIT_TIME         (3 * (NODE_TRAVERSAL_TIME) * (NET_DIAMETER) / 2)
 #define DELETE_PERIOD          5 * MAX((ACTIVE_ROUTE_TIMEOUT),((ALLOWED_HELLO_LOSS)*(HELLO_INTERVAL)))
 #define GROUP_HELLO_INTERVAL   5000
-#define REV_ROUTE_LIFE         (RREP_WAIT_TIME)
-#define MTREE_BUILD            2 * (REV_ROUTE_LIFE)
 #define MY_ROUTE_TIMEOUT       2 * (ACTIVE_ROUTE_TIMEOUT)
 #define NEXT_HOP_WAIT          (NODE_TRAVERSAL_TIME) + 10
 #define PRUNE_TIMEOUT          (ACTIVE_ROUTE_TIMEOUT)
@@ -26,6 +25,11 @@
 #define TTL_START              1
 #define TTL_INCREMENT          2
 #define TTL_TRESHOLD           7
+#define MAX_REPAIR_TTL         (3 * (NET_DIAMETER) / 10)
+#define LOCAL_ADD_TTL          2
+#define RREQ_JITTER            10
+#define GOSSIP_HOPS            1
+#define GOSSIP_DEGREE          8
 #define RREQ                   1
 #define RREP                   2
 #define RERR                   3
@@ -59,6 +63,13 @@ struct rrep
   u_int32_t    lifetime;
 };
 
+/* A HELLO is a RREP a node sends one hop for itself */
+#define RREP_IS_HELLO(p) ((p)->hop_cnt == 0 && (p)->dst_ip == (p)->src_ip)
+#define HELLO_SEQ_MASK   0x3ff   /* HELLOs are numbered in the reserved
+				    bits */
+#define RREP_FROM_DST    0x200   /* In the reserved bits of other RREPs:
+				    sent by the destination itself */
+
 struct rerr_unr_dst
 {
   u_int32_t unr_dst_ip;
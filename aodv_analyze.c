@@ -0,0 +1,689 @@
+/*
+ *	FILE: aodv_analyze.c
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ *      Usage:
+ *        aodv_analyze [-w ms] trace...
+ *
+ *        -w     How long a node remembers a RREQ, RREP_WAIT_TIME by
+ *               default. Nodes that measured slower hops remember it
+ *               longer, see broadcast_record_time.
+ ********************************
+ *
+ *	General description:
+ *      -------------------
+ *
+ * Reads control traffic traces in one streaming pass and reports route
+ * discovery latency, RREQ retries, duplicate RREQs, RERR fan-out and
+ * control overhead. See aodv_analyze.h.
+ *
+ *	Internal procedures:
+ *
+ * src_less()
+ * heap_down()
+ * heap_up()
+ * merge_next()
+ * disc_find()
+ * disc_end()
+ * seen_check()
+ * do_rreq()
+ * do_rrep()
+ * do_rerr()
+ * report()
+ *
+ *	External procedures:
+ *
+ * main()
+ *
+ ********************************
+ *
+ *   Extendend RCS Info: $Id$
+ *
+ */
+
+#include "aodv_analyze.h"
+
+/* Message classes for the overhead counters */
+#define CLS_HELLO 0
+#define CLS_RREQ  1
+#define CLS_RREP  2
+#define CLS_RERR  3
+#define CLS_NUM   4
+
+char *cls_name[CLS_NUM] = { "HELLO", "RREQ", "RREP", "RERR" };
+
+/* The inputs, and a heap of them ordered by the time of their record */
+struct source *srcs;
+int nsrcs;
+int *heap;
+int heapn;
+
+/* Hash tables */
+struct disc *discs[HASH_SIZE];
+struct seen *seens[HASH_SIZE];
+
+/* Results */
+struct hist latency;              /* Discovery latency, us */
+struct hist rerr_dsts;            /* Destinations per sent RERR */
+u_int64_t disc_ok = 0;
+u_int64_t disc_failed = 0;
+u_int64_t disc_open = 0;
+u_int64_t ndiscs = 0;             /* Discoveries in the hash table */
+u_int64_t retries[MAX_RETRIES_SHOWN + 1];
+u_int64_t sent_msgs[CLS_NUM];
+u_int64_t sent_bytes[CLS_NUM];
+u_int64_t rerr_recv = 0;
+u_int64_t records = 0;
+u_int64_t seen_window = RREP_WAIT_TIME; /* ms, see seen_check */
+u_int64_t first_time = 0;
+u_int64_t last_time = 0;
+
+/*
+ *   src_less
+ *
+ *   Description:
+ *     Orders two inputs by the time of their current record. Ties are
+ *     broken by input order so the merge is deterministic.
+ *
+ *   Arguments:
+ *     int a - Index of an input.
+ *     int b - Index of an input.
+ *
+ *   Return:
+ *     int - 1 if a comes before b, 0 otherwise.
+*/
+int
+src_less(int a, int b)
+{
+  if (srcs[a].time != srcs[b].time)
+    return srcs[a].time < srcs[b].time;
+
+  return a < b;
+}
+
+/*
+ *   heap_down
+ *
+ *   Description:
+ *     Moves the heap element at a position down to its place.
+ *
+ *   Arguments:
+ *     int i - Position in the heap.
+ *
+ *   Return: None.
+*/
+void
+heap_down(int i)
+{
+  int child;
+  int tmp;
+
+  while ((child = 2 * i + 1) < heapn)
+    {
+      if (child + 1 < heapn && src_less(heap[child + 1], heap[child]))
+	child++;
+
+      if (!src_less(heap[child], heap[i]))
+	break;
+
+      tmp = heap[i];
+      heap[i] = heap[child];
+      heap[child] = tmp;
+      i = child;
+    }
+}
+
+/*
+ *   heap_up
+ *
+ *   Description:
+ *     Moves the heap element at a position up to its place.
+ *
+ *   Arguments:
+ *     int i - Position in the heap.
+ *
+ *   Return: None.
+*/
+void
+heap_up(int i)
+{
+  int tmp;
+
+  while (i > 0 && src_less(heap[i], heap[(i - 1) / 2]))
+    {
+      tmp = heap[i];
+      heap[i] = heap[(i - 1) / 2];
+      heap[(i - 1) / 2] = tmp;
+      i = (i - 1) / 2;
+    }
+}
+
+/*
+ *   merge_next
+ *
+ *   Description:
+ *     Reads the next record of an input and puts the input back into
+ *     the heap, or drops it at the end of its trace.
+ *
+ *   Arguments:
+ *     int s - Index of the input.
+ *
+ *   Return:
+ *     int - On a corrupt trace -1 is returned else 0
+*/
+int
+merge_next(int s)
+{
+  struct source *src = &srcs[s];
+  int rc;
+
+  if ((rc = trace_read(src->fp, &src->rec, src->data)) == -1)
+    {
+      fprintf(stderr, "%s: trace is truncated or corrupt\n", src->path);
+      return -1;
+    }
+
+  if (rc == 0)
+    return 0;
+
+  src->time = trace_realtime(&src->hdr, src->rec.time);
+  heap[heapn] = s;
+  heap_up(heapn++);
+
+  return 0;
+}
+
+/*
+ *   disc_find
+ *
+ *   Description:
+ *     Looks up the discovery of a destination by an originator.
+ *
+ *   Arguments:
+ *     u_int32_t src_ip - The originator.
+ *     u_int32_t dst_ip - The destination.
+ *     struct disc ***pp - Set to the link pointing to the result, or to
+ *                         the end of the chain.
+ *
+ *   Return:
+ *     struct disc* - The discovery, NULL if none is in progress.
+*/
+struct disc *
+disc_find(u_int32_t src_ip, u_int32_t dst_ip, struct disc ***pp)
+{
+  struct disc **p;
+
+  p = &discs[((src_ip * 2654435761U) ^ dst_ip) & (HASH_SIZE - 1)];
+  for (; *p != NULL; p = &(*p)->next)
+    if ((*p)->src_ip == src_ip && (*p)->dst_ip == dst_ip)
+      break;
+
+  *pp = p;
+  return *p;
+}
+
+/*
+ *   disc_end
+ *
+ *   Description:
+ *     Counts and removes a discovery.
+ *
+ *   Arguments:
+ *     struct disc **p - The link pointing to the discovery.
+ *     u_int64_t now   - End of the discovery, 0 if it failed.
+ *
+ *   Return: None.
+*/
+void
+disc_end(struct disc **p, u_int64_t now)
+{
+  struct disc *d = *p;
+
+  if (now != 0)
+    {
+      hist_add(&latency, now - d->start);
+      disc_ok++;
+    }
+  else
+    disc_failed++;
+
+  retries[MIN(d->retries, MAX_RETRIES_SHOWN)]++;
+
+  *p = d->next;
+  free(d);
+  ndiscs--;
+}
+
+/*
+ *   seen_check
+ *
+ *   Description:
+ *     Does what find_rreq and add_rreq do for a node: tells if a RREQ
+ *     was seen before and remembers it for seen_window. Expired
+ *     entries met on the way are freed.
+ *
+ *   Arguments:
+ *     u_int32_t node_ip      - The node.
+ *     u_int32_t src_ip       - Originator of the RREQ.
+ *     u_int32_t broadcast_id - Broadcast id of the RREQ.
+ *     u_int64_t now          - Time of the RREQ, us.
+ *
+ *   Return:
+ *     int - 1 if the RREQ is a duplicate, 0 otherwise.
+*/
+int
+seen_check(u_int32_t node_ip, u_int32_t src_ip, u_int32_t broadcast_id,
+	   u_int64_t now)
+{
+  struct seen **p;
+  struct seen *e;
+  u_int32_t h;
+
+  h = (node_ip * 2654435761U) ^ (src_ip * 40503U) ^ broadcast_id;
+  p = &seens[h & (HASH_SIZE - 1)];
+
+  while ((e = *p) != NULL)
+    {
+      if (e->expire <= now)
+	{
+	  /* Forgotten by the node, free it */
+	  *p = e->next;
+	  free(e);
+	  continue;
+	}
+
+      if (e->node_ip == node_ip && e->src_ip == src_ip &&
+	  e->broadcast_id == broadcast_id)
+	return 1;
+
+      p = &e->next;
+    }
+
+  if ((e = malloc(sizeof(struct seen))) == NULL)
+    return 0;
+
+  e->node_ip = node_ip;
+  e->src_ip = src_ip;
+  e->broadcast_id = broadcast_id;
+  e->expire = now + seen_window * 1000;
+  e->next = *p;
+  *p = e;
+
+  return 0;
+}
+
+/*
+ *   do_rreq
+ *
+ *   Description:
+ *     Accounts a RREQ record.
+ *
+ *   Arguments:
+ *     struct source *src - The input the record came from.
+ *
+ *   Return: None.
+*/
+void
+do_rreq(struct source *src)
+{
+  struct rreq *pkt = (struct rreq*)src->data;
+  struct trace_rec *rec = &src->rec;
+  struct disc **p;
+  struct disc *d;
+  u_int64_t timeout;
+
+  if (pkt->dst_ip == INADDR_BROADCAST)
+    {
+      /* HELLO of an older version */
+      if (rec->dir == TRACE_DIR_OUT)
+	{
+	  sent_msgs[CLS_HELLO]++;
+	  sent_bytes[CLS_HELLO] += rec->origlen;
+	}
+      return;
+    }
+
+  if (rec->dir == TRACE_DIR_IN)
+    {
+      src->rreq_in++;
+      if (seen_check(src->hdr.my_ip, pkt->src_ip, pkt->broadcast_id,
+		     src->time))
+	src->rreq_dup++;
+      return;
+    }
+
+  sent_msgs[CLS_RREQ]++;
+  sent_bytes[CLS_RREQ] += rec->origlen;
+
+  if (pkt->src_ip != src->hdr.my_ip || pkt->hop_cnt != 0)
+    /* Forwarded, not ours */
+    return;
+
+  /* Originated here, by gen_rreq or rreq_timeout */
+  seen_check(src->hdr.my_ip, pkt->src_ip, pkt->broadcast_id, src->time);
+  timeout = (2 * rec->ttl * NODE_TRAVERSAL_TIME + DISC_SLACK) * 1000ULL;
+  if (rec->ttl >= NET_DIAMETER)
+    /* The retries over the whole network back off, see rreq_timeout */
+    timeout <<= RREQ_RETRIES;
+
+  if ((d = disc_find(pkt->src_ip, pkt->dst_ip, &p)) != NULL)
+    {
+      if (src->time <= d->deadline)
+	{
+	  /* A retry of the discovery in progress */
+	  d->retries++;
+	  d->deadline = src->time + timeout;
+	  return;
+	}
+
+      /* The old discovery gave up, this is a new one */
+      disc_end(p, 0);
+      d = disc_find(pkt->src_ip, pkt->dst_ip, &p);
+    }
+
+  if ((d = malloc(sizeof(struct disc))) == NULL)
+    return;
+
+  d->src_ip = pkt->src_ip;
+  d->dst_ip = pkt->dst_ip;
+  d->start = src->time;
+  d->deadline = src->time + timeout;
+  d->retries = 0;
+  d->next = NULL;
+  *p = d;
+  ndiscs++;
+}
+
+/*
+ *   do_rrep
+ *
+ *   Description:
+ *     Accounts a RREP record, or a HELLO.
+ *
+ *   Arguments:
+ *     struct source *src - The input the record came from.
+ *
+ *   Return: None.
+*/
+void
+do_rrep(struct source *src)
+{
+  struct rrep *pkt = (struct rrep*)src->data;
+  struct trace_rec *rec = &src->rec;
+  struct disc **p;
+  struct disc *d;
+
+  if (RREP_IS_HELLO(pkt))
+    {
+      if (rec->dir == TRACE_DIR_OUT)
+	{
+	  sent_msgs[CLS_HELLO]++;
+	  sent_bytes[CLS_HELLO] += rec->origlen;
+	}
+      return;
+    }
+
+  if (rec->dir == TRACE_DIR_OUT)
+    {
+      sent_msgs[CLS_RREP]++;
+      sent_bytes[CLS_RREP] += rec->origlen;
+      return;
+    }
+
+  /* A RREP received by the originator ends its discovery */
+  if (pkt->src_ip != src->hdr.my_ip)
+    return;
+
+  if ((d = disc_find(pkt->src_ip, pkt->dst_ip, &p)) == NULL)
+    return;
+
+  disc_end(p, src->time <= d->deadline ? src->time : 0);
+}
+
+/*
+ *   do_rerr
+ *
+ *   Description:
+ *     Accounts a RERR record.
+ *
+ *   Arguments:
+ *     struct source *src - The input the record came from.
+ *
+ *   Return: None.
+*/
+void
+do_rerr(struct source *src)
+{
+  struct rerr *pkt = (struct rerr*)src->data;
+  struct trace_rec *rec = &src->rec;
+
+  if (rec->dir == TRACE_DIR_IN)
+    {
+      rerr_recv++;
+      return;
+    }
+
+  sent_msgs[CLS_RERR]++;
+  sent_bytes[CLS_RERR] += rec->origlen;
+  hist_add(&rerr_dsts, pkt->dst_cnt);
+}
+
+/*
+ *   report
+ *
+ *   Description:
+ *     Prints the results.
+ *
+ *   Arguments: None.
+ *
+ *   Return: None.
+*/
+void
+report()
+{
+  u_int64_t total_msgs = 0;
+  u_int64_t total_bytes = 0;
+  u_int64_t in = 0;
+  u_int64_t dup = 0;
+  int i;
+
+  printf("Traces: %d  Records: %llu  Span: %.3f s\n", nsrcs,
+	 (unsigned long long)records,
+	 records ? (last_time - first_time) / 1e6 : 0.0);
+
+  printf("\nRoute discovery\n");
+  printf("  Succeeded: %llu  Failed: %llu  Unfinished: %llu\n",
+	 (unsigned long long)disc_ok, (unsigned long long)disc_failed,
+	 (unsigned long long)disc_open);
+  printf("  Latency ms  p50: %.3f  p90: %.3f  p99: %.3f  max: %.3f  "
+	 "mean: %.3f\n",
+	 hist_percentile(&latency, 50) / 1e3,
+	 hist_percentile(&latency, 90) / 1e3,
+	 hist_percentile(&latency, 99) / 1e3,
+	 latency.max / 1e3, hist_mean(&latency) / 1e3);
+  printf("  Retries per discovery:");
+  for (i = 0; i <= MAX_RETRIES_SHOWN; i++)
+    if (retries[i] != 0)
+      printf("  %d%s: %llu", i, i == MAX_RETRIES_SHOWN ? "+" : "",
+	     (unsigned long long)retries[i]);
+  printf("\n");
+
+  printf("\nDuplicate RREQs (dropped by find_rreq)\n");
+  for (i = 0; i < nsrcs; i++)
+    {
+      printf("  %-15s received: %-8llu duplicates: %-8llu %5.1f%%\n",
+	     inet_ntoa(*((struct in_addr*)&srcs[i].hdr.my_ip)),
+	     (unsigned long long)srcs[i].rreq_in,
+	     (unsigned long long)srcs[i].rreq_dup,
+	     srcs[i].rreq_in ? 100.0 * srcs[i].rreq_dup / srcs[i].rreq_in : 0);
+      in += srcs[i].rreq_in;
+      dup += srcs[i].rreq_dup;
+    }
+  printf("  %-15s received: %-8llu duplicates: %-8llu %5.1f%%\n", "All",
+	 (unsigned long long)in, (unsigned long long)dup,
+	 in ? 100.0 * dup / in : 0);
+
+  printf("\nRERR fan-out\n");
+  printf("  Sent: %llu  Received: %llu  Receptions per RERR: %.2f\n",
+	 (unsigned long long)sent_msgs[CLS_RERR],
+	 (unsigned long long)rerr_recv,
+	 sent_msgs[CLS_RERR] ?
+	 (double)rerr_recv / sent_msgs[CLS_RERR] : 0);
+  printf("  Destinations per RERR  mean: %.2f  p99: %llu  max: %llu\n",
+	 hist_mean(&rerr_dsts),
+	 (unsigned long long)hist_percentile(&rerr_dsts, 99),
+	 (unsigned long long)rerr_dsts.max);
+
+  printf("\nControl overhead (sent, AODV payload)\n");
+  for (i = 0; i < CLS_NUM; i++)
+    {
+      printf("  %-6s messages: %-10llu bytes: %llu\n", cls_name[i],
+	     (unsigned long long)sent_msgs[i],
+	     (unsigned long long)sent_bytes[i]);
+      total_msgs += sent_msgs[i];
+      total_bytes += sent_bytes[i];
+    }
+  printf("  %-6s messages: %-10llu bytes: %llu\n", "Total",
+	 (unsigned long long)total_msgs, (unsigned long long)total_bytes);
+  if (disc_ok != 0)
+    printf("  Per established route: %.1f bytes, %.1f bytes without "
+	   "HELLOs\n", (double)total_bytes / disc_ok,
+	   (double)(total_bytes - sent_bytes[CLS_HELLO]) / disc_ok);
+}
+
+/* ------------------------------------------------------------------- */
+
+int
+main(int argc, char *argv[])
+{
+  struct source *src;
+  struct disc **p;
+  struct disc *d;
+  u_int64_t sweep = 0;
+  int opt;
+  int s;
+  int i;
+
+  while ((opt = getopt(argc, argv, "w:")) != -1)
+    switch (opt)
+      {
+      case 'w':
+	seen_window = strtoull(optarg, NULL, 0);
+	break;
+
+      default:
+	/* Reported below */
+	optind = argc;
+	break;
+      }
+
+  if (optind >= argc)
+    {
+      fprintf(stderr, "Usage: %s [-w ms] trace...\n", argv[0]);
+      exit(1);
+    }
+
+  nsrcs = argc - optind;
+  if ((srcs = calloc(nsrcs, sizeof(struct source))) == NULL ||
+      (heap = malloc(nsrcs * sizeof(int))) == NULL)
+    {
+      perror("malloc");
+      exit(1);
+    }
+
+  hist_init(&latency);
+  hist_init(&rerr_dsts);
+
+  for (s = 0; s < nsrcs; s++)
+    {
+      srcs[s].path = argv[optind + s];
+      if ((srcs[s].fp = trace_open(srcs[s].path, &srcs[s].hdr)) == NULL)
+	exit(1);
+      if (merge_next(s) == -1)
+	exit(1);
+    }
+
+  /* Take records in time order from all traces */
+  while (heapn > 0)
+    {
+      s = heap[0];
+      heap[0] = heap[--heapn];
+      heap_down(0);
+
+      src = &srcs[s];
+      if (records++ == 0)
+	first_time = src->time;
+      last_time = src->time;
+
+      /* Failed kernel route changes carry no message */
+      if (src->rec.dir != TRACE_DIR_KRT && src->rec.caplen >= 1)
+	{
+	  switch (*(u_int8_t*)src->data)
+	    {
+	    case RREQ:
+	      if (src->rec.caplen >= sizeof(struct rreq))
+		do_rreq(src);
+	      break;
+
+	    case RREP:
+	      if (src->rec.caplen >= sizeof(struct rrep))
+		do_rrep(src);
+	      break;
+
+	    case RERR:
+	      if (src->rec.caplen >= sizeof(struct rerr))
+		do_rerr(src);
+	      break;
+	    }
+	}
+
+      /* Now and then end discoveries that gave up so memory stays
+	 bounded */
+      if (last_time >= sweep && ndiscs > 0)
+	{
+	  for (i = 0; i < HASH_SIZE; i++)
+	    for (p = &discs[i]; (d = *p) != NULL; )
+	      if (d->deadline < last_time)
+		disc_end(p, 0);
+	      else
+		p = &d->next;
+	  sweep = last_time + SWEEP_INTERVAL;
+	}
+
+      if (merge_next(s) == -1)
+	exit(1);
+    }
+
+  /* What is left either gave up or was cut off by the end of a trace */
+  for (i = 0; i < HASH_SIZE; i++)
+    while ((d = discs[i]) != NULL)
+      {
+	if (d->deadline < last_time)
+	  disc_end(&discs[i], 0);
+	else
+	  {
+	    disc_open++;
+	    discs[i] = d->next;
+	    free(d);
+	  }
+      }
+
+  report();
+
+  exit(0);
+}
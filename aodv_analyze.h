@@ -0,0 +1,135 @@
+/*
+ *	FILE: aodv_analyze.c
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ *      Usage:
+ *        aodv_analyze [-w ms] trace...
+ *
+ *        -w     How long a node remembers a RREQ, RREP_WAIT_TIME by
+ *               default. Nodes that measured slower hops remember it
+ *               longer, see broadcast_record_time.
+ *        trace  Control traffic traces written by aodv_daemon, one per
+ *               node. The records of all traces are merged by time.
+ *
+ ********************************
+ *
+ *	General description:
+ *      -------------------
+ *
+ * Reads control traffic traces in one streaming pass and reports:
+ *
+ *   - Route discovery latency, from the first RREQ a node originates for
+ *     a destination to the RREP it receives for it, as percentiles.
+ *   - RREQ retries per discovery, the resends done by rreq_timeout.
+ *   - Duplicate RREQs, received RREQs the node had already seen within
+ *     the -w window and that find_rreq therefore drops.
+ *   - RERR fan-out, unreachable destinations per RERR and receptions
+ *     per sent RERR.
+ *   - Control bytes sent in total, per message type and per
+ *     established route.
+ *
+ * Memory use is bounded by the number of nodes and of concurrent
+ * discoveries, not by the length of the traces.
+ *
+ *	Internal procedures:
+ *
+ * src_less()
+ * heap_down()
+ * heap_up()
+ * merge_next()
+ * disc_find()
+ * disc_end()
+ * seen_check()
+ * do_rreq()
+ * do_rrep()
+ * do_rerr()
+ * report()
+ *
+ *	External procedures:
+ *
+ * main()
+ *
+ ********************************
+ *
+ *   Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef AODV_ANALYZE_H
+#define AODV_ANALYZE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "aodv.h"
+#include "trace.h"
+#include "hist.h"
+
+/* Size of the hash tables, must be a power of two */
+#define HASH_SIZE 65536
+
+/* Extra time given to a RREQ attempt on top of its timer, in ms */
+#define DISC_SLACK 100
+
+/* How often discoveries that gave up are cleared away, in us of trace
+   time */
+#define SWEEP_INTERVAL 60000000ULL
+
+/* Largest retry count shown separately */
+#define MAX_RETRIES_SHOWN 8
+
+/* One input trace */
+struct source
+{
+  char *path;
+  FILE *fp;
+  struct trace_hdr hdr;
+  struct trace_rec rec;           /* The current record */
+  char data[TRACE_MAXCAP];        /* Its message */
+  u_int64_t time;                 /* Its wall clock time in us */
+  u_int64_t rreq_in;              /* RREQs received, HELLOs excluded */
+  u_int64_t rreq_dup;             /* Of those, duplicates */
+};
+
+/* A route discovery in progress */
+struct disc
+{
+  u_int32_t src_ip;               /* Originator */
+  u_int32_t dst_ip;               /* Destination sought */
+  u_int64_t start;                /* First RREQ, us */
+  u_int64_t deadline;             /* When the last attempt times out, us */
+  int retries;                    /* Resends of the RREQ */
+  struct disc *next;
+};
+
+/* A (node, originator, broadcast id) seen in a RREQ */
+struct seen
+{
+  u_int32_t node_ip;              /* Node that saw it */
+  u_int32_t src_ip;               /* Originator of the RREQ */
+  u_int32_t broadcast_id;
+  u_int64_t expire;               /* When find_rreq forgets it, us */
+  struct seen *next;
+};
+
+#endif
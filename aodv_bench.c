@@ -0,0 +1,652 @@
+/*
+ *	FILE: aodv_bench.c
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ *      Usage:
+ *        aodv_bench [-n size] [-t ms] [-b name]
+ *
+ *        -n  Largest table size, sizes go from 10 up by factors of 10
+ *            (100000).
+ *        -t  Time spent on each benchmark and size in ms (200).
+ *        -b  Only run the benchmark of this name: rt, prec, pq or rreq.
+ *
+ ********************************
+ *
+ *	General description:
+ *      -------------------
+ *
+ * Microbenchmarks of the routing table, the precursor lists, the timer
+ * queue and the route request list, at table sizes from 10 up. Each
+ * benchmark and size runs in a child process of its own, so its peak
+ * RSS is its own. Prints JSON on stdout: for every operation and size
+ * the number of operations timed, ns/op, allocations/op and the peak
+ * RSS in KB.
+ *
+ *   rt    getentry of a random destination, insert_entry of a new one,
+ *         delete_entry of the oldest.
+ *   prec  add_precursor to random entries, delete_precursor_from_all
+ *         of that precursor.
+ *   pq    pq_insert at a random time, pq_getfirstofidflags of a random
+ *         id, pq_deleteidflags of the inserted ids.
+ *   rreq  find_rreq of a random entry, add_rreq of a new one.
+ *
+ * The tables are filled in O(size) before the timing starts: routes and
+ * timers are inserted so that each goes first, the route request list
+ * is linked directly. Calls to malloc from the code under test are
+ * counted through the linker (--wrap=malloc). The kernel route calls
+ * and net_send are replaced by stubs. The clock runs on its virtual
+ * source and stands still, so nothing expires.
+ *
+ *	Internal procedures:
+ *
+ * bench_time()
+ * bench_random()
+ * bench_begin()
+ * bench_end()
+ * bench_rt()
+ * bench_prec()
+ * bench_pq()
+ * bench_rreq()
+ * bench_run()
+ *
+ *	External procedures:
+ *
+ * __wrap_malloc()
+ * net_send()
+ * add_kroute()
+ * del_kroute()
+ * main()
+ *
+ ********************************
+ *
+ *   Extendend RCS Info: $Id$
+ *
+ */
+
+#include "aodv_bench.h"
+
+/* Pre-declaration of internal functions */
+u_int64_t bench_time();
+u_int64_t bench_random();
+void bench_begin(struct bench_op *op);
+void bench_end(struct bench_op *op, int ops);
+int bench_rt(struct aodv_node *node, int size, struct bench_op *op);
+int bench_prec(struct aodv_node *node, int size, struct bench_op *op);
+int bench_pq(struct aodv_node *node, int size, struct bench_op *op);
+int bench_rreq(struct aodv_node *node, int size, struct bench_op *op);
+int bench_run(struct bench *b, int size, int first);
+
+struct bench benches[] =
+{
+  { "rt", bench_rt },
+  { "prec", bench_prec },
+  { "pq", bench_pq },
+  { "rreq", bench_rreq },
+  { NULL, NULL }
+};
+
+u_int64_t allocs = 0;             /* Calls to malloc */
+u_int64_t budget = 200000000;     /* ns per benchmark and size */
+u_int64_t rng = 0x9e3779b97f4a7c15ULL;
+
+/* Start of the operation being timed */
+u_int64_t t0;
+u_int64_t allocs0;
+
+/*
+ *   __wrap_malloc
+ *
+ *   Description:
+ *     Counts the call and hands it to malloc. The linker sends the
+ *     calls to malloc of the protocol code here.
+ *
+ *   Arguments:
+ *     size_t size - Bytes.
+ *
+ *   Return:
+ *     void* - The memory, NULL if there is none.
+*/
+void *
+__wrap_malloc(size_t size)
+{
+  allocs++;
+
+  return __real_malloc(size);
+}
+
+/*
+ *   net_send
+ *
+ *   Description:
+ *     Replaces the socket send of netio.c, nothing is sent.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The sending node.
+ *     struct info *pktinfo   - Destination and ttl.
+ *     void *data             - The message.
+ *     int datalen            - Its length.
+ *
+ *   Return:
+ *     int - Always 0
+*/
+int
+net_send(struct aodv_node *node, struct info *pktinfo, void *data,
+	 int datalen)
+{
+  return 0;
+}
+
+/*
+ *   add_kroute
+ *
+ *   Description:
+ *     Replaces the kernel route change of krtable.c, does nothing.
+ *
+ *   Arguments:
+ *     u_int32_t dst_ip - Destination of the route.
+ *     u_int32_t gw_ip  - Gateway.
+ *
+ *   Return:
+ *     int - Always 0
+*/
+int
+add_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
+{
+  return 0;
+}
+
+/*
+ *   del_kroute
+ *
+ *   Description:
+ *     Replaces the kernel route change of krtable.c, does nothing.
+ *
+ *   Arguments:
+ *     u_int32_t dst_ip - Destination of the route.
+ *     u_int32_t gw_ip  - Gateway.
+ *
+ *   Return:
+ *     int - Always 0
+*/
+int
+del_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
+{
+  return 0;
+}
+
+/*
+ *   bench_time
+ *
+ *   Description:
+ *     Reads the monotonic clock.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     u_int64_t - The time, ns.
+*/
+u_int64_t
+bench_time()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (u_int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ *   bench_random
+ *
+ *   Description:
+ *     Returns the next number of the generator (xorshift64*). Every
+ *     child starts from the same state.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     u_int64_t - The number.
+*/
+u_int64_t
+bench_random()
+{
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+
+  return rng * 2685821657736338717ULL;
+}
+
+/*
+ *   bench_begin
+ *
+ *   Description:
+ *     Starts timing a batch of an operation.
+ *
+ *   Arguments:
+ *     struct bench_op *op - The operation.
+ *
+ *   Return: None
+*/
+void
+bench_begin(struct bench_op *op)
+{
+  allocs0 = allocs;
+  t0 = bench_time();
+}
+
+/*
+ *   bench_end
+ *
+ *   Description:
+ *     Ends timing a batch of an operation and adds it to its results.
+ *
+ *   Arguments:
+ *     struct bench_op *op - The operation.
+ *     int ops             - Operations in the batch.
+ *
+ *   Return: None
+*/
+void
+bench_end(struct bench_op *op, int ops)
+{
+  op->ns += bench_time() - t0;
+  op->allocs += allocs - allocs0;
+  op->ops += ops;
+}
+
+/*
+ *   bench_rt
+ *
+ *   Description:
+ *     Routing table: getentry of a random destination, insert_entry of
+ *     a new one and delete_entry of the oldest. New routes go first, so
+ *     the oldest is found last, as when routes expire.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - A fresh node.
+ *     int size               - Number of routes.
+ *     struct bench_op *op    - Where the results go.
+ *
+ *   Return:
+ *     int - Number of operations, -1 on error.
+*/
+int
+bench_rt(struct aodv_node *node, int size, struct bench_op *op)
+{
+  struct artentry *rte;
+  u_int64_t start;
+  u_int32_t lo = BENCH_NET;
+  u_int32_t hi = BENCH_NET;
+  int i;
+
+  op[0].name = "getentry";
+  op[1].name = "insert_entry";
+  op[2].name = "delete_entry";
+
+  for (i = 0; i < size; i++)
+    {
+      if ((rte = insert_entry(node)) == NULL)
+	return -1;
+      rte->dst_ip = hi++;
+    }
+
+  start = bench_time();
+  while (bench_time() - start < budget)
+    {
+      bench_begin(&op[0]);
+      for (i = 0; i < BENCH_BATCH; i++)
+	getentry(node, lo + bench_random() % size);
+      bench_end(&op[0], BENCH_BATCH);
+
+      bench_begin(&op[1]);
+      for (i = 0; i < BENCH_BATCH; i++)
+	{
+	  if ((rte = insert_entry(node)) == NULL)
+	    return -1;
+	  rte->dst_ip = hi++;
+	}
+      bench_end(&op[1], BENCH_BATCH);
+
+      bench_begin(&op[2]);
+      for (i = 0; i < BENCH_BATCH; i++)
+	delete_entry(node, lo++);
+      bench_end(&op[2], BENCH_BATCH);
+    }
+
+  return 3;
+}
+
+/*
+ *   bench_prec
+ *
+ *   Description:
+ *     Precursor lists: add_precursor of a new neighbour to random
+ *     routes, then delete_precursor_from_all of it, as when a link to
+ *     it breaks. Every route has BENCH_PRECS precursors of its own.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - A fresh node.
+ *     int size               - Number of routes.
+ *     struct bench_op *op    - Where the results go.
+ *
+ *   Return:
+ *     int - Number of operations, -1 on error.
+*/
+int
+bench_prec(struct aodv_node *node, int size, struct bench_op *op)
+{
+  struct artentry **rtes;
+  u_int64_t start;
+  u_int32_t nbr = 1;
+  int i;
+  int j;
+
+  op[0].name = "add_precursor";
+  op[1].name = "delete_precursor_from_all";
+
+  if ((rtes = malloc(size * sizeof(struct artentry*))) == NULL)
+    return -1;
+
+  for (i = 0; i < size; i++)
+    {
+      if ((rtes[i] = insert_entry(node)) == NULL)
+	return -1;
+      rtes[i]->dst_ip = BENCH_NET + i;
+      for (j = 0; j < BENCH_PRECS; j++)
+	if (add_precursor(rtes[i], nbr++) == -1)
+	  return -1;
+    }
+
+  start = bench_time();
+  while (bench_time() - start < budget)
+    {
+      bench_begin(&op[0]);
+      for (i = 0; i < BENCH_BATCH; i++)
+	add_precursor(rtes[bench_random() % size], nbr);
+      bench_end(&op[0], BENCH_BATCH);
+
+      bench_begin(&op[1]);
+      delete_precursor_from_all(node, nbr);
+      bench_end(&op[1], 1);
+
+      nbr++;
+    }
+
+  free(rtes);
+
+  return 2;
+}
+
+/*
+ *   bench_pq
+ *
+ *   Description:
+ *     Timer queue: pq_insert at a random time, pq_getfirstofidflags of
+ *     a random queued id and pq_deleteidflags of the inserted ids.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - A fresh node.
+ *     int size               - Number of timers.
+ *     struct bench_op *op    - Where the results go.
+ *
+ *   Return:
+ *     int - Number of operations, -1 on error.
+*/
+int
+bench_pq(struct aodv_node *node, int size, struct bench_op *op)
+{
+  u_int64_t start;
+  u_int32_t id;
+  int i;
+
+  op[0].name = "pq_insert";
+  op[1].name = "pq_getfirstofidflags";
+  op[2].name = "pq_deleteidflags";
+
+  /* Latest first, each goes to the front */
+  for (i = size - 1; i >= 0; i--)
+    if (pq_insert(&node->pq, BENCH_NOW + 10 * i, NULL, BENCH_NET + i,
+		  PQ_PACKET_RREQ) == -1)
+      return -1;
+
+  id = BENCH_NET + size;
+  start = bench_time();
+  while (bench_time() - start < budget)
+    {
+      bench_begin(&op[0]);
+      for (i = 0; i < BENCH_BATCH; i++)
+	if (pq_insert(&node->pq, BENCH_NOW + bench_random() % (10 * size),
+		      NULL, id + i, PQ_PACKET_RREQ) == -1)
+	  return -1;
+      bench_end(&op[0], BENCH_BATCH);
+
+      bench_begin(&op[1]);
+      for (i = 0; i < BENCH_BATCH; i++)
+	pq_getfirstofidflags(&node->pq, BENCH_NET + bench_random() % size,
+			     PQ_PACKET_RREQ);
+      bench_end(&op[1], BENCH_BATCH);
+
+      bench_begin(&op[2]);
+      for (i = 0; i < BENCH_BATCH; i++)
+	pq_deleteidflags(&node->pq, id + i, PQ_PACKET_RREQ);
+      bench_end(&op[2], BENCH_BATCH);
+    }
+
+  return 3;
+}
+
+/*
+ *   bench_rreq
+ *
+ *   Description:
+ *     Route request list: find_rreq of a random entry and add_rreq of
+ *     a new one. The new entries are taken off the end again between
+ *     the batches, untimed.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - A fresh node.
+ *     int size               - Number of entries.
+ *     struct bench_op *op    - Where the results go.
+ *
+ *   Return:
+ *     int - Number of operations, -1 on error.
+*/
+int
+bench_rreq(struct aodv_node *node, int size, struct bench_op *op)
+{
+  struct rreq_entry *last;
+  struct rreq_entry *e;
+  u_int64_t start;
+  int i;
+  int k;
+
+  op[0].name = "find_rreq";
+  op[1].name = "add_rreq";
+
+  /* add_rreq walks to the end, the list is linked here instead */
+  last = node->rreq_header;
+  last->src_ip = BENCH_NET;
+  last->broadcast_id = 0;
+  last->lifetime = ~0ULL;
+  for (i = 1; i < size; i++)
+    {
+      if ((e = malloc(sizeof(struct rreq_entry))) == NULL)
+	return -1;
+      e->src_ip = BENCH_NET + i;
+      e->broadcast_id = i;
+      e->lifetime = ~0ULL;
+      e->prev = last;
+      e->next = NULL;
+      last->next = e;
+      last = e;
+    }
+
+  start = bench_time();
+  while (bench_time() - start < budget)
+    {
+      bench_begin(&op[0]);
+      for (i = 0; i < BENCH_BATCH; i++)
+	{
+	  k = bench_random() % size;
+	  find_rreq(node, BENCH_NET + k, k);
+	}
+      bench_end(&op[0], BENCH_BATCH);
+
+      bench_begin(&op[1]);
+      for (i = 0; i < BENCH_BATCH; i++)
+	if (add_rreq(node, BENCH_NET + size + i, 0, ~0ULL) == -1)
+	  return -1;
+      bench_end(&op[1], BENCH_BATCH);
+
+      while ((e = last->next) != NULL)
+	{
+	  last->next = e->next;
+	  free(e);
+	}
+    }
+
+  return 2;
+}
+
+/*
+ *   bench_run
+ *
+ *   Description:
+ *     Runs a benchmark at a size in a child process and prints its
+ *     results as JSON objects.
+ *
+ *   Arguments:
+ *     struct bench *b - The benchmark.
+ *     int size        - Table size.
+ *     int first       - 1 if nothing was printed before.
+ *
+ *   Return:
+ *     int - 0 if the child printed its results, else -1.
+*/
+int
+bench_run(struct bench *b, int size, int first)
+{
+  struct bench_op op[BENCH_MAXOPS];
+  struct aodv_node node;
+  struct rusage ru;
+  pid_t pid;
+  int status;
+  int n;
+  int i;
+
+  fflush(stdout);
+  if ((pid = fork()) == -1)
+    return -1;
+
+  if (pid > 0)
+    {
+      if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) ||
+	  WEXITSTATUS(status) != 0)
+	{
+	  fprintf(stderr, "aodv_bench: %s at %d failed\n", b->name, size);
+	  return -1;
+	}
+      return 0;
+    }
+
+  memset(op, 0, sizeof(op));
+  if (node_init(&node, htonl(0x0a000001)) == -1 ||
+      (n = b->run(&node, size, op)) == -1)
+    exit(1);
+
+  getrusage(RUSAGE_SELF, &ru);
+
+  for (i = 0; i < n; i++)
+    printf("%s    { \"bench\": \"%s\", \"op\": \"%s\", \"size\": %d, "
+	   "\"ops\": %llu, \"ns_per_op\": %.1f, \"allocs_per_op\": %.3f, "
+	   "\"peak_rss_kb\": %ld }", first && i == 0 ? "" : ",\n", b->name,
+	   op[i].name, size, (unsigned long long)op[i].ops,
+	   op[i].ops ? (double)op[i].ns / op[i].ops : 0.0,
+	   op[i].ops ? (double)op[i].allocs / op[i].ops : 0.0, ru.ru_maxrss);
+  fflush(stdout);
+
+  /* The tables die with the child */
+  exit(0);
+}
+
+/* ------------------------------------------------------------------- */
+
+int
+main(int argc, char *argv[])
+{
+  struct bench *b;
+  char *only = NULL;
+  int maxsize = 100000;
+  int first = 1;
+  int size;
+  int opt;
+  int ret = 0;
+
+  while ((opt = getopt(argc, argv, "n:t:b:")) != -1)
+    {
+      switch (opt)
+	{
+	case 'n':
+	  maxsize = atoi(optarg);
+	  break;
+
+	case 't':
+	  budget = strtoull(optarg, NULL, 10) * 1000000;
+	  break;
+
+	case 'b':
+	  only = optarg;
+	  break;
+
+	default:
+	  fprintf(stderr, "Usage: %s [-n size] [-t ms] [-b name]\n",
+		  argv[0]);
+	  exit(1);
+	}
+    }
+
+  if (maxsize < 10 || budget == 0)
+    {
+      fprintf(stderr, "%s: the size must be 10 or more and the time "
+	      "above 0\n", argv[0]);
+      exit(1);
+    }
+
+  /* Nothing expires while the clock stands still */
+  clock_source(CLOCK_SRC_VIRTUAL);
+  clock_set(BENCH_NOW);
+
+  printf("{\n  \"benchmarks\": [\n");
+  for (b = benches; b->name != NULL; b++)
+    {
+      if (only != NULL && strcmp(only, b->name) != 0)
+	continue;
+
+      for (size = 10; size <= maxsize; size *= 10)
+	{
+	  if (bench_run(b, size, first) == -1)
+	    ret = 1;
+	  else
+	    first = 0;
+	}
+    }
+  printf("\n  ]\n}\n");
+
+  return ret;
+}
@@ -0,0 +1,138 @@
+/*
+ *	FILE: aodv_bench.c
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ *      Usage:
+ *        aodv_bench [-n size] [-t ms] [-b name]
+ *
+ *        -n  Largest table size, sizes go from 10 up by factors of 10
+ *            (100000).
+ *        -t  Time spent on each benchmark and size in ms (200).
+ *        -b  Only run the benchmark of this name: rt, prec, pq or rreq.
+ *
+ ********************************
+ *
+ *	General description:
+ *      -------------------
+ *
+ * Microbenchmarks of the routing table, the precursor lists, the timer
+ * queue and the route request list, at table sizes from 10 up. Each
+ * benchmark and size runs in a child process of its own, so its peak
+ * RSS is its own. Prints JSON on stdout: for every operation and size
+ * the number of operations timed, ns/op, allocations/op and the peak
+ * RSS in KB.
+ *
+ *   rt    getentry of a random destination, insert_entry of a new one,
+ *         delete_entry of the oldest.
+ *   prec  add_precursor to random entries, delete_precursor_from_all
+ *         of that precursor.
+ *   pq    pq_insert at a random time, pq_getfirstofidflags of a random
+ *         id, pq_deleteidflags of the inserted ids.
+ *   rreq  find_rreq of a random entry, add_rreq of a new one.
+ *
+ * The tables are filled in O(size) before the timing starts: routes and
+ * timers are inserted so that each goes first, the route request list
+ * is linked directly. Calls to malloc from the code under test are
+ * counted through the linker (--wrap=malloc). The kernel route calls
+ * and net_send are replaced by stubs. The clock runs on its virtual
+ * source and stands still, so nothing expires.
+ *
+ *	Internal procedures:
+ *
+ * bench_time()
+ * bench_random()
+ * bench_begin()
+ * bench_end()
+ * bench_rt()
+ * bench_prec()
+ * bench_pq()
+ * bench_rreq()
+ * bench_run()
+ *
+ *	External procedures:
+ *
+ * __wrap_malloc()
+ * net_send()
+ * add_kroute()
+ * del_kroute()
+ * main()
+ *
+ ********************************
+ *
+ *   Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef AODV_BENCH_H
+#define AODV_BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "aodv.h"
+#include "info.h"
+#include "node.h"
+#include "RT.h"
+#include "timer.h"
+#include "rreq_list.h"
+#include "krtable.h"
+#include "clock.h"
+
+/* Operations between two readings of the clock */
+#define BENCH_BATCH 32
+
+/* Precursors each route starts with */
+#define BENCH_PRECS 2
+
+/* Largest number of operations of one benchmark */
+#define BENCH_MAXOPS 4
+
+/* Base of the addresses used as keys */
+#define BENCH_NET 0x0b000000
+
+/* The clock stands still here, in ms */
+#define BENCH_NOW 1000000
+
+/* Results of one operation */
+struct bench_op
+{
+  char *name;
+  u_int64_t ops;
+  u_int64_t ns;
+  u_int64_t allocs;
+};
+
+/* A benchmark */
+struct bench
+{
+  char *name;
+  int (*run)(struct aodv_node *node, int size, struct bench_op *op);
+};
+
+/* The real malloc, and the one the code under test calls */
+void *__real_malloc(size_t size);
+void *__wrap_malloc(size_t size);
+
+#endif
@@ -18,9 +18,15 @@
  *
  *
  *      Usage: 
- *        <aodv_daemon_X_xx "interface"> where "interface" indicates the 
- *        name of the interface to be used, as shown in the ifconfig listing.
- *        X_xx indicates the RCS version number.
+ *        <aodv_daemon_X_xx [-e] [-i] [-r hops] [-m] "interface"> where
+ *        "interface" indicates the name of the interface to be used, as
+ *        shown in the ifconfig listing. X_xx indicates the RCS version
+ *        number. With -e routes are chosen by the ETX of the first hop,
+ *        see neighbour.h. With -i data frames from and to neighbours
+ *        stand in for HELLOs, all nodes should then use -i. With -r
+ *        broken routes at most hops long are repaired locally, see
+ *        rerr.h, MAX_REPAIR_TTL is a good choice. With -m alternate next
+ *        hops are kept and take over when a link breaks, see RT.h.
  *       
  ********************************
  *
@@ -35,16 +41,25 @@
  * for processing. Incoming packets on the AODV port, and incoming events, 
  * are then dispatched to the corresponding event/packet-handling function. 
  *
+ * The main loop is the protocol stage of the daemon. Captured packets are
+ * parsed by the capture stage (packetcap.c) and kernel route changes and
+ * message logging are done by the sync stage (stage.c), each in a thread
+ * of its own and joined to the main loop by rings. See stage.h.
+ *
+ * The protocol state (routing table, timer queue, RREQ list) is kept in
+ * the struct aodv_node g_node, see node.h. Only its timer queue is tied
+ * to SIGALRM.
+ *
  *	Internal procedures:
  *
  * parse_arguments()
  * init_socket()
  * bind_socket()
  * get_interface_ip()
- * initialize_RT()
- * check_packet()
  * init_anc_message()
  * make_info_struct()
+ * stop_daemon()
+ * cleanup()
  *	
  *	External procedures:
  *
@@ -60,41 +75,84 @@
 
 #define MAXBUFLEN 1024
 
-struct artentry *g_my_entry;
-u_int32_t        g_my_ip;
-int              scanner_pid;
+struct aodv_node g_node;          /* The node run by the daemon */
 int              reboot_state = 0;
 
+/* Set by SIGINT, the main loop shuts the daemon down, see cleanup */
+volatile sig_atomic_t closing = 0;
+
 
 /* 
  * parse_arguments
  * ---------------
  *
  * Description: 
- *   Gets the name of the interface intended for use with the AODV-daemon.
+ *   Gets the name of the interface intended for use with the AODV-daemon,
+ *   the route metric, -e for METRIC_ETX, -i for implicit HELLOs, -r
+ *   for the longest route repaired locally, -m for multipath, -b for
+ *   the copies of a RREQ that stop its rebroadcast, -g for the gossip
+ *   percent and -o for relay mode.
  *
  * Arguments: 
  *   <argc> and <argv> directly from main().
+ *   <metric> where the metric is put.
+ *   <implicit> set to 1 with -i, else 0.
+ *   <repair_ttl> the hops given with -r, else 0.
+ *   <multipath> set to 1 with -m, else 0.
+ *   <fwd_limit> the copies given with -b, else 0.
+ *   <gossip> the percent given with -g, else 0.
+ *   <mpr> set to 1 with -o, else 0.
  *
  * Return: 
- *   Puts the only argument in <IF> if successful. 
- *   If not -1 is returned.
+ *   Puts the last argument in <IF> if successful. 
+ *   If not NULL is returned.
 */
 
 char* 
-parse_arguments (int argc, char *argv[])
+parse_arguments (int argc, char *argv[], int *metric, int *implicit,
+		 int *repair_ttl, int *multipath, int *fwd_limit,
+		 int *gossip, int *mpr)
 {
   char *IF;
-  
-  if (argc != 2)
-    /* Wrong number of arguments */
+  int i;
+  
+  *metric = METRIC_HOPS;
+  *implicit = 0;
+  *repair_ttl = 0;
+  *multipath = 0;
+  *fwd_limit = 0;
+  *gossip = 0;
+  *mpr = 0;
+  for (i = 1; i < argc - 1; i++)
+    {
+      if (strcmp(argv[i], "-e") == 0)
+	*metric = METRIC_ETX;
+      else if (strcmp(argv[i], "-i") == 0)
+	*implicit = 1;
+      else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc - 1)
+	*repair_ttl = atoi(argv[++i]);
+      else if (strcmp(argv[i], "-m") == 0)
+	*multipath = 1;
+      else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc - 1)
+	*fwd_limit = atoi(argv[++i]);
+      else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc - 1)
+	*gossip = atoi(argv[++i]);
+      else if (strcmp(argv[i], "-o") == 0)
+	*mpr = 1;
+      else
+	/* Unknown option */
+	return(NULL);
+    }
+
+  if (argc < 2 || argv[argc - 1][0] == '-')
+    /* No interface */
     return(NULL);
   
   /* Copy the interface from the command line */
-  if ((IF = malloc(strlen(argv[1]) * sizeof(char))) == NULL)
+  if ((IF = malloc((strlen(argv[argc - 1]) + 1) * sizeof(char))) == NULL)
     return(NULL);
 
-  strncpy(IF,argv[1],strlen(argv[1]));
+  strcpy(IF,argv[argc - 1]);
 
   return(IF);
 }
@@ -229,7 +287,6 @@ init_socket (char *IF)
  *   non-internet address in ecountered it's ignored. If the name 
  *   corresponding to <IF> is found <addr> is set accordingly. If no
  *   matching ip-address is found an error value is retuned. 
- *   Also sets the global variable g_my_ip.
  *
  * Arguments: 
  *   int fd - File descriptor specifies which socket should be checked 
@@ -276,9 +333,6 @@ get_interface_ip (int fd, char *IF, int port, struct sockaddr_in *addr)
 	continue;
     }
 
-  /* Sets global variable g_my_ip */
-  g_my_ip = addr->sin_addr.s_addr;
-  
   return (0);
 }
 
@@ -314,99 +368,6 @@ bind_socket (int fd, struct sockaddr_in *addr)
   return 0;  
 }
 
-/* 
- * check_packet
- * ------------
- *
- * Description:
- *   Checks the size of incoming packets and matches this with the stated 
- *   message type, and in the case of RERR with the number of error messages.
- *
- * Arguments:
- *   The number of bytes received <numbytes>, the packet type <type> and
- *   the number of unreachable destinations in an RERR packet <errcount>.
- *
- * Return:
- *   int - 0 if the packet is correct
- *        -1 if it's not.
- *
- */
-
-int 
-check_packet (int numbytes, int type, int errcount)
-{
-  switch (type) 
-    {
-    case 1: 
-      if (numbytes == 24)
-	return 0;
-      break;
-      
-    case 2: 
-      if (numbytes == 20) 
-	return 0;
-      break;
-      
-    case 3: 
-      if (numbytes == (4 + 8 * errcount)) 
-	return 0;
-      break;
-    
-    default: 
-      break;
-    }
-
-  return -1;
-}
-
-
-/* 
- * initialize_RT
- * -------------
- *
- * Description: 
- *   Initializes the routing table by calling init_rt(). Inserts entry to 
- *   the own node by setting the IP to my_addr. The destination sequence 
- *   number for this entry is used as source sequence number. Life time 
- *   is set to infinity,
- *   Also sets the global variable g_my_entry.
- *
- * Arguments: 
- *   My own address <addr> used to add my own entry.
- *
- * Return: 
- *   int - 0 if init_rt() and inert_entry() succeeds
- *         Otherwise -1 is returned.
- */
-int
-initialize_RT (struct sockaddr_in addr)
-{
-  struct artentry* rte;
-
-  if (init_rt() == -1)
-    /* Failed to initialize the routing table */
-    return(-1);
-  
-  if ((rte = insert_entry()) == NULL)
-    /* Couldn't create a new entry in the routing table */
-    return(-1);
-  
-  rte->dst_ip = addr.sin_addr.s_addr;
-  rte->dst_seq = 1;
-  rte->broadcast_id = 1;
-  rte->hop_cnt = 0;
-  rte->lst_hop_cnt = 0;
-
-  rte->nxt_hop = addr.sin_addr.s_addr;
-  rte->lifetime = -1;
-  rte->rt_flags = 0;
-  
-  /* Sets global variable <g_my_entry> : pointer to my entry */
-  g_my_entry = rte;
-  
-  return 0;
-}
-
 /* 
  * init_anc_message
  * ----------------
@@ -462,57 +423,51 @@ make_info_struct (struct sockaddr_in *ta, struct sockaddr_in *my,
   inf->ip_pkt_ttl = ttl;
 }
 
-/* 
- * start_HELLO
- * -----------
- * Description: 
- *   Initiates HELLO message sending by calling gen_rreq() with
- *   dst_ip = broadcast.
+/*
+ * stop_daemon
  *
- * Arguments: None
+ * Description:
+ *   Handles SIGINT. Only tells the main loop to shut down, the stages
+ *   may be in the middle of a ring operation. The select of the main
+ *   loop returns at the signal, or within a second if it arrives just
+ *   before.
  *
- * Return:
- *   int - Returns 0 if gen_rreq() ok 
- *         else return -1.
+ * Arguments:
+ *   int sig - Argument passed on by SIGINT
+ *
+ * Returns: void
  */
-
-int
-start_HELLO ()
+void
+stop_daemon (int sig)
 {
-  struct info inf;
-
-  inf.ip_pkt_dst_ip = inet_addr("255.255.255.255");
-  inf.ip_pkt_src_ip = g_my_ip;
-  inf.ip_pkt_my_ip = g_my_ip;
-  inf.ip_pkt_ttl = 1;
-  if (gen_rreq(&inf) == -1)
-    /* Couldn't generate the RREQ for HELLO */
-    return(-1);
-  
-  return 0;
+  closing = 1;
 }
 
 /*
  * cleanup
  *
  * Description:
- *   Cleans up the lock files
+ *   Shuts the daemon down from the main loop after SIGINT. Stops the
+ *   capture stage, lets the sync stage apply the queued kernel route
+ *   changes before the routes are removed and cleans up the lock files.
  *
- * Arguments:
- *   int dummy - Argument passed on by SIGINT
+ * Arguments: None
  *
  * Returns: void
  */
 void 
-cleanup (int dummy)
+cleanup ()
 {
+  int fd;
+
   printf("Closing down...\n");
-  kill(scanner_pid, SIGINT);
-  krt_cleanup();
+  packetcapturestop();
+  stage_sync_stop();
+  krt_cleanup(&g_node);
 
   remove("/var/lock/aodv_time");
-  dummy = open("/var/lock/aodv_time", (O_CREAT | O_WRONLY));
-  close(dummy);
+  fd = open("/var/lock/aodv_time", (O_CREAT | O_WRONLY));
+  close(fd);
   remove("/var/lock/aodv_lock");
 
   exit(0);
@@ -525,76 +480,72 @@ cleanup (int dummy)
  *   Makes sure the daemon waits enough time after reboot
  * 
  * Arguments:
- *   char *interface - which intreface the daemon should run on
+ *   struct aodv_node *node - The node.
  *   long wait - how long should it wait after reboot
  *   int aodvFD - file descriptor to the lock file
+ *   int pipeFD - file descriptor from packetcaptureinit
  *
  * Return: Void
  */
 void
-reboot_wait (char *interface, long wait, int aodvFD)
+reboot_wait (struct aodv_node *node, long wait, int aodvFD, int pipeFD)
 {
-  int pipeFD;
-  
   struct scanpac scanned_reboot;
   struct info info_msg_reboot;
   struct timeval tv_reboot;
   char buffer[MAXBUFLEN];
   fd_set readfds_reboot;
   int addr_len;
-  
-  switch (pipeFD = packetcaptureinit(interface))
-    {
-    case -1:
-      printf("Packet capture init. Reboot\n");
-      exit(1);
-      break;
-      
-    case -2:
-      printf("Fork failed. Reboot\n");
-      exit(1);
-      break;
-      
-    default:
-    }
+  int cap_pending;
 
   while((wait - time(NULL)) > 0)
     {
+      if (closing)
+	cleanup();
+
       tv_reboot.tv_sec = 1;
       tv_reboot.tv_usec = 1;
       
+      /* Don't sleep if the capture stage already queued packets */
+      if ((cap_pending = (packetcapturewait() == -1)))
+	tv_reboot.tv_sec = tv_reboot.tv_usec = 0;
+
       FD_ZERO(&readfds_reboot);
       FD_SET(pipeFD, &readfds_reboot); 
       FD_SET(aodvFD, &readfds_reboot);
       
       addr_len = sizeof(struct sockaddr);
 
-      if(select(pipeFD + 1, &readfds_reboot, NULL, NULL, &tv_reboot) >= 0)
+      if(select(MAX(pipeFD, aodvFD) + 1, &readfds_reboot, NULL, NULL,
+		&tv_reboot) >= 0)
 	{
-	  if (FD_ISSET(pipeFD, &readfds_reboot))
+	  clock_tick();
+
+	  if (cap_pending || FD_ISSET(pipeFD, &readfds_reboot))
 	    {
-	      /* Information from packet scanner arrived in pipe. Reboot mode
+	      /* Information from packet scanner arrived in ring. Reboot mode
 	       * ALL incoming data packets should result in an RERR.
 	       */
 	      
-	      read(pipeFD, &scanned_reboot, sizeof(struct scanpac));
-	      
-	      switch (scanned_reboot.type)
+	      while (packetcaptureread(&scanned_reboot) == 0)
 		{
-		case SP_TYPE_IP:
-		  /* Send RERR for all packets received except broadcast */
-		  if(scanned_reboot.ip != -1)
+		  switch (scanned_reboot.type)
 		    {
-		      wait = time(NULL) + DELETE_PERIOD / 1000;
+		    case SP_TYPE_IP:
+		      /* Send RERR for all packets received except broadcast */
+		      if(scanned_reboot.ip != -1)
+			{
+			  wait = time(NULL) + DELETE_PERIOD / 1000;
 		      
-		      info_msg_reboot.ip_pkt_dst_ip = scanned_reboot.ip;
-		      info_msg_reboot.ip_pkt_src_ip = g_my_ip;
-		      info_msg_reboot.ip_pkt_my_ip = g_my_ip;
-		      info_msg_reboot.ip_pkt_ttl = 1;
-		      host_unr(&info_msg_reboot,scanned_reboot.ip);
-		    }
-		  break;
-		} 
+			  info_msg_reboot.ip_pkt_dst_ip = scanned_reboot.ip;
+			  info_msg_reboot.ip_pkt_src_ip = node->my_ip;
+			  info_msg_reboot.ip_pkt_my_ip = node->my_ip;
+			  info_msg_reboot.ip_pkt_ttl = 1;
+			  host_unr(node, &info_msg_reboot,scanned_reboot.ip);
+			}
+		      break;
+		    } 
+		}
 	    }
 	  else if (FD_ISSET(aodvFD, &readfds_reboot))
 	    {
@@ -606,7 +557,6 @@ reboot_wait (char *interface, long wait, int aodvFD)
     }
   
   reboot_state = 0;
-  kill(scanner_pid, SIGKILL);
   
   return;
 }
@@ -622,7 +572,9 @@ main (int argc,char *argv[])
    * ---------------------------
    */
 
-  /* File descriptor for AODV, fd for packet scanner, IP-addresses */
+  /* The node, file descriptor for AODV, fd for packet scanner,
+     IP-addresses */
+  struct aodv_node *node = &g_node;
   struct sockaddr_in my_addr;
   struct sockaddr_in their_addr;
   char *interface;
@@ -632,6 +584,7 @@ main (int argc,char *argv[])
   /* Timer struct & file descriptor set for select */
   struct timeval tv;
   fd_set readfds;
+  int ready;
 
   /* Buffer for recvfrom() */
   char buffer[MAXBUFLEN];
@@ -648,30 +601,34 @@ main (int argc,char *argv[])
   struct a_in_pktinfo pktinfo;
   union control_union control_un;
 
-  /* Create aodv message types */
-  struct rerrhdr rerrhdr_msg;
-  struct rerr_unr_dst *tp;
-  struct rreq *rreq_msgp;
-  struct rrep *rrep_msgp;
-  u_int8_t aodv_type;
-  int rerri;
-
   /* Create info struct */
   struct info info_msg;
 
   /* Timer variables */
-  struct prioqent *timer_pqe;
   int timerFD;
 
   /* Io types */
   struct info io_info;
   char *iobuff;
 
-  /* Packet scanner pipe */
+  /* Packet scanner ring */
   struct artentry *scanned_rt;
   struct scanpac scanned;
+  int cap_pending;
   int pipeFD;
   int maxFD;
+  int scani;
+
+  /* METRIC_HOPS or METRIC_ETX, implicit HELLOs, local repair,
+     multipath, the RREQ forward limit, gossip and relay mode */
+
+  int metric;
+  int implicit;
+  int repair_ttl;
+  int multipath;
+  int fwd_limit;
+  int gossip;
+  int mpr;
 
   /* Print RT */
   
@@ -693,9 +650,12 @@ main (int argc,char *argv[])
    * ---------------------------
    */
 
-  if ((interface = parse_arguments(argc, argv)) == NULL)
+  if ((interface = parse_arguments(argc, argv, &metric, &implicit,
+				   &repair_ttl, &multipath, &fwd_limit,
+				   &gossip, &mpr)) == NULL)
     {
-      printf("Usage: aodv_daemon <interface>\n");
+      printf("Usage: aodv_daemon [-e] [-i] [-r hops] [-m] [-b copies] "
+	     "[-g percent] [-o] <interface>\n");
       exit(1);
     }
 
@@ -711,17 +671,10 @@ main (int argc,char *argv[])
     exit(1);
   }
 
-  /* Init Timer queue */
-  if ((timerFD = pq_new()) == -1)
+  /* Get the socket used for kernel route changes */
+  if ((krt = init_rtsocket()) == -1)
     {
-      printf("Error initializing timer queue\n");
-      exit(1);
-    }
-  
-  /* Init RREQ list */
-  if (init_rreq_list() == -1)
-    {
-      printf("Error initilizing RREQ list\n");
+      printf("Error getting kernel routing socket\n");
       exit(1);
     }
 
@@ -740,23 +693,72 @@ main (int argc,char *argv[])
       exit(1);
     }
   
-  /* Get ip of interface card and create the my_addr struct. 
-     Also set g_my_ip. */
+  /* Get ip of interface card and create the my_addr struct. */
   if (get_interface_ip(aodvFD, interface, AODVPORT, &my_addr) == -1)
     {
       printf("Error getting Interface IP\n");
       exit(1);
     }
   
-  /* Initalize RT. Create my_entry, and dummy entry  */
-  if (initialize_RT(my_addr) == -1)
+  /* Start the flight recorder, SIGUSR1 dumps it */
+  if (flight_init(my_addr.sin_addr.s_addr) == -1)
+    printf("Couldn't open %s, events can't be dumped\n", FLIGHT_FILE);
+
+  /* Protocol time is read once per pass of the main loop and per
+     timer signal */
+  clock_source(CLOCK_SRC_TICK);
+
+  /* Initalize the node: RT with my_entry, and the RREQ list */
+  if (node_init(node, my_addr.sin_addr.s_addr) == -1)
     {
       printf("Error initializing routing table\n");
       exit(1);
     }
+  node->metric = metric;
+  node->repair_ttl = repair_ttl;
+  node->multipath = multipath;
+  node->fwd_limit = fwd_limit;
+  node->gossip = gossip;
+  node->mpr = mpr;
+
+  /* Init Timer queue of the node */
+  if ((timerFD = pq_new(&node->pq)) == -1)
+    {
+      printf("Error initializing timer queue\n");
+      exit(1);
+    }
+
+#ifdef LOGMSG
+  /* Create the control traffic trace */
+  if (logmsg_init(interface, node->my_ip) == -1)
+    printf("Couldn't create %s, messages are not logged\n", LOG_FILE);
+#endif
+
+  /* Start the sync stage, kernel routes and logging */
+  if (stage_sync_start() == -1)
+    {
+      printf("Error starting sync stage\n");
+      exit(1);
+    }
+
+  /* Initialize packet capture */
+  switch (pipeFD = packetcaptureinit(interface, node->my_ip, implicit))
+    {
+    case -1:
+      printf("Error initializing packet capture\n");
+      exit(1);
+      break;
+      
+    case -2:
+      printf("Couldn't start capture stage.\n");
+      exit(1);
+      break;
+      
+    default:
+    }
 
   /* Check if the daemon has crashed, or if a wait-state is necessary. */
-  signal(SIGINT, (void*)cleanup);
+  signal(SIGINT, (void*)stop_daemon);
   if ((lockFD = open("/var/lock/aodv_lock",
 		     (O_RDONLY | O_CREAT | O_EXCL ))) == -1 )
     {
@@ -776,31 +778,15 @@ main (int argc,char *argv[])
     }   
   
   if (reboot_state)
-    reboot_wait(interface, reboot_time, aodvFD);
+    reboot_wait(node, reboot_time, aodvFD, pipeFD);
   
   /* Starting HELLO-message timer */
-  if (start_HELLO(info_msg) == -1)
+  if (node_hello(node) == -1)
     {
       printf("Error starting HELLO\n");
       exit(1);
     }
 
-  /* Initialize packet capture */
-  switch (pipeFD = packetcaptureinit(interface))
-    {
-    case -1:
-      printf("Error initializing packet capture\n");
-      exit(1);
-      break;
-      
-    case -2:
-      printf("Fork failed.\n");
-      exit(1);
-      break;
-      
-    default:
-    }
-  
   /* get the largest FD for select */
   maxFD = MAX ( MAX(aodvFD, timerFD), MAX(IO_FD, pipeFD)); 
   
@@ -816,12 +802,12 @@ main (int argc,char *argv[])
   while(1)
     {      
       
-      find_inactives();
+      find_inactives(node);
 
       if( next_print < getcurrtime() )
 	{
 	  next_print = getcurrtime() + SECOND * 2;
-	  print_rt();
+	  print_rt(node);
 	}
 
       addr_len = sizeof(struct sockaddr);
@@ -835,6 +821,10 @@ main (int argc,char *argv[])
       /* Set the timer struct used by select & add aodvFD to readFDset */
       tv.tv_sec = 1;
       tv.tv_usec = 1;
+
+      /* Don't sleep if the capture stage already queued packets */
+      if ((cap_pending = (packetcapturewait() == -1)))
+	tv.tv_sec = tv.tv_usec = 0;
       FD_ZERO(&readfds);
       FD_SET(aodvFD, &readfds); 
       FD_SET(timerFD, &readfds);
@@ -843,7 +833,16 @@ main (int argc,char *argv[])
       
       /* Wait until packet arrives or timer has run out! 
 	 If select returns -1, a timer has expired. */
-      if(select(maxFD + 1, &readfds, NULL, NULL, &tv) >= 0)
+      ready = select(maxFD + 1, &readfds, NULL, NULL, &tv);
+
+      if (closing)
+	cleanup();
+
+      /* Everything done in this pass sees this tick, unless a timer
+	 signal takes another in the middle of it, see pq_signal */
+      clock_tick();
+
+      if (ready >= 0)
 	{
 	  /* Check if aodvFD has received a packet, or was it a timeout? */
 	  if (FD_ISSET(aodvFD, &readfds))
@@ -903,104 +902,15 @@ main (int argc,char *argv[])
 			       received_ttl, &info_msg);
 	      
 #ifdef LOGMSG
-	      logmsg(buffer, numbytes, &info_msg);
+	      logmsg(buffer, numbytes, &info_msg, LOG_DIR_IN);
 #endif
 	      
-	      /* What type of aodv message? */
-	      aodv_type = (int)buffer[0];
-	      switch (aodv_type)
-		{
-		case RREQ:
-		  /* RREQ */
-		  /* Cast to struct rreq */
-		  if (check_packet(numbytes, aodv_type, 0) == -1)
-		    break;
-		  
-		  rreq_msgp = (struct rreq*)buffer;
-		  
-		  rec_rreq(&info_msg, rreq_msgp);
-		  break;
-		  /* case 1 */
-		  
-		case RREP:
-		  /* RREP */
-		  /* Cast to struct rrep */
-		  if (check_packet(numbytes, aodv_type, 0) == -1)
-		    break;
-		  
-		  rrep_msgp = (struct rrep*)buffer;
-		  rec_rrep(&info_msg, rrep_msgp);
-		  break;
-		  /* case 2 */
-		  
-		case RERR:
-		  /* RERR */
-		  /* Create header */
-		  /* Must know the number of unreachable destinations 
-		     before checking! */
-		  
-		  rerrhdr_msg.type = (u_int8_t)buffer[0];
-		  rerrhdr_msg.reserved = (u_int16_t)buffer[1];
-		  rerrhdr_msg.dst_cnt = (u_int8_t)buffer[3];
-		  if (check_packet(numbytes, aodv_type,
-				   rerrhdr_msg.dst_cnt) == -1)
-		    break;
-		  
-		  /* Make space for dest_count structs, and assign them.
-		   * This is a linked list of structs. The corresponding
-		   * data from <buffer> is copied with memcopy. */
-		  
-		  rerrhdr_msg.unr_dst = NULL;
-		  for (rerri = 0; rerri < rerrhdr_msg.dst_cnt; rerri++)
-		    {
-		      if ((tp = (struct rerr_unr_dst*) 
-			   malloc(sizeof(struct rerr_unr_dst))) == NULL)
-			{
-			  break; /* Skip to next package */
-			}
-		      
-		      tp->next = rerrhdr_msg.unr_dst;
-		      rerrhdr_msg.unr_dst = tp;
-		      memcpy((void *)&(tp->unr_dst_ip), 
-			     (void *)&(buffer[4 + rerri * 8]), 4);
-		      memcpy((void *)&(tp->unr_dst_seq), 
-			     (void *)&(buffer[4 + rerri * 8+ 4 ]), 4);
-		    }
-		  
-		  rec_rerr(&info_msg, &rerrhdr_msg);
-		  
-		  /* Free the list of structs that was sent to rec_rerr() */
-		  for (rerri = 0; rerri < rerrhdr_msg.dst_cnt; rerri++)
-		    {
-		      tp = rerrhdr_msg.unr_dst;
-		      rerrhdr_msg.unr_dst = rerrhdr_msg.unr_dst -> next;
-		      free(tp);
-		    }
-		  break;
-		  
-		default:
-		  /* Unknown message received on aodv-port */
-		  
-		} 
+	      node_recv(node, &info_msg, buffer, numbytes);
 	    } 
 	  
 	  else if (FD_ISSET(timerFD, &readfds))
 	    {
-	      timer_pqe = pq_readpipe();
-	      switch (timer_pqe->flags)
-		{
-		case PQ_PACKET_RREQ:
-		  if (rreq_timeout(timer_pqe->data) == -1)
-		    free(timer_pqe); /* Queue entry */
-		  break;
-		  
-		case PQ_PACKET_HELLO:
-		  hello_resend(timer_pqe->data);
-		  break;
-		  
-		default:
-		  break;
-		}
+	      node_timer(node, pq_readpipe(&node->pq));
 	    }
 	  
 	  else if (FD_ISSET(IO_FD, &readfds))
@@ -1012,48 +922,66 @@ main (int argc,char *argv[])
 		{
 		  io_info.ip_pkt_src_ip = my_addr.sin_addr.s_addr;
 		  io_info.ip_pkt_my_ip = my_addr.sin_addr.s_addr;
-		  io_parse(iobuff, &io_info);
+		  io_parse(node, iobuff, &io_info);
 		}
 	    }
 	  
-	  else if (FD_ISSET(pipeFD, &readfds))
+	  else if (cap_pending || FD_ISSET(pipeFD, &readfds))
 	    {
-	      /* Information from packet scanner arrived in pipe */
-	      
-	      read(pipeFD, &scanned, sizeof(struct scanpac));
+	      /* Information from packet scanner arrived in ring. Take at
+		 most CAP_BATCH packets so a burst of captured traffic
+		 can't starve the other sources. */
 	      
-	      switch (scanned.type)
+	      for (scani = 0; scani < CAP_BATCH && 
+		     packetcaptureread(&scanned) == 0; scani++)
 		{
-		case SP_TYPE_IP:
-		  if (scanned.ip != g_my_ip)
+		  switch (scanned.type)
 		    {
-		      if ((scanned_rt = getentry(scanned.ip)) != NULL)
-			scanned_rt->lifetime = MAX(scanned_rt->lifetime, 
-						   getcurrtime() + 
-						   ACTIVE_ROUTE_TIMEOUT);
-		    }
-		  break;
+		    case SP_TYPE_IP:
+		      if (scanned.ip != node->my_ip)
+			{
+			  /* Data for a route that link_break left to be
+			     repaired, the data itself is lost */
+			  local_repair(node, scanned.ip);
+
+			  if ((scanned_rt = getentry(node, scanned.ip)) != NULL)
+			    scanned_rt->lifetime = MAX(scanned_rt->lifetime, 
+						       getcurrtime() + 
+						       ACTIVE_ROUTE_TIMEOUT);
+			}
+		      break;
 		  
-		case SP_TYPE_ARP:
-		  scanned_rt = getentry(scanned.ip);
-		  if (scanned_rt == NULL || scanned_rt->hop_cnt == 255)
-		    {
+		    case SP_TYPE_ARP:
+		      scanned_rt = getentry(node, scanned.ip);
+		      if (scanned_rt == NULL || scanned_rt->hop_cnt == 255)
+			{
+			  info_msg.ip_pkt_dst_ip = scanned.ip;
+			  info_msg.ip_pkt_src_ip = node->my_ip;
+			  info_msg.ip_pkt_my_ip = node->my_ip;
+			  info_msg.ip_pkt_ttl = 1;
+			  gen_rreq(node, &info_msg);
+			}
+		      break;
+		  
+		    case SP_TYPE_ICMP:
 		      info_msg.ip_pkt_dst_ip = scanned.ip;
-		      info_msg.ip_pkt_src_ip = g_my_ip;
-		      info_msg.ip_pkt_my_ip = g_my_ip;
+		      info_msg.ip_pkt_src_ip = node->my_ip;
+		      info_msg.ip_pkt_my_ip = node->my_ip;
 		      info_msg.ip_pkt_ttl = 1;
-		      gen_rreq(&info_msg);
+		      if (local_repair(node, scanned.ip) == -1 &&
+			  pq_getfirstofidflags(&node->pq, scanned.ip, 
+					       PQ_PACKET_RREQ) == NULL)
+			host_unr(node, &info_msg, scanned.ip);
+		      break;
+
+		    case SP_TYPE_HEARD:
+		      hello_heard(node, scanned.ip);
+		      break;
+
+		    case SP_TYPE_SENT:
+		      nb_sent(node, scanned.ip);
+		      break;
 		    }
-		  break;
-		  
-		case SP_TYPE_ICMP:
-		  info_msg.ip_pkt_dst_ip = scanned.ip;
-		  info_msg.ip_pkt_src_ip = g_my_ip;
-		  info_msg.ip_pkt_my_ip = g_my_ip;
-		  info_msg.ip_pkt_ttl = 1;
-		  if (pq_getfirstofidflags(scanned.ip, 
-					   PQ_PACKET_RREQ) == NULL)
-		    host_unr(&info_msg, scanned.ip);
 		}
 	    } 
 	  
@@ -18,9 +18,15 @@
  *
  *
  *      Usage: 
- *        <aodv_daemon_X_xx "interface"> where "interface" indicates the 
- *        name of the interface to be used, as shown in the ifconfig listing.
- *        X_xx indicates the RCS version number.
+ *        <aodv_daemon_X_xx [-e] [-i] [-r hops] [-m] "interface"> where
+ *        "interface" indicates the name of the interface to be used, as
+ *        shown in the ifconfig listing. X_xx indicates the RCS version
+ *        number. With -e routes are chosen by the ETX of the first hop,
+ *        see neighbour.h. With -i data frames from and to neighbours
+ *        stand in for HELLOs, all nodes should then use -i. With -r
+ *        broken routes at most hops long are repaired locally, see
+ *        rerr.h, MAX_REPAIR_TTL is a good choice. With -m alternate next
+ *        hops are kept and take over when a link breaks, see RT.h.
  *       
  ********************************
  *
@@ -41,8 +47,6 @@
  * init_socket()
  * bind_socket()
  * get_interface_ip()
- * initialize_RT()
- * check_packet()
  * init_anc_message()
  * make_info_struct()
  *	
@@ -88,9 +92,17 @@
 #include "uio.h"
 #include "logmsg.h"
 #include "packetcap.h"
+#include "stage.h"
+#include "flight.h"
+#include "node.h"
+#include "neighbour.h"
+#include "hello.h"
 
 #define PRINT_RT_INTERVAL 2000
 
+/* Max number of captured packets handled per pass of the main loop */
+#define CAP_BATCH 64
+
 struct a_in_pktinfo
 {
   unsigned int   ipi_ifindex;  /* Interface index */
@@ -0,0 +1,396 @@
+#!/bin/bash
+#
+#	FILE: aodv_netbed.sh
+#
+#
+# Mad-hoc by
+#
+# Fredrik Lilieblad
+# Oskar Mattsson
+# Petra Nylund
+# Dan Ouchterlony
+# Anders Roxenhag
+#
+# Released 2000-05-27
+# This software is Open Source under the GNU General Public Licence.
+#
+# Mail : mad-hoc@flyinglinux.net
+# WWW  : mad-hoc.flyinglinix.net
+#
+#
+#      Usage:
+#        aodv_netbed.sh [-n nodes] [-T chain|star|grid] [-l delay]
+#                       [-L loss] [-r discoveries] [-k]
+#
+#        -n  Number of nodes (5).
+#        -T  How the nodes are linked (chain).
+#        -l  Delay of each link in ms, added by netem (5).
+#        -L  Loss of each link in percent, added by netem (0).
+#        -r  Number of route discoveries timed (3).
+#        -k  Keep the namespaces and the work directory afterwards.
+#
+########################################
+#
+#	General description:
+#      -------------------
+#
+# Runs real aodv_daemons on one host, each in a network namespace of
+# its own, and measures them end to end. Needs root, a kernel with
+# network namespaces and bridge port isolation (4.18 or later), ip, tc,
+# bridge and ping. 'make netbed' runs it with the defaults.
+#
+# Every node has a bridge br0 with its address, 10.99.0.1 and up, in
+# 10.99.0.0/16. A link between two nodes is a veth pair with one end in
+# each bridge. The bridge ports are isolated, so a frame only reaches
+# the node at the other end of the veth and is never passed on: as with
+# a radio, a node hears its neighbours only. netem adds delay and loss
+# on each end. The daemons run on br0, each with a private /var/lock
+# and in a directory of its own where it writes its trace.
+#
+# Three things are measured:
+#
+#   Discovery  node A starts pinging node B, the time until the route
+#              to B is in the kernel table of A. Repeated for -r pairs,
+#              the first one as far apart as the topology allows.
+#   Recovery   while A pings B every 50 ms the link from A to its next
+#              hop is cut (netem loss 100%, the carrier stays up as
+#              with a radio). The times until the old route is gone,
+#              until a new one is installed and the longest gap
+#              between ping replies.
+#   Overhead   the traces of all daemons are merged by aodv_analyze,
+#              whose report is printed, and the RREQs, RREPs and RERRs
+#              sent per established route are worked out from it.
+#
+########################################
+#
+#   Extendend RCS Info: $Id$
+#
+
+NODES=5
+TOPO=chain
+DELAY=5
+LOSS=0
+DISCS=3
+KEEP=0
+
+PREFIX=aodvbed
+NET=10.99
+DIR=$(cd "$(dirname "$0")" && pwd)
+WORK=$(mktemp -d /tmp/aodv_netbed.XXXXXX)
+
+# Pairs of linked nodes, "i j" per line
+LINKS=""
+
+usage ()
+{
+    echo "Usage: $0 [-n nodes] [-T chain|star|grid] [-l delay] [-L loss]" >&2
+    echo "       [-r discoveries] [-k]" >&2
+    exit 1
+}
+
+# Time in ms since the epoch
+now_ms ()
+{
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+# Address of node $1
+addr ()
+{
+    echo "$NET.$(( $1 / 250 )).$(( $1 % 250 + 1 ))"
+}
+
+# Runs the rest of the arguments in the namespace of node $1
+nsx ()
+{
+    local n=$1
+    shift
+    ip netns exec "$PREFIX$n" "$@"
+}
+
+# Gateway of the kernel route from node $1 to node $2, empty if there is
+# none. A route to a neighbour has the neighbour itself as gateway.
+route_of ()
+{
+    nsx "$1" ip -4 route show "$(addr "$2")/32" 2>/dev/null |
+	awk '{ for (i = 1; i < NF; i++) if ($i == "via") { print $(i+1);
+	       exit } } NF > 0 { print $1; exit }'
+}
+
+# Fills LINKS with the links of the topology
+make_links ()
+{
+    local i side
+
+    case $TOPO in
+	chain)
+	    for (( i = 0; i + 1 < NODES; i++ )); do
+		LINKS+="$i $(( i + 1 ))"$'\n'
+	    done
+	    ;;
+	star)
+	    for (( i = 1; i < NODES; i++ )); do
+		LINKS+="0 $i"$'\n'
+	    done
+	    ;;
+	grid)
+	    side=1
+	    while (( side * side < NODES )); do
+		side=$(( side + 1 ))
+	    done
+	    for (( i = 0; i < NODES; i++ )); do
+		if (( i % side + 1 < side && i + 1 < NODES )); then
+		    LINKS+="$i $(( i + 1 ))"$'\n'
+		fi
+		if (( i + side < NODES )); then
+		    LINKS+="$i $(( i + side ))"$'\n'
+		fi
+	    done
+	    ;;
+	*)
+	    usage
+	    ;;
+    esac
+}
+
+# Creates the namespaces, bridges and links
+bed_setup ()
+{
+    local i j v
+
+    for (( i = 0; i < NODES; i++ )); do
+	ip netns add "$PREFIX$i" || return 1
+	nsx $i ip link set lo up
+	nsx $i ip link add br0 type bridge
+	nsx $i ip addr add "$(addr $i)/16" dev br0
+	nsx $i ip link set br0 up
+	nsx $i ip route add 255.255.255.255/32 dev br0
+	nsx $i sysctl -qw net.ipv4.ip_forward=1
+	# Forwarding out of the interface a packet came in on is normal
+	# here, redirects would bypass AODV
+	nsx $i sysctl -qw net.ipv4.conf.all.send_redirects=0
+	nsx $i sysctl -qw net.ipv4.conf.br0.send_redirects=0
+	nsx $i sysctl -qw net.ipv4.conf.all.accept_redirects=0
+	mkdir -p "$WORK/node$i"
+    done
+
+    while read -r i j; do
+	[ -n "$i" ] || continue
+	ip link add "v$i-$j" netns "$PREFIX$i" type veth \
+	    peer name "v$j-$i" netns "$PREFIX$j" || return 1
+	for v in "$i v$i-$j" "$j v$j-$i"; do
+	    set -- $v
+	    nsx $1 ip link set "$2" master br0
+	    nsx $1 bridge link set dev "$2" isolated on || return 1
+	    nsx $1 tc qdisc add dev "$2" root netem delay "${DELAY}ms" \
+		loss "${LOSS}%"
+	    nsx $1 ip link set "$2" up
+	done
+    done <<< "$LINKS"
+}
+
+# Starts a daemon on every node
+bed_start ()
+{
+    local i lock
+
+    # The daemons read commands from stdin, a fifo that stays open and
+    # quiet while this script runs
+    mkfifo "$WORK/stdin"
+    exec 3<> "$WORK/stdin"
+
+    lock=$(readlink -f /var/lock)
+    for (( i = 0; i < NODES; i++ )); do
+	( cd "$WORK/node$i" &&
+	  exec ip netns exec "$PREFIX$i" unshare -m sh -c \
+	      "mount -t tmpfs none $lock && exec '$DIR/aodv_daemon' br0" \
+	      < "$WORK/stdin" > daemon.out 2>&1 ) &
+    done
+
+    # Let the HELLOs find the neighbours
+    sleep 4
+}
+
+# Stops everything running in the namespaces, the daemons flush their
+# traces on SIGINT
+bed_stop ()
+{
+    local i pids=""
+
+    for (( i = 0; i < NODES; i++ )); do
+	pids+=" $(ip netns pids "$PREFIX$i" 2>/dev/null)"
+    done
+    [ -n "${pids// /}" ] || return
+    kill -INT $pids 2>/dev/null
+    sleep 2
+    kill -KILL $pids 2>/dev/null
+}
+
+# Removes everything bed_setup created
+bed_teardown ()
+{
+    local i
+
+    bed_stop
+    if (( KEEP )); then
+	echo "Kept the namespaces $PREFIX* and $WORK"
+	return
+    fi
+    for (( i = 0; i < NODES; i++ )); do
+	ip netns del "$PREFIX$i" 2>/dev/null
+    done
+    rm -rf "$WORK"
+}
+
+# Times the discovery of a route from node $1 to node $2, prints ms or
+# "failed"
+discover ()
+{
+    local t0 t1 pid
+
+    t0=$(now_ms)
+    nsx "$1" ping -q -i 0.2 -w 10 "$(addr "$2")" > /dev/null 2>&1 &
+    pid=$!
+    while [ -z "$(route_of "$1" "$2")" ]; do
+	if (( $(now_ms) - t0 > 10000 )); then
+	    kill $pid 2>/dev/null
+	    echo failed
+	    return 1
+	fi
+	sleep 0.005
+    done
+    t1=$(now_ms)
+    kill $pid 2>/dev/null
+    wait $pid 2>/dev/null
+    echo $(( t1 - t0 ))
+}
+
+# Sets the loss of the link between nodes $1 and $2 to $3 percent
+link_loss ()
+{
+    nsx "$1" tc qdisc change dev "v$1-$2" root netem delay "${DELAY}ms" \
+	loss "$3%"
+    nsx "$2" tc qdisc change dev "v$2-$1" root netem delay "${DELAY}ms" \
+	loss "$3%"
+}
+
+# Cuts the link from node $1 to its next hop towards node $2 and times
+# the repair
+recover ()
+{
+    local a=$1 b=$2 gw hop t0 t_gone="" t_new="" cur pid gap
+
+    if [ "$(discover $a $b)" = failed ]; then
+	echo "  No route from $(addr $a) to $(addr $b) to cut"
+	return
+    fi
+
+    nsx $a ping -D -i 0.05 -w 30 "$(addr $b)" > "$WORK/ping.out" 2>&1 &
+    pid=$!
+    sleep 2
+
+    gw=$(route_of $a $b)
+    hop=$(( $(echo "$gw" | awk -F. '{ print $3 * 250 + $4 - 1 }') ))
+    if ! grep -qx "$a $hop\|$hop $a" <<< "$LINKS"; then
+	echo "  Next hop $gw of $(addr $a) is not a neighbour"
+	kill $pid 2>/dev/null
+	return
+    fi
+
+    echo "  Cutting $(addr $a) - $gw on the route to $(addr $b)"
+    t0=$(now_ms)
+    link_loss $a $hop 100
+
+    while (( $(now_ms) - t0 < 20000 )); do
+	cur=$(route_of $a $b)
+	if [ -z "$t_gone" ] && [ "$cur" != "$gw" ]; then
+	    t_gone=$(( $(now_ms) - t0 ))
+	fi
+	if [ -n "$cur" ] && [ "$cur" != "$gw" ]; then
+	    t_new=$(( $(now_ms) - t0 ))
+	    break
+	fi
+	sleep 0.005
+    done
+
+    sleep 1
+    kill $pid 2>/dev/null
+    wait $pid 2>/dev/null
+    link_loss $a $hop "$LOSS"
+
+    # Longest gap between two replies after the cut
+    gap=$(awk -v t0="$t0" '/bytes from/ { t = substr($1, 2) * 1000;
+	  if (t >= t0 && last != "" && t - last > gap) gap = t - last;
+	  last = t } END { printf "%d", gap }' "$WORK/ping.out")
+
+    echo "  Old route gone after: ${t_gone:-never} ms"
+    echo "  New route after:      ${t_new:-never} ms"
+    echo "  Longest gap between replies: $gap ms"
+}
+
+while getopts "n:T:l:L:r:k" opt; do
+    case $opt in
+	n) NODES=$OPTARG ;;
+	T) TOPO=$OPTARG ;;
+	l) DELAY=$OPTARG ;;
+	L) LOSS=$OPTARG ;;
+	r) DISCS=$OPTARG ;;
+	k) KEEP=1 ;;
+	*) usage ;;
+    esac
+done
+
+if (( NODES < 2 || NODES > 1000 )); then
+    echo "$0: between 2 and 1000 nodes" >&2
+    exit 1
+fi
+if [ "$(id -u)" != 0 ]; then
+    echo "$0: must be run as root" >&2
+    exit 1
+fi
+for tool in ip tc bridge ping unshare; do
+    if ! command -v $tool > /dev/null; then
+	echo "$0: $tool is missing" >&2
+	exit 1
+    fi
+done
+if [ ! -x "$DIR/aodv_daemon" ] || [ ! -x "$DIR/aodv_analyze" ]; then
+    echo "$0: build aodv_daemon and aodv_analyze first" >&2
+    exit 1
+fi
+
+make_links
+trap bed_teardown EXIT
+
+echo "Nodes: $NODES  Topology: $TOPO  Delay: $DELAY ms  Loss: $LOSS%"
+bed_setup || exit 1
+bed_start
+
+# The first pair is the farthest apart, the others move inwards
+echo
+echo "Route discovery, ms"
+for (( k = 0; k < DISCS; k++ )); do
+    a=$(( k % NODES ))
+    b=$(( NODES - 1 - k % NODES ))
+    [ "$TOPO" = star ] && (( a == 0 )) && a=1
+    if (( a == b )); then
+	b=$(( (b + 1) % NODES ))
+    fi
+    echo "  $(addr $a) -> $(addr $b): $(discover $a $b)"
+done
+
+echo
+echo "Route recovery"
+if [ "$TOPO" = star ]; then
+    recover 1 $(( NODES - 1 ))
+else
+    recover 0 $(( NODES - 1 ))
+fi
+
+bed_stop
+echo
+"$DIR/aodv_analyze" "$WORK"/node*/aodv.trace | tee "$WORK/analyze.out"
+awk '/Succeeded:/ { ok = $2 }
+     /^  (RREQ|RREP|RERR) +messages:/ { msgs += $3 }
+     END { if (ok > 0) printf "\nRREQ, RREP and RERR per established " \
+			      "route: %.1f\n", msgs / ok }' "$WORK/analyze.out"
@@ -0,0 +1,691 @@
+/*
+ *	FILE: aodv_replay.c
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ *      Usage:
+ *        aodv_replay [-n messages] [-N nodes] [-k neighbours] [-i us]
+ *                    [-m rreq:rrep:rerr] [-s seed] [trace]
+ *
+ *        -n  Number of messages generated (100000).
+ *        -N  Number of nodes the messages are about (1000).
+ *        -k  Number of neighbours they come from (8).
+ *        -i  Time between two messages in us (200).
+ *        -m  Mix of the generated messages in percent (60:30:10).
+ *        -s  Seed of the generator (1).
+ *
+ *        With a trace the messages the traced node received are
+ *        replayed instead, at the times they were received.
+ *
+ ********************************
+ *
+ *	General description:
+ *      -------------------
+ *
+ * Feeds a stream of AODV messages, each with its struct info, straight
+ * into rec_rreq, rec_rrep and rec_rerr of one node, and measures the
+ * CPU time the protocol code spends on each. The stream is read from a
+ * trace written by the daemon or generated: RREQs from random nodes
+ * for random destinations, RREPs back to the nodes that asked, RERRs
+ * for a few destinations at a time, all forwarded by random neighbours.
+ *
+ * Only the protocol code is timed. net_send and the kernel route calls
+ * are replaced by stubs that count, the clock runs on its virtual
+ * source and follows the times of the messages. Timers that fall due
+ * and the sweep of find_inactives are run between the messages and
+ * timed on their own.
+ *
+ * Prints the messages handled per second of protocol CPU, a latency
+ * histogram of each message type and the messages sent and kernel
+ * route changes per handled message.
+ *
+ *	Internal procedures:
+ *
+ * replay_time()
+ * replay_random()
+ * replay_gen()
+ * replay_read()
+ * replay_handle()
+ * replay_advance()
+ * replay_report()
+ *
+ *	External procedures:
+ *
+ * net_send()
+ * add_kroute()
+ * del_kroute()
+ * main()
+ *
+ ********************************
+ *
+ *   Extendend RCS Info: $Id$
+ *
+ */
+
+#include "aodv_replay.h"
+
+/* Pre-declaration of internal functions */
+u_int64_t replay_time();
+u_int64_t replay_random();
+int replay_gen(struct replay_msg *m);
+int replay_read(struct replay_msg *m);
+void replay_handle(struct aodv_node *node, struct replay_msg *m);
+void replay_advance(struct aodv_node *node, u_int64_t now);
+void replay_report(double wall, u_int64_t span);
+
+static char *replay_names[REPLAY_NUM] =
+{
+  "RREQ", "RREP", "RERR", "Timer", "Sweep"
+};
+
+struct replay_stat stats[REPLAY_NUM];
+int cur_kind = REPLAY_RREQ;       /* Whose sends and routes are counted */
+
+/* The generated stream */
+int nnodes = 1000;
+int nnbrs = 8;
+int mix[3] = { 60, 30, 10 };
+u_int64_t nmsgs = 100000;
+u_int64_t interval = 200;         /* us */
+u_int64_t rng = 1;
+u_int64_t gen_us = 0;             /* Time of the last message */
+u_int32_t *seqs;                  /* Last sequence number of each node */
+u_int32_t *bcast_ids;             /* Last broadcast id of each node */
+
+/* The replayed trace */
+FILE *tfp = NULL;
+struct trace_hdr thdr;
+u_int64_t tfirst = 0;             /* Time of its first record, us */
+int tstarted = 0;
+
+u_int64_t next_sweep = REPLAY_EPOCH + REPLAY_SWEEP_INTERVAL;
+
+/* Address of node i, the replayed node is 0 */
+#define REPLAY_ADDR(i) htonl(REPLAY_NET + 1 + (i))
+
+/*
+ *   net_send
+ *
+ *   Description:
+ *     Replaces the socket send of netio.c, the message is only counted.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The sending node.
+ *     struct info *pktinfo   - Destination and ttl.
+ *     void *data             - The message.
+ *     int datalen            - Its length.
+ *
+ *   Return:
+ *     int - Always 0
+*/
+int
+net_send(struct aodv_node *node, struct info *pktinfo, void *data,
+	 int datalen)
+{
+  stats[cur_kind].sent++;
+
+  return 0;
+}
+
+/*
+ *   add_kroute
+ *
+ *   Description:
+ *     Replaces the kernel route change of krtable.c, only counts.
+ *
+ *   Arguments:
+ *     u_int32_t dst_ip - Destination of the route.
+ *     u_int32_t gw_ip  - Gateway.
+ *
+ *   Return:
+ *     int - Always 0
+*/
+int
+add_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
+{
+  stats[cur_kind].krt_add++;
+
+  return 0;
+}
+
+/*
+ *   del_kroute
+ *
+ *   Description:
+ *     Replaces the kernel route change of krtable.c, only counts.
+ *
+ *   Arguments:
+ *     u_int32_t dst_ip - Destination of the route.
+ *     u_int32_t gw_ip  - Gateway.
+ *
+ *   Return:
+ *     int - Always 0
+*/
+int
+del_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
+{
+  stats[cur_kind].krt_del++;
+
+  return 0;
+}
+
+/*
+ *   replay_time
+ *
+ *   Description:
+ *     Reads the monotonic clock.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     u_int64_t - The time, ns.
+*/
+u_int64_t
+replay_time()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (u_int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ *   replay_random
+ *
+ *   Description:
+ *     Returns the next number of the generator (xorshift64*).
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     u_int64_t - The number.
+*/
+u_int64_t
+replay_random()
+{
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+
+  return rng * 2685821657736338717ULL;
+}
+
+/*
+ *   replay_gen
+ *
+ *   Description:
+ *     Generates the next message. RREQs come from any node but the
+ *     replayed one and may be for it, RREPs go back to any node, RERRs
+ *     report 1 to REPLAY_MAXUNR destinations. All are forwarded by one
+ *     of the neighbours, nodes 1 to nnbrs.
+ *
+ *   Arguments:
+ *     struct replay_msg *m - Where the message goes.
+ *
+ *   Return:
+ *     int - 1 if a message was generated, 0 when all have been.
+*/
+int
+replay_gen(struct replay_msg *m)
+{
+  struct rreq *rreq;
+  struct rrep *rrep;
+  u_int32_t ip;
+  u_int32_t seq;
+  int type;
+  int src;
+  int dst;
+  int cnt;
+  int i;
+
+  if (nmsgs == 0)
+    return 0;
+  nmsgs--;
+
+  gen_us += interval;
+  m->time = REPLAY_EPOCH + gen_us / 1000;
+  m->inf.ip_pkt_src_ip = REPLAY_ADDR(1 + replay_random() % nnbrs);
+  m->inf.ip_pkt_my_ip = REPLAY_ADDR(0);
+  memset(m->data, 0, sizeof(struct rreq));
+
+  type = replay_random() % 100;
+  if (type < mix[0])
+    {
+      rreq = (struct rreq*)m->data;
+      src = 1 + replay_random() % nnodes;
+      dst = replay_random() % (nnodes + 1);
+      rreq->type = RREQ;
+      rreq->hop_cnt = replay_random() % 8;
+      rreq->broadcast_id = ++bcast_ids[src];
+      rreq->dst_ip = REPLAY_ADDR(dst);
+      rreq->dst_seq = seqs[dst];
+      rreq->src_ip = REPLAY_ADDR(src);
+      rreq->src_seq = ++seqs[src];
+
+      m->inf.ip_pkt_dst_ip = inet_addr("255.255.255.255");
+      m->inf.ip_pkt_ttl = 1 + replay_random() % NET_DIAMETER;
+      m->len = sizeof(struct rreq);
+    }
+  else if (type < mix[0] + mix[1])
+    {
+      rrep = (struct rrep*)m->data;
+      src = replay_random() % (nnodes + 1);
+      dst = 1 + replay_random() % nnodes;
+      rrep->type = RREP;
+      rrep->hop_cnt = replay_random() % 8;
+      rrep->dst_ip = REPLAY_ADDR(dst);
+      rrep->dst_seq = ++seqs[dst];
+      rrep->src_ip = REPLAY_ADDR(src);
+      rrep->lifetime = ACTIVE_ROUTE_TIMEOUT;
+
+      m->inf.ip_pkt_dst_ip = REPLAY_ADDR(0);
+      m->inf.ip_pkt_ttl = NET_DIAMETER;
+      m->len = sizeof(struct rrep);
+    }
+  else
+    {
+      cnt = 1 + replay_random() % REPLAY_MAXUNR;
+      m->data[0] = RERR;
+      m->data[3] = cnt;
+      for (i = 0; i < cnt; i++)
+	{
+	  dst = 1 + replay_random() % nnodes;
+	  ip = REPLAY_ADDR(dst);
+	  seq = ++seqs[dst];
+	  memcpy(&m->data[4 + i * 8], &ip, 4);
+	  memcpy(&m->data[4 + i * 8 + 4], &seq, 4);
+	}
+
+      m->inf.ip_pkt_dst_ip = inet_addr("255.255.255.255");
+      m->inf.ip_pkt_ttl = 1;
+      m->len = 4 + 8 * cnt;
+    }
+
+  return 1;
+}
+
+/*
+ *   replay_read
+ *
+ *   Description:
+ *     Reads the next message the traced node received.
+ *
+ *   Arguments:
+ *     struct replay_msg *m - Where the message goes.
+ *
+ *   Return:
+ *     int - 1 if a message was read, 0 at the end of the trace and -1
+ *           if the trace is corrupt.
+*/
+int
+replay_read(struct replay_msg *m)
+{
+  struct trace_rec rec;
+  int ret;
+
+  while ((ret = trace_read(tfp, &rec, m->data)) == 1)
+    {
+      if (rec.dir != TRACE_DIR_IN)
+	continue;
+
+      if (!tstarted)
+	{
+	  tfirst = rec.time;
+	  tstarted = 1;
+	}
+
+      m->time = REPLAY_EPOCH + (rec.time - tfirst) / 1000;
+      m->inf.ip_pkt_src_ip = rec.src_ip;
+      m->inf.ip_pkt_dst_ip = rec.dst_ip;
+      m->inf.ip_pkt_my_ip = thdr.my_ip;
+      m->inf.ip_pkt_ttl = rec.ttl;
+
+      /* A truncated message is dropped as malformed */
+      m->len = rec.caplen;
+      return 1;
+    }
+
+  return ret;
+}
+
+/*
+ *   replay_handle
+ *
+ *   Description:
+ *     Checks the size of a message as node_recv does and hands it to
+ *     rec_rreq, rec_rrep, rec_hello or rec_rerr, timing only that call,
+ *     a HELLO counts as a RREP. The list
+ *     of unreachable destinations of a RERR is built beforehand without
+ *     allocating.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The replayed node.
+ *     struct replay_msg *m   - The message.
+ *
+ *   Return: None
+*/
+void
+replay_handle(struct aodv_node *node, struct replay_msg *m)
+{
+  struct rerr_unr_dst unr[256];
+  struct rerrhdr rerrhdr_msg;
+  u_int64_t t0;
+  int kind;
+  int i;
+
+  switch (m->len > 0 ? (u_int8_t)m->data[0] : 0)
+    {
+    case RREQ:
+      kind = REPLAY_RREQ;
+      if (m->len != sizeof(struct rreq))
+	break;
+
+      cur_kind = kind;
+      t0 = replay_time();
+      rec_rreq(node, &m->inf, (struct rreq*)m->data);
+      hist_add(&stats[kind].ns, replay_time() - t0);
+      return;
+
+    case RREP:
+      kind = REPLAY_RREP;
+      /* A HELLO may carry the neighbour list, see gen_hello */
+      if (m->len != sizeof(struct rrep) &&
+	  !(m->len >= (int)(sizeof(struct rrep) + sizeof(struct hello_ext)) &&
+	    RREP_IS_HELLO((struct rrep*)m->data) &&
+	    (u_int8_t)m->data[20] == HELLO_EXT_NB &&
+	    (u_int8_t)m->data[21] % 4 == 0 &&
+	    m->len == 24 + (u_int8_t)m->data[21]))
+	break;
+
+      cur_kind = kind;
+      t0 = replay_time();
+      if (RREP_IS_HELLO((struct rrep*)m->data))
+	rec_hello(node, &m->inf, (struct rrep*)m->data, m->len);
+      else
+	rec_rrep(node, &m->inf, (struct rrep*)m->data);
+      hist_add(&stats[kind].ns, replay_time() - t0);
+      return;
+
+    case RERR:
+      kind = REPLAY_RERR;
+      if (m->len < 4 || m->len != 4 + 8 * (u_int8_t)m->data[3])
+	break;
+
+      rerrhdr_msg.type = RERR;
+      rerrhdr_msg.reserved = 0;
+      rerrhdr_msg.dst_cnt = (u_int8_t)m->data[3];
+      rerrhdr_msg.unr_dst = NULL;
+      for (i = rerrhdr_msg.dst_cnt - 1; i >= 0; i--)
+	{
+	  memcpy(&unr[i].unr_dst_ip, &m->data[4 + i * 8], 4);
+	  memcpy(&unr[i].unr_dst_seq, &m->data[4 + i * 8 + 4], 4);
+	  unr[i].next = rerrhdr_msg.unr_dst;
+	  rerrhdr_msg.unr_dst = &unr[i];
+	}
+
+      cur_kind = kind;
+      t0 = replay_time();
+      rec_rerr(node, &m->inf, &rerrhdr_msg);
+      hist_add(&stats[kind].ns, replay_time() - t0);
+      return;
+
+    default:
+      /* Not an AODV message, counted with the RREQs */
+      kind = REPLAY_RREQ;
+      break;
+    }
+
+  stats[kind].dropped++;
+}
+
+/*
+ *   replay_advance
+ *
+ *   Description:
+ *     Moves the virtual clock forward and runs the timers that fall due
+ *     and the sweeps of the routing table up to then.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The replayed node.
+ *     u_int64_t now          - The new time, ms.
+ *
+ *   Return: None
+*/
+void
+replay_advance(struct aodv_node *node, u_int64_t now)
+{
+  struct prioqent *pqe;
+  u_int64_t t0;
+
+  clock_set(now);
+
+  cur_kind = REPLAY_TIMER;
+  while ((pqe = pq_getfirstdue(&node->pq, now)) != NULL)
+    {
+      t0 = replay_time();
+      pq_unqueuefirstent(&node->pq);
+      node_timer(node, pqe);
+      hist_add(&stats[REPLAY_TIMER].ns, replay_time() - t0);
+    }
+
+  cur_kind = REPLAY_SWEEP;
+  for (; next_sweep <= now; next_sweep += REPLAY_SWEEP_INTERVAL)
+    {
+      t0 = replay_time();
+      find_inactives(node);
+      hist_add(&stats[REPLAY_SWEEP].ns, replay_time() - t0);
+    }
+}
+
+/*
+ *   replay_report
+ *
+ *   Description:
+ *     Prints the results.
+ *
+ *   Arguments:
+ *     double wall    - Wall clock time of the replay, s.
+ *     u_int64_t span - Virtual time the messages spanned, ms.
+ *
+ *   Return: None
+*/
+void
+replay_report(double wall, u_int64_t span)
+{
+  struct replay_stat *st;
+  u_int64_t msgs = 0;
+  u_int64_t dropped = 0;
+  u_int64_t cpu = 0;
+  u_int64_t msgs_cpu = 0;
+  int k;
+
+  for (k = 0; k < REPLAY_NUM; k++)
+    {
+      cpu += stats[k].ns.sum;
+      if (k <= REPLAY_RERR)
+	{
+	  msgs += stats[k].ns.count;
+	  dropped += stats[k].dropped;
+	  msgs_cpu += stats[k].ns.sum;
+	}
+    }
+
+  printf("Messages: %llu  Dropped: %llu  Spanned: %.1f s  Wall: %.3f s\n",
+	 (unsigned long long)msgs, (unsigned long long)dropped,
+	 span / 1e3, wall);
+  printf("Protocol CPU: %.3f ms  %.0f messages/s  %.1f%% of the span\n",
+	 cpu / 1e6, msgs_cpu > 0 ? msgs / (msgs_cpu / 1e9) : 0.0,
+	 span > 0 ? cpu / 1e4 / span : 0.0);
+
+  printf("\nTime in the protocol code, ns\n");
+  printf("  %-6s %10s %8s %8s %8s %10s %10s\n", "", "count", "p50", "p90",
+	 "p99", "max", "mean");
+  for (k = 0; k < REPLAY_NUM; k++)
+    {
+      st = &stats[k];
+      printf("  %-6s %10llu %8llu %8llu %8llu %10llu %10.1f\n",
+	     replay_names[k], (unsigned long long)st->ns.count,
+	     (unsigned long long)hist_percentile(&st->ns, 50),
+	     (unsigned long long)hist_percentile(&st->ns, 90),
+	     (unsigned long long)hist_percentile(&st->ns, 99),
+	     (unsigned long long)st->ns.max, hist_mean(&st->ns));
+    }
+
+  printf("\nWork caused, per message or run\n");
+  printf("  %-6s %10s %10s %10s\n", "", "sent", "krt add", "krt del");
+  for (k = 0; k < REPLAY_NUM; k++)
+    {
+      st = &stats[k];
+      if (st->ns.count == 0)
+	continue;
+      printf("  %-6s %10.3f %10.3f %10.3f\n", replay_names[k],
+	     (double)st->sent / st->ns.count,
+	     (double)st->krt_add / st->ns.count,
+	     (double)st->krt_del / st->ns.count);
+    }
+}
+
+/* ------------------------------------------------------------------- */
+
+int
+main(int argc, char *argv[])
+{
+  struct aodv_node node;
+  struct replay_msg *m;
+  struct timespec w0;
+  struct timespec w1;
+  u_int64_t first = 0;
+  u_int64_t last = 0;
+  u_int32_t my_ip;
+  int ret;
+  int opt;
+  int k;
+
+  while ((opt = getopt(argc, argv, "n:N:k:i:m:s:")) != -1)
+    {
+      switch (opt)
+	{
+	case 'n':
+	  nmsgs = strtoull(optarg, NULL, 10);
+	  break;
+
+	case 'N':
+	  nnodes = atoi(optarg);
+	  break;
+
+	case 'k':
+	  nnbrs = atoi(optarg);
+	  break;
+
+	case 'i':
+	  interval = strtoull(optarg, NULL, 10);
+	  break;
+
+	case 'm':
+	  if (sscanf(optarg, "%d:%d:%d", &mix[0], &mix[1], &mix[2]) != 3 ||
+	      mix[0] < 0 || mix[1] < 0 || mix[2] < 0 ||
+	      mix[0] + mix[1] + mix[2] != 100)
+	    {
+	      fprintf(stderr, "%s: the mix must be three percentages adding "
+		      "up to 100\n", argv[0]);
+	      exit(1);
+	    }
+	  break;
+
+	case 's':
+	  rng = strtoull(optarg, NULL, 10);
+	  break;
+
+	default:
+	  fprintf(stderr, "Usage: %s [-n messages] [-N nodes] "
+		  "[-k neighbours] [-i us]\n"
+		  "       [-m rreq:rrep:rerr] [-s seed] [trace]\n", argv[0]);
+	  exit(1);
+	}
+    }
+
+  if (nnodes < 1 || nnbrs < 1 || nnbrs > nnodes)
+    {
+      fprintf(stderr, "%s: there must be at least one node and between "
+	      "one and that many neighbours\n", argv[0]);
+      exit(1);
+    }
+
+  /* The generator must not start from 0 */
+  rng = rng * 0x9e3779b97f4a7c15ULL + 1;
+
+  if (optind < argc)
+    {
+      if ((tfp = trace_open(argv[optind], &thdr)) == NULL)
+	exit(1);
+      my_ip = thdr.my_ip;
+    }
+  else
+    {
+      seqs = calloc(nnodes + 1, sizeof(u_int32_t));
+      bcast_ids = calloc(nnodes + 1, sizeof(u_int32_t));
+      if (seqs == NULL || bcast_ids == NULL)
+	{
+	  fprintf(stderr, "%s: out of memory\n", argv[0]);
+	  exit(1);
+	}
+      my_ip = REPLAY_ADDR(0);
+    }
+
+  for (k = 0; k < REPLAY_NUM; k++)
+    {
+      memset(&stats[k], 0, sizeof(struct replay_stat));
+      hist_init(&stats[k].ns);
+    }
+
+  clock_source(CLOCK_SRC_VIRTUAL);
+  clock_set(REPLAY_EPOCH);
+
+  if ((m = malloc(sizeof(struct replay_msg))) == NULL ||
+      node_init(&node, my_ip) == -1)
+    {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      exit(1);
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &w0);
+  while ((ret = tfp != NULL ? replay_read(m) : replay_gen(m)) == 1)
+    {
+      if (first == 0)
+	first = m->time;
+      last = m->time;
+
+      replay_advance(&node, m->time);
+      replay_handle(&node, m);
+    }
+  clock_gettime(CLOCK_MONOTONIC, &w1);
+
+  if (ret == -1)
+    fprintf(stderr, "%s: %s is corrupt, replayed up to there\n", argv[0],
+	    argv[optind]);
+
+  replay_report(w1.tv_sec - w0.tv_sec + (w1.tv_nsec - w0.tv_nsec) / 1e9,
+		last - first);
+
+  node_free(&node);
+  free(m);
+  if (tfp != NULL && tfp != stdin)
+    fclose(tfp);
+
+  return ret == -1 ? 1 : 0;
+}
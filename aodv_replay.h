@@ -0,0 +1,144 @@
+/*
+ *	FILE: aodv_replay.c
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ *      Usage:
+ *        aodv_replay [-n messages] [-N nodes] [-k neighbours] [-i us]
+ *                    [-m rreq:rrep:rerr] [-s seed] [trace]
+ *
+ *        -n  Number of messages generated (100000).
+ *        -N  Number of nodes the messages are about (1000).
+ *        -k  Number of neighbours they come from (8).
+ *        -i  Time between two messages in us (200).
+ *        -m  Mix of the generated messages in percent (60:30:10).
+ *        -s  Seed of the generator (1).
+ *
+ *        With a trace the messages the traced node received are
+ *        replayed instead, at the times they were received.
+ *
+ ********************************
+ *
+ *	General description:
+ *      -------------------
+ *
+ * Feeds a stream of AODV messages, each with its struct info, straight
+ * into rec_rreq, rec_rrep and rec_rerr of one node, and measures the
+ * CPU time the protocol code spends on each. The stream is read from a
+ * trace written by the daemon or generated: RREQs from random nodes
+ * for random destinations, RREPs back to the nodes that asked, RERRs
+ * for a few destinations at a time, all forwarded by random neighbours.
+ *
+ * Only the protocol code is timed. net_send and the kernel route calls
+ * are replaced by stubs that count, the clock runs on its virtual
+ * source and follows the times of the messages. Timers that fall due
+ * and the sweep of find_inactives are run between the messages and
+ * timed on their own.
+ *
+ * Prints the messages handled per second of protocol CPU, a latency
+ * histogram of each message type and the messages sent and kernel
+ * route changes per handled message.
+ *
+ *	Internal procedures:
+ *
+ * replay_time()
+ * replay_random()
+ * replay_gen()
+ * replay_read()
+ * replay_handle()
+ * replay_advance()
+ * replay_report()
+ *
+ *	External procedures:
+ *
+ * net_send()
+ * add_kroute()
+ * del_kroute()
+ * main()
+ *
+ ********************************
+ *
+ *   Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef AODV_REPLAY_H
+#define AODV_REPLAY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "aodv.h"
+#include "info.h"
+#include "node.h"
+#include "rreq.h"
+#include "rrep.h"
+#include "hello.h"
+#include "rerr.h"
+#include "find_inactives.h"
+#include "krtable.h"
+#include "timer.h"
+#include "clock.h"
+#include "trace.h"
+#include "hist.h"
+
+/* The replayed node lives in 10.0.0.0/8, it is 10.0.0.1 */
+#define REPLAY_NET 0x0a000000
+
+/* Virtual time of the first message, in ms */
+#define REPLAY_EPOCH 1000000
+
+/* Time between two sweeps of the routing table, in ms */
+#define REPLAY_SWEEP_INTERVAL 1000
+
+/* Most unreachable destinations in a generated RERR */
+#define REPLAY_MAXUNR 4
+
+/* What the time is spent on */
+#define REPLAY_RREQ  0
+#define REPLAY_RREP  1
+#define REPLAY_RERR  2
+#define REPLAY_TIMER 3
+#define REPLAY_SWEEP 4
+#define REPLAY_NUM   5
+
+/* A message to replay */
+struct replay_msg
+{
+  u_int64_t time;                   /* When it arrives, virtual ms */
+  struct info inf;                  /* Sender, destination and ttl */
+  int len;                          /* Length of the message */
+  char data[TRACE_MAXCAP];          /* The message */
+};
+
+/* Costs of one kind of work */
+struct replay_stat
+{
+  struct hist ns;                   /* Protocol CPU time of each, in ns */
+  u_int64_t dropped;                /* Malformed messages */
+  u_int64_t sent;                   /* Messages it sent */
+  u_int64_t krt_add;                /* Kernel routes it added */
+  u_int64_t krt_del;                /* Kernel routes it deleted */
+};
+
+#endif
@@ -0,0 +1,1998 @@
+/*
+ *	FILE: aodv_sim.c
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ *      Usage:
+ *        aodv_sim [-n nodes] [-r discoveries] [-t seconds] [-w seconds]
+ *                 [-l delay] [-s seed] [-j threads] [-q]
+ *                 [-T grid|line|rgg|cluster] [-f scenario] [-R range]
+ *                 [-d degree] [-M none|waypoint|gauss|group|file]
+ *                 [-v speed] [-p pause] [-c disk|distance|asym]
+ *                 [-L loss] [-C] [-S flaps] [-J] [-E] [-I] [-H hops] [-P]
+ *                 [-B copies] [-G percent] [-O]
+ *
+ *        -n  Number of nodes (100).
+ *        -r  Number of route discoveries, started at random times
+ *            between the warm-up and the end between random pairs (100).
+ *        -t  Simulated time in seconds (60).
+ *        -w  Warm-up in seconds before the first discovery (6).
+ *        -l  Delay of one hop in us (1000).
+ *        -s  Seed, runs with the same seed and options are identical (1).
+ *        -j  Number of worker threads, does not change the results (1).
+ *        -q  Don't send HELLOs.
+ *        -T  Placement of the nodes, see topo.h (grid).
+ *        -f  Place and move the nodes as in an ns-2 setdest scenario,
+ *            the number of nodes is taken from it.
+ *        -R  Radio range in m (250).
+ *        -d  Mean number of neighbours of rgg and cluster (8).
+ *        -M  Mobility model, file for the setdest commands of -f (none).
+ *        -v  Highest speed in m/s (10).
+ *        -p  Pause at each random waypoint in s (0).
+ *        -c  Channel model, see chan.h (disk).
+ *        -L  Highest loss of a link with asym, 0 to 1 (0.3).
+ *        -C  CSMA: messages take airtime, senders back off and
+ *            overlapping messages are lost.
+ *        -S  Cut and restore links and run flows of data as in a
+ *            scenario, see scen.h.
+ *        -J  Print the results as one line of JSON.
+ *        -E  Choose routes by the ETX of the first hop, see neighbour.h.
+ *        -I  Data packets stand in for HELLOs, as with aodv_daemon -i.
+ *        -H  Repair broken routes at most hops long locally, as with
+ *            aodv_daemon -r. A repairing node holds the data packets
+ *            for the route until the repair is over (0).
+ *        -P  Keep alternate next hops and switch to one when a link
+ *            breaks, as with aodv_daemon -m.
+ *        -B  Rebroadcast a RREQ after a random jitter, and not at all if
+ *            this many copies from other nodes arrive meanwhile, as with
+ *            aodv_daemon -b (0, at once).
+ *        -G  Rebroadcast that percent of the RREQs further than
+ *            GOSSIP_HOPS from the source, scaled by the number of
+ *            neighbours, as with aodv_daemon -g (0, all).
+ *        -O  Only relays elected from the two-hop neighbours rebroadcast
+ *            RREQs, as with aodv_daemon -o. The HELLOs list the
+ *            neighbours and are never skipped.
+ *
+ ********************************
+ *
+ *	General description:
+ *      -------------------
+ *
+ * Runs many AODV nodes on a simulated medium in simulated time, split
+ * over worker threads, and reports route discovery latency, control
+ * overhead, channel losses and CPU time per node. Can cut links and run
+ * data flows from a scenario to time route repair. See aodv_sim.h.
+ *
+ *	Internal procedures:
+ *
+ * sim_random()
+ * sim_ip()
+ * sim_lookup()
+ * sim_ms()
+ * ev_less()
+ * heap_up()
+ * heap_down()
+ * heap_add()
+ * sim_push()
+ * sim_drain()
+ * sim_linked()
+ * sim_transmit()
+ * sim_csma()
+ * sim_rearm()
+ * disc_start()
+ * disc_check()
+ * sim_forward()
+ * sim_arrive()
+ * sim_deliver()
+ * sim_handle()
+ * sim_worker()
+ * report_json()
+ * report()
+ *
+ *	External procedures:
+ *
+ * net_send()
+ * add_kroute()
+ * del_kroute()
+ * flight_event()
+ * main()
+ *
+ ********************************
+ *
+ *   Extendend RCS Info: $Id$
+ *
+ */
+
+
+#include "aodv_sim.h"
+
+char *cls_name[CLS_NUM] = { "HELLO", "RREQ", "RREP", "RERR" };
+
+/* The nodes, and where they are */
+struct sim_node *nodes;
+int nnodes;
+struct topo topo;
+struct chan chan;
+struct scen scen;
+
+/* The partitions, and the one run by this thread. NULL while the
+   events are set up */
+struct sim_part *parts;
+int nparts = 1;
+__thread struct sim_part *cur = NULL;
+__thread struct sim_node *cur_node = NULL;  /* Node of the event run */
+pthread_barrier_t barrier;
+
+u_int64_t setup_seq = 0;          /* Events scheduled before the run */
+u_int64_t end;                    /* End of the run, us */
+u_int64_t windows = 0;
+
+/* Options */
+u_int64_t hop_delay = 1000;
+u_int64_t rng;
+int json = 0;
+int implicit = 0;                 /* Data packets count as HELLOs */
+
+/* Results */
+struct hist cpu;                  /* CPU time per node, ns */
+u_int64_t disc_open = 0;
+
+/*
+ *   sim_random
+ *
+ *   Description:
+ *     Returns the next number of a seeded generator (xorshift64*).
+ *
+ *   Arguments:
+ *     u_int64_t *state - State of the generator, never 0.
+ *
+ *   Return:
+ *     u_int64_t - The number.
+*/
+u_int64_t
+sim_random(u_int64_t *state)
+{
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+
+  return *state * 2685821657736338717ULL;
+}
+
+/*
+ *   sim_ip
+ *
+ *   Description:
+ *     Gives the address of a node.
+ *
+ *   Arguments:
+ *     int i - Index of the node.
+ *
+ *   Return:
+ *     u_int32_t - The address in network byte order.
+*/
+u_int32_t
+sim_ip(int i)
+{
+  return htonl(SIM_NET + i + 1);
+}
+
+/*
+ *   sim_lookup
+ *
+ *   Description:
+ *     Finds a name in a list of names.
+ *
+ *   Arguments:
+ *     char **names - The names, ending with NULL.
+ *     char *name   - The name.
+ *
+ *   Return:
+ *     int - Its index, or -1 if it is not there.
+*/
+int
+sim_lookup(char **names, char *name)
+{
+  int i;
+
+  for (i = 0; names[i] != NULL; i++)
+    if (strcmp(names[i], name) == 0)
+      return i;
+
+  return -1;
+}
+
+/*
+ *   sim_ms
+ *
+ *   Description:
+ *     Formats the time from one moment to another in ms, for the
+ *     report.
+ *
+ *   Arguments:
+ *     char *buf      - Where the text goes, 32 bytes.
+ *     u_int64_t at   - The later moment, us, 0 if it never came.
+ *     u_int64_t from - The earlier one, us.
+ *
+ *   Return:
+ *     char* - buf, "never" or null in JSON if the moment never
+ *              came.
+*/
+char *
+sim_ms(char *buf, u_int64_t at, u_int64_t from)
+{
+  if (at == 0)
+    strcpy(buf, json ? "null" : "never");
+  else
+    sprintf(buf, "%.1f%s", (at - from) / 1e3, json ? "" : " ms");
+
+  return buf;
+}
+
+/*
+ *   ev_less
+ *
+ *   Description:
+ *     Orders two events by time, node, origin and the number the
+ *     origin gave them. None of these depend on the partitions.
+ *
+ *   Arguments:
+ *     struct sim_ev *a - An event.
+ *     struct sim_ev *b - An event.
+ *
+ *   Return:
+ *     int - 1 if a comes before b, 0 otherwise.
+*/
+int
+ev_less(struct sim_ev *a, struct sim_ev *b)
+{
+  if (a->time != b->time)
+    return a->time < b->time;
+  if (a->node != b->node)
+    return a->node < b->node;
+  if (a->origin != b->origin)
+    return a->origin < b->origin;
+
+  return a->oseq < b->oseq;
+}
+
+/*
+ *   heap_up
+ *
+ *   Description:
+ *     Moves the heap element at a position up to its place.
+ *
+ *   Arguments:
+ *     struct sim_part *p - The partition.
+ *     int i              - Position in its heap.
+ *
+ *   Return: None.
+*/
+void
+heap_up(struct sim_part *p, int i)
+{
+  struct sim_ev tmp;
+  int parent;
+
+  while (i > 0)
+    {
+      parent = (i - 1) / 2;
+      if (!ev_less(&p->heap[i], &p->heap[parent]))
+	break;
+
+      tmp = p->heap[i];
+      p->heap[i] = p->heap[parent];
+      p->heap[parent] = tmp;
+      i = parent;
+    }
+}
+
+/*
+ *   heap_down
+ *
+ *   Description:
+ *     Moves the heap element at a position down to its place.
+ *
+ *   Arguments:
+ *     struct sim_part *p - The partition.
+ *     int i              - Position in its heap.
+ *
+ *   Return: None.
+*/
+void
+heap_down(struct sim_part *p, int i)
+{
+  struct sim_ev tmp;
+  int child;
+
+  while ((child = 2 * i + 1) < p->heapn)
+    {
+      if (child + 1 < p->heapn &&
+	  ev_less(&p->heap[child + 1], &p->heap[child]))
+	child++;
+
+      if (!ev_less(&p->heap[child], &p->heap[i]))
+	break;
+
+      tmp = p->heap[i];
+      p->heap[i] = p->heap[child];
+      p->heap[child] = tmp;
+      i = child;
+    }
+}
+
+/*
+ *   heap_add
+ *
+ *   Description:
+ *     Puts an event in the heap of a partition.
+ *
+ *   Arguments:
+ *     struct sim_part *p - The partition.
+ *     struct sim_ev *ev  - The event, copied.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+*/
+int
+heap_add(struct sim_part *p, struct sim_ev *ev)
+{
+  struct sim_ev *heap;
+
+  if (p->heapn == p->heapmax)
+    {
+      p->heapmax = p->heapmax ? 2 * p->heapmax : 1024;
+      if ((heap = realloc(p->heap, p->heapmax * sizeof(struct sim_ev)))
+	  == NULL)
+	return -1;
+      p->heap = heap;
+    }
+
+  p->heap[p->heapn] = *ev;
+  heap_up(p, p->heapn++);
+
+  return 0;
+}
+
+/*
+ *   sim_push
+ *
+ *   Description:
+ *     Schedules an event. An event for a node of another partition is
+ *     pushed on the mail list of that partition, no lock is taken.
+ *
+ *   Arguments:
+ *     u_int64_t time      - When, us.
+ *     int type            - SIM_EV_ constant.
+ *     u_int32_t node      - Index of the node it happens at.
+ *     u_int32_t origin    - Index of the node that schedules it, or
+ *                           SIM_SETUP.
+ *     u_int32_t arg       - Destination of a SIM_EV_DISC.
+ *     struct sim_msg *msg - Message of a SIM_EV_RECV or SIM_EV_RXEND.
+ *     struct sim_rx *rx   - Reception of a SIM_EV_RXEND.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+*/
+int
+sim_push(u_int64_t time, int type, u_int32_t node, u_int32_t origin,
+	 u_int32_t arg, struct sim_msg *msg, struct sim_rx *rx)
+{
+  struct sim_part *p = &parts[nodes[node].part];
+  struct sim_mail *m;
+  struct sim_ev ev;
+
+  ev.time = time;
+  ev.node = node;
+  ev.origin = origin;
+  ev.oseq = origin == SIM_SETUP ? setup_seq++ : nodes[origin].oseq++;
+  ev.type = type;
+  ev.arg = arg;
+  ev.msg = msg;
+  ev.rx = rx;
+
+  if (cur == NULL || p == cur)
+    return heap_add(p, &ev);
+
+  if ((m = malloc(sizeof(struct sim_mail))) == NULL)
+    return -1;
+
+  m->ev = ev;
+  m->next = __atomic_load_n(&p->mail, __ATOMIC_RELAXED);
+  while (!__atomic_compare_exchange_n(&p->mail, &m->next, m, 1,
+				      __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    ;
+  cur->mailed++;
+
+  return 0;
+}
+
+/*
+ *   sim_drain
+ *
+ *   Description:
+ *     Moves the events mailed to a partition into its heap. Their
+ *     order on the mail list does not matter.
+ *
+ *   Arguments:
+ *     struct sim_part *p - The partition.
+ *
+ *   Return: None.
+*/
+void
+sim_drain(struct sim_part *p)
+{
+  struct sim_mail *m;
+  struct sim_mail *next;
+
+  m = __atomic_exchange_n(&p->mail, NULL, __ATOMIC_ACQUIRE);
+  while (m != NULL)
+    {
+      next = m->next;
+      heap_add(p, &m->ev);
+      free(m);
+      m = next;
+    }
+}
+
+/*
+ *   sim_linked
+ *
+ *   Description:
+ *     Tells if a node is in range of another and their link is not
+ *     cut by the scenario.
+ *
+ *   Arguments:
+ *     struct sim_node *sn - The node.
+ *     int j               - Index of the other node.
+ *
+ *   Return:
+ *     int - 1 if they are linked, else 0.
+*/
+int
+sim_linked(struct sim_node *sn, int j)
+{
+  int lo = topo.first[sn->id];
+  int hi = topo.first[sn->id + 1];
+  int mid;
+  int i;
+
+  for (i = 0; i < sn->ncut; i++)
+    if (sn->cut[i] == j)
+      return 0;
+
+  /* The neighbours are in increasing order */
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (topo.nbr[mid] < j)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+
+  return lo < topo.first[sn->id + 1] && topo.nbr[lo] == j;
+}
+
+/*
+ *   sim_transmit
+ *
+ *   Description:
+ *     Puts a message on the medium now. It arrives after the hop delay
+ *     at every neighbour of the sender if it is a broadcast, else at
+ *     the neighbour it is addressed to.
+ *
+ *   Arguments:
+ *     struct sim_node *sn - The sending node.
+ *     struct sim_msg *msg - The message, freed when nobody gets it.
+ *
+ *   Return: None.
+*/
+void
+sim_transmit(struct sim_node *sn, struct sim_msg *msg)
+{
+  u_int32_t dst_ip = msg->inf.ip_pkt_dst_ip;
+  int i;
+  int j;
+
+  if (chan.csma)
+    sn->tx_end = cur->now + chan_airtime(msg->len);
+
+  /* No receiver runs before the next window, so refs can be counted up
+     without atomics */
+  for (i = topo.first[sn->id]; i < topo.first[sn->id + 1]; i++)
+    {
+      j = topo.nbr[i];
+      if (sn->ncut > 0 && !sim_linked(sn, j))
+	continue;
+      if (dst_ip == 0xffffffff || dst_ip == sim_ip(j))
+	{
+	  if (sim_push(cur->now + hop_delay, SIM_EV_RECV, j, sn->id, 0, msg,
+		       NULL) == -1)
+	    break;
+	  msg->refs++;
+	}
+    }
+
+  if (msg->refs == 0)
+    {
+      if (dst_ip != 0xffffffff)
+	cur->lost++;
+      free(msg);
+    }
+}
+
+/*
+ *   sim_csma
+ *
+ *   Description:
+ *     Runs when the backoff of a node is over. Sends the first message
+ *     of its queue if the medium it senses is free, else backs off
+ *     again until it is. Then waits for the next message.
+ *
+ *   Arguments:
+ *     struct sim_node *sn - The node.
+ *
+ *   Return: None.
+*/
+void
+sim_csma(struct sim_node *sn)
+{
+  struct sim_msg *msg;
+  u_int64_t busy;
+
+  busy = MAX(sn->tx_end, sn->rx_end);
+  if (busy <= cur->now)
+    {
+      msg = sn->txq;
+      if ((sn->txq = msg->next) == NULL)
+	sn->txq_tail = NULL;
+      sim_transmit(sn, msg);
+      busy = sn->tx_end;
+    }
+
+  if (sn->txq != NULL)
+    sim_push(busy + chan_backoff(sim_random(&sn->rng)), SIM_EV_TX, sn->id,
+	     sn->id, 0, NULL, NULL);
+}
+
+/*
+ *   net_send
+ *
+ *   Description:
+ *     Replaces the socket send of netio.c. Counts the message and
+ *     transmits it, with CSMA after a backoff once the medium the
+ *     sender senses is free and the messages before it are sent.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The sending node.
+ *     struct info *pktinfo   - Destination and ttl.
+ *     void *data             - The message.
+ *     int datalen            - Its length.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+*/
+int
+net_send(struct aodv_node *node, struct info *pktinfo, void *data,
+	 int datalen)
+{
+  struct sim_node *sn = (struct sim_node*)node;
+  struct sim_msg *msg;
+  int cls;
+
+  if (datalen < 1 || datalen > SIM_MAXMSG)
+    return -1;
+
+  switch (*(u_int8_t*)data)
+    {
+    case RREQ:
+      cls = datalen >= sizeof(struct rreq) &&
+	((struct rreq*)data)->dst_ip == 0xffffffff ? CLS_HELLO : CLS_RREQ;
+      break;
+
+    case RREP:
+      cls = datalen >= sizeof(struct rrep) &&
+	RREP_IS_HELLO((struct rrep*)data) ? CLS_HELLO : CLS_RREP;
+      break;
+
+    default:
+      cls = CLS_RERR;
+      break;
+    }
+  cur->sent_msgs[cls]++;
+  cur->sent_bytes[cls] += datalen;
+  sn->sent++;
+
+  if ((msg = malloc(sizeof(struct sim_msg) + datalen)) == NULL)
+    return -1;
+
+  msg->next = NULL;
+  msg->refs = 0;
+  msg->from = sn->id;
+  msg->cls = cls;
+  msg->len = datalen;
+  msg->inf = *pktinfo;
+  msg->inf.ip_pkt_src_ip = node->my_ip;
+  if (msg->inf.ip_pkt_ttl == 0)
+    /* The system default */
+    msg->inf.ip_pkt_ttl = 64;
+  memcpy(msg->data, data, datalen);
+
+  if (!chan.csma)
+    {
+      sim_transmit(sn, msg);
+      return 0;
+    }
+
+  if (sn->txq == NULL)
+    {
+      sn->txq = msg;
+      sim_push(cur->now + chan_backoff(sim_random(&sn->rng)), SIM_EV_TX,
+	       sn->id, sn->id, 0, NULL, NULL);
+    }
+  else
+    sn->txq_tail->next = msg;
+  sn->txq_tail = msg;
+
+  return 0;
+}
+
+/*
+ *   add_kroute
+ *
+ *   Description:
+ *     Replaces the kernel route change of krtable.c, only counts.
+ *
+ *   Arguments:
+ *     u_int32_t dst_ip - Destination of the route.
+ *     u_int32_t gw_ip  - Gateway.
+ *
+ *   Return:
+ *     int - Always 0
+*/
+int
+add_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
+{
+  if (cur != NULL)
+    cur->krt_changes++;
+
+  return 0;
+}
+
+/*
+ *   del_kroute
+ *
+ *   Description:
+ *     Replaces the kernel route change of krtable.c, only counts.
+ *
+ *   Arguments:
+ *     u_int32_t dst_ip - Destination of the route.
+ *     u_int32_t gw_ip  - Gateway.
+ *
+ *   Return:
+ *     int - Always 0
+*/
+int
+del_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
+{
+  if (cur != NULL)
+    /* Not counted when the nodes are freed */
+    cur->krt_changes++;
+
+  return 0;
+}
+
+/*
+ *   flight_event
+ *
+ *   Description:
+ *     Replaces the flight recorder of flight.c. Records for the
+ *     scenario when an end of a cut link first marks a route over it
+ *     broken or switches it to an alternate next hop, and when the
+ *     source of a flow sees its route break and then gets a new one.
+ *     Only the partition of the node writes what is recorded for it.
+ *
+ *   Arguments:
+ *     int type    - FLIGHT_ constant.
+ *     u_int32_t a - Arguments, see the FLIGHT_ constants.
+ *     u_int32_t b
+ *     u_int32_t c
+ *     u_int32_t d
+ *
+ *   Return: None
+*/
+void
+flight_event(int type, u_int32_t a, u_int32_t b, u_int32_t c, u_int32_t d)
+{
+  struct scen_link *l;
+  struct scen_flow *f;
+  u_int64_t now;
+  int last;
+  int peer;
+  int i;
+
+  if (cur == NULL || cur_node == NULL ||
+      (type != FLIGHT_RT_BROKEN && type != FLIGHT_RT_INSERT &&
+       type != FLIGHT_RT_UPDATE && type != FLIGHT_RT_SWITCH))
+    return;
+
+  now = cur->now - SIM_EPOCH;
+  if ((last = scen_last(&scen, now)) == -1)
+    return;
+
+  if (type == FLIGHT_RT_BROKEN || type == FLIGHT_RT_SWITCH)
+    {
+      /* The next hop b is cut off if the last event of the link was a
+	 cut */
+      peer = ntohl(b) - SIM_NET - 1;
+      for (i = last; i >= 0; i--)
+	{
+	  l = &scen.link[i];
+	  if (l->a == cur_node->id && l->b == peer)
+	    {
+	      if (l->what == SCEN_CUT && l->detect_a == 0)
+		l->detect_a = now;
+	      break;
+	    }
+	  if (l->b == cur_node->id && l->a == peer)
+	    {
+	      if (l->what == SCEN_CUT && l->detect_b == 0)
+		l->detect_b = now;
+	      break;
+	    }
+	}
+    }
+
+  for (i = 0; i < scen.nflow; i++)
+    {
+      f = &scen.flow[i];
+      if (f->src != cur_node->id || a != sim_ip(f->dst))
+	continue;
+
+      if (type == FLIGHT_RT_BROKEN || type == FLIGHT_RT_SWITCH)
+	{
+	  if (f->broken[last] == 0)
+	    f->broken[last] = now;
+	  if (type == FLIGHT_RT_SWITCH && f->rerouted[last] == 0)
+	    /* An alternate took over right away */
+	    f->rerouted[last] = now;
+	}
+      else if (f->broken[last] != 0 && f->rerouted[last] == 0)
+	f->rerouted[last] = now;
+    }
+}
+
+/*
+ *   sim_rearm
+ *
+ *   Description:
+ *     Makes sure a SIM_EV_TIMER is pending for the first timer of a
+ *     node. Later events left from before are ignored when they come.
+ *
+ *   Arguments:
+ *     struct sim_node *sn - The node.
+ *
+ *   Return: None.
+*/
+void
+sim_rearm(struct sim_node *sn)
+{
+  struct prioqent *pqe;
+  u_int64_t t;
+
+  if ((pqe = pq_getfirst(&sn->node.pq)) == NULL)
+    return;
+
+  t = MAX(pqe->tv * 1000, cur->now);
+  if (sn->wake == 0 || t < sn->wake)
+    {
+      sn->wake = t;
+      sim_push(t, SIM_EV_TIMER, sn->id, sn->id, 0, NULL, NULL);
+    }
+}
+
+/*
+ *   disc_start
+ *
+ *   Description:
+ *     Starts a route discovery the way the daemon does for an ARP
+ *     request to an unknown host. A discovery already running for the
+ *     destination is joined.
+ *
+ *   Arguments:
+ *     struct sim_node *sn - The originating node.
+ *     u_int32_t dst_ip    - The destination.
+ *
+ *   Return: None.
+*/
+void
+disc_start(struct sim_node *sn, u_int32_t dst_ip)
+{
+  struct artentry *rte;
+  struct sim_disc *d;
+  struct info inf;
+
+  cur->disc_started++;
+
+  rte = getentry(&sn->node, dst_ip);
+  if (rte != NULL && rte->hop_cnt != 255)
+    {
+      cur->disc_known++;
+      return;
+    }
+
+  if (pq_getfirstofidflags(&sn->node.pq, dst_ip, PQ_PACKET_RREQ) == NULL)
+    {
+      inf.ip_pkt_dst_ip = dst_ip;
+      inf.ip_pkt_src_ip = sn->node.my_ip;
+      inf.ip_pkt_my_ip = sn->node.my_ip;
+      inf.ip_pkt_ttl = 1;
+      if (gen_rreq(&sn->node, &inf) == -1)
+	{
+	  cur->disc_failed++;
+	  return;
+	}
+    }
+
+  if ((d = malloc(sizeof(struct sim_disc))) == NULL)
+    {
+      cur->disc_failed++;
+      return;
+    }
+
+  d->dst_ip = dst_ip;
+  d->start = cur->now;
+  d->next = sn->discs;
+  sn->discs = d;
+}
+
+/*
+ *   disc_check
+ *
+ *   Description:
+ *     Ends the discoveries of a node that found a route. After a
+ *     timeout also those that gave up, they have no RREQ timer left.
+ *
+ *   Arguments:
+ *     struct sim_node *sn - The node.
+ *     int timeout         - 1 if a timer of the node just ran.
+ *
+ *   Return: None.
+*/
+void
+disc_check(struct sim_node *sn, int timeout)
+{
+  struct artentry *rte;
+  struct sim_disc **p;
+  struct sim_disc *d;
+
+  p = &sn->discs;
+  while ((d = *p) != NULL)
+    {
+      rte = getentry(&sn->node, d->dst_ip);
+      if (rte != NULL && rte->hop_cnt != 255)
+	{
+	  hist_add(&cur->latency, cur->now - d->start);
+	  cur->disc_ok++;
+	}
+      else if (timeout &&
+	       pq_getfirstofidflags(&sn->node.pq, d->dst_ip,
+				    PQ_PACKET_RREQ) == NULL)
+	cur->disc_failed++;
+      else
+	{
+	  p = &d->next;
+	  continue;
+	}
+
+      *p = d->next;
+      free(d);
+    }
+}
+
+/*
+ *   sim_forward
+ *
+ *   Description:
+ *     Passes a data packet on at a node, along the route the node has
+ *     for its destination, and refreshes that route as the daemon does
+ *     for the packets it sees. A source without a route starts a
+ *     discovery unless one is running, as the daemon does when the
+ *     kernel asks for the address of the destination. A forwarding
+ *     node without one sends a RERR, as the daemon does when its
+ *     kernel sends an ICMP host unreachable. A node repairing the route
+ *     holds the packet, which the daemon can't do.
+ *
+ *   Arguments:
+ *     struct sim_node *sn - The node the packet is at.
+ *     struct sim_msg *msg - The packet, freed when it ends here.
+ *
+ *   Return: None.
+*/
+void
+sim_forward(struct sim_node *sn, struct sim_msg *msg)
+{
+  struct sim_data *d = (struct sim_data*)msg->data;
+  struct scen_flow *f = &scen.flow[d->flow];
+  struct artentry *rte;
+  struct info inf;
+  u_int32_t dst_ip = msg->inf.ip_pkt_dst_ip;
+  int j;
+
+  if (sn->id == f->dst)
+    {
+      f->got[d->seq] = 1;
+      cur->data_ok++;
+      free(msg);
+      return;
+    }
+
+  rte = getentry(&sn->node, dst_ip);
+  if (local_repair(&sn->node, dst_ip) == 0)
+    {
+      /* The node holds the packet until the local repair is over */
+      if (!d->held)
+	{
+	  d->held = 1;
+	  cur->data_held++;
+	}
+      msg->from = sn->id;
+      if (sim_push(cur->now + SIM_HOLD_POLL, SIM_EV_DATA, sn->id, sn->id, 0,
+		   msg, NULL) == -1)
+	{
+	  cur->data_noroute++;
+	  free(msg);
+	}
+      return;
+    }
+
+  if (rte == NULL || rte->hop_cnt == 255)
+    {
+      /* The source looks for a route, the kernel of a forwarding node
+	 answers with an ICMP host unreachable that the daemon turns
+	 into a RERR */
+      if (pq_getfirstofidflags(&sn->node.pq, dst_ip, PQ_PACKET_RREQ) ==
+	  NULL)
+	{
+	  if (sn->id == f->src)
+	    disc_start(sn, dst_ip);
+	  else
+	    {
+	      inf.ip_pkt_dst_ip = dst_ip;
+	      inf.ip_pkt_src_ip = sn->node.my_ip;
+	      inf.ip_pkt_my_ip = sn->node.my_ip;
+	      inf.ip_pkt_ttl = 1;
+	      host_unr(&sn->node, &inf, dst_ip);
+	    }
+	}
+      cur->data_noroute++;
+      free(msg);
+      return;
+    }
+
+  rte->lifetime = MAX(rte->lifetime, getcurrtime() + ACTIVE_ROUTE_TIMEOUT);
+
+  if (--msg->inf.ip_pkt_ttl == 0)
+    {
+      cur->data_ttl++;
+      free(msg);
+      return;
+    }
+
+  j = ntohl(rte->nxt_hop) - SIM_NET - 1;
+  if (j < 0 || j >= nnodes || !sim_linked(sn, j))
+    {
+      cur->data_link++;
+      free(msg);
+      return;
+    }
+
+  /* Sent, whether it gets there or not */
+  if (implicit)
+    nb_sent(&sn->node, rte->nxt_hop);
+
+  if (chan.model != CHAN_DISK &&
+      (sim_random(&sn->rng) >> 11) * (1.0 / 9007199254740992.0) <
+      chan_loss(&chan, &topo, sn->id, j))
+    {
+      cur->data_lost++;
+      free(msg);
+      return;
+    }
+
+  msg->from = sn->id;
+  if (sim_push(cur->now + hop_delay, SIM_EV_DATA, j, sn->id, 0, msg,
+	       NULL) == -1)
+    {
+      cur->data_link++;
+      free(msg);
+    }
+}
+
+/*
+ *   sim_arrive
+ *
+ *   Description:
+ *     Decides what becomes of a message arriving at a node. The channel
+ *     model may lose it. With CSMA the reception takes the airtime of
+ *     the message and fails if another message overlaps it, or the
+ *     node sends meanwhile. The message is then handed to the node by
+ *     a SIM_EV_RXEND at the end of the airtime.
+ *
+ *   Arguments:
+ *     struct sim_node *sn - The receiving node.
+ *     struct sim_msg *msg - The message.
+ *
+ *   Return:
+ *     int - 1 if the message is to be handed to the node now, else 0.
+*/
+int
+sim_arrive(struct sim_node *sn, struct sim_msg *msg)
+{
+  struct sim_rx *rx;
+
+  if (chan.model != CHAN_DISK &&
+      (sim_random(&sn->rng) >> 11) * (1.0 / 9007199254740992.0) <
+      chan_loss(&chan, &topo, msg->from, sn->id))
+    {
+      cur->rx_lost[msg->cls]++;
+      return 0;
+    }
+
+  if (!chan.csma)
+    return 1;
+
+  if ((rx = malloc(sizeof(struct sim_rx))) == NULL)
+    {
+      cur->rx_lost[msg->cls]++;
+      return 0;
+    }
+
+  rx->end = cur->now + chan_airtime(msg->len);
+
+  /* Half duplex */
+  rx->collided = sn->tx_end > cur->now;
+
+  /* Any reception still going on overlaps the one that ends last */
+  if (sn->rx_end > cur->now)
+    {
+      rx->collided = 1;
+      if (sn->rx_last != NULL)
+	sn->rx_last->collided = 1;
+    }
+
+  if (rx->end > sn->rx_end)
+    {
+      sn->rx_end = rx->end;
+      sn->rx_last = rx;
+    }
+
+  /* The reception holds a reference of its own */
+  __atomic_add_fetch(&msg->refs, 1, __ATOMIC_RELAXED);
+  if (sim_push(rx->end, SIM_EV_RXEND, sn->id, sn->id, 0, msg, rx) == -1)
+    {
+      __atomic_sub_fetch(&msg->refs, 1, __ATOMIC_RELAXED);
+      if (sn->rx_last == rx)
+	sn->rx_last = NULL;
+      free(rx);
+      cur->rx_lost[msg->cls]++;
+    }
+
+  return 0;
+}
+
+/*
+ *   sim_deliver
+ *
+ *   Description:
+ *     Hands a received message to the protocol code of a node.
+ *
+ *   Arguments:
+ *     struct sim_node *sn - The receiving node.
+ *     struct sim_msg *msg - The message.
+ *
+ *   Return: None.
+*/
+void
+sim_deliver(struct sim_node *sn, struct sim_msg *msg)
+{
+  struct info inf;
+  char buf[SIM_MAXMSG];
+
+  cur->rx_ok[msg->cls]++;
+
+  /* The handlers may change the message, each receiver gets a copy */
+  memcpy(buf, msg->data, msg->len);
+  inf = msg->inf;
+  inf.ip_pkt_my_ip = sn->node.my_ip;
+  node_recv(&sn->node, &inf, buf, msg->len);
+
+  if (sn->discs != NULL)
+    disc_check(sn, 0);
+}
+
+/*
+ *   sim_handle
+ *
+ *   Description:
+ *     Runs an event at its node and charges the CPU time spent to it.
+ *
+ *   Arguments:
+ *     struct sim_ev *ev - The event.
+ *
+ *   Return: None.
+*/
+void
+sim_handle(struct sim_ev *ev)
+{
+  struct sim_node *sn = &nodes[ev->node];
+  struct scen_flow *f;
+  struct sim_data *d;
+  struct prioqent *pqe;
+  struct sim_msg *msg;
+  struct timespec t0;
+  struct timespec t1;
+  int *cut;
+  int i;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t0);
+  cur_node = sn;
+
+  switch (ev->type)
+    {
+    case SIM_EV_RECV:
+      if (sim_arrive(sn, ev->msg))
+	sim_deliver(sn, ev->msg);
+      if (__atomic_sub_fetch(&ev->msg->refs, 1, __ATOMIC_ACQ_REL) == 0)
+	free(ev->msg);
+      break;
+
+    case SIM_EV_TX:
+      sim_csma(sn);
+      break;
+
+    case SIM_EV_RXEND:
+      if (sn->rx_last == ev->rx)
+	sn->rx_last = NULL;
+      if (ev->rx->collided)
+	cur->rx_collided[ev->msg->cls]++;
+      else
+	sim_deliver(sn, ev->msg);
+      free(ev->rx);
+      if (__atomic_sub_fetch(&ev->msg->refs, 1, __ATOMIC_ACQ_REL) == 0)
+	free(ev->msg);
+      break;
+
+    case SIM_EV_TIMER:
+      if (ev->time != sn->wake)
+	/* Replaced by an earlier one */
+	break;
+
+      sn->wake = 0;
+      while ((pqe = pq_getfirstdue(&sn->node.pq, getcurrtime())) != NULL)
+	{
+	  pq_unqueuefirstent(&sn->node.pq);
+	  node_timer(&sn->node, pqe);
+	}
+      if (sn->discs != NULL)
+	disc_check(sn, 1);
+      break;
+
+    case SIM_EV_SWEEP:
+      find_inactives(&sn->node);
+      sim_push(cur->now + SIM_SWEEP_INTERVAL * 1000, SIM_EV_SWEEP, sn->id,
+	       sn->id, 0, NULL, NULL);
+      break;
+
+    case SIM_EV_HELLO:
+      node_hello(&sn->node);
+      break;
+
+    case SIM_EV_DISC:
+      disc_start(sn, ev->arg);
+      break;
+
+    case SIM_EV_CUT:
+      if ((cut = realloc(sn->cut, (sn->ncut + 1) * sizeof(int))) != NULL)
+	{
+	  sn->cut = cut;
+	  sn->cut[sn->ncut++] = ev->arg;
+	}
+      break;
+
+    case SIM_EV_RESTORE:
+      for (i = 0; i < sn->ncut; i++)
+	if (sn->cut[i] == ev->arg)
+	  {
+	    sn->cut[i] = sn->cut[--sn->ncut];
+	    break;
+	  }
+      break;
+
+    case SIM_EV_FLOW:
+      f = &scen.flow[ev->arg];
+      cur->data_sent++;
+      if ((msg = malloc(sizeof(struct sim_msg) +
+			sizeof(struct sim_data))) != NULL)
+	{
+	  msg->next = NULL;
+	  msg->refs = 1;
+	  msg->from = sn->id;
+	  msg->cls = CLS_NUM;
+	  msg->len = sizeof(struct sim_data);
+	  msg->inf.ip_pkt_src_ip = sn->node.my_ip;
+	  msg->inf.ip_pkt_dst_ip = sim_ip(f->dst);
+	  msg->inf.ip_pkt_my_ip = sn->node.my_ip;
+	  msg->inf.ip_pkt_ttl = SIM_DATA_TTL;
+	  d = (struct sim_data*)msg->data;
+	  d->flow = ev->arg;
+	  d->seq = f->next;
+	  d->held = 0;
+	  sim_forward(sn, msg);
+	}
+
+      if (++f->next < f->npkts)
+	sim_push(SIM_EPOCH + f->start + f->next * f->interval, SIM_EV_FLOW,
+		 sn->id, sn->id, ev->arg, NULL, NULL);
+      break;
+
+    case SIM_EV_DATA:
+      if (implicit)
+	hello_heard(&sn->node, sim_ip(ev->msg->from));
+      sim_forward(sn, ev->msg);
+      break;
+    }
+
+  sim_rearm(sn);
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1);
+  sn->cpu += (t1.tv_sec - t0.tv_sec) * 1000000000LL +
+    (t1.tv_nsec - t0.tv_nsec);
+}
+
+/*
+ *   sim_worker
+ *
+ *   Description:
+ *     Runs a partition. Every window starts at the first pending event
+ *     of all partitions and is one hop delay long, so no message sent
+ *     in it is due in it. The partitions meet at the barrier before and
+ *     after each window. Moving nodes are moved by the first partition
+ *     while the others wait, windows end where that is due.
+ *
+ *   Arguments:
+ *     void *arg - The partition.
+ *
+ *   Return:
+ *     void* - NULL
+*/
+void *
+sim_worker(void *arg)
+{
+  struct sim_part *p = arg;
+  struct sim_ev ev;
+  u_int64_t move_at = ~0ULL;
+  u_int64_t first;
+  u_int64_t limit;
+  int i;
+
+  cur = p;
+  if (topo.model != MOB_NONE)
+    move_at = SIM_EPOCH + SIM_MOVE_INTERVAL * 1000;
+
+  while (1)
+    {
+      /* All mail of the last window has been sent */
+      sim_drain(p);
+      p->next = p->heapn > 0 ? p->heap[0].time : ~0ULL;
+      pthread_barrier_wait(&barrier);
+
+      first = ~0ULL;
+      for (i = 0; i < nparts; i++)
+	first = MIN(first, parts[i].next);
+      if (first >= end)
+	break;
+
+      if (first >= move_at)
+	{
+	  /* Every partition keeps its own move_at, in step */
+	  while (first >= move_at)
+	    move_at += SIM_MOVE_INTERVAL * 1000;
+
+	  if (p->id == 0)
+	    {
+	      topo_step(&topo, (move_at - SIM_MOVE_INTERVAL * 1000 -
+				SIM_EPOCH) / 1e6);
+	      if (topo_links(&topo) == -1)
+		{
+		  perror("topo_links");
+		  exit(1);
+		}
+	    }
+
+	  pthread_barrier_wait(&barrier);
+	  continue;
+	}
+
+      limit = MIN(MIN(first + hop_delay, end), move_at);
+      if (p->id == 0)
+	windows++;
+
+      while (p->heapn > 0 && p->heap[0].time < limit)
+	{
+	  ev = p->heap[0];
+	  p->heap[0] = p->heap[--p->heapn];
+	  heap_down(p, 0);
+
+	  p->now = ev.time;
+	  clock_set(p->now / 1000);
+	  p->events++;
+	  sim_handle(&ev);
+	}
+
+      /* Everybody is done reading the next times */
+      pthread_barrier_wait(&barrier);
+    }
+
+  return NULL;
+}
+
+/*
+ *   report_json
+ *
+ *   Description:
+ *     Prints the results on one line of JSON, for scripts that run a
+ *     scenario many times.
+ *
+ *   Arguments:
+ *     struct sim_part *all - The added up results of the partitions.
+ *     u_int64_t span       - Simulated time, us.
+ *
+ *   Return: None.
+*/
+void
+report_json(struct sim_part *all, u_int64_t span)
+{
+  struct scen_link *l;
+  struct scen_flow *f;
+  struct scen_res res;
+  char buf[32];
+  char buf2[32];
+  int i;
+  int c;
+
+  printf("{\"scenario\":\"%s\",\"nodes\":%d,\"links\":%d,"
+	 "\"seconds\":%.1f,\"topology\":\"%s\",\"mobility\":\"%s\","
+	 "\"channel\":\"%s\",\"csma\":%d,\"control\":{",
+	 scen.name, nnodes, topo.nlinks, span / 1e6, topo_kinds[topo.kind],
+	 topo_models[topo.model], chan_models[chan.model], chan.csma);
+  for (c = 0; c < CLS_NUM; c++)
+    printf("%s\"%s\":[%llu,%llu]", c ? "," : "", cls_name[c],
+	   (unsigned long long)all->sent_msgs[c],
+	   (unsigned long long)all->sent_bytes[c]);
+  printf("},\"discoveries\":[%llu,%llu,%llu],",
+	 (unsigned long long)all->disc_started,
+	 (unsigned long long)all->disc_ok,
+	 (unsigned long long)all->disc_failed);
+  printf("\"rreq_fwd\":[%llu,%llu],\"rreq_gossip\":%llu,"
+	 "\"rreq_relay\":%llu,\"rreq_per_disc\":%.1f,\"ntt\":[%.1f,%llu],", (unsigned long long)all->fwd_sent,
+	 (unsigned long long)all->fwd_suppressed,
+	 (unsigned long long)all->gossip_dropped,
+	 (unsigned long long)all->mpr_dropped,
+	 all->disc_ok ? (double)all->sent_msgs[CLS_RREQ] / all->disc_ok : 0.0,
+	 all->ntt_nodes ? (double)all->ntt_sum / all->ntt_nodes : 0.0,
+	 (unsigned long long)all->ntt_nodes);
+  printf("\"data\":{\"sent\":%llu,\"delivered\":%llu,\"noroute\":%llu,"
+	 "\"link\":%llu,\"lost\":%llu,\"ttl\":%llu,\"held\":%llu},"
+	 "\"events\":[",
+	 (unsigned long long)all->data_sent, (unsigned long long)all->data_ok,
+	 (unsigned long long)all->data_noroute,
+	 (unsigned long long)all->data_link,
+	 (unsigned long long)all->data_lost, (unsigned long long)all->data_ttl,
+	 (unsigned long long)all->data_held);
+
+  for (i = 0; i < scen.nlink; i++)
+    {
+      l = &scen.link[i];
+      printf("%s{\"what\":\"%s\",\"a\":%d,\"b\":%d,\"time_ms\":%.1f,",
+	     i ? "," : "", l->what == SCEN_CUT ? "cut" : "restore", l->a,
+	     l->b, l->time / 1e3);
+      if (l->what == SCEN_CUT)
+	printf("\"detect_ms\":[%s,%s],", sim_ms(buf, l->detect_a, l->time),
+	       sim_ms(buf2, l->detect_b, l->time));
+      printf("\"flows\":[");
+      for (c = 0; c < scen.nflow; c++)
+	{
+	  f = &scen.flow[c];
+	  scen_result(&scen, i, c, span, &res);
+	  printf("%s{\"src\":%d,\"dst\":%d,\"sent\":%llu,\"lost\":%llu,"
+		 "\"outage_ms\":%.1f,\"gap_ms\":%.1f,", c ? "," : "",
+		 f->src, f->dst, (unsigned long long)res.sent,
+		 (unsigned long long)res.lost, res.outage / 1e3,
+		 res.window / 1e3);
+	  printf("\"broken_ms\":%s,", f->broken[i] == 0 ? "null" :
+		 sim_ms(buf, f->broken[i], l->time));
+	  printf("\"rerouted_ms\":%s}", f->rerouted[i] == 0 ? "null" :
+		 sim_ms(buf2, f->rerouted[i], l->time));
+	}
+      printf("]}");
+    }
+  printf("]}\n");
+}
+
+/*
+ *   report
+ *
+ *   Description:
+ *     Adds up the results of the partitions and prints them.
+ *
+ *   Arguments:
+ *     u_int64_t span - Simulated time, us.
+ *     double wall    - Wall clock time of the run, s.
+ *
+ *   Return: None.
+*/
+void
+report(u_int64_t span, double wall)
+{
+  struct sim_part all;
+  struct scen_link *l;
+  struct scen_flow *f;
+  struct scen_res res;
+  char buf[32];
+  char buf2[32];
+  u_int64_t total_msgs = 0;
+  u_int64_t total_bytes = 0;
+  double node_s;
+  int i;
+  int c;
+
+  memset(&all, 0, sizeof(all));
+  hist_init(&all.latency);
+  for (i = 0; i < nparts; i++)
+    {
+      hist_merge(&all.latency, &parts[i].latency);
+      all.disc_started += parts[i].disc_started;
+      all.disc_known += parts[i].disc_known;
+      all.disc_ok += parts[i].disc_ok;
+      all.disc_failed += parts[i].disc_failed;
+      for (c = 0; c < CLS_NUM; c++)
+	{
+	  all.sent_msgs[c] += parts[i].sent_msgs[c];
+	  all.sent_bytes[c] += parts[i].sent_bytes[c];
+	}
+      all.lost += parts[i].lost;
+      for (c = 0; c < CLS_NUM; c++)
+	{
+	  all.rx_ok[c] += parts[i].rx_ok[c];
+	  all.rx_lost[c] += parts[i].rx_lost[c];
+	  all.rx_collided[c] += parts[i].rx_collided[c];
+	}
+      all.krt_changes += parts[i].krt_changes;
+      all.events += parts[i].events;
+      all.mailed += parts[i].mailed;
+      all.data_sent += parts[i].data_sent;
+      all.data_ok += parts[i].data_ok;
+      all.data_noroute += parts[i].data_noroute;
+      all.data_link += parts[i].data_link;
+      all.data_lost += parts[i].data_lost;
+      all.data_ttl += parts[i].data_ttl;
+      all.data_held += parts[i].data_held;
+    }
+  for (i = 0; i < nnodes; i++)
+    {
+      all.fwd_sent += nodes[i].node.fwd_sent;
+      all.fwd_suppressed += nodes[i].node.fwd_suppressed;
+      all.gossip_dropped += nodes[i].node.gossip_dropped;
+      all.mpr_dropped += nodes[i].node.mpr_dropped;
+      if (nodes[i].node.rtt_samples > 0)
+	{
+	  all.ntt_sum += node_traversal_time(&nodes[i].node);
+	  all.ntt_nodes++;
+	}
+    }
+
+  if (json)
+    {
+      report_json(&all, span);
+      return;
+    }
+
+  node_s = (double)nnodes * span / 1e6;
+
+  printf("Nodes: %d  Links: %d  Simulated: %.1f s  Events: %llu\n",
+	 nnodes, topo.nlinks, span / 1e6, (unsigned long long)all.events);
+  printf("Topology: %s  Mobility: %s  Link changes: %llu\n",
+	   topo_kinds[topo.kind], topo_models[topo.model],
+	   (unsigned long long)topo.changes);
+  printf("Threads: %d  Windows: %llu  Crossing partitions: %llu\n",
+	 nparts, (unsigned long long)windows,
+	 (unsigned long long)all.mailed);
+  printf("Wall: %.3f s  %.0f events/s\n", wall,
+	 wall > 0 ? all.events / wall : 0.0);
+
+  printf("\nRoute discovery\n");
+  printf("  Started: %llu  In table: %llu  Succeeded: %llu  Failed: %llu  "
+	 "Unfinished: %llu\n", (unsigned long long)all.disc_started,
+	 (unsigned long long)all.disc_known, (unsigned long long)all.disc_ok,
+	 (unsigned long long)all.disc_failed, (unsigned long long)disc_open);
+  printf("  Latency ms  p50: %.3f  p90: %.3f  p99: %.3f  max: %.3f  "
+	 "mean: %.3f\n",
+	 hist_percentile(&all.latency, 50) / 1e3,
+	 hist_percentile(&all.latency, 90) / 1e3,
+	 hist_percentile(&all.latency, 99) / 1e3,
+	 all.latency.max / 1e3, hist_mean(&all.latency) / 1e3);
+  if (all.disc_ok > 0)
+    printf("  RREQs sent per successful discovery: %.1f\n",
+	   (double)all.sent_msgs[CLS_RREQ] / all.disc_ok);
+
+  printf("\nControl overhead (sent, AODV payload)\n");
+  for (c = 0; c < CLS_NUM; c++)
+    {
+      printf("  %-6s messages: %-10llu bytes: %llu\n", cls_name[c],
+	     (unsigned long long)all.sent_msgs[c],
+	     (unsigned long long)all.sent_bytes[c]);
+      total_msgs += all.sent_msgs[c];
+      total_bytes += all.sent_bytes[c];
+    }
+  printf("  %-6s messages: %-10llu bytes: %llu\n", "Total",
+	 (unsigned long long)total_msgs, (unsigned long long)total_bytes);
+  if (node_s > 0)
+    printf("  Per node and second: %.2f messages, %.1f bytes\n",
+	   total_msgs / node_s, total_bytes / node_s);
+  printf("  Unicasts out of reach: %llu  Kernel route changes: %llu\n",
+	 (unsigned long long)all.lost, (unsigned long long)all.krt_changes);
+  if (all.fwd_sent + all.fwd_suppressed > 0)
+    printf("  Delayed RREQ rebroadcasts sent: %llu  suppressed: %llu\n",
+	   (unsigned long long)all.fwd_sent,
+	   (unsigned long long)all.fwd_suppressed);
+  if (all.gossip_dropped > 0)
+    printf("  RREQs gossip did not rebroadcast: %llu\n",
+	   (unsigned long long)all.gossip_dropped);
+  if (all.mpr_dropped > 0)
+    printf("  RREQs left to the relays: %llu\n",
+	   (unsigned long long)all.mpr_dropped);
+  if (all.ntt_nodes > 0)
+    printf("  Node traversal time: %.1f ms, mean of %llu nodes that "
+	   "measured it\n", (double)all.ntt_sum / all.ntt_nodes,
+	   (unsigned long long)all.ntt_nodes);
+
+  printf("\nChannel: %s%s\n", chan_models[chan.model],
+	 chan.csma ? " with CSMA" : "");
+  for (c = 0; c < CLS_NUM; c++)
+    printf("  %-6s received: %-10llu lost: %-10llu collided: %llu\n",
+	   cls_name[c], (unsigned long long)all.rx_ok[c],
+	   (unsigned long long)all.rx_lost[c],
+	   (unsigned long long)all.rx_collided[c]);
+
+  printf("\nCPU time in the protocol code\n");
+  printf("  Total: %.3f ms  Per node  p50: %.1f us  p99: %.1f us  "
+	 "max: %.1f us  mean: %.1f us\n",
+	 cpu.sum / 1e6, hist_percentile(&cpu, 50) / 1e3,
+	 hist_percentile(&cpu, 99) / 1e3, cpu.max / 1e3,
+	 hist_mean(&cpu) / 1e3);
+  if (node_s > 0)
+    printf("  Per node and simulated second: %.2f us\n",
+	   cpu.sum / 1e3 / node_s);
+
+  if (scen.nlink == 0 && scen.nflow == 0)
+    return;
+
+  printf("\nScenario: %s\n", scen.name);
+  printf("  Data sent: %llu  Delivered: %llu  No route: %llu  "
+	 "Link down: %llu  Lost: %llu  TTL: %llu  Held: %llu\n",
+	 (unsigned long long)all.data_sent, (unsigned long long)all.data_ok,
+	 (unsigned long long)all.data_noroute,
+	 (unsigned long long)all.data_link,
+	 (unsigned long long)all.data_lost, (unsigned long long)all.data_ttl,
+	 (unsigned long long)all.data_held);
+  for (i = 0; i < scen.nlink; i++)
+    {
+      l = &scen.link[i];
+      printf("  %s %d-%d at %.3f s", l->what == SCEN_CUT ? "Cut" : "Restore",
+	     l->a, l->b, l->time / 1e6);
+      if (l->what == SCEN_CUT)
+	printf("  Detected by %d: %s  by %d: %s", l->a,
+	       sim_ms(buf, l->detect_a, l->time), l->b,
+	       sim_ms(buf2, l->detect_b, l->time));
+      printf("\n");
+
+      for (c = 0; c < scen.nflow; c++)
+	{
+	  f = &scen.flow[c];
+	  scen_result(&scen, i, c, span, &res);
+	  if (res.sent == 0)
+	    continue;
+	  printf("    Flow %d->%d  sent: %llu  lost: %llu  outage: %.1f ms"
+		 "  longest gap: %.1f ms", f->src, f->dst,
+		 (unsigned long long)res.sent, (unsigned long long)res.lost,
+		 res.outage / 1e3, res.window / 1e3);
+	  if (f->broken[i] != 0)
+	    printf("  broken: %s  rerouted: %s",
+		   sim_ms(buf, f->broken[i], l->time),
+		   sim_ms(buf2, f->rerouted[i], l->time));
+	  printf("\n");
+	}
+    }
+}
+
+/* ------------------------------------------------------------------- */
+
+int
+main(int argc, char *argv[])
+{
+  struct sim_disc *d;
+  struct sim_msg *msg;
+  struct sim_ev *ev;
+  struct sim_part *p;
+  struct timespec w0;
+  struct timespec w1;
+  u_int64_t seed = 1;
+  u_int64_t span = 60;
+  u_int64_t warm = 6;
+  int ndiscs = 100;
+  int hellos = 1;
+  int src;
+  int dst;
+  int opt;
+  int i;
+  char *scenario = NULL;
+  char *flaps = NULL;
+  struct scen_link *l;
+  double range = 250;
+  double degree = 8;
+  double speed = 10;
+  double pause = 0;
+  int kind = TOPO_GRID;
+  int model = MOB_NONE;
+  double loss = 0.3;
+  int channel = CHAN_DISK;
+  int csma = 0;
+  int metric = METRIC_HOPS;
+  int repair_ttl = 0;
+  int multipath = 0;
+  int fwd_limit = 0;
+  int gossip = 0;
+  int mpr = 0;
+
+  nnodes = 100;
+  while ((opt = getopt(argc, argv,
+		       "n:r:t:w:l:s:j:qT:f:R:d:M:v:p:c:L:CS:JEIH:PB:G:O")) != -1)
+    {
+      switch (opt)
+	{
+	case 'n':
+	  nnodes = atoi(optarg);
+	  break;
+
+	case 'r':
+	  ndiscs = atoi(optarg);
+	  break;
+
+	case 't':
+	  span = strtoull(optarg, NULL, 10);
+	  break;
+
+	case 'w':
+	  warm = strtoull(optarg, NULL, 10);
+	  break;
+
+	case 'l':
+	  hop_delay = strtoull(optarg, NULL, 10);
+	  break;
+
+	case 's':
+	  seed = strtoull(optarg, NULL, 10);
+	  break;
+
+	case 'j':
+	  nparts = atoi(optarg);
+	  break;
+
+	case 'q':
+	  hellos = 0;
+	  break;
+
+	case 'T':
+	  kind = sim_lookup(topo_kinds, optarg);
+	  break;
+
+	case 'f':
+	  scenario = optarg;
+	  break;
+
+	case 'R':
+	  range = atof(optarg);
+	  break;
+
+	case 'd':
+	  degree = atof(optarg);
+	  break;
+
+	case 'M':
+	  model = sim_lookup(topo_models, optarg);
+	  break;
+
+	case 'v':
+	  speed = atof(optarg);
+	  break;
+
+	case 'p':
+	  pause = atof(optarg);
+	  break;
+
+	case 'c':
+	  channel = sim_lookup(chan_models, optarg);
+	  break;
+
+	case 'L':
+	  loss = atof(optarg);
+	  break;
+
+	case 'C':
+	  csma = 1;
+	  break;
+
+	case 'S':
+	  flaps = optarg;
+	  break;
+
+	case 'J':
+	  json = 1;
+	  break;
+
+	case 'E':
+	  metric = METRIC_ETX;
+	  break;
+
+	case 'I':
+	  implicit = 1;
+	  break;
+
+	case 'H':
+	  repair_ttl = atoi(optarg);
+	  break;
+
+	case 'P':
+	  multipath = 1;
+	  break;
+
+	case 'B':
+	  fwd_limit = atoi(optarg);
+	  break;
+
+	case 'G':
+	  gossip = atoi(optarg);
+	  break;
+
+	case 'O':
+	  mpr = 1;
+	  break;
+
+	default:
+	  kind = -1;
+	  break;
+	}
+    }
+
+  if (kind < 0 || kind == TOPO_FILE || model < 0 ||
+      chan_init(&chan, channel, csma, loss, seed) == -1)
+    {
+      fprintf(stderr, "Usage: %s [-n nodes] [-r discoveries] "
+	      "[-t seconds] [-w seconds] [-l delay] [-s seed] "
+	      "[-j threads] [-q] [-T grid|line|rgg|cluster] [-f scenario] "
+	      "[-R range] [-d degree] [-M none|waypoint|gauss|group|file] "
+	      "[-v speed] [-p pause] [-c disk|distance|asym] [-L loss] "
+	      "[-C] [-S flaps] [-J] [-E] [-I] [-H hops] [-P] [-B copies] "
+	      "[-G percent] [-O]\n", argv[0]);
+      exit(1);
+    }
+
+  /* The placement has a generator of its own, the discoveries stay the
+     same whatever the topology */
+  if (scenario != NULL)
+    {
+      if (topo_load(&topo, scenario, range, seed) == -1)
+	{
+	  fprintf(stderr, "%s: can't load %s\n", argv[0], scenario);
+	  exit(1);
+	}
+      nnodes = topo.n;
+    }
+  else if (nnodes >= 1 &&
+	   topo_init(&topo, kind, nnodes, range, degree, seed) == -1)
+    {
+      fprintf(stderr, "%s: the range and degree must be above 0\n",
+	      argv[0]);
+      exit(1);
+    }
+
+  if (nnodes >= 1 && topo_mobility(&topo, model, speed, pause) == -1)
+    {
+      fprintf(stderr, "%s: mobility needs a speed above 0, file needs "
+	      "-f\n", argv[0]);
+      exit(1);
+    }
+
+  if (nnodes < 2 || nnodes >= 0xffffff || ndiscs < 0 || warm >= span)
+    {
+      fprintf(stderr, "%s: need 2 or more nodes and a warm-up shorter "
+	      "than the run\n", argv[0]);
+      exit(1);
+    }
+
+  /* The hop delay is the lookahead, it can't be 0 */
+  if (hop_delay < 1 || nparts < 1 || nparts > SIM_MAXTHREADS)
+    {
+      fprintf(stderr, "%s: the hop delay must be 1 us or more and the "
+	      "threads 1 to %d\n", argv[0], SIM_MAXTHREADS);
+      exit(1);
+    }
+  nparts = MIN(nparts, nnodes);
+
+  /* A zero state would stay zero */
+  rng = seed * 0x9e3779b97f4a7c15ULL + 1;
+  span *= 1000000;
+  warm *= 1000000;
+  end = SIM_EPOCH + span;
+
+  strcpy(scen.name, "none");
+  if (flaps != NULL && scen_load(&scen, flaps, nnodes, span) == -1)
+    exit(1);
+
+  clock_source(CLOCK_SRC_VIRTUAL);
+  clock_set(SIM_EPOCH / 1000);
+  hist_init(&cpu);
+
+  if ((nodes = calloc(nnodes, sizeof(struct sim_node))) == NULL ||
+      (parts = calloc(nparts, sizeof(struct sim_part))) == NULL ||
+      topo_links(&topo) == -1)
+    {
+      perror("malloc");
+      exit(1);
+    }
+
+  for (i = 0; i < nparts; i++)
+    {
+      parts[i].id = i;
+      parts[i].now = SIM_EPOCH;
+      hist_init(&parts[i].latency);
+    }
+
+  for (i = 0; i < nnodes; i++)
+    {
+      nodes[i].id = i;
+      nodes[i].part = (long)i * nparts / nnodes;
+      nodes[i].rng = (((seed << 24) + i + 1) * 0x9e3779b97f4a7c15ULL) | 1;
+      if (node_init(&nodes[i].node, sim_ip(i)) == -1)
+	{
+	  perror("node_init");
+	  exit(1);
+	}
+      nodes[i].node.metric = metric;
+      nodes[i].node.repair_ttl = repair_ttl;
+      nodes[i].node.multipath = multipath;
+      nodes[i].node.fwd_limit = fwd_limit;
+      nodes[i].node.gossip = gossip;
+      nodes[i].node.mpr = mpr;
+      /* The jitter follows the seed too */
+      nodes[i].node.rng = (nodes[i].rng * 0xbf58476d1ce4e5b9ULL) | 1;
+
+      /* Nodes don't start in step */
+      if (hellos)
+	sim_push(SIM_EPOCH + sim_random(&rng) % (HELLO_INTERVAL * 1000),
+		 SIM_EV_HELLO, i, SIM_SETUP, 0, NULL, NULL);
+      sim_push(SIM_EPOCH + sim_random(&rng) % (SIM_SWEEP_INTERVAL * 1000),
+	       SIM_EV_SWEEP, i, SIM_SETUP, 0, NULL, NULL);
+    }
+
+  for (i = 0; i < ndiscs; i++)
+    {
+      src = sim_random(&rng) % nnodes;
+      dst = sim_random(&rng) % (nnodes - 1);
+      if (dst >= src)
+	dst++;
+      sim_push(SIM_EPOCH + warm + sim_random(&rng) % (span - warm),
+	       SIM_EV_DISC, src, SIM_SETUP, sim_ip(dst), NULL, NULL);
+    }
+
+  /* Each end of a link takes the cut on its own, so only its own
+     partition touches its list */
+  for (l = scen.link; l < scen.link + scen.nlink; l++)
+    {
+      sim_push(SIM_EPOCH + l->time,
+	       l->what == SCEN_CUT ? SIM_EV_CUT : SIM_EV_RESTORE, l->a,
+	       SIM_SETUP, l->b, NULL, NULL);
+      sim_push(SIM_EPOCH + l->time,
+	       l->what == SCEN_CUT ? SIM_EV_CUT : SIM_EV_RESTORE, l->b,
+	       SIM_SETUP, l->a, NULL, NULL);
+    }
+
+  for (i = 0; i < scen.nflow; i++)
+    if (scen.flow[i].npkts > 0)
+      sim_push(SIM_EPOCH + scen.flow[i].start, SIM_EV_FLOW, scen.flow[i].src,
+	       SIM_SETUP, i, NULL, NULL);
+
+  if (pthread_barrier_init(&barrier, NULL, nparts) != 0)
+    {
+      perror("pthread_barrier_init");
+      exit(1);
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &w0);
+
+  /* This thread runs the first partition */
+  for (i = 1; i < nparts; i++)
+    if (pthread_create(&parts[i].tid, NULL, sim_worker, &parts[i]) != 0)
+      {
+	perror("pthread_create");
+	exit(1);
+      }
+  sim_worker(&parts[0]);
+  for (i = 1; i < nparts; i++)
+    pthread_join(parts[i].tid, NULL);
+
+  clock_gettime(CLOCK_MONOTONIC, &w1);
+
+  for (i = 0; i < nnodes; i++)
+    {
+      hist_add(&cpu, nodes[i].cpu);
+      while ((d = nodes[i].discs) != NULL)
+	{
+	  disc_open++;
+	  nodes[i].discs = d->next;
+	  free(d);
+	}
+    }
+
+  report(span, (w1.tv_sec - w0.tv_sec) + (w1.tv_nsec - w0.tv_nsec) / 1e9);
+
+  /* Messages still on the medium */
+  cur = NULL;
+  for (p = parts; p < parts + nparts; p++)
+    {
+      for (ev = p->heap; ev < p->heap + p->heapn; ev++)
+	{
+	  if (ev->type == SIM_EV_RXEND)
+	    free(ev->rx);
+	  if ((ev->type == SIM_EV_RECV || ev->type == SIM_EV_RXEND ||
+	       ev->type == SIM_EV_DATA) && --ev->msg->refs == 0)
+	    free(ev->msg);
+	}
+      free(p->heap);
+    }
+
+  for (i = 0; i < nnodes; i++)
+    {
+      while ((msg = nodes[i].txq) != NULL)
+	{
+	  nodes[i].txq = msg->next;
+	  free(msg);
+	}
+      node_free(&nodes[i].node);
+      free(nodes[i].cut);
+    }
+
+  pthread_barrier_destroy(&barrier);
+  free(parts);
+  topo_free(&topo);
+  scen_free(&scen);
+  free(nodes);
+
+  return 0;
+}
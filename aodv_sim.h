@@ -0,0 +1,377 @@
+/*
+ *	FILE: aodv_sim.c
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ *      Usage:
+ *        aodv_sim [-n nodes] [-r discoveries] [-t seconds] [-w seconds]
+ *                 [-l delay] [-s seed] [-j threads] [-q]
+ *                 [-T grid|line|rgg|cluster] [-f scenario] [-R range]
+ *                 [-d degree] [-M none|waypoint|gauss|group|file]
+ *                 [-v speed] [-p pause] [-c disk|distance|asym]
+ *                 [-L loss] [-C] [-S flaps] [-J] [-E] [-I] [-H hops] [-P]
+ *                 [-B copies] [-G percent] [-O]
+ *
+ *        -n  Number of nodes (100).
+ *        -r  Number of route discoveries, started at random times
+ *            between the warm-up and the end between random pairs (100).
+ *        -t  Simulated time in seconds (60).
+ *        -w  Warm-up in seconds before the first discovery (6).
+ *        -l  Delay of one hop in us (1000).
+ *        -s  Seed, runs with the same seed and options are identical (1).
+ *        -j  Number of worker threads, does not change the results (1).
+ *        -q  Don't send HELLOs.
+ *        -T  Placement of the nodes, see topo.h (grid).
+ *        -f  Place and move the nodes as in an ns-2 setdest scenario,
+ *            the number of nodes is taken from it.
+ *        -R  Radio range in m (250).
+ *        -d  Mean number of neighbours of rgg and cluster (8).
+ *        -M  Mobility model, file for the setdest commands of -f (none).
+ *        -v  Highest speed in m/s (10).
+ *        -p  Pause at each random waypoint in s (0).
+ *        -c  Channel model, see chan.h (disk).
+ *        -L  Highest loss of a link with asym, 0 to 1 (0.3).
+ *        -C  CSMA: messages take airtime, senders back off and
+ *            overlapping messages are lost.
+ *        -S  Cut and restore links and run flows of data as in a
+ *            scenario, see scen.h.
+ *        -J  Print the results as one line of JSON.
+ *        -E  Choose routes by the ETX of the first hop, see neighbour.h.
+ *        -I  Data packets stand in for HELLOs, as with aodv_daemon -i.
+ *        -H  Repair broken routes at most hops long locally, as with
+ *            aodv_daemon -r. A repairing node holds the data packets
+ *            for the route until the repair is over (0).
+ *        -P  Keep alternate next hops and switch to one when a link
+ *            breaks, as with aodv_daemon -m.
+ *        -B  Rebroadcast a RREQ after a random jitter, and not at all if
+ *            this many copies from other nodes arrive meanwhile, as with
+ *            aodv_daemon -b (0, at once).
+ *        -G  Rebroadcast that percent of the RREQs further than
+ *            GOSSIP_HOPS from the source, scaled by the number of
+ *            neighbours, as with aodv_daemon -g (0, all).
+ *        -O  Only relays elected from the two-hop neighbours rebroadcast
+ *            RREQs, as with aodv_daemon -o. The HELLOs list the
+ *            neighbours and are never skipped.
+ *
+ ********************************
+ *
+ *	General description:
+ *      -------------------
+ *
+ * Runs many AODV nodes in one process, in simulated time. Each node is
+ * a struct aodv_node driven by the real protocol code through node_recv,
+ * node_timer and node_hello, as in the daemon. Only the edges are
+ * replaced: this file links its own net_send, which puts messages on a
+ * simulated broadcast medium, and its own add_kroute and del_kroute,
+ * which only count. The clock runs on its virtual source and is set to
+ * the time of each event. No socket, timer signal or kernel route is
+ * used.
+ *
+ * The medium delivers a message to the nodes in radio range of the
+ * sender, or to the one of them it is addressed to, after the hop
+ * delay. The channel model may lose it on the way. With CSMA the
+ * sender queues it, waits a backoff and sends it if the medium it
+ * senses is free, else backs off again. A receiver hands the message
+ * to the node after its airtime, if no other message overlapped it.
+ * A node senses a message when it arrives, so carrier sense lags by
+ * the hop delay; CSMA wants a hop delay well below the airtime, like
+ * -l 2.
+ *
+ * When the nodes move, their positions and links are updated every
+ * SIM_MOVE_INTERVAL, between two windows.
+ *
+ * The nodes are split into partitions of consecutive nodes, one per
+ * worker thread. topo.c numbers the nodes so that a partition is a
+ * strip of the area. Each partition keeps its events in a heap of its
+ * own. The partitions run in windows as long as the hop delay, the
+ * lookahead: no message sent in a window can arrive in it,
+ * so the partitions run a window without waiting for each other and
+ * meet at a barrier after it. Messages to a node of another partition
+ * are pushed on a lock-free list of that partition and moved into its
+ * heap after the barrier.
+ *
+ * The events of a node are ordered by time, then by the node that
+ * scheduled them and the number it gave them. That order does not
+ * depend on the partitions, so the results are the same for any
+ * number of threads.
+ *
+ * A scenario (-S) cuts links and restores them, and runs flows of data
+ * packets. A packet goes from node to node along the routes in their
+ * tables, one hop delay per hop, and refreshes the route it takes as
+ * the daemon does for the packets it sees. A node without a route
+ * drops it. The source then starts a discovery, a forwarding node
+ * sends a RERR as the daemon does on the ICMP host unreachable of its
+ * kernel. Data takes no airtime. A cut link carries neither data nor AODV messages, but
+ * the nodes stay in range: as with a radio, the break is only noticed
+ * when HELLOs stop coming. flight_event is replaced too, it records
+ * when routes over a cut link break and when the sources of the flows
+ * lose and regain their routes.
+ *
+ * Reports route discovery latency, control overhead, receptions lost
+ * by the channel and the CPU time spent in the protocol code per node,
+ * and for a scenario the delivery of the flows and how long each cut
+ * took to be noticed and repaired.
+ *
+ *	Internal procedures:
+ *
+ * sim_random()
+ * sim_ip()
+ * sim_lookup()
+ * sim_ms()
+ * ev_less()
+ * heap_up()
+ * heap_down()
+ * heap_add()
+ * sim_push()
+ * sim_drain()
+ * sim_linked()
+ * sim_transmit()
+ * sim_csma()
+ * sim_rearm()
+ * disc_start()
+ * disc_check()
+ * sim_forward()
+ * sim_arrive()
+ * sim_deliver()
+ * sim_handle()
+ * sim_worker()
+ * report_json()
+ * report()
+ *
+ *	External procedures:
+ *
+ * net_send()
+ * add_kroute()
+ * del_kroute()
+ * flight_event()
+ * main()
+ *
+ ********************************
+ *
+ *   Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef AODV_SIM_H
+#define AODV_SIM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "aodv.h"
+#include "info.h"
+#include "node.h"
+#include "neighbour.h"
+#include "hello.h"
+#include "RT.h"
+#include "timer.h"
+#include "find_inactives.h"
+#include "gen_rreq.h"
+#include "rerr.h"
+#include "krtable.h"
+#include "hist.h"
+#include "clock.h"
+#include "topo.h"
+#include "chan.h"
+#include "scen.h"
+#include "rtt.h"
+
+/* Node i has the address SIM_NET + i + 1 */
+#define SIM_NET 0x0a000000
+
+/* Simulated time starts here, in us. Keeps lifetimes computed as
+   now minus something positive */
+#define SIM_EPOCH 1000000000ULL
+
+/* How often each node looks for expired routes, in ms. The daemon does
+   it on every pass of its main loop */
+#define SIM_SWEEP_INTERVAL 1000
+
+/* How often moving nodes get new positions and links, in ms */
+#define SIM_MOVE_INTERVAL 100
+
+/* Origin of the events scheduled before the run */
+#define SIM_SETUP 0xffffffff
+
+/* Largest number of worker threads */
+#define SIM_MAXTHREADS 256
+
+/* Largest AODV message, a RERR with 255 destinations */
+#define SIM_MAXMSG (4 + 8 * 255)
+
+/* Event types */
+#define SIM_EV_RECV   1         /* Message arrives at node, with CSMA
+				   its first bit */
+#define SIM_EV_TIMER  2         /* The first timer of node may be due */
+#define SIM_EV_SWEEP  3         /* find_inactives on node */
+#define SIM_EV_HELLO  4         /* node starts its HELLOs */
+#define SIM_EV_DISC   5         /* node looks for a route to arg */
+#define SIM_EV_RXEND  6         /* node has received rx, with CSMA */
+#define SIM_EV_TX     7         /* Backoff of node is over, with CSMA */
+#define SIM_EV_CUT    8         /* node loses its link to arg */
+#define SIM_EV_RESTORE 9        /* node has its link to arg back */
+#define SIM_EV_FLOW   10        /* Flow arg sends its next packet */
+#define SIM_EV_DATA   11        /* Data packet msg arrives at node */
+
+/* IP ttl of the data packets */
+#define SIM_DATA_TTL 64
+
+/* How often a node that holds a data packet for a route being repaired
+   looks at the route again, us */
+#define SIM_HOLD_POLL 10000
+
+/* Message classes for the overhead counters */
+#define CLS_HELLO 0
+#define CLS_RREQ  1
+#define CLS_RREP  2
+#define CLS_RERR  3
+#define CLS_NUM   4
+
+/* What a data packet carries, in the data of its struct sim_msg */
+struct sim_data
+{
+  int flow;                       /* Index of the flow in the scenario */
+  u_int32_t seq;                  /* Number of the packet in the flow */
+  int held;                       /* 1 once held for a local repair */
+};
+
+/* A message on the medium, shared by all its receivers */
+struct sim_msg
+{
+  struct sim_msg *next;           /* In the queue of the sender */
+  int refs;                       /* Receivers that still hold it, may
+				     be in other partitions */
+  int from;                       /* Index of the sender */
+  int cls;                        /* CLS_ constant, CLS_NUM for data */
+  int len;
+  struct info inf;                /* Sender, destination and ttl */
+  char data[1];                   /* The message, len bytes */
+};
+
+/* An event */
+struct sim_ev
+{
+  u_int64_t time;                 /* Simulated time, us */
+  u_int32_t node;                 /* Index of the node */
+  u_int32_t origin;               /* Node that scheduled it, or SIM_SETUP */
+  u_int64_t oseq;                 /* Number given to it by the origin */
+  int type;                       /* SIM_EV_ constant */
+  u_int32_t arg;                  /* Destination of a SIM_EV_DISC */
+  struct sim_msg *msg;            /* Message of a SIM_EV_RECV or
+				     SIM_EV_RXEND */
+  struct sim_rx *rx;              /* Reception of a SIM_EV_RXEND */
+};
+
+/* A message being received with CSMA */
+struct sim_rx
+{
+  u_int64_t end;                  /* us */
+  int collided;                   /* Overlapped by another message */
+};
+
+/* An event sent to another partition */
+struct sim_mail
+{
+  struct sim_ev ev;
+  struct sim_mail *next;
+};
+
+/* A partition of the nodes, run by one worker thread */
+struct sim_part
+{
+  int id;
+  pthread_t tid;
+  struct sim_ev *heap;            /* Pending events */
+  int heapn;
+  int heapmax;
+  u_int64_t now;                  /* Simulated time, us */
+  u_int64_t next;                 /* First event after the mail is in */
+
+  /* Pushed to by the other partitions, taken whole by this one */
+  struct sim_mail *mail __attribute__ ((aligned (64)));
+  char pad[64 - sizeof(struct sim_mail*)];
+
+  /* Results */
+  struct hist latency;            /* Discovery latency, us */
+  u_int64_t disc_started;
+  u_int64_t disc_known;           /* Route was already in the table */
+  u_int64_t disc_ok;
+  u_int64_t disc_failed;
+  u_int64_t sent_msgs[CLS_NUM];
+  u_int64_t sent_bytes[CLS_NUM];
+  u_int64_t lost;                 /* Unicasts to a node out of reach */
+  u_int64_t rx_ok[CLS_NUM];       /* Receptions handed to the node */
+  u_int64_t rx_lost[CLS_NUM];     /* Lost by the channel model */
+  u_int64_t rx_collided[CLS_NUM]; /* Lost to overlapping messages */
+  u_int64_t krt_changes;
+  u_int64_t data_sent;            /* Data packets sent by the flows */
+  u_int64_t data_ok;              /* that arrived */
+  u_int64_t data_noroute;         /* dropped by a node without a route */
+  u_int64_t data_link;            /* sent to a node out of reach */
+  u_int64_t data_lost;            /* lost by the channel model */
+  u_int64_t data_ttl;             /* that ran out of ttl */
+  u_int64_t data_held;            /* held during a local repair */
+  u_int64_t fwd_sent;             /* Delayed RREQ rebroadcasts sent */
+  u_int64_t fwd_suppressed;       /* and dropped, see rreq_forward */
+  u_int64_t gossip_dropped;       /* RREQs gossip didn't rebroadcast */
+  u_int64_t mpr_dropped;          /* RREQs left to the relays */
+  u_int64_t ntt_sum;              /* Node traversal times of the */
+  u_int64_t ntt_nodes;            /* nodes that measured one */
+  u_int64_t events;
+  u_int64_t mailed;               /* Events sent to other partitions */
+};
+
+/* A route discovery in progress */
+struct sim_disc
+{
+  u_int32_t dst_ip;
+  u_int64_t start;                /* us */
+  struct sim_disc *next;
+};
+
+/* A simulated node. The protocol state comes first so the struct
+   aodv_node given to net_send leads back to it */
+struct sim_node
+{
+  struct aodv_node node;
+  int id;
+  int part;                       /* Index of its partition */
+  u_int64_t oseq;                 /* Events it has scheduled */
+  u_int64_t wake;                 /* Pending SIM_EV_TIMER, 0 = none */
+  u_int64_t rng;                  /* Own generator, for losses and
+				     backoffs */
+  u_int64_t tx_end;               /* Medium busy sending until, us */
+  u_int64_t rx_end;               /* Medium busy receiving until, us */
+  struct sim_rx *rx_last;         /* Reception that ends at rx_end */
+  struct sim_msg *txq;            /* Messages waiting for the medium */
+  struct sim_msg *txq_tail;
+  struct sim_disc *discs;         /* Own discoveries in progress */
+  int *cut;                       /* Nodes its links to are cut */
+  int ncut;
+  u_int64_t sent;                 /* Messages sent */
+  u_int64_t cpu;                  /* CPU time in the protocol code, ns */
+};
+
+#endif
@@ -0,0 +1,423 @@
+/*
+ *	FILE: aodv_trace.c
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ *      Usage:
+ *        aodv_trace [-H] [-t type]... [-a address] [-d in|out] [file]
+ *
+ ********************************
+ *
+ *	General description:
+ *      -------------------
+ *
+ * Decodes a control traffic trace written by aodv_daemon and prints the
+ * messages in the same text format the daemon used to write to
+ * logmsg.txt.
+ *
+ *	Internal procedures:
+ *
+ * septime()
+ * print_rreq()
+ * print_rrep()
+ * print_rerr()
+ * print_krt()
+ * print_header()
+ * match()
+ *
+ *	External procedures:
+ *
+ * main()
+ *
+ ********************************
+ *
+ *   Extendend RCS Info: $Id$
+ *
+ */
+
+#include "aodv_trace.h"
+
+/* Filters set from the command line */
+int       f_types = TYPE_ALL;
+u_int32_t f_addr = 0;
+int       f_dir = -1;
+
+/*
+ *   septime
+ *
+ *   Description:
+ *     Writes the 64bit number in groups of two
+ *     to the buffer, separated by :'s.
+ *
+ *   Arguments:
+ *     char *buffer     - The buffer to be written in to
+ *     u_int64_t u64num - The 64 bit number to be written
+ *
+ *   Return:
+ *     char*            - Sames as the input buffer
+*/
+char *
+septime(char *buffer, u_int64_t u64num)
+{
+  char tmpbuff[MAXBUFLEN];
+  int i = 0, j = 0;
+
+  sprintf(tmpbuff, "%llu", (unsigned long long)u64num);
+  for (i = 0;i < strlen(tmpbuff); i++)
+    {
+      buffer[j++] = tmpbuff[i];
+      if ((i + 1) % 2 == 0 && (i + 1) != strlen(tmpbuff))
+	buffer[j++] = ':';
+    }
+  buffer[j] = '\0';
+
+  return buffer;
+}
+
+/*
+ *   print_rreq
+ *
+ *   Description:
+ *     Prints a RREQ package.
+ *
+ *   Arguments:
+ *     struct rreq* pkt - The packet to be printed.
+ *
+ *   Return: None.
+*/
+void
+print_rreq(struct rreq* pkt)
+{
+  printf("Type: %u(RREQ)  J: %u  R: %u  Reserved: %u  Hop Count: %u\n",
+	 pkt->type,pkt->j, pkt->r, pkt->reserved, pkt->hop_cnt);
+  printf("BroadcastID: %u\n", pkt->broadcast_id);
+  printf("Dst IP: %s\tDst Seq nr: %u\n",
+	 inet_ntoa(*((struct in_addr*)&pkt->dst_ip)), pkt->dst_seq);
+  printf("Src IP: %s\tSrc seq nr: %u\n",
+	 inet_ntoa(*((struct in_addr*)&pkt->src_ip)), pkt->src_seq);
+}
+
+/*
+ *   print_rrep
+ *
+ *   Description:
+ *     Prints a RREP package.
+ *
+ *   Arguments:
+ *     struct rrep* pkt - The packet to be printed.
+ *
+ *   Return: None.
+*/
+void
+print_rrep(struct rrep* pkt)
+{
+  printf("Type: %u(RREP)  R: %u  Reserved: %u  "
+	 "Prefix Sz: %u  Hop Count: %u\n",
+	 pkt->type,pkt->r, pkt->reserved, pkt->prefix_sz, pkt->hop_cnt);
+  printf("Dst IP: %s\tDst Seq nr: %u\n",
+	 inet_ntoa(*((struct in_addr*)&pkt->dst_ip)), pkt->dst_seq);
+  printf("Src IP: %s\n", inet_ntoa(*((struct in_addr*)&pkt->src_ip)));
+  printf("Lifetime: %u\n", pkt->lifetime);
+}
+
+/*
+ *   print_rerr
+ *
+ *   Description:
+ *     Prints a RERR package. Only the destinations that are in the
+ *     record are printed.
+ *
+ *   Arguments:
+ *     void* pkt  - The raw data to be interpreted as a RERR package.
+ *     int caplen - Number of bytes of the package in the record.
+ *
+ *   Return: None.
+*/
+void
+print_rerr(void *pkt, int caplen)
+{
+  struct rerrdst *m_rerrdst;
+  struct rerr *m_rerr;
+  int count;
+  int i = 0;
+
+  m_rerr = (struct rerr*)pkt;
+
+  printf("Type: %d(RRER)  Reserved: %u  Count: %u\n",
+	 m_rerr->type, m_rerr->reserved, m_rerr->dst_cnt);
+
+  count = MIN(m_rerr->dst_cnt,
+	      (caplen - sizeof(struct rerr)) / sizeof(struct rerrdst));
+
+  for (i = 0 ; i < count ; i++)
+    {
+      m_rerrdst = (struct rerrdst*)(pkt + sizeof(struct rerr) +
+				    (i * sizeof(struct rerrdst)));
+
+      printf("Dst IP: %s\tDst Seq nr: %u\n",
+	     inet_ntoa(*((struct in_addr*)&m_rerrdst->unr_dst_ip)),
+	     m_rerrdst->unr_dst_seq);
+    }
+
+  if (count < m_rerr->dst_cnt)
+    printf("(%d destinations not in trace)\n", m_rerr->dst_cnt - count);
+}
+
+/*
+ *   print_krt
+ *
+ *   Description:
+ *     Prints a kernel route change that failed.
+ *
+ *   Arguments:
+ *     struct trace_krt *krt - The change.
+ *
+ *   Return: None.
+*/
+void
+print_krt(struct trace_krt *krt)
+{
+  printf("Kernel route %s failed: %s\n",
+	 krt->op == TRACE_KRT_ADD ? "add" : "delete", strerror(krt->err));
+}
+
+/*
+ *   print_header
+ *
+ *   Description:
+ *     Prints the header of a trace.
+ *
+ *   Arguments:
+ *     struct trace_hdr *hdr - The header.
+ *
+ *   Return: None.
+*/
+void
+print_header(struct trace_hdr *hdr)
+{
+  time_t start;
+
+  start = hdr->start_real / 1000000;
+
+  printf("Trace version: %u\n", hdr->version);
+  printf("Interface: %s\n", hdr->ifname);
+  printf("Node IP: %s\n", inet_ntoa(*((struct in_addr*)&hdr->my_ip)));
+  printf("Started: %s", ctime(&start));
+}
+
+/*
+ *   match
+ *
+ *   Description:
+ *     Checks a record against the filters.
+ *
+ *   Arguments:
+ *     struct trace_rec *rec - The record.
+ *     void *data            - The message in the record.
+ *
+ *   Return:
+ *     int - 1 if the record should be printed, 0 otherwise.
+*/
+int
+match(struct trace_rec *rec, void *data)
+{
+  u_int8_t pkt_type;
+  int type = 0;
+  u_int32_t a1 = 0;
+  u_int32_t a2 = 0;
+
+  if (f_dir != -1 && rec->dir != f_dir)
+    return 0;
+
+  if (rec->dir == TRACE_DIR_KRT)
+    {
+      if (rec->caplen < sizeof(struct trace_krt) || !(f_types & TYPE_KRT))
+	return 0;
+      return f_addr == 0 || f_addr == rec->src_ip || f_addr == rec->dst_ip;
+    }
+
+  if (rec->caplen < 1)
+    return 0;
+
+  /* Extract the package type (we know it is 8 bits)*/
+  pkt_type = *((u_int8_t*)data);
+  switch (pkt_type)
+    {
+    case(RREQ):
+      if (rec->caplen < sizeof(struct rreq))
+	return 0;
+      a1 = ((struct rreq*)data)->dst_ip;
+      a2 = ((struct rreq*)data)->src_ip;
+      /* A RREQ for the broadcast address is the HELLO of an older
+	 version */
+      type = (a1 == INADDR_BROADCAST) ? TYPE_HELLO : TYPE_RREQ;
+      break;
+
+    case(RREP):
+      if (rec->caplen < sizeof(struct rrep))
+	return 0;
+      a1 = ((struct rrep*)data)->dst_ip;
+      a2 = ((struct rrep*)data)->src_ip;
+      type = RREP_IS_HELLO((struct rrep*)data) ? TYPE_HELLO : TYPE_RREP;
+      break;
+
+    case(RERR):
+      if (rec->caplen < sizeof(struct rerr))
+	return 0;
+      type = TYPE_RERR;
+      break;
+
+    default:
+      return 0;
+    }
+
+  if (!(type & f_types))
+    return 0;
+
+  if (f_addr != 0 && f_addr != rec->src_ip && f_addr != rec->dst_ip &&
+      f_addr != a1 && f_addr != a2)
+    return 0;
+
+  return 1;
+}
+
+/* ------------------------------------------------------------------- */
+
+int
+main(int argc, char *argv[])
+{
+  char buffer[MAXBUFLEN];
+  char data[TRACE_MAXCAP];
+  struct trace_hdr hdr;
+  struct trace_rec rec;
+  char *path = DEFAULT_TRACE;
+  int header = 0;
+  int typeset = 0;
+  u_int8_t pkt_type;
+  FILE *fp;
+  int rc;
+  int c;
+
+  while ((c = getopt(argc, argv, "Ht:a:d:")) != -1)
+    {
+      switch (c)
+	{
+	case 'H':
+	  header = 1;
+	  break;
+
+	case 't':
+	  /* The first -t replaces the default of all types */
+	  if (!typeset)
+	    f_types = 0;
+	  typeset = 1;
+	  if (strcmp(optarg, "rreq") == 0)
+	    f_types |= TYPE_RREQ;
+	  else if (strcmp(optarg, "rrep") == 0)
+	    f_types |= TYPE_RREP;
+	  else if (strcmp(optarg, "rerr") == 0)
+	    f_types |= TYPE_RERR;
+	  else if (strcmp(optarg, "hello") == 0)
+	    f_types |= TYPE_HELLO;
+	  else if (strcmp(optarg, "krt") == 0)
+	    f_types |= TYPE_KRT;
+	  else
+	    goto usage;
+	  break;
+
+	case 'a':
+	  if ((f_addr = inet_addr(optarg)) == INADDR_NONE)
+	    goto usage;
+	  break;
+
+	case 'd':
+	  if (strcmp(optarg, "in") == 0)
+	    f_dir = TRACE_DIR_IN;
+	  else if (strcmp(optarg, "out") == 0)
+	    f_dir = TRACE_DIR_OUT;
+	  else
+	    goto usage;
+	  break;
+
+	default:
+	  goto usage;
+	}
+    }
+
+  if (optind < argc)
+    path = argv[optind++];
+  if (optind < argc)
+    goto usage;
+
+  if ((fp = trace_open(path, &hdr)) == NULL)
+    exit(1);
+
+  if (header)
+    print_header(&hdr);
+
+  while ((rc = trace_read(fp, &rec, data)) == 1)
+    {
+      if (!match(&rec, data))
+	continue;
+
+      printf("\n");
+
+      /* Write timestamp, ms of wall clock as the daemon did */
+      printf("%s", septime(buffer, trace_realtime(&hdr, rec.time) / 1000));
+
+      /* Write source dest and ttl */
+      printf(" %s", inet_ntoa(*((struct in_addr*)&rec.src_ip)));
+      printf(" -> %s ttl: %d  len:%d \n",
+	     inet_ntoa(*((struct in_addr*)&rec.dst_ip)),
+	     rec.ttl, rec.origlen);
+
+      if (rec.dir == TRACE_DIR_KRT)
+	{
+	  print_krt((struct trace_krt*)data);
+	  continue;
+	}
+
+      pkt_type = *((u_int8_t*)data);
+      switch (pkt_type)
+	{
+	case(RREQ):
+	  print_rreq((struct rreq*)data);
+	  break;
+
+	case(RREP):
+	  print_rrep((struct rrep*)data);
+	  break;
+
+	case(RERR):
+	  print_rerr(data, rec.caplen);
+	  break;
+	}
+    }
+
+  if (rc == -1)
+    {
+      fprintf(stderr, "%s: trace is truncated or corrupt\n", path);
+      exit(1);
+    }
+
+  exit(0);
+
+ usage:
+  fprintf(stderr, "Usage: %s [-H] [-t rreq|rrep|rerr|hello|krt]... "
+	  "[-a address] [-d in|out] [file]\n", argv[0]);
+  exit(1);
+}
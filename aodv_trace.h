@@ -0,0 +1,88 @@
+/*
+ *	FILE: aodv_trace.c
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ *      Usage:
+ *        aodv_trace [-H] [-t type]... [-a address] [-d in|out] [file]
+ *
+ *        -H          Print the trace header first.
+ *        -t type     Only print messages of this type: rreq, rrep, rerr
+ *                    or hello, or krt for failed kernel route changes.
+ *                    May be given several times.
+ *        -a address  Only print messages sent from or to the address, or
+ *                    carrying it as source or destination.
+ *        -d in|out   Only print received or sent messages.
+ *        file        The trace, default aodv.trace. "-" reads stdin.
+ *
+ ********************************
+ *
+ *	General description:
+ *      -------------------
+ *
+ * Decodes a control traffic trace written by aodv_daemon and prints the
+ * messages in the same text format the daemon used to write to
+ * logmsg.txt.
+ *
+ *	Internal procedures:
+ *
+ * septime()
+ * print_rreq()
+ * print_rrep()
+ * print_rerr()
+ * print_krt()
+ * print_header()
+ * match()
+ *
+ *	External procedures:
+ *
+ * main()
+ *
+ ********************************
+ *
+ *   Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef AODV_TRACE_H
+#define AODV_TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "aodv.h"
+#include "trace.h"
+
+#define DEFAULT_TRACE "aodv.trace"
+
+/* Message type filter bits, set with -t */
+#define TYPE_RREQ   0x01
+#define TYPE_RREP   0x02
+#define TYPE_RERR   0x04
+#define TYPE_HELLO  0x08
+#define TYPE_KRT    0x10
+#define TYPE_ALL    0x1f
+
+#define MAXBUFLEN 1024
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Channel models of the aodv_sim medium. A model gives the
+ *        chance that a message sent over a link within radio range is
+ *        lost: never (unit disk), growing with the distance, or a fixed
+ *        chance of its own for each direction of each link. The loss of
+ *        a link is derived from the seed and the two nodes, no state is
+ *        kept per link.
+ *
+ *        With CSMA a message takes airtime on the medium. A sender waits
+ *        for the medium it senses to be free and then a random backoff,
+ *        and a receiver loses overlapping messages. The timing of that
+ *        is here, the bookkeeping per node is in aodv_sim.c.
+ *
+ *	Internal procedures:
+ *        chan_hash
+ *
+ *	External procedures:
+ *        chan_init
+ *        chan_loss
+ *        chan_airtime
+ *        chan_backoff
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "chan.h"
+
+char *chan_models[] = { "disk", "distance", "asym", NULL };
+
+/* Pre-declaration of internal function */
+u_int64_t chan_hash(u_int64_t x);
+
+/*
+ *   chan_hash
+ *
+ *   Description:
+ *     Mixes the bits of a number (the splitmix64 finalizer).
+ *
+ *   Arguments:
+ *     u_int64_t x - The number.
+ *
+ *   Return:
+ *     u_int64_t - The mixed number.
+ */
+u_int64_t
+chan_hash(u_int64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+
+  return x ^ (x >> 31);
+}
+
+/*
+ *   chan_init
+ *
+ *   Description:
+ *     Sets up a channel.
+ *
+ *   Arguments:
+ *     struct chan *c  - The channel.
+ *     int model       - CHAN_ constant.
+ *     int csma        - 1 for CSMA.
+ *     double loss     - Highest loss of CHAN_ASYM, 0 to 1.
+ *     u_int64_t seed  - Seed of the link losses.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+chan_init(struct chan *c, int model, int csma, double loss, u_int64_t seed)
+{
+  if (model < CHAN_DISK || model > CHAN_ASYM || loss < 0 || loss > 1)
+    return -1;
+
+  c->model = model;
+  c->csma = csma;
+  c->loss = loss;
+  c->seed = seed;
+
+  return 0;
+}
+
+/*
+ *   chan_loss
+ *
+ *   Description:
+ *     Gives the chance that a message from one node to a neighbour is
+ *     lost.
+ *
+ *   Arguments:
+ *     struct chan *c  - The channel.
+ *     struct topo *t  - Where the nodes are.
+ *     int from        - The sender.
+ *     int to          - The receiver.
+ *
+ *   Return:
+ *     double - The chance, 0 to 1.
+ */
+double
+chan_loss(struct chan *c, struct topo *t, int from, int to)
+{
+  double d;
+
+  switch (c->model)
+    {
+    case CHAN_DISTANCE:
+      d = hypot(t->node[from].x - t->node[to].x,
+		t->node[from].y - t->node[to].y) / t->range;
+      return MIN(pow(d, CHAN_LOSS_EXP), 1.0);
+
+    case CHAN_ASYM:
+      /* The same for the run, different for to -> from */
+      return c->loss * (chan_hash(chan_hash(c->seed ^ from) ^ to) >> 11) *
+	(1.0 / 9007199254740992.0);
+
+    default:
+      return 0;
+    }
+}
+
+/*
+ *   chan_airtime
+ *
+ *   Description:
+ *     Gives how long a message takes on the medium.
+ *
+ *   Arguments:
+ *     int len - Length of the AODV message, bytes.
+ *
+ *   Return:
+ *     u_int64_t - The time, us.
+ */
+u_int64_t
+chan_airtime(int len)
+{
+  return CHAN_PREAMBLE +
+    ((u_int64_t)(len + CHAN_HEADERS) * 8 * 1000000 + CHAN_BITRATE - 1) /
+    CHAN_BITRATE;
+}
+
+/*
+ *   chan_backoff
+ *
+ *   Description:
+ *     Gives how long a sender waits after the medium is free.
+ *
+ *   Arguments:
+ *     u_int64_t r - A random number.
+ *
+ *   Return:
+ *     u_int64_t - The time, us.
+ */
+u_int64_t
+chan_backoff(u_int64_t r)
+{
+  return CHAN_DIFS + (r % CHAN_CW) * CHAN_SLOT;
+}
@@ -0,0 +1,153 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Channel models of the aodv_sim medium. A model gives the
+ *        chance that a message sent over a link within radio range is
+ *        lost: never (unit disk), growing with the distance, or a fixed
+ *        chance of its own for each direction of each link. The loss of
+ *        a link is derived from the seed and the two nodes, no state is
+ *        kept per link.
+ *
+ *        With CSMA a message takes airtime on the medium. A sender waits
+ *        for the medium it senses to be free and then a random backoff,
+ *        and a receiver loses overlapping messages. The timing of that
+ *        is here, the bookkeeping per node is in aodv_sim.c.
+ *
+ *	Internal procedures:
+ *        chan_hash
+ *
+ *	External procedures:
+ *        chan_init
+ *        chan_loss
+ *        chan_airtime
+ *        chan_backoff
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef CHAN_H
+#define CHAN_H
+
+#include <math.h>
+#include <sys/types.h>
+
+#include "topo.h"
+
+/* Models */
+#define CHAN_DISK      0        /* No loss within range */
+#define CHAN_DISTANCE  1        /* Loss (distance / range) ^ CHAN_LOSS_EXP */
+#define CHAN_ASYM      2        /* Loss of each direction uniform in
+				   0 ... the highest loss */
+
+#define CHAN_LOSS_EXP  4
+
+/* CSMA timing, 802.11b broadcasts at the basic rate. Broadcasts are
+   not acknowledged, so the contention window never grows */
+#define CHAN_BITRATE   2000000  /* bit/s */
+#define CHAN_PREAMBLE  192      /* us */
+#define CHAN_HEADERS   62       /* MAC, IP and UDP headers, bytes */
+#define CHAN_DIFS      50       /* us */
+#define CHAN_SLOT      20       /* us */
+#define CHAN_CW        32       /* Slots */
+
+/* Names of the models, indexed by the constants above, ending with
+   NULL */
+extern char *chan_models[];
+
+struct chan
+{
+  int model;                    /* CHAN_ constant */
+  int csma;                     /* 1 if messages take airtime */
+  double loss;                  /* Highest loss of CHAN_ASYM */
+  u_int64_t seed;
+};
+
+
+/*
+ *   chan_init
+ *
+ *   Description:
+ *     Sets up a channel.
+ *
+ *   Arguments:
+ *     struct chan *c  - The channel.
+ *     int model       - CHAN_ constant.
+ *     int csma        - 1 for CSMA.
+ *     double loss     - Highest loss of CHAN_ASYM, 0 to 1.
+ *     u_int64_t seed  - Seed of the link losses.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int chan_init(struct chan *c, int model, int csma, double loss,
+	      u_int64_t seed);
+
+/*
+ *   chan_loss
+ *
+ *   Description:
+ *     Gives the chance that a message from one node to a neighbour is
+ *     lost.
+ *
+ *   Arguments:
+ *     struct chan *c  - The channel.
+ *     struct topo *t  - Where the nodes are.
+ *     int from        - The sender.
+ *     int to          - The receiver.
+ *
+ *   Return:
+ *     double - The chance, 0 to 1.
+ */
+double chan_loss(struct chan *c, struct topo *t, int from, int to);
+
+/*
+ *   chan_airtime
+ *
+ *   Description:
+ *     Gives how long a message takes on the medium.
+ *
+ *   Arguments:
+ *     int len - Length of the AODV message, bytes.
+ *
+ *   Return:
+ *     u_int64_t - The time, us.
+ */
+u_int64_t chan_airtime(int len);
+
+/*
+ *   chan_backoff
+ *
+ *   Description:
+ *     Gives how long a sender waits after the medium is free.
+ *
+ *   Arguments:
+ *     u_int64_t r - A random number.
+ *
+ *   Return:
+ *     u_int64_t - The time, us.
+ */
+u_int64_t chan_backoff(u_int64_t r);
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The time base of the protocol code, see clock.h.
+ *
+ *	Internal procedures:
+ *        clock_read
+ *
+ *	External procedures:
+ *        clock_source
+ *        clock_tick
+ *        clock_set
+ *        getcurrtime
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "clock.h"
+
+static int clock_src = CLOCK_SRC_TICK;
+
+/* Time of the last tick. Written by the timer signal too, so it is
+   only accessed atomically */
+static u_int64_t clock_now = 0;
+
+/* The virtual time, each thread has its own */
+static __thread u_int64_t clock_virt = 0;
+
+/* Pre-declaration of internal function */
+u_int64_t clock_read(clockid_t id);
+
+/* 
+ *   clock_read
+ *
+ *   Description: 
+ *     Reads a system clock.
+ *
+ *   Arguments:
+ *     clockid_t id - The clock.
+ *
+ *   Return: 
+ *     u_int64_t - Its time in ms.
+ */
+u_int64_t
+clock_read(clockid_t id)
+{
+  struct timespec ts;
+
+  clock_gettime(id, &ts);
+
+  return (u_int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* 
+ *   clock_source
+ *
+ *   Description: 
+ *     Selects the time source. A tick is taken right away for
+ *     CLOCK_SRC_TICK, the virtual clock keeps its time.
+ *
+ *   Arguments:
+ *     int source - CLOCK_SRC_ constant.
+ *
+ *   Return: None
+ */
+void
+clock_source(int source)
+{
+  clock_src = source;
+  clock_tick();
+}
+
+/* 
+ *   clock_tick
+ *
+ *   Description: 
+ *     Reads the monotonic clock into the time returned by getcurrtime
+ *     when the source is CLOCK_SRC_TICK. Async-signal-safe.
+ *
+ *   Arguments: None
+ *
+ *   Return: None
+ */
+void
+clock_tick()
+{
+  if (clock_src == CLOCK_SRC_TICK)
+    __atomic_store_n(&clock_now, clock_read(CLOCK_MONOTONIC),
+		     __ATOMIC_RELAXED);
+}
+
+/* 
+ *   clock_set
+ *
+ *   Description: 
+ *     Sets the time of the virtual clock of the calling thread.
+ *
+ *   Arguments:
+ *     u_int64_t ms - The time in ms.
+ *
+ *   Return: None
+ */
+void
+clock_set(u_int64_t ms)
+{
+  clock_virt = ms;
+}
+
+/* 
+ *   getcurrtime
+ *
+ *   Description: 
+ *     Gets the current time in ms from the selected source.
+ *
+ *   Arguments: None
+ *
+ *   Return: 
+ *     u_int64_t - The time.
+ */
+u_int64_t
+getcurrtime()
+{
+  if (clock_src == CLOCK_SRC_COARSE)
+    return clock_read(CLOCK_MONOTONIC_COARSE);
+
+  if (clock_src == CLOCK_SRC_VIRTUAL)
+    return clock_virt;
+
+  if (clock_now == 0)
+    /* No tick taken yet */
+    clock_tick();
+
+  return __atomic_load_n(&clock_now, __ATOMIC_RELAXED);
+}
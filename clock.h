@@ -0,0 +1,123 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The time base of the protocol code. Route lifetimes, timer
+ *        deadlines and RREQ list lifetimes are all taken from
+ *        getcurrtime, in ms. The time comes from one of three sources:
+ *
+ *        CLOCK_SRC_TICK     The monotonic clock, read by clock_tick once
+ *                           per pass of the main loop and per timer
+ *                           signal. getcurrtime only loads the value.
+ *                           A pass sees one time unless a timer signal
+ *                           arrives during it, the handler must tick as
+ *                           the loop may be blocked in select. Used by
+ *                           the daemon.
+ *        CLOCK_SRC_COARSE   CLOCK_MONOTONIC_COARSE, read on every call.
+ *        CLOCK_SRC_VIRTUAL  Only moves when clock_set is called. Each
+ *                           thread has its own, so the partitions of
+ *                           aodv_sim can be at different times.
+ *
+ *        The monotonic sources don't jump when the wall clock is set,
+ *        so a step of the wall clock no longer expires or revives every
+ *        route and timer at once.
+ *
+ *	Internal procedures:
+ *        clock_read
+ *
+ *	External procedures:
+ *        clock_source
+ *        clock_tick
+ *        clock_set
+ *        getcurrtime
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <time.h>
+#include <sys/types.h>
+
+/* Time sources */
+#define CLOCK_SRC_TICK     0
+#define CLOCK_SRC_COARSE   1
+#define CLOCK_SRC_VIRTUAL  2
+
+
+/* 
+ *   clock_source
+ *
+ *   Description: 
+ *     Selects the time source. A tick is taken right away for
+ *     CLOCK_SRC_TICK, the virtual clock keeps its time.
+ *
+ *   Arguments:
+ *     int source - CLOCK_SRC_ constant.
+ *
+ *   Return: None
+ */
+void clock_source(int source);
+
+/* 
+ *   clock_tick
+ *
+ *   Description: 
+ *     Reads the monotonic clock into the time returned by getcurrtime
+ *     when the source is CLOCK_SRC_TICK. Async-signal-safe.
+ *
+ *   Arguments: None
+ *
+ *   Return: None
+ */
+void clock_tick();
+
+/* 
+ *   clock_set
+ *
+ *   Description: 
+ *     Sets the time of the virtual clock of the calling thread.
+ *
+ *   Arguments:
+ *     u_int64_t ms - The time in ms.
+ *
+ *   Return: None
+ */
+void clock_set(u_int64_t ms);
+
+/* 
+ *   getcurrtime
+ *
+ *   Description: 
+ *     Gets the current time in ms from the selected source.
+ *
+ *   Arguments: None
+ *
+ *   Return: 
+ *     u_int64_t - The time.
+ */
+u_int64_t getcurrtime();
+
+#endif
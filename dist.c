@@ -0,0 +1,155 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The hop distances a node has learnt to other nodes. Every RREQ
+ *        tells the nodes it passes how far they are from its source,
+ *        every RREP how far they are from its destination. Routes are
+ *        deleted some time after they break, the distances are kept,
+ *        so a later route discovery can start its expanding ring search
+ *        just past the last distance instead of at TTL_START, see
+ *        gen_rreq.
+ *
+ *        The table has DIST_SLOTS entries and is direct mapped, a
+ *        destination takes the slot of another that hashes the same.
+ *        It is allocated when the first distance is learnt.
+ *
+ *	Internal procedures:
+ *        dist_slot
+ *
+ *	External procedures:
+ *        dist_learn
+ *        dist_get
+ *        free_dist
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "dist.h"
+#include "aodv.h"
+
+/* Pre-declaration of internal function */
+struct dist_entry *dist_slot(struct aodv_node *node, u_int32_t ip);
+
+/*
+ * dist_slot
+ *
+ * Description:
+ *   Finds the slot of a destination, by a multiplicative hash of its
+ *   address. The high bits are taken, the low ones of the product only
+ *   depend on the first byte of the address.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node, its table allocated.
+ *   u_int32_t ip           - The destination.
+ *
+ * Return:
+ *   struct dist_entry* - The slot
+ */
+struct dist_entry *
+dist_slot(struct aodv_node *node, u_int32_t ip)
+{
+  return &node->dist[((ip * 2654435761U) >> 24) % DIST_SLOTS];
+}
+
+/*
+ * dist_learn
+ *
+ * Description:
+ *   Notes the hop distance to a node, it replaces the one learnt
+ *   before.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - The other node.
+ *   int hops               - Its distance, 1 to NET_DIAMETER.
+ *
+ * Return:
+ *   int - 0, -1 if the table couldn't be allocated
+ */
+int
+dist_learn(struct aodv_node *node, u_int32_t ip, int hops)
+{
+  struct dist_entry *de;
+
+  if (ip == node->my_ip || hops < 1 || hops > NET_DIAMETER)
+    return 0;
+
+  if (node->dist == NULL &&
+      (node->dist = (struct dist_entry*)
+       calloc(DIST_SLOTS, sizeof(struct dist_entry))) == NULL)
+    return -1;
+
+  de = dist_slot(node, ip);
+  de->ip = ip;
+  de->hops = hops;
+
+  return 0;
+}
+
+/*
+ * dist_get
+ *
+ * Description:
+ *   Looks up the last known hop distance to a node.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - The other node.
+ *
+ * Return:
+ *   int - The distance, 0 if it isn't known
+ */
+int
+dist_get(struct aodv_node *node, u_int32_t ip)
+{
+  struct dist_entry *de;
+
+  if (node->dist == NULL)
+    return 0;
+
+  de = dist_slot(node, ip);
+  if (de->ip != ip)
+    return 0;
+
+  return de->hops;
+}
+
+/*
+ * free_dist
+ *
+ * Description:
+ *   Frees the table of a node.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return: None
+ */
+void
+free_dist(struct aodv_node *node)
+{
+  free(node->dist);
+  node->dist = NULL;
+}
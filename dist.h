@@ -0,0 +1,111 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The hop distances a node has learnt to other nodes. Every RREQ
+ *        tells the nodes it passes how far they are from its source,
+ *        every RREP how far they are from its destination. Routes are
+ *        deleted some time after they break, the distances are kept,
+ *        so a later route discovery can start its expanding ring search
+ *        just past the last distance instead of at TTL_START, see
+ *        gen_rreq.
+ *
+ *        The table has DIST_SLOTS entries and is direct mapped, a
+ *        destination takes the slot of another that hashes the same.
+ *        It is allocated when the first distance is learnt.
+ *
+ *	Internal procedures:
+ *        dist_slot
+ *
+ *	External procedures:
+ *        dist_learn
+ *        dist_get
+ *        free_dist
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef DIST_H
+#define DIST_H
+
+#include <stdlib.h>
+#include <sys/types.h>
+
+#include "node.h"
+
+#define DIST_SLOTS  256          /* Destinations remembered at most,
+				    256 or less */
+
+struct dist_entry
+{
+  u_int32_t ip;                  /* The destination, 0 if free */
+  u_int8_t hops;                 /* Its last known hop distance */
+};
+
+/*
+ * dist_learn
+ *
+ * Description:
+ *   Notes the hop distance to a node, it replaces the one learnt
+ *   before.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - The other node.
+ *   int hops               - Its distance, 1 to NET_DIAMETER.
+ *
+ * Return:
+ *   int - 0, -1 if the table couldn't be allocated
+ */
+int dist_learn(struct aodv_node *node, u_int32_t ip, int hops);
+
+/*
+ * dist_get
+ *
+ * Description:
+ *   Looks up the last known hop distance to a node.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - The other node.
+ *
+ * Return:
+ *   int - The distance, 0 if it isn't known
+ */
+int dist_get(struct aodv_node *node, u_int32_t ip);
+
+/*
+ * free_dist
+ *
+ * Description:
+ *   Frees the table of a node.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return: None
+ */
+void free_dist(struct aodv_node *node);
+
+#endif
@@ -25,7 +25,7 @@
  *        renewed and times out the route is deleted from the routing 
  *        table. find_inactives is called every HELLO_INTERVAL. If the 
  *        expired node is a neighbour link_break is called to inform other
- *        neighbours.
+ *        neighbours, as it is for neighbours whose HELLOs stopped coming.
  *
  *      Internal procedures: 
  *      
@@ -39,9 +39,8 @@
  */
 
 #include "find_inactives.h"
+#include "neighbour.h"
 
-extern u_int32_t         g_my_ip;
-extern struct artentry  *g_my_entry;
 
 /*
  * find_inactives
@@ -49,18 +48,28 @@ extern struct artentry  *g_my_entry;
  * Descritpion:
  *   Finds inactive entries 
  *
- * Arguments: Void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Return: Void
  */
 void
-find_inactives()
+find_inactives(struct aodv_node *node)
 {
   struct rt_entry_list *tmp_rt_entry_list;
   struct artentry *tmp_artentry;
   struct info tmp_info;
+  u_int32_t lost_ip;
+
+  /* Neighbours that stopped saying HELLO */
+  while ((lost_ip = nb_lost(node)) != 0)
+    {
+      node->my_entry->dst_seq++;
+      tmp_info.ip_pkt_my_ip = node->my_ip;
+      link_break(node, &tmp_info, lost_ip);
+    }
   
-  for(tmp_rt_entry_list = get_first_entry();
+  for(tmp_rt_entry_list = get_first_entry(node);
       tmp_rt_entry_list->ishead != 1;
       tmp_rt_entry_list = tmp_rt_entry_list->next)
     {
@@ -74,21 +83,24 @@ find_inactives()
 	    {
 	      /* step back before deletion */
 	      tmp_rt_entry_list = tmp_rt_entry_list->prev; 
-	      delete_entry(tmp_artentry->dst_ip);
+	      delete_entry(node, tmp_artentry->dst_ip);
 	    }
 	  else /* time to be expired */
 	    {
 	      if(tmp_artentry->nxt_hop == tmp_artentry->dst_ip) 
 		{		
 		  /* thus neighbour */
-		  g_my_entry->dst_seq++;
-		  tmp_info.ip_pkt_my_ip = g_my_ip;
+		  node->my_entry->dst_seq++;
+		  tmp_info.ip_pkt_my_ip = node->my_ip;
 		  /* link break also performs route_expiry */
-		  link_break(&tmp_info, tmp_artentry->dst_ip);
+		  link_break(node, &tmp_info, tmp_artentry->dst_ip);
 		}
 	      else
 		{
 		  route_expiry(tmp_artentry);
+		  flight_event(FLIGHT_RT_EXPIRE, tmp_artentry->dst_ip,
+			       tmp_artentry->nxt_hop, tmp_artentry->lst_hop_cnt,
+			       tmp_artentry->dst_seq);
 		}
 	    }
 	}
@@ -24,7 +24,8 @@
  *        as expired in the routing table. When an expired route is not
  *        renewed and times out the route is deleted from the routing table.
  *        find_inactives is called every HELLO_INTERVAL. If the expired node
- *        is a neighbour link_break is called to inform other neighbours.
+ *        is a neighbour link_break is called to inform other neighbours,
+ *        as it is for neighbours whose HELLOs stopped coming.
  *
  *      Internal procedures: 
  *      
@@ -51,11 +52,12 @@
  * Descritpion:
  *   Finds inactive entries 
  *
- * Arguments: Void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *
  * Return: Void
  */
-void find_inactives();
+void find_inactives(struct aodv_node *node);
 
 #endif
 
@@ -0,0 +1,447 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Flight recorder. Keeps the last FLIGHT_SLOTS protocol events
+ *        (route changes, precursor changes, timers, kernel route results,
+ *        duplicate RREQs) in a fixed ring in memory. Recording an event
+ *        takes one atomic add and a few stores, any thread may record.
+ *        The oldest events are overwritten.
+ *
+ *        The ring is appended as text to FLIGHT_FILE on SIGUSR1, on the
+ *        dump_events command and when the daemon dies from a fatal
+ *        signal. Dumping only uses async-signal-safe calls.
+ *
+ *	Internal procedures:
+ *        flight_signal
+ *        put_str
+ *        put_num
+ *        put_ip
+ *
+ *	External procedures:
+ *        flight_init
+ *        flight_event
+ *        flight_dump
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "flight.h"
+
+static struct flight_ev flight_ring[FLIGHT_SLOTS];
+static unsigned long flight_next = 0;   /* Number of the next event */
+static int flight_fd = -1;
+
+/* Signals that make the daemon dump the ring before it dies */
+static int flight_fatal[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, 0 };
+
+static const char *flight_names[FLIGHT_NTYPES] =
+{
+  "?", "start", "rt_insert", "rt_update", "rt_expire", "rt_broken",
+  "rt_delete", "prec_add", "prec_del", "timer", "krt_add", "krt_del",
+  "rreq_dup", "rt_alt", "rt_switch", "rreq_supp"
+};
+
+/* Pre-declaration of internal functions */
+void flight_signal(int sig);
+char *put_str(char *p, const char *s);
+char *put_num(char *p, u_int64_t n, int width);
+char *put_ip(char *p, u_int32_t ip);
+
+/*
+ *   flight_init
+ *
+ *   Description:
+ *     Opens the dump file and installs the handlers for SIGUSR1 and the
+ *     fatal signals.
+ *
+ *   Arguments:
+ *     u_int32_t my_ip - The ip of the node, recorded as the first event.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+flight_init(u_int32_t my_ip)
+{
+  struct sigaction sa;
+  int i;
+
+  if ((flight_fd = open(FLIGHT_FILE, O_WRONLY|O_CREAT|O_APPEND,
+			S_IRUSR|S_IWUSR)) < 0)
+    return -1;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = flight_signal;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGUSR1, &sa, NULL);
+
+  /* Dump once and then die the normal way */
+  sa.sa_flags = SA_RESETHAND | SA_NODEFER;
+  for (i = 0; flight_fatal[i] != 0; i++)
+    sigaction(flight_fatal[i], &sa, NULL);
+
+  flight_event(FLIGHT_START, my_ip, 0, 0, 0);
+
+  return 0;
+}
+
+/*
+ *   flight_event
+ *
+ *   Description:
+ *     Records an event. May be called from any thread.
+ *
+ *   Arguments:
+ *     int type    - FLIGHT_ constant.
+ *     u_int32_t a - Arguments, see the FLIGHT_ constants.
+ *     u_int32_t b
+ *     u_int32_t c
+ *     u_int32_t d
+ *
+ *   Return: None
+ */
+void
+flight_event(int type, u_int32_t a, u_int32_t b, u_int32_t c, u_int32_t d)
+{
+  struct flight_ev *ev;
+  struct timespec ts;
+  unsigned long n;
+
+  /* Claim a slot, writers never wait for each other */
+  n = __atomic_fetch_add(&flight_next, 1, __ATOMIC_RELAXED);
+  ev = &flight_ring[n & (FLIGHT_SLOTS - 1)];
+
+  /* The coarse clock is read without a system call and is precise
+     enough next to the event number */
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+
+  /* A dump must not take the slot for the event it held while it is
+     rewritten. No dump looks for event n - 1 in this slot */
+  __atomic_store_n(&ev->seq, (u_int32_t)n - 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  ev->time = (u_int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+  ev->type = type;
+  ev->a = a;
+  ev->b = b;
+  ev->c = c;
+  ev->d = d;
+
+  /* Tells a dump that the slot holds event n and is complete */
+  __atomic_store_n(&ev->seq, (u_int32_t)n, __ATOMIC_RELEASE);
+}
+
+/*
+ *   put_str
+ *
+ *   Description:
+ *     Copies a string into a buffer.
+ *
+ *   Arguments:
+ *     char *p       - Where to write.
+ *     const char *s - The string.
+ *
+ *   Return:
+ *     char* - The end of what was written.
+ */
+char *
+put_str(char *p, const char *s)
+{
+  while (*s != '\0')
+    *p++ = *s++;
+
+  return p;
+}
+
+/*
+ *   put_num
+ *
+ *   Description:
+ *     Writes a number in decimal into a buffer.
+ *
+ *   Arguments:
+ *     char *p     - Where to write.
+ *     u_int64_t n - The number.
+ *     int width   - Minimum number of digits, padded with zeros.
+ *
+ *   Return:
+ *     char* - The end of what was written.
+ */
+char *
+put_num(char *p, u_int64_t n, int width)
+{
+  char tmp[24];
+  int i = 0;
+
+  do
+    {
+      tmp[i++] = '0' + n % 10;
+      n /= 10;
+    }
+  while (n != 0 || i < width);
+
+  while (i > 0)
+    *p++ = tmp[--i];
+
+  return p;
+}
+
+/*
+ *   put_ip
+ *
+ *   Description:
+ *     Writes an ip address in dotted form into a buffer.
+ *
+ *   Arguments:
+ *     char *p      - Where to write.
+ *     u_int32_t ip - The address in network byte order.
+ *
+ *   Return:
+ *     char* - The end of what was written.
+ */
+char *
+put_ip(char *p, u_int32_t ip)
+{
+  unsigned char *b = (unsigned char*)&ip;
+  int i;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (i > 0)
+	*p++ = '.';
+      p = put_num(p, b[i], 1);
+    }
+
+  return p;
+}
+
+/*
+ *   flight_dump
+ *
+ *   Description:
+ *     Appends the recorded events, oldest first, to the dump file.
+ *     Async-signal-safe.
+ *
+ *   Arguments:
+ *     const char *reason - Why the dump is done, written in its header.
+ *
+ *   Return:
+ *     int - Number of events written, -1 if there is no dump file.
+ */
+int
+flight_dump(const char *reason)
+{
+  struct flight_ev ev;
+  struct flight_ev *slot;
+  struct timespec ts;
+  unsigned long first;
+  unsigned long last;
+  unsigned long n;
+  char line[160];
+  char *p;
+  int count = 0;
+
+  if (flight_fd == -1)
+    return -1;
+
+  last = __atomic_load_n(&flight_next, __ATOMIC_ACQUIRE);
+  first = last > FLIGHT_SLOTS ? last - FLIGHT_SLOTS : 0;
+
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  p = put_str(line, "=== flight recorder dump: ");
+  p = put_str(p, reason);
+  p = put_str(p, ", pid ");
+  p = put_num(p, getpid(), 1);
+  p = put_str(p, ", now ");
+  p = put_num(p, ts.tv_sec, 1);
+  *p++ = '.';
+  p = put_num(p, ts.tv_nsec / 1000000, 3);
+  p = put_str(p, ", events ");
+  p = put_num(p, first, 1);
+  *p++ = '-';
+  p = put_num(p, last, 1);
+  p = put_str(p, " ===\n");
+  write(flight_fd, line, p - line);
+
+  for (n = first; n < last; n++)
+    {
+      slot = &flight_ring[n & (FLIGHT_SLOTS - 1)];
+
+      /* Copy the event and check it was not overwritten meanwhile, a
+	 slot being rewritten holds no valid number, see flight_event */
+      if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != (u_int32_t)n)
+	continue;
+      ev = *slot;
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != (u_int32_t)n)
+	continue;
+
+      p = put_num(line, n, 1);
+      *p++ = ' ';
+      p = put_num(p, ev.time / 1000000000, 1);
+      *p++ = '.';
+      p = put_num(p, (ev.time / 1000000) % 1000, 3);
+      *p++ = ' ';
+      p = put_str(p, ev.type < FLIGHT_NTYPES ? flight_names[ev.type] : "?");
+
+      switch (ev.type)
+	{
+	case FLIGHT_START:
+	  p = put_str(p, " ip ");
+	  p = put_ip(p, ev.a);
+	  break;
+
+	case FLIGHT_RT_INSERT:
+	case FLIGHT_RT_UPDATE:
+	case FLIGHT_RT_EXPIRE:
+	case FLIGHT_RT_BROKEN:
+	case FLIGHT_RT_ALT:
+	  p = put_str(p, " dst ");
+	  p = put_ip(p, ev.a);
+	  p = put_str(p, " via ");
+	  p = put_ip(p, ev.b);
+	  p = put_str(p, " hops ");
+	  p = put_num(p, ev.c, 1);
+	  p = put_str(p, " seq ");
+	  p = put_num(p, ev.d, 1);
+	  break;
+
+	case FLIGHT_RT_DELETE:
+	  p = put_str(p, " dst ");
+	  p = put_ip(p, ev.a);
+	  p = put_str(p, " via ");
+	  p = put_ip(p, ev.b);
+	  break;
+
+	case FLIGHT_RT_SWITCH:
+	  p = put_str(p, " dst ");
+	  p = put_ip(p, ev.a);
+	  p = put_str(p, " from ");
+	  p = put_ip(p, ev.b);
+	  p = put_str(p, " to ");
+	  p = put_ip(p, ev.c);
+	  p = put_str(p, " seq ");
+	  p = put_num(p, ev.d, 1);
+	  break;
+
+	case FLIGHT_PREC_ADD:
+	case FLIGHT_PREC_DEL:
+	  p = put_str(p, " dst ");
+	  p = ev.a ? put_ip(p, ev.a) : put_str(p, "all");
+	  p = put_str(p, " precursor ");
+	  p = put_ip(p, ev.b);
+	  break;
+
+	case FLIGHT_TIMER:
+	  p = put_str(p, " id ");
+	  p = put_ip(p, ev.a);
+	  p = put_str(p, " flags ");
+	  p = put_num(p, ev.b, 1);
+	  break;
+
+	case FLIGHT_KRT_ADD:
+	case FLIGHT_KRT_DEL:
+	  p = put_str(p, " dst ");
+	  p = put_ip(p, ev.a);
+	  p = put_str(p, " gw ");
+	  p = put_ip(p, ev.b);
+	  p = put_str(p, ev.c ? " failed errno " : " ok");
+	  if (ev.c)
+	    p = put_num(p, ev.c, 1);
+	  break;
+
+	case FLIGHT_RREQ_DUP:
+	  p = put_str(p, " src ");
+	  p = put_ip(p, ev.a);
+	  p = put_str(p, " dst ");
+	  p = put_ip(p, ev.b);
+	  p = put_str(p, " bcast_id ");
+	  p = put_num(p, ev.c, 1);
+	  break;
+
+	case FLIGHT_RREQ_SUPP:
+	  p = put_str(p, " src ");
+	  p = put_ip(p, ev.a);
+	  p = put_str(p, " dst ");
+	  p = put_ip(p, ev.b);
+	  p = put_str(p, " bcast_id ");
+	  p = put_num(p, ev.c, 1);
+	  p = put_str(p, " copies ");
+	  p = put_num(p, ev.d, 1);
+	  break;
+	}
+
+      *p++ = '\n';
+      write(flight_fd, line, p - line);
+      count++;
+    }
+
+  return count;
+}
+
+/*
+ *   flight_signal
+ *
+ *   Description:
+ *     Handler for SIGUSR1 and the fatal signals. A fatal signal is
+ *     raised again after the dump, the handler was reset by then.
+ *
+ *   Arguments:
+ *     int sig - The signal.
+ *
+ *   Return: None
+ */
+void
+flight_signal(int sig)
+{
+  switch (sig)
+    {
+    case SIGUSR1:
+      flight_dump("SIGUSR1");
+      return;
+
+    case SIGSEGV:
+      flight_dump("SIGSEGV");
+      break;
+
+    case SIGBUS:
+      flight_dump("SIGBUS");
+      break;
+
+    case SIGFPE:
+      flight_dump("SIGFPE");
+      break;
+
+    case SIGILL:
+      flight_dump("SIGILL");
+      break;
+
+    default:
+      flight_dump("SIGABRT");
+      break;
+    }
+
+  raise(sig);
+}
@@ -0,0 +1,149 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Flight recorder. Keeps the last FLIGHT_SLOTS protocol events
+ *        (route changes, precursor changes, timers, kernel route results,
+ *        duplicate RREQs) in a fixed ring in memory. Recording an event
+ *        takes one atomic add and a few stores, any thread may record.
+ *        The oldest events are overwritten.
+ *
+ *        The ring is appended as text to FLIGHT_FILE on SIGUSR1, on the
+ *        dump_events command and when the daemon dies from a fatal
+ *        signal. Dumping only uses async-signal-safe calls.
+ *
+ *	Internal procedures:
+ *        flight_signal
+ *        put_str
+ *        put_num
+ *        put_ip
+ *
+ *	External procedures:
+ *        flight_init
+ *        flight_event
+ *        flight_dump
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef FLIGHT_H
+#define FLIGHT_H
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* Number of events kept, must be a power of two */
+#define FLIGHT_SLOTS 4096
+
+/* Dumps are appended to this file, it is never truncated */
+#define FLIGHT_FILE "aodv_flight.log"
+
+/* Event types. The meaning of the arguments a, b, c and d is given
+   after each type */
+#define FLIGHT_START       1   /* my ip */
+#define FLIGHT_RT_INSERT   2   /* dst, next hop, hop count, dst seq */
+#define FLIGHT_RT_UPDATE   3   /* dst, next hop, hop count, dst seq */
+#define FLIGHT_RT_EXPIRE   4   /* dst, next hop, last hop count, dst seq */
+#define FLIGHT_RT_BROKEN   5   /* dst, next hop, last hop count, dst seq */
+#define FLIGHT_RT_DELETE   6   /* dst, next hop */
+#define FLIGHT_PREC_ADD    7   /* dst, precursor */
+#define FLIGHT_PREC_DEL    8   /* dst (0 = all), precursor */
+#define FLIGHT_TIMER       9   /* id, flags */
+#define FLIGHT_KRT_ADD    10   /* dst, gateway, errno (0 = ok) */
+#define FLIGHT_KRT_DEL    11   /* dst, gateway, errno (0 = ok) */
+#define FLIGHT_RREQ_DUP   12   /* src, dst, broadcast id */
+#define FLIGHT_RT_ALT     13   /* dst, alternate next hop, hop count, dst seq */
+#define FLIGHT_RT_SWITCH  14   /* dst, broken next hop, new next hop, dst seq */
+#define FLIGHT_RREQ_SUPP  15   /* src, dst, broadcast id, copies heard */
+#define FLIGHT_NTYPES     16
+
+/* One event, 32 bytes */
+struct flight_ev
+{
+  u_int64_t time;      /* CLOCK_MONOTONIC_COARSE in ns */
+  u_int32_t seq;       /* Low bits of the event number, written last,
+			  one less while the slot is rewritten */
+  u_int32_t type;      /* FLIGHT_ constant */
+  u_int32_t a;
+  u_int32_t b;
+  u_int32_t c;
+  u_int32_t d;
+};
+
+
+/*
+ *   flight_init
+ *
+ *   Description:
+ *     Opens the dump file and installs the handlers for SIGUSR1 and the
+ *     fatal signals.
+ *
+ *   Arguments:
+ *     u_int32_t my_ip - The ip of the node, recorded as the first event.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int flight_init(u_int32_t my_ip);
+
+/*
+ *   flight_event
+ *
+ *   Description:
+ *     Records an event. May be called from any thread.
+ *
+ *   Arguments:
+ *     int type    - FLIGHT_ constant.
+ *     u_int32_t a - Arguments, see the FLIGHT_ constants.
+ *     u_int32_t b
+ *     u_int32_t c
+ *     u_int32_t d
+ *
+ *   Return: None
+ */
+void flight_event(int type, u_int32_t a, u_int32_t b, u_int32_t c,
+		  u_int32_t d);
+
+/*
+ *   flight_dump
+ *
+ *   Description:
+ *     Appends the recorded events, oldest first, to the dump file.
+ *     Async-signal-safe.
+ *
+ *   Arguments:
+ *     const char *reason - Why the dump is done, written in its header.
+ *
+ *   Return:
+ *     int - Number of events written, -1 if there is no dump file.
+ */
+int flight_dump(const char *reason);
+
+#endif
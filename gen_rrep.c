@@ -35,7 +35,6 @@
 
 #include "gen_rrep.h"
 
-extern struct artentry *g_my_entry;
 
 /*
  * gen_rrep
@@ -44,6 +43,7 @@ extern struct artentry *g_my_entry;
  *   Generates a RREP
  *
  * Arguments:    
+ *   struct aodv_node *node - The node.
  *   struct info *my_info - The information on IP level
  *   struct rreq *my_rreq - The RREQ that needs a RREP
  *
@@ -51,7 +51,7 @@ extern struct artentry *g_my_entry;
  *   int - 0 (- if succesful)
  */
 int
-gen_rrep(struct info *my_info, struct rreq *my_rreq)
+gen_rrep(struct aodv_node *node, struct info *my_info, struct rreq *my_rreq)
 {
   struct rrep      my_rrep;
   struct artentry  *rt;
@@ -63,15 +63,18 @@ gen_rrep(struct info *my_info, struct rreq *my_rreq)
   my_rrep.dst_ip = my_rreq->dst_ip;
   
   /* Get the routing table entry corresponding to the asked destination */
-  rt = getentry(my_rrep.dst_ip); 
+  rt = getentry(node, my_rrep.dst_ip); 
   
   /* Check if the destination IP of RREQ was this node */
   if (my_rreq->dst_ip == my_info->ip_pkt_my_ip)    
     {
       /* The RREQ was for this node */
 
-      /* Increase my source sequence number */
-      (g_my_entry->dst_seq)++;
+      /* Increase my source sequence number. In multipath mode only
+	 when the RREQ asks for a newer one, as RFC 3561 has it, so the
+	 answers to the copies of a RREQ carry the same number */
+      if (!node->multipath || my_rreq->dst_seq > node->my_entry->dst_seq)
+	(node->my_entry->dst_seq)++;
 
       /* Set the reply structure */
       if (my_rreq->dst_seq > rt->dst_seq) 
@@ -80,6 +83,7 @@ gen_rrep(struct info *my_info, struct rreq *my_rreq)
       my_rrep.dst_seq = rt->dst_seq;
       my_rrep.hop_cnt = 0;
       my_rrep.lifetime = MY_ROUTE_TIMEOUT;
+      my_rrep.reserved = RREP_FROM_DST;
     }
   else 
     {
@@ -90,7 +94,8 @@ gen_rrep(struct info *my_info, struct rreq *my_rreq)
       my_rrep.hop_cnt = rt->hop_cnt;
       curr_time = getcurrtime(); /* Get current time */
       my_rrep.lifetime = rt->lifetime - curr_time;
-      rt_src = getentry(my_rrep.src_ip); 
+      my_rrep.reserved = 0;
+      rt_src = getentry(node, my_rrep.src_ip); 
       
       /* Add to precursors... */
       if (add_precursor(rt_src, rt->nxt_hop) == -1)
@@ -113,18 +118,23 @@ gen_rrep(struct info *my_info, struct rreq *my_rreq)
   my_info->ip_pkt_dst_ip = my_info->ip_pkt_src_ip;
   my_info->ip_pkt_src_ip = my_info->ip_pkt_my_ip;
 
-  if (send_datagram(my_info, &my_rrep, sizeof(my_rrep)) == -1)
+  if (send_datagram(node, my_info, &my_rrep, sizeof(my_rrep)) == -1)
     {
       /* Couldn't send the RREP. Ignore and let the sourse request again */
     }
 
-  if (my_rreq->dst_ip != my_info->ip_pkt_my_ip)
+  /* The route back to the source can still be broken when the RREQ
+     had an older sequence number than the node knew */
+  rt_src = getentry(node, my_rreq->src_ip);
+  if (my_rreq->dst_ip != my_info->ip_pkt_my_ip &&
+      rt_src != NULL && rt_src->hop_cnt != 255)
     {
       /* Now send a datagram to the requested host telling it it has been 
 	 asked for */
       
       my_rrep.type = 2;
       my_rrep.r = 0;
+      my_rrep.reserved = 0;
       my_rrep.prefix_sz = 0;
       my_info->ip_pkt_ttl = 1;
       
@@ -133,7 +143,7 @@ gen_rrep(struct info *my_info, struct rreq *my_rreq)
       my_rrep.src_ip = my_rreq->dst_ip;
       
       /* Get info on the source */
-      rt = getentry(my_rreq->src_ip); 
+      rt = getentry(node, my_rreq->src_ip); 
       
       /* Insert the rreq's source attributes */
       my_rrep.dst_ip = rt->dst_ip;
@@ -143,13 +153,13 @@ gen_rrep(struct info *my_info, struct rreq *my_rreq)
       my_rrep.lifetime = rt->lifetime - curr_time;
       
       /* Get info on the destination */
-      rt = getentry(my_rreq->dst_ip); 
+      rt = getentry(node, my_rreq->dst_ip); 
       
       my_info->ip_pkt_dst_ip = rt->nxt_hop;
       my_info->ip_pkt_src_ip = my_info->ip_pkt_my_ip;
       
       
-      if (send_datagram(my_info, &my_rrep, sizeof(my_rrep)) == -1)
+      if (send_datagram(node, my_info, &my_rrep, sizeof(my_rrep)) == -1)
 	{
 	  /* Couldn't send the RREP. Ignore, let the sourse request again */
 	}
@@ -55,6 +55,7 @@
  *   Generates a RREP
  *
  * Arguments:    
+ *   struct aodv_node *node - The node.
  *   struct info *my_info - The information on IP level
  *   struct rreq *my_rreq - The RREQ that needs a RREP
  *
@@ -62,7 +63,7 @@
  *   int - 0 (- if succesful)
  */
 int
-gen_rrep(struct info *my_info, struct rreq *my_rreq);
+gen_rrep(struct aodv_node *node, struct info *my_info, struct rreq *my_rreq);
 
 #endif
 
@@ -8,6 +8,7 @@
  *        parameters
  *
  *	Internal procedures:
+ *        start_ttl
  *	
  *	External procedures:
  *        gen_rreq
@@ -19,6 +20,44 @@
  */
 #include "gen_rreq.h"
 
+/* Pre-declaration of internal function */
+int start_ttl(struct aodv_node *node, struct artentry *rtent,
+	      u_int32_t dst_ip);
+
+/*
+ *   start_ttl
+ *
+ *   Description:
+ *     Picks the TTL of the first RREQ of a route discovery. It reaches
+ *     TTL_INCREMENT past the hop count of a valid route, else past the
+ *     distance last learnt from a RREQ or RREP (see dist_get), else
+ *     past the hop count the route had when it broke. With no distance
+ *     known the search starts at TTL_START.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node.
+ *     struct artentry *rtent - The route to the destination or NULL.
+ *     u_int32_t dst_ip       - The destination.
+ *
+ *   Return:
+ *     int - The TTL, at most NET_DIAMETER
+*/
+int
+start_ttl(struct aodv_node *node, struct artentry *rtent, u_int32_t dst_ip)
+{
+  int hops;
+
+  if (rtent != NULL && rtent->hop_cnt != 255)
+    hops = rtent->hop_cnt;
+  else if ((hops = dist_get(node, dst_ip)) == 0 && rtent != NULL)
+    hops = rtent->lst_hop_cnt;
+
+  if (hops == 0)
+    return TTL_START;
+
+  return MIN(hops + TTL_INCREMENT, NET_DIAMETER);
+}
+
 /* 
  *   gen_rreq
  *
@@ -28,9 +67,15 @@
  *     The rreq is allways sent to the broadcast(255.255.255.255)
  *     address.
  *     The rreq is then enqueued on the prioqueue for retransmission
- *     if a RREP is not recived within the timeout period.
+ *     if a RREP is not recived within the timeout period, see
+ *     ring_traversal_time.
+ *     The first ring reaches TTL_INCREMENT past the last known
+ *     distance to the destination, see start_ttl.
+ *     For a route being repaired locally the TTL is the last known
+ *     hop count plus LOCAL_ADD_TTL and the rreq is not retransmitted.
  *
  *   Arguments:
+ *     struct aodv_node *node - The node.
  *     struct info *is - The data about the addresses.
  *     is->ip_pkt_dst_ip = The destination addres in the RREQ
  *     is->ip_pkt_src_ip = The source addres in the RREQ
@@ -41,16 +86,18 @@
  *     int - On error -1 is returned otherwise 0
 */
 int
-gen_rreq(struct info *is)
+gen_rreq(struct aodv_node *node, struct info *is)
 {
   struct artentry *rtent;
   struct rreq_tdata *trd;
   struct rreq *out_rreq;
   struct info bcast;
+  int retries = 0;
   
   /* Do not send rreq to the same host again if its already in the 
      timer queue */
-  if (pq_getfirstofidflags(is->ip_pkt_dst_ip,PQ_PACKET_RREQ) != NULL)
+  if (pq_getfirstofidflags(&node->pq, is->ip_pkt_dst_ip,
+			   PQ_PACKET_RREQ) != NULL)
     return 0;
   
   /* Allocate memory for the rreq message */
@@ -67,27 +114,33 @@ gen_rreq(struct info *is)
     return -1;
 
   /* Get routing table entry for destination */
-  rtent = getentry(is->ip_pkt_dst_ip);
+  rtent = getentry(node, is->ip_pkt_dst_ip);
   
   if (rtent == NULL)
     {
       /* Entry does not exist -> set to initial values*/    
-      out_rreq->broadcast_id = 0;
       out_rreq->dst_seq = 0;
-      bcast.ip_pkt_ttl =  TTL_START;
+      bcast.ip_pkt_ttl = start_ttl(node, rtent, is->ip_pkt_dst_ip);
+    }
+  else if (rtent->hop_cnt == 255 && (rtent->rt_flags & RT_REPAIR))
+    {
+      /* Local repair -> one RREQ that reaches a little past the old
+	 distance, see local_repair */
+      out_rreq->dst_seq = rtent->dst_seq;
+      bcast.ip_pkt_ttl = rtent->lst_hop_cnt + LOCAL_ADD_TTL;
+      retries = RREQ_RETRIES;
     }
   else 
     {
       /* Entry does exist -> get value from rt */    
-      out_rreq->broadcast_id = (rtent->broadcast_id)++;
       out_rreq->dst_seq = rtent->dst_seq;
-      bcast.ip_pkt_ttl =  rtent->hop_cnt + TTL_INCREMENT;
+      bcast.ip_pkt_ttl = start_ttl(node, rtent, is->ip_pkt_dst_ip);
     }
   
   
   /* Get routing table entry for source, when this is ourself this one
      should allways exist*/
-  rtent = getentry(is->ip_pkt_src_ip);
+  rtent = getentry(node, is->ip_pkt_src_ip);
   
   if (rtent == NULL)
     {
@@ -96,8 +149,13 @@ gen_rreq(struct info *is)
       return -1;
     } 
   else 
-    /* Get our own sequence number */
-    out_rreq->src_seq = rtent->dst_seq;
+    {
+      /* Get our own sequence number. The broadcast id counts every RREQ
+	 of the node, one kept per destination would start over when the
+	 route is deleted and be taken for a duplicate */
+      out_rreq->src_seq = rtent->dst_seq;
+      out_rreq->broadcast_id = (rtent->broadcast_id)++;
+    }
   
   /* Fill in the package */
   out_rreq->dst_ip = is->ip_pkt_dst_ip;
@@ -113,8 +171,8 @@ gen_rreq(struct info *is)
   bcast.ip_pkt_my_ip = is->ip_pkt_my_ip;
   bcast.ip_pkt_src_ip = is->ip_pkt_my_ip;
   
-  if (add_rreq(out_rreq->src_ip, 
-	       out_rreq->broadcast_id, getcurrtime() + BCAST_ID_SAVE) == -1)
+  if (add_rreq(node, out_rreq->src_ip, out_rreq->broadcast_id,
+	       getcurrtime() + broadcast_record_time(node)) == -1)
     {
       fprintf(stderr,"%s : %d : Can't add to broadcast list\n",
 	      __FILE__, __LINE__);
@@ -122,7 +180,7 @@ gen_rreq(struct info *is)
     }
   
   /* Send the package */
-  if (send_datagram(&bcast,out_rreq,sizeof(struct rreq)) < 0)
+  if (send_datagram(node, &bcast,out_rreq,sizeof(struct rreq)) < 0)
     {
       fprintf(stderr,"%s : %d : Can't send broadcast\n",
 	      __FILE__, __LINE__);
@@ -131,18 +189,14 @@ gen_rreq(struct info *is)
   
   /* Enqueue in the message queue */
   trd->rd = out_rreq;
-  trd->retries = 0;
+  trd->retries = retries;
   trd->ttl = bcast.ip_pkt_ttl;
   trd->dst_ip = bcast.ip_pkt_dst_ip;
+  trd->sent = getcurrtime();
   
-  /* Is this HELLO message ? */
-  if (out_rreq->dst_ip == inet_addr("255.255.255.255"))
-      pq_insert(getcurrtime() + HELLO_INTERVAL, trd, out_rreq->dst_ip,
-		PQ_PACKET_HELLO);
-
-  else
-      pq_insert(getcurrtime() + 2 * bcast.ip_pkt_ttl * NODE_TRAVERSAL_TIME,
-		trd, out_rreq->dst_ip, PQ_PACKET_RREQ);
+  pq_insert(&node->pq,
+	    getcurrtime() + ring_traversal_time(node, bcast.ip_pkt_ttl),
+	    trd, out_rreq->dst_ip, PQ_PACKET_RREQ);
 
   return 0;
 }
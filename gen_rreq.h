@@ -8,6 +8,7 @@
  *        parameters
  *
  *	Internal procedures:
+ *        start_ttl
  *	
  *	External procedures:
  *        gen_rreq
@@ -33,6 +34,8 @@
 #include "timer.h"
 #include "to_rreq.h"
 #include "rreq_list.h"
+#include "dist.h"
+#include "rtt.h"
 
 /* 
  *   gen_rreq
@@ -43,9 +46,15 @@
  *     The rreq is allways sent to the broadcast(255.255.255.255)
  *     address.
  *     The rreq is then enqueued on the prioqueue for retransmission
- *     if a RREP is not recived within the timeout period.
+ *     if a RREP is not recived within the timeout period, see
+ *     ring_traversal_time.
+ *     The first ring reaches TTL_INCREMENT past the last known
+ *     distance to the destination, see start_ttl.
+ *     For a route being repaired locally the TTL is the last known
+ *     hop count plus LOCAL_ADD_TTL and the rreq is not retransmitted.
  *
  *   Arguments:
+ *     struct aodv_node *node - The node.
  *     struct info *is - The data about the addresses.
  *     is->ip_pkt_dst_ip = The destination addres in the RREQ
  *     is->ip_pkt_src_ip = The source addres in the RREQ
@@ -56,6 +65,6 @@
  *     int - On error -1 is returned otherwise 0
  */
 int
-gen_rreq(struct info *is);
+gen_rreq(struct aodv_node *node, struct info *is);
 
 #endif
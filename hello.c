@@ -0,0 +1,304 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        HELLO messages. Every HELLO_INTERVAL a node broadcasts a RREP
+ *        for itself with TTL 1: hop count 0, its own address as both
+ *        destination and originator, its sequence number and a lifetime
+ *        of ALLOWED_HELLO_LOSS intervals. A neighbour that hears it
+ *        makes sure it has a route to the node, one hop, and enters it
+ *        in its neighbour table. Nobody answers, so a round of HELLOs
+ *        costs one broadcast per node however many neighbours it has.
+ *
+ *        A broadcast of any kind postpones the next HELLO, see
+ *        send_datagram. A HELLO is also skipped when every neighbour
+ *        has had a message from the node in the last half interval,
+ *        unicasts included, as the message told it as much. At most
+ *        HELLO_MAX_SKIP in a row are skipped, so neighbours that don't
+ *        know the node yet still hear of it.
+ *
+ *        In relay mode a HELLO carries a hello_ext after the RREP with
+ *        the neighbours of the node, its relays first, see
+ *        nb_select_relays. Those HELLOs are neither postponed nor
+ *        skipped, the neighbours need the list.
+ *
+ *	Internal procedures:
+ *
+ *	External procedures:
+ *        gen_hello
+ *        rec_hello
+ *        hello_heard
+ *        hello_resend
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "hello.h"
+#include "RT.h"
+#include "neighbour.h"
+#include "timer.h"
+#include "to_rreq.h"
+#include "utils.h"
+#include "krtable.h"
+#include "clock.h"
+
+/*
+ * gen_hello
+ *
+ * Description:
+ *   Broadcasts a HELLO. HELLOs are numbered in the reserved bits so a
+ *   neighbour can tell how many were lost. In relay mode the relays
+ *   are elected anew and the HELLO lists the neighbours.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   int - 0 if it was sent, else -1
+ */
+int
+gen_hello(struct aodv_node *node)
+{
+  u_int32_t buf[(sizeof(struct rrep) + sizeof(struct hello_ext)) / 4 +
+		HELLO_MAX_NB];
+  struct rrep *hello = (struct rrep*)buf;
+  struct hello_ext *ext;
+  struct nb_entry *nb;
+  struct info inf;
+  u_int32_t *list;
+  int len = sizeof(struct rrep);
+  int n = 0;
+
+  hello->type = RREP;
+  hello->r = 0;
+  hello->reserved = node->hello_seq++ & HELLO_SEQ_MASK;
+  hello->prefix_sz = 0;
+  hello->hop_cnt = 0;
+  hello->dst_ip = node->my_ip;
+  hello->dst_seq = node->my_entry->dst_seq;
+  hello->src_ip = node->my_ip;
+  hello->lifetime = ALLOWED_HELLO_LOSS * HELLO_INTERVAL;
+
+  if (node->mpr)
+    {
+      ext = (struct hello_ext*)((char*)buf + sizeof(struct rrep));
+      list = (u_int32_t*)(ext + 1);
+
+      /* The relays first, then the other neighbours */
+      nb_select_relays(node);
+      for (nb = node->nb_list; nb != NULL && n < HELLO_MAX_NB; nb = nb->next)
+	if (nb->relay)
+	  list[n++] = nb->ip;
+      ext->relays = n;
+      for (nb = node->nb_list; nb != NULL && n < HELLO_MAX_NB; nb = nb->next)
+	if (!nb->relay)
+	  list[n++] = nb->ip;
+
+      ext->type = HELLO_EXT_NB;
+      ext->len = n * sizeof(u_int32_t);
+      ext->reserved = 0;
+      len += sizeof(struct hello_ext) + ext->len;
+    }
+
+  inf.ip_pkt_dst_ip = inet_addr("255.255.255.255");
+  inf.ip_pkt_src_ip = node->my_ip;
+  inf.ip_pkt_my_ip = node->my_ip;
+  inf.ip_pkt_ttl = 1;
+
+  if (send_datagram(node, &inf, buf, len) < 0)
+    return -1;
+
+  return 0;
+}
+
+/*
+ * rec_hello
+ *
+ * Description:
+ *   Handles a HELLO from a neighbour. Enters the neighbour in the
+ *   neighbour table and makes the route to it one hop, valid at least
+ *   for the lifetime of the HELLO. RREQs the node sent for the
+ *   neighbour are dropped, it has its route. The neighbour list of a
+ *   HELLO in relay mode goes to nb_set_list.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   struct info *inf       - Sender of the HELLO.
+ *   struct rrep *hello     - The HELLO.
+ *   int len                - Its length, with the neighbour list.
+ *
+ * Return:
+ *   int - 0, -1 if the route couldn't be allocated
+ */
+int
+rec_hello(struct aodv_node *node, struct info *inf, struct rrep *hello,
+	  int len)
+{
+  struct artentry *rt;
+  struct prioqent *pqe;
+  struct rreq_tdata *trd;
+  struct hello_ext ext;
+  u_int32_t list[HELLO_MAX_NB];
+  u_int64_t curr_time = getcurrtime();
+  int event = FLIGHT_RT_UPDATE;
+
+  if (hello->dst_ip != inf->ip_pkt_src_ip || hello->dst_ip == node->my_ip)
+    /* Only a neighbour can say HELLO for itself */
+    return 0;
+
+  if (nb_hello(node, hello->dst_ip, hello->lifetime, hello->reserved)
+      == NULL)
+    {
+      /* Couldn't enter the neighbour, the route still shows the link */
+    }
+  else if (len > (int)sizeof(struct rrep))
+    {
+      /* The neighbour list, node_recv checked the length */
+      memcpy(&ext, (char*)hello + sizeof(struct rrep), sizeof(ext));
+      memcpy(list, (char*)hello + sizeof(struct rrep) + sizeof(ext),
+	     ext.len);
+      nb_set_list(node, hello->dst_ip, list, ext.len / sizeof(u_int32_t),
+		  ext.relays);
+    }
+
+  /* Remove RREQ from resend-queue, the queue doesn't free the RREQ */
+  while ((pqe = pq_getfirstofidflags(&node->pq, hello->dst_ip,
+				     PQ_PACKET_RREQ)) != NULL)
+    {
+      trd = pqe->data;
+      free(trd->rd);
+      free(trd);
+      pq_deleteent(&node->pq, pqe);
+    }
+
+  if ((rt = getentry(node, hello->dst_ip)) == NULL)
+    {
+      if ((rt = insert_entry(node)) == NULL)
+	return -1;
+
+      event = FLIGHT_RT_INSERT;
+      rt->dst_ip = hello->dst_ip;
+      rt->dst_seq = hello->dst_seq;
+      rt->broadcast_id = 0;
+      rt->lst_hop_cnt = 0;
+      rt->hop_cnt = 255;
+      rt->nxt_hop = 0;
+    }
+
+  if (hello->dst_seq > rt->dst_seq)
+    rt->dst_seq = hello->dst_seq;
+
+  if ((rt->hop_cnt != 1 || rt->nxt_hop != hello->dst_ip)
+      && (rt->hop_cnt == 255 || rt->lifetime < curr_time
+	  || nb_cost(node, hello->dst_ip, 1)
+	  <= nb_cost(node, rt->nxt_hop, rt->hop_cnt)))
+    {
+      /* A new route, or one that the link replaces. With METRIC_ETX a
+	 lossy link doesn't replace a better route through others */
+      if (rt->hop_cnt != 255)
+	del_kroute(rt->dst_ip, rt->nxt_hop);
+      else
+	rt->lifetime = 0;
+
+      rt->nxt_hop = hello->dst_ip;
+      rt->hop_cnt = 1;
+      trim_alt_hops(rt);
+      flight_event(event, rt->dst_ip, rt->nxt_hop, rt->hop_cnt,
+		   rt->dst_seq);
+      if (add_kroute(rt->dst_ip, rt->nxt_hop))
+	{
+	  /* add_kroute failed, ignore and continue */
+	}
+    }
+
+  rt->lifetime = MAX(rt->lifetime, curr_time + hello->lifetime);
+  if (rt->hop_cnt != 255)
+    /* A local repair is over */
+    rt->rt_flags &= ~RT_REPAIR;
+
+  return 0;
+}
+
+/*
+ * hello_heard
+ *
+ * Description:
+ *   Takes a message from a known neighbour as a HELLO: the neighbour
+ *   table keeps it and the route to it stays valid as long as the
+ *   neighbour. Unknown senders wait for a real HELLO.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the sender.
+ *
+ * Return: None
+ */
+void
+hello_heard(struct aodv_node *node, u_int32_t ip)
+{
+  struct nb_entry *nb;
+  struct artentry *rt;
+
+  if ((nb = nb_heard(node, ip)) == NULL)
+    return;
+
+  rt = getentry(node, ip);
+  if (rt != NULL && rt->hop_cnt == 1 && rt->nxt_hop == ip)
+    rt->lifetime = MAX(rt->lifetime, nb->expire);
+}
+
+/*
+ * hello_resend
+ *
+ * Description:
+ *   Sends a HELLO, unless all neighbours have heard from the node
+ *   lately and it is not in relay mode, and queues the next one
+ *   HELLO_INTERVAL later.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   int - 0 if the HELLO was sent, else -1
+ */
+int
+hello_resend(struct aodv_node *node)
+{
+  int ret = 0;
+
+  if (!node->mpr && node->hello_skip < HELLO_MAX_SKIP &&
+      node->nb_list != NULL && nb_silent(node) == 0)
+    /* Every neighbour knows the node is there */
+    node->hello_skip++;
+  else
+    {
+      node->hello_skip = 0;
+      ret = gen_hello(node);
+    }
+
+  pq_insert(&node->pq, getcurrtime() + HELLO_INTERVAL, NULL,
+	    inet_addr("255.255.255.255"), PQ_PACKET_HELLO);
+
+  return ret;
+}
@@ -0,0 +1,149 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        HELLO messages. Every HELLO_INTERVAL a node broadcasts a RREP
+ *        for itself with TTL 1: hop count 0, its own address as both
+ *        destination and originator, its sequence number and a lifetime
+ *        of ALLOWED_HELLO_LOSS intervals. A neighbour that hears it
+ *        makes sure it has a route to the node, one hop, and enters it
+ *        in its neighbour table. Nobody answers, so a round of HELLOs
+ *        costs one broadcast per node however many neighbours it has.
+ *
+ *        A broadcast of any kind postpones the next HELLO, see
+ *        send_datagram. A HELLO is also skipped when every neighbour
+ *        has had a message from the node in the last half interval,
+ *        unicasts included, as the message told it as much. At most
+ *        HELLO_MAX_SKIP in a row are skipped, so neighbours that don't
+ *        know the node yet still hear of it.
+ *
+ *        In relay mode a HELLO carries a hello_ext after the RREP with
+ *        the neighbours of the node, its relays first, see
+ *        nb_select_relays. Those HELLOs are neither postponed nor
+ *        skipped, the neighbours need the list.
+ *
+ *	Internal procedures:
+ *
+ *	External procedures:
+ *        gen_hello
+ *        rec_hello
+ *        hello_heard
+ *        hello_resend
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef HELLO_H
+#define HELLO_H
+
+#include <arpa/inet.h>
+#include <sys/types.h>
+
+#include "aodv.h"
+#include "info.h"
+#include "node.h"
+
+#define HELLO_MAX_SKIP 3         /* HELLOs skipped in a row at most */
+
+/* The neighbour list of a HELLO in relay mode, after the RREP */
+struct hello_ext
+{
+  u_int8_t type;                 /* HELLO_EXT_NB */
+  u_int8_t len;                  /* Bytes of addresses that follow */
+  u_int8_t relays;               /* The first relays are its relays */
+  u_int8_t reserved;
+};
+
+#define HELLO_EXT_NB   3         /* Type of the neighbour list */
+#define HELLO_MAX_NB   63        /* Neighbours listed at most */
+
+/*
+ * gen_hello
+ *
+ * Description:
+ *   Broadcasts a HELLO.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   int - 0 if it was sent, else -1
+ */
+int gen_hello(struct aodv_node *node);
+
+/*
+ * rec_hello
+ *
+ * Description:
+ *   Handles a HELLO from a neighbour. Enters the neighbour in the
+ *   neighbour table and makes the route to it one hop, valid at least
+ *   for the lifetime of the HELLO. RREQs the node sent for the
+ *   neighbour are dropped, it has its route. The neighbour list of a
+ *   HELLO in relay mode goes to nb_set_list.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   struct info *inf       - Sender of the HELLO.
+ *   struct rrep *hello     - The HELLO.
+ *   int len                - Its length, with the neighbour list.
+ *
+ * Return:
+ *   int - 0, -1 if the route couldn't be allocated
+ */
+int rec_hello(struct aodv_node *node, struct info *inf, struct rrep *hello,
+	      int len);
+
+/*
+ * hello_heard
+ *
+ * Description:
+ *   Takes a message from a known neighbour as a HELLO: the neighbour
+ *   table keeps it and the route to it stays valid as long as the
+ *   neighbour. Unknown senders wait for a real HELLO.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the sender.
+ *
+ * Return: None
+ */
+void hello_heard(struct aodv_node *node, u_int32_t ip);
+
+/*
+ * hello_resend
+ *
+ * Description:
+ *   Sends a HELLO, unless all neighbours have heard from the node
+ *   lately and it is not in relay mode, and queues the next one
+ *   HELLO_INTERVAL later.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   int - 0 if the HELLO was sent, else -1
+ */
+int hello_resend(struct aodv_node *node);
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Fixed size log-linear histogram of 64 bit values. Values below
+ *        HIST_SUB are counted exactly, above that every power of two is
+ *        split into HIST_SUB buckets, so a percentile is off by at most
+ *        1/HIST_SUB of its value. Adding a value is a few instructions
+ *        and the memory use does not depend on the number of values.
+ *
+ *	Internal procedures:
+ *        hist_index
+ *        hist_value
+ *
+ *	External procedures:
+ *        hist_init
+ *        hist_add
+ *        hist_merge
+ *        hist_percentile
+ *        hist_mean
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "hist.h"
+
+/* Pre-declaration of internal functions */
+int hist_index(u_int64_t value);
+u_int64_t hist_value(int index);
+
+/*
+ *   hist_index
+ *
+ *   Description:
+ *     Maps a value to its bucket.
+ *
+ *   Arguments:
+ *     u_int64_t value - The value.
+ *
+ *   Return:
+ *     int - Index of the bucket.
+ */
+int
+hist_index(u_int64_t value)
+{
+  int e;
+
+  if (value < HIST_SUB)
+    return value;
+
+  /* Position of the highest set bit */
+  e = 63 - __builtin_clzll(value);
+
+  return (e - HIST_SUBBITS + 1) * HIST_SUB +
+    ((value >> (e - HIST_SUBBITS)) & (HIST_SUB - 1));
+}
+
+/*
+ *   hist_value
+ *
+ *   Description:
+ *     Maps a bucket to the largest value it holds.
+ *
+ *   Arguments:
+ *     int index - Index of the bucket.
+ *
+ *   Return:
+ *     u_int64_t - The largest value of the bucket.
+ */
+u_int64_t
+hist_value(int index)
+{
+  int e;
+  u_int64_t m;
+
+  if (index < HIST_SUB)
+    return index;
+
+  e = index / HIST_SUB + HIST_SUBBITS - 1;
+  m = index % HIST_SUB;
+
+  return ((HIST_SUB + m + 1) << (e - HIST_SUBBITS)) - 1;
+}
+
+/*
+ *   hist_init
+ *
+ *   Description:
+ *     Empties a histogram.
+ *
+ *   Arguments:
+ *     struct hist *h - The histogram.
+ *
+ *   Return: None
+ */
+void
+hist_init(struct hist *h)
+{
+  memset(h, 0, sizeof(struct hist));
+  h->min = ~0ULL;
+}
+
+/*
+ *   hist_add
+ *
+ *   Description:
+ *     Counts a value.
+ *
+ *   Arguments:
+ *     struct hist *h  - The histogram.
+ *     u_int64_t value - The value.
+ *
+ *   Return: None
+ */
+void
+hist_add(struct hist *h, u_int64_t value)
+{
+  h->bucket[hist_index(value)]++;
+  h->count++;
+  h->sum += value;
+
+  if (value < h->min)
+    h->min = value;
+  if (value > h->max)
+    h->max = value;
+}
+
+/*
+ *   hist_merge
+ *
+ *   Description:
+ *     Adds the values counted in one histogram to another.
+ *
+ *   Arguments:
+ *     struct hist *to   - The histogram added to.
+ *     struct hist *from - The histogram added.
+ *
+ *   Return: None
+ */
+void
+hist_merge(struct hist *to, struct hist *from)
+{
+  int i;
+
+  for (i = 0; i < HIST_BUCKETS; i++)
+    to->bucket[i] += from->bucket[i];
+  to->count += from->count;
+  to->sum += from->sum;
+
+  if (from->min < to->min)
+    to->min = from->min;
+  if (from->max > to->max)
+    to->max = from->max;
+}
+
+/*
+ *   hist_percentile
+ *
+ *   Description:
+ *     Returns the value below which a given percentage of the counted
+ *     values fall.
+ *
+ *   Arguments:
+ *     struct hist *h - The histogram.
+ *     double pct     - The percentile, 0 to 100.
+ *
+ *   Return:
+ *     u_int64_t - Upper bound of the bucket holding the percentile,
+ *                 never above the largest value. 0 if h is empty.
+ */
+u_int64_t
+hist_percentile(struct hist *h, double pct)
+{
+  u_int64_t rank;
+  u_int64_t seen = 0;
+  u_int64_t value;
+  int i;
+
+  if (h->count == 0)
+    return 0;
+
+  /* Rank of the value, 1 to count */
+  rank = (u_int64_t)(pct / 100.0 * h->count + 0.5);
+  if (rank < 1)
+    rank = 1;
+  if (rank > h->count)
+    rank = h->count;
+
+  for (i = 0; i < HIST_BUCKETS; i++)
+    {
+      seen += h->bucket[i];
+      if (seen >= rank)
+	break;
+    }
+
+  value = hist_value(i);
+
+  return value < h->max ? value : h->max;
+}
+
+/*
+ *   hist_mean
+ *
+ *   Description:
+ *     Returns the mean of the counted values.
+ *
+ *   Arguments:
+ *     struct hist *h - The histogram.
+ *
+ *   Return:
+ *     double - The mean, 0 if h is empty.
+ */
+double
+hist_mean(struct hist *h)
+{
+  if (h->count == 0)
+    return 0;
+
+  return (double)h->sum / h->count;
+}
@@ -0,0 +1,141 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Fixed size log-linear histogram of 64 bit values. Values below
+ *        HIST_SUB are counted exactly, above that every power of two is
+ *        split into HIST_SUB buckets, so a percentile is off by at most
+ *        1/HIST_SUB of its value. Adding a value is a few instructions
+ *        and the memory use does not depend on the number of values.
+ *
+ *	Internal procedures:
+ *        hist_index
+ *        hist_value
+ *
+ *	External procedures:
+ *        hist_init
+ *        hist_add
+ *        hist_merge
+ *        hist_percentile
+ *        hist_mean
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef HIST_H
+#define HIST_H
+
+#include <string.h>
+#include <sys/types.h>
+
+/* Buckets per power of two, must be a power of two */
+#define HIST_SUBBITS  4
+#define HIST_SUB      (1 << HIST_SUBBITS)
+
+/* Enough buckets for any 64 bit value */
+#define HIST_BUCKETS  ((64 - HIST_SUBBITS + 1) * HIST_SUB)
+
+struct hist
+{
+  u_int64_t count;                  /* Number of values */
+  u_int64_t sum;                    /* Sum of the values */
+  u_int64_t min;                    /* Smallest value */
+  u_int64_t max;                    /* Largest value */
+  u_int64_t bucket[HIST_BUCKETS];
+};
+
+
+/*
+ *   hist_init
+ *
+ *   Description:
+ *     Empties a histogram.
+ *
+ *   Arguments:
+ *     struct hist *h - The histogram.
+ *
+ *   Return: None
+ */
+void hist_init(struct hist *h);
+
+/*
+ *   hist_add
+ *
+ *   Description:
+ *     Counts a value.
+ *
+ *   Arguments:
+ *     struct hist *h  - The histogram.
+ *     u_int64_t value - The value.
+ *
+ *   Return: None
+ */
+void hist_add(struct hist *h, u_int64_t value);
+
+/*
+ *   hist_merge
+ *
+ *   Description:
+ *     Adds the values counted in one histogram to another.
+ *
+ *   Arguments:
+ *     struct hist *to   - The histogram added to.
+ *     struct hist *from - The histogram added.
+ *
+ *   Return: None
+ */
+void hist_merge(struct hist *to, struct hist *from);
+
+/*
+ *   hist_percentile
+ *
+ *   Description:
+ *     Returns the value below which a given percentage of the counted
+ *     values fall.
+ *
+ *   Arguments:
+ *     struct hist *h - The histogram.
+ *     double pct     - The percentile, 0 to 100.
+ *
+ *   Return:
+ *     u_int64_t - Upper bound of the bucket holding the percentile,
+ *                 never above the largest value. 0 if h is empty.
+ */
+u_int64_t hist_percentile(struct hist *h, double pct);
+
+/*
+ *   hist_mean
+ *
+ *   Description:
+ *     Returns the mean of the counted values.
+ *
+ *   Arguments:
+ *     struct hist *h - The histogram.
+ *
+ *   Return:
+ *     double - The mean, 0 if h is empty.
+ */
+double hist_mean(struct hist *h);
+
+#endif
@@ -30,6 +30,7 @@
  *         init_rtsocket()
  *         add_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
  *         del_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
+ *         krt_ioctl(int req, u_int32_t dst_ip, u_int32_t gw_ip)
  *
  ********************************
  *
@@ -38,6 +39,11 @@
  */
 
 #include"krtable.h"
+#include"stage.h"
+#include"flight.h"
+
+/* Socket used for the route ioctls */
+int krt;
 
 /* 
  *  init_rtsocket
@@ -111,7 +117,8 @@ gen_krtentry(u_int32_t dst_ip, u_int32_t gw_ip)
  * add_kroute
  *
  * Description:
- *   Adds a route to the kernel's routing table.
+ *   Adds a route to the kernel's routing table. When the sync stage
+ *   runs the change is only queued and 0 is returned.
  *
  * Arguments:
  *   u_int32_t dst_ip - IP address to the destination
@@ -124,24 +131,18 @@ gen_krtentry(u_int32_t dst_ip, u_int32_t gw_ip)
 int
 add_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
 {
-  struct rtentry  *new_krtentry;
-  
-  if ((new_krtentry = gen_krtentry(dst_ip, gw_ip)) == NULL)
-    /* gen_krtentry failed */
-    return -1; 
-  
-  if(ioctl(krt, SIOCADDRT, (char*) new_krtentry) == -1)
-    /* SIOCADDRT failed */ 
-    return -1;
-  
-  return 0;
+  if (stage_running())
+    return stage_kroute(SIOCADDRT, dst_ip, gw_ip);
+
+  return krt_ioctl(SIOCADDRT, dst_ip, gw_ip);
 }
 
 /*
  * del_kroute
  *
  * Description:
- *   Deletes a route from the kernel's routing table.
+ *   Deletes a route from the kernel's routing table. When the sync stage
+ *   runs the change is only queued and 0 is returned.
  *
  * Arguments:
  *   u_int32_t dst_ip - IP address to the destination
@@ -153,15 +154,46 @@ add_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
  */ 
 int
 del_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
+{
+  if (stage_running())
+    return stage_kroute(SIOCDELRT, dst_ip, gw_ip);
+
+  return krt_ioctl(SIOCDELRT, dst_ip, gw_ip);
+}
+
+/*
+ * krt_ioctl
+ *
+ * Description:
+ *   Changes the kernel's routing table right away. Used by the sync
+ *   stage and by add_kroute/del_kroute when it does not run.
+ *
+ * Arguments:
+ *   int req          - SIOCADDRT or SIOCDELRT
+ *   u_int32_t dst_ip - IP address to the destination
+ *   u_int32_t gw_ip  - IP address to the gateway of the route
+ *
+ * Return:
+ *   int - 0 on success
+ *        -1 on failure
+ */
+int
+krt_ioctl(int req, u_int32_t dst_ip, u_int32_t gw_ip)
 {
   struct rtentry  *new_krtentry;
+  int rc;
 
   if ((new_krtentry = gen_krtentry(dst_ip, gw_ip)) == NULL)
-    /* del_kroute failed */
+    /* gen_krtentry failed */
     return -1;
   
-  if(ioctl(krt, SIOCDELRT, (char*) new_krtentry) == -1)
-    /* SIOCDELRT failed */
+  rc = ioctl(krt, req, (char*) new_krtentry);
+  flight_event(req == SIOCADDRT ? FLIGHT_KRT_ADD : FLIGHT_KRT_DEL,
+	       dst_ip, gw_ip, rc == -1 ? errno : 0, 0);
+  free(new_krtentry);
+
+  if (rc == -1)
+    /* SIOCADDRT/SIOCDELRT failed */
     return -1;
   
   return 0;
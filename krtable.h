@@ -30,6 +30,7 @@
  *         init_rtsocket()
  *         add_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
  *         del_kroute(u_int32_t dst_ip, u_int32_t gw_ip)
+ *         krt_ioctl(int req, u_int32_t dst_ip, u_int32_t gw_ip)
  *
  ********************************
  *
@@ -54,8 +55,8 @@
 #include<fcntl.h>
 #include<unistd.h>
 
-/* Declaration of global variable */
-int krt;
+/* Declaration of global variable, defined in krtable.c */
+extern int krt;
 
 /* 
  *  init_rtsocket
@@ -75,7 +76,8 @@ int init_rtsocket ();
  * add_kroute
  *
  * Description:
- *   Adds a route to the kernel's routing table.
+ *   Adds a route to the kernel's routing table. When the sync stage
+ *   runs the change is only queued and 0 is returned.
  *
  * Arguments:
  *   u_int32_t dst_ip - IP address to the destination
@@ -91,7 +93,8 @@ int add_kroute(u_int32_t dst_ip, u_int32_t gw_ip);
  * del_kroute
  *
  * Description:
- *   Deletes a route from the kernel's routing table.
+ *   Deletes a route from the kernel's routing table. When the sync stage
+ *   runs the change is only queued and 0 is returned.
  *
  * Arguments:
  *   u_int32_t dst_ip - IP address to the destination
@@ -103,4 +106,22 @@ int add_kroute(u_int32_t dst_ip, u_int32_t gw_ip);
  */ 
 int del_kroute(u_int32_t dst_ip, u_int32_t gw_ip);
 
+/*
+ * krt_ioctl
+ *
+ * Description:
+ *   Changes the kernel's routing table right away. Used by the sync
+ *   stage and by add_kroute/del_kroute when it does not run.
+ *
+ * Arguments:
+ *   int req          - SIOCADDRT or SIOCDELRT
+ *   u_int32_t dst_ip - IP address to the destination
+ *   u_int32_t gw_ip  - IP address to the gateway of the route
+ *
+ * Return:
+ *   int - 0 on success
+ *        -1 on failure
+ */
+int krt_ioctl(int req, u_int32_t dst_ip, u_int32_t gw_ip);
+
 #endif
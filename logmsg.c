@@ -20,16 +20,25 @@
  ********************************
  *
  *	General description:
- *        Writes logging messages about packages to a filedescriptor
+ *        Logs sent and received packages to a control traffic trace,
+ *        see trace.h for the format. The protocol stage only copies the
+ *        package into a record in the log ring, the sync stage turns the
+ *        records into trace records, collects them into blocks and writes
+ *        a block at a time to the trace file.
  *
  *     Internal procedures:
- *        septime
- *        print_rreq
- *        print_rrep
- *        print_rerr
+ *        log_wanted
+ *        log_now
  *
  *	External procedures:
+ *        logmsg_init
  *        logmsg
+ *        logmsg_write
+ *        logmsg_krt
+ *        logmsg_flush
+ *        logmsg_flushwait
+ *        logmsg_setlevel
+ *        logmsg_getlevel
  *
  ********************************
  *
@@ -38,219 +47,370 @@
  */
 
 #include "logmsg.h"
+#include "stage.h"
+
+/* Only read and set by the protocol stage */
+static int log_level = LOG_LEVEL_ALL;
+
+/* The block being filled, only used by the stage that writes records */
+static char log_block[LOG_BLOCK_SIZE] __attribute__ ((aligned (8)));
+static int log_blocklen = 0;
+static u_int64_t log_blocktime = 0;   /* When the first record was added */
+static int log_fd = -1;
+
+/* Pre-declaration of internal functions */
+int log_wanted(void *data, int datalen);
+u_int64_t log_now();
 
 /* 
- *   septime
- * 
+ *   log_wanted
+ *
  *   Description: 
- *     Writes the 64bit number in groups of two
- *     to the buffer, separated by :'s.
+ *     Checks the package type against the log level.
  *
  *   Arguments:
- *     char *buffer     - The buffer to be written in to
- *     u_int64_t u64num - The 64 bit number to be written
+ *     void *data  - The raw package.
+ *     int datalen - The length of the package.
  *
  *   Return:
- *     char*            - Sames as the input buffer
+ *     int - 1 if the package should be logged, 0 otherwise.
 */
-char *
-septime(char *buffer, u_int64_t u64num)
+int
+log_wanted(void *data, int datalen)
 {
-  char tmpbuff[MAXBUFLEN];
-  int i = 0, j = 0;
-  
-  sprintf(tmpbuff, "%Lu", u64num);
-  for (i = 0;i < strlen(tmpbuff); i++)
+  u_int8_t pkt_type;
+
+  if (log_level == LOG_LEVEL_OFF || datalen < 1)
+    return 0;
+
+  if (log_level == LOG_LEVEL_ALL)
+    return 1;
+
+  /* Extract the package type (we know it is 8 bits)*/
+  pkt_type = *((u_int8_t*)data);
+  switch (pkt_type)
     {
-      buffer[j++] = tmpbuff[i];
-      if ((i + 1) % 2 == 0 && (i + 1) != strlen(tmpbuff))
-	buffer[j++] = ':';
+    case(RERR):
+      return 1;
+
+    case(RREP):
+      /* A RREP a node sends for itself is a HELLO message */
+      return log_level >= LOG_LEVEL_ROUTE &&
+	datalen >= sizeof(struct rrep) &&
+	!RREP_IS_HELLO((struct rrep*)data);
+
+    case(RREQ):
+      /* A RREQ for the broadcast address is the HELLO of an older
+	 version */
+      return log_level >= LOG_LEVEL_ROUTE && 
+	datalen >= sizeof(struct rreq) &&
+	((struct rreq*)data)->dst_ip != INADDR_BROADCAST;
+
+    default:
+      return 0;
     }
-  buffer[j] = '\0';
-  
-  return buffer;
 }
 
 /* 
- *   print_rreq
+ *   log_now
+ *
+ *   Description: 
+ *     Returns the monotonic time used in the trace.
+ *
+ *   Arguments: None.
+ *
+ *   Return:
+ *     u_int64_t - Time in us.
+*/
+u_int64_t
+log_now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (u_int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* 
+ *   logmsg_init
  *
  *   Description: 
- *     Writes a RREQ package to the filedescriptor writefd
+ *     Creates the trace file and writes the trace header. Packages
+ *     logged before this are thrown away.
  *
  *   Arguments:
- *     struct rreq* pkt - The packet to be logged.
+ *     char *ifname    - The interface the daemon runs on.
+ *     u_int32_t my_ip - The ip of the interface.
  *
- *   Return: None.
+ *   Return:
+ *     int - On error -1 is returned else 0
 */
-void
-print_rreq(struct rreq* pkt, int writefd)
+int
+logmsg_init(char *ifname, u_int32_t my_ip)
 {
-  char outbuffer[MAXBUFLEN];  
-  
-  sprintf(outbuffer, 
-	  "Type: %u(RREQ)  J: %u  R: %u  Reserved: %u  Hop Count: %u\n",
-	  pkt->type,pkt->j, pkt->r, pkt->reserved, pkt->hop_cnt);
-  write(writefd, outbuffer, strlen(outbuffer));
-  
-  sprintf(outbuffer, "BroadcastID: %u\n", pkt->broadcast_id);
-  write(writefd, outbuffer, strlen(outbuffer));
-  
-  sprintf(outbuffer, "Dst IP: %s\tDst Seq nr: %u\n",
-	  inet_ntoa(*((struct in_addr*)&pkt->dst_ip)), pkt->dst_seq);
-  write(writefd, outbuffer, strlen(outbuffer));
-  
-  sprintf(outbuffer, "Src IP: %s\tSrc seq nr: %u\n",
-	  inet_ntoa(*((struct in_addr*)&pkt->src_ip)), pkt->src_seq);
-  write(writefd, outbuffer, strlen(outbuffer));
+  struct trace_hdr hdr;
+
+  if ((log_fd = open(LOG_FILE, 
+		     O_WRONLY|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR)) < 0)
+    /*  Couldn't create the trace */
+    return -1;
+
+  trace_inithdr(&hdr, ifname, my_ip);
+  if (write(log_fd, &hdr, sizeof(struct trace_hdr)) != 
+      sizeof(struct trace_hdr))
+    {
+      close(log_fd);
+      log_fd = -1;
+      return -1;
+    }
+
+  return 0;
 }
 
 /* 
- *   print_rrep
+ *   logmsg
  *
  *   Description: 
- *     Writes a RREP package to the filedescriptor writefd
+ *     Takes a raw data package and logs it if the log level says so.
+ *     When the sync stage runs the package is copied straight into a
+ *     slot of the log ring, nothing else is done by the caller.
  *
  *   Arguments:
- *     struct rrep* pkt - The packet to be logged.
+ *     void *data      - The raw data area to be logged.
+ *     int datalen     - The length of the raw data
+ *     struct info *is - Information about the addresses related to the 
+ *                       package.
+ *       is->ip_pkt_dst_ip = To whome the package was sent (own ip or 
+ *                           broadcast)
+ *       is->ip_pkt_src_ip = Who sent the package.
+ *       ip->ip_pkt_ttl    = The recived ttl.
+ *     int dir         - LOG_DIR_IN or LOG_DIR_OUT
  *
  *   Return: None.
 */
 void
-print_rrep(struct rrep* pkt, int writefd)
+logmsg(void *data, int datalen, struct info *is, int dir)
 {
-  char outbuffer[MAXBUFLEN];  
-  
-  sprintf(outbuffer, "Type: %u(RREP)  R: %u  Reserved: %u  " 
-	  "Prefix Sz: %u  Hop Count: %u\n",
-	  pkt->type,pkt->r, pkt->reserved, pkt->prefix_sz, pkt->hop_cnt);
-  write(writefd, outbuffer, strlen(outbuffer));
-  
-  sprintf(outbuffer, "Dst IP: %s\tDst Seq nr: %u\n",
-	  inet_ntoa(*((struct in_addr*)&pkt->dst_ip)), pkt->dst_seq);
-  write(writefd, outbuffer, strlen(outbuffer));
-  
-  sprintf(outbuffer, "Src IP: %s\n",
-	  inet_ntoa(*((struct in_addr*)&pkt->src_ip)));
-  write(writefd, outbuffer, strlen(outbuffer));
-  
-  sprintf(outbuffer, "Lifetime: %u\n", pkt->lifetime);
-  write(writefd, outbuffer, strlen(outbuffer));
+  struct logrec tmp;
+  struct logrec *rec;
+  int queued;
+
+  if (!log_wanted(data, datalen))
+    return;
+
+  queued = stage_running();
+  if (queued)
+    {
+      /* Fill the ring slot in place, the record is lost if it is full */
+      if ((rec = stage_log_reserve()) == NULL)
+	return;
+    }
+  else
+    rec = &tmp;
+
+  rec->time = log_now();
+  rec->src_ip = is->ip_pkt_src_ip;
+  rec->dst_ip = is->ip_pkt_dst_ip;
+  rec->len = datalen;
+  rec->dir = dir;
+  rec->ttl = is->ip_pkt_ttl;
+  memcpy(rec->data, data, MIN(datalen, LOG_DATA_LEN));
+
+  if (queued)
+    stage_log_commit();
+  else
+    {
+      logmsg_write(rec);
+      logmsg_flush();
+    }
 }
 
 /* 
- *   print_rerr
+ *   logmsg_write
  *
  *   Description: 
- *     Writes a RERR package to the filedescriptor writefd
+ *     Adds a record to the current block as a trace record, the block is
+ *     written to the trace file when it is full. Called by the sync stage for records
+ *     queued by logmsg.
  *
  *   Arguments:
- *     void* pkt - The raw data to be interpreted as a RERR package.
+ *     struct logrec *rec - The record to write.
  *
  *   Return: None.
 */
 void
-print_rerr(void *pkt, int writefd)
+logmsg_write(struct logrec *rec)
 {
-  char outbuffer[MAXBUFLEN];  
-  struct rerrdst *m_rerrdst;
-  struct rerr *m_rerr;
-  struct rerr t_rerr;
-  int i = 0;
+  struct trace_rec *trec;
+  int caplen;
+  int reclen;
 
-  m_rerr = (struct rerr*)pkt;
+  caplen = MIN(rec->len, LOG_DATA_LEN);
+  reclen = TRACE_RECLEN(caplen);
 
-  t_rerr.type = 3;
-  t_rerr.reserved = 0;
-  t_rerr.dst_cnt = 2;
+  if (log_blocklen + reclen > LOG_BLOCK_SIZE)
+    logmsg_flush();
 
-  sprintf(outbuffer, "Type: %d(RRER)  Reserved: %u  Count: %u\n",
-	  m_rerr->type, m_rerr->reserved, m_rerr->dst_cnt);
-  write(writefd, outbuffer, strlen(outbuffer));
+  if (log_blocklen == 0)
+    log_blocktime = log_now() / 1000;
 
-  for (i = 0 ; i < m_rerr->dst_cnt ; i++)
-    {
-      m_rerrdst = (struct rerrdst*)(pkt + sizeof(struct rerr) + 
-				    (i * sizeof(struct rerrdst)));
-
-      sprintf(outbuffer, "Dst IP: %s\tDst Seq nr: %u\n",
-	      inet_ntoa(*((struct in_addr*)&m_rerrdst->unr_dst_ip)),
-	      m_rerrdst->unr_dst_seq);
-      write(writefd, outbuffer, strlen(outbuffer));
-    } 
-}
+  /* Records are a multiple of 8 bytes, so trec is always aligned */
+  trec = (struct trace_rec*)(log_block + log_blocklen);
+  trec->reclen = reclen;
+  trec->dir = rec->dir;
+  trec->ttl = rec->ttl;
+  trec->origlen = rec->len;
+  trec->caplen = caplen;
+  trec->time = rec->time;
+  trec->src_ip = rec->src_ip;
+  trec->dst_ip = rec->dst_ip;
+  memcpy(trec + 1, rec->data, caplen);
+  memset((char*)(trec + 1) + caplen, 0, 
+	 reclen - sizeof(struct trace_rec) - caplen);
 
+  log_blocklen += reclen;
+}
 
 /* 
- *   logmsg
+ *   logmsg_krt
  *
  *   Description: 
- *     Takes a raw data package, determines the type of package
- *     and prints the data in the package.
+ *     Adds a TRACE_DIR_KRT record for a kernel route change that failed
+ *     to the current block. Called by the sync stage, which owns the
+ *     block, so the record doesn't go through the log ring.
  *
  *   Arguments:
- *     void *data      - The raw data area to be interpreted.
- *     int datalen     - The length of the raw data
- *     struct info *is - Information about the addresses related to the 
- *                       package.
- *       is->ip_pkt_dst_ip = To whome the package was sent (own ip or 
- *                           broadcast)
- *       is->ip_pkt_src_ip = Who sent the package.
- *       ip->ip_pkt_ttl    = The recived ttl.
- *       ip->ip_pkt_my_ip  = The host own ip.
+ *     int op           - TRACE_KRT_ADD or TRACE_KRT_DEL
+ *     u_int32_t dst_ip - Destination of the route
+ *     u_int32_t gw_ip  - Gateway of the route
+ *     int err          - errno of the change
  *
  *   Return: None.
 */
 void
-logmsg(void *data, int datalen, struct info *is)
+logmsg_krt(int op, u_int32_t dst_ip, u_int32_t gw_ip, int err)
 {
-  static int writefd = -1;
+  struct logrec rec;
+  struct trace_krt krt;
 
-  char outbuffer[MAXBUFLEN];
-  u_int64_t currtime;
-  u_int8_t pkt_type;
-  
-  if (writefd == -1)
+  memset(&krt, 0, sizeof(struct trace_krt));
+  krt.op = op;
+  krt.err = err;
+
+  rec.time = log_now();
+  rec.src_ip = dst_ip;
+  rec.dst_ip = gw_ip;
+  rec.len = sizeof(struct trace_krt);
+  rec.dir = TRACE_DIR_KRT;
+  rec.ttl = 0;
+  memcpy(rec.data, &krt, sizeof(struct trace_krt));
+
+  logmsg_write(&rec);
+}
+
+/* 
+ *   logmsg_flush
+ *
+ *   Description: 
+ *     Writes the current block to the trace file.
+ *
+ *   Arguments: None.
+ *
+ *   Return: None.
+*/
+void
+logmsg_flush()
+{
+  int written = 0;
+  int n;
+
+  if (log_blocklen == 0)
+    return;
+
+  if (log_fd == -1)
     {
-      if ((writefd = open("logmsg.txt", 
-			  O_WRONLY|O_CREAT|O_TRUNC, S_IRWXU)) < 0)
-	/*  Couldn't open logfile */
-	return;
+      /* No trace file, throw the block away */
+      log_blocklen = 0;
+      return;
     }
-  
-  sprintf(outbuffer,"\n");
-  write(writefd, outbuffer, strlen(outbuffer));
-  
-  /* Write timestamp */
-  currtime = getcurrtime();
-  septime(outbuffer, currtime);
-  write(writefd, outbuffer, strlen(outbuffer));
-
-  /* Write source dest and ttl */
-  sprintf(outbuffer, " %s", 
-	  inet_ntoa( *((struct in_addr*)&is->ip_pkt_src_ip) ));
-  write(writefd, outbuffer, strlen(outbuffer));
-
-  sprintf(outbuffer, " -> %s ttl: %d  len:%d \n",
-	  inet_ntoa(*((struct in_addr*)&is->ip_pkt_dst_ip)), 
-	  is->ip_pkt_ttl, datalen);
-  write(writefd, outbuffer, strlen(outbuffer));
-  
-  /* Extract the package type (we know it is 8 bits)*/
-  pkt_type = *((u_int8_t*)data);
-  switch (pkt_type)
+
+  while (written < log_blocklen)
     {
-    case(RREQ):
-      print_rreq((struct rreq*)data, writefd);
-      break;
-      
-    case(RREP):
-      print_rrep((struct rrep*)data, writefd);
-      break;
-      
-    case(RERR):
-      print_rerr(data, writefd);
-      break;
-      
-    default:
+      if ((n = write(log_fd, log_block + written, 
+		     log_blocklen - written)) <= 0)
+	/* Write error, the rest of the block is lost */
+	break;
+      written += n;
     }
+
+  log_blocklen = 0;
+}
+
+/* 
+ *   logmsg_flushwait
+ *
+ *   Description: 
+ *     Tells when the current block has to be written so that no record
+ *     waits longer than LOG_FLUSH_INTERVAL.
+ *
+ *   Arguments: None.
+ *
+ *   Return:
+ *     int - Time in ms until the block is due, 0 if it is due now and -1
+ *           if the block is empty.
+*/
+int
+logmsg_flushwait()
+{
+  u_int64_t age;
+
+  if (log_blocklen == 0)
+    return -1;
+
+  age = log_now() / 1000 - log_blocktime;
+  if (age >= LOG_FLUSH_INTERVAL)
+    return 0;
+
+  return LOG_FLUSH_INTERVAL - age;
+}
+
+/* 
+ *   logmsg_setlevel
+ *
+ *   Description: 
+ *     Sets the log level.
+ *
+ *   Arguments:
+ *     int level - One of the LOG_LEVEL_ constants.
+ *
+ *   Return:
+ *     int - On error (unknown level) -1 is returned else 0
+*/
+int
+logmsg_setlevel(int level)
+{
+  if (level < LOG_LEVEL_OFF || level > LOG_LEVEL_ALL)
+    return -1;
+
+  log_level = level;
+
+  return 0;
+}
+
+/* 
+ *   logmsg_getlevel
+ *
+ *   Description: 
+ *     Returns the log level.
+ *
+ *   Arguments: None.
+ *
+ *   Return:
+ *     int - The current LOG_LEVEL_ constant.
+*/
+int
+logmsg_getlevel()
+{
+  return log_level;
 }
@@ -20,16 +20,24 @@
  ********************************
  *
  *	General description:
- *        Writes logging messages about packages to a filedescriptor
+ *        Logs sent and received packages to a control traffic trace,
+ *        see trace.h for the format. The protocol stage only copies the
+ *        package into a record in the log ring, the sync stage turns the
+ *        records into trace records, collects them into blocks and writes
+ *        a block at a time to the trace file.
  *
  *     Internal procedures:
- *        septime
- *        print_rreq
- *        print_rrep
- *        print_rerr
+ *        log_wanted
  *
  *	External procedures:
+ *        logmsg_init
  *        logmsg
+ *        logmsg_write
+ *        logmsg_krt
+ *        logmsg_flush
+ *        logmsg_flushwait
+ *        logmsg_setlevel
+ *        logmsg_getlevel
  *
  ********************************
  *
@@ -53,28 +61,80 @@
 #include <signal.h>
 
 #include "aodv.h"
+#include "info.h"
 #include "utils.h"
+#include "trace.h"
 
 /* The type field in the aodv packages */
 #define RREQ         1
 #define RREP         2
 #define RERR         3
 
-/* The filedescriptor to write to */
-#define WRITE        1
+/* The trace file */
+#define LOG_FILE "aodv.trace"
 
-#define MAXBUFLEN 1024
+/* Direction of a logged package */
+#define LOG_DIR_IN   TRACE_DIR_IN
+#define LOG_DIR_OUT  TRACE_DIR_OUT
 
+/* Log levels, each level includes the ones below it */
+#define LOG_LEVEL_OFF    0   /* Nothing is logged */
+#define LOG_LEVEL_RERR   1   /* Route errors */
+#define LOG_LEVEL_ROUTE  2   /* Route requests, replies and errors */
+#define LOG_LEVEL_ALL    3   /* Everything, including HELLO messages */
+
+/* Bytes of the package kept in a record. Fills the record up to 128
+   bytes, enough for a RREQ, a RREP or a RERR with 13 destinations */
+#define LOG_DATA_LEN 108
+
+/* Size of the blocks written to the log file */
+#define LOG_BLOCK_SIZE 65536
+
+/* Max time in ms a record may wait in a block before it is written */
+#define LOG_FLUSH_INTERVAL 1000
+
+/* A logged package, filled in by logmsg and written by logmsg_write.
+   All fields are in host byte order except the addresses and data */
+struct logrec
+{
+  u_int64_t time;                /* When it was sent or received, us of
+				    CLOCK_MONOTONIC */
+  u_int32_t src_ip;              /* Who sent the package */
+  u_int32_t dst_ip;              /* To whome it was sent */
+  u_int16_t len;                 /* Length of the whole package */
+  u_int8_t  dir;                 /* LOG_DIR_IN, LOG_DIR_OUT or
+				    TRACE_DIR_KRT, see logmsg_krt */
+  u_int8_t  ttl;                 /* IP ttl, received ttl for LOG_DIR_IN */
+  u_int8_t  data[LOG_DATA_LEN];  /* The package, truncated to LOG_DATA_LEN */
+};
+
+
+/* 
+ *   logmsg_init
+ *
+ *   Description: 
+ *     Creates the trace file and writes the trace header. Packages
+ *     logged before this are thrown away.
+ *
+ *   Arguments:
+ *     char *ifname    - The interface the daemon runs on.
+ *     u_int32_t my_ip - The ip of the interface.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+*/
+int logmsg_init(char *ifname, u_int32_t my_ip);
 
 /* 
  *   logmsg
  *
  *   Description: 
- *     Takes a raw data package, determines the type of package
- *     and prints the data in the package.
+ *     Takes a raw data package and logs it if the log level says so.
+ *     When the sync stage runs the package is copied straight into a
+ *     slot of the log ring, nothing else is done by the caller.
  *
  *   Arguments:
- *     void *data      - The raw data area to be interpreted.
+ *     void *data      - The raw data area to be logged.
  *     int datalen     - The length of the raw data
  *     struct info *is - Information about the addresses related to the 
  *                       package.
@@ -82,11 +142,97 @@
  *                           broadcast)
  *       is->ip_pkt_src_ip = Who sent the package.
  *       ip->ip_pkt_ttl    = The recived ttl.
- *       ip->ip_pkt_my_ip  = The host own ip.
+ *     int dir         - LOG_DIR_IN or LOG_DIR_OUT
  *
  *   Return: None.
 */
-void logmsg(void *data, int datalen, struct info *is);
+void logmsg(void *data, int datalen, struct info *is, int dir);
 
-#endif
+/* 
+ *   logmsg_write
+ *
+ *   Description: 
+ *     Adds a record to the current block as a trace record, the block is
+ *     written to the trace file when it is full. Called by the sync stage for records
+ *     queued by logmsg.
+ *
+ *   Arguments:
+ *     struct logrec *rec - The record to write.
+ *
+ *   Return: None.
+*/
+void logmsg_write(struct logrec *rec);
+
+/* 
+ *   logmsg_krt
+ *
+ *   Description: 
+ *     Adds a TRACE_DIR_KRT record for a kernel route change that failed
+ *     to the current block. Called by the sync stage, which owns the
+ *     block, so the record doesn't go through the log ring.
+ *
+ *   Arguments:
+ *     int op           - TRACE_KRT_ADD or TRACE_KRT_DEL
+ *     u_int32_t dst_ip - Destination of the route
+ *     u_int32_t gw_ip  - Gateway of the route
+ *     int err          - errno of the change
+ *
+ *   Return: None.
+*/
+void logmsg_krt(int op, u_int32_t dst_ip, u_int32_t gw_ip, int err);
 
+/* 
+ *   logmsg_flush
+ *
+ *   Description: 
+ *     Writes the current block to the trace file.
+ *
+ *   Arguments: None.
+ *
+ *   Return: None.
+*/
+void logmsg_flush();
+
+/* 
+ *   logmsg_flushwait
+ *
+ *   Description: 
+ *     Tells when the current block has to be written so that no record
+ *     waits longer than LOG_FLUSH_INTERVAL.
+ *
+ *   Arguments: None.
+ *
+ *   Return:
+ *     int - Time in ms until the block is due, 0 if it is due now and -1
+ *           if the block is empty.
+*/
+int logmsg_flushwait();
+
+/* 
+ *   logmsg_setlevel
+ *
+ *   Description: 
+ *     Sets the log level.
+ *
+ *   Arguments:
+ *     int level - One of the LOG_LEVEL_ constants.
+ *
+ *   Return:
+ *     int - On error (unknown level) -1 is returned else 0
+*/
+int logmsg_setlevel(int level);
+
+/* 
+ *   logmsg_getlevel
+ *
+ *   Description: 
+ *     Returns the log level.
+ *
+ *   Arguments: None.
+ *
+ *   Return:
+ *     int - The current LOG_LEVEL_ constant.
+*/
+int logmsg_getlevel();
+
+#endif
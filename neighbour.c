@@ -0,0 +1,767 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The neighbour table of a node. A neighbour is entered when
+ *        its first HELLO arrives and is kept as long as HELLOs or other
+ *        AODV messages keep coming from it. The table knows when the
+ *        next HELLO of each neighbour is due and gives up on the link
+ *        when a neighbour has been silent for ALLOWED_HELLO_LOSS of its
+ *        HELLO intervals.
+ *
+ *        HELLOs are numbered, so the table also knows which of the last
+ *        NB_WINDOW HELLOs of a neighbour got through. The share that
+ *        did is the delivery ratio of the link, its inverse the
+ *        expected transmission count (ETX) of the link. Only the
+ *        direction from the neighbour is measured, a HELLO has no room
+ *        to report the other. With METRIC_ETX route selection adds the
+ *        ETX of the first hop to the hop count, so a route over a good
+ *        link wins over an equally long or slightly shorter one over a
+ *        poor link. The messages don't carry the ETX of the rest of
+ *        the path.
+ *
+ *        Traffic stands in for HELLOs both ways. Anything heard from a
+ *        neighbour keeps its entry, and the table notes when the node
+ *        last sent each neighbour something, so hello_resend can skip a
+ *        HELLO that all neighbours would hear as nothing new.
+ *
+ *        In relay mode the HELLOs list the neighbours of the sender, so
+ *        the table also knows the neighbours two hops away. A node
+ *        elects as few neighbours as it can as relays, multipoint relays
+ *        as in OLSR, so that every node two hops away is a neighbour of
+ *        a relay. The HELLO names the relays, and a node only
+ *        rebroadcasts a RREQ whose first copy came from a neighbour that
+ *        elected it.
+ *
+ *	Internal procedures:
+ *        nb_window
+ *        nb_cmp_ip
+ *        nb_lists
+ *        nb_covers
+ *
+ *	External procedures:
+ *        find_nb
+ *        nb_hello
+ *        nb_heard
+ *        nb_sent
+ *        nb_silent
+ *        nb_count
+ *        nb_set_list
+ *        nb_select_relays
+ *        nb_relay
+ *        nb_lost
+ *        nb_etx
+ *        nb_cost
+ *        print_nb
+ *        free_nb_list
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "neighbour.h"
+#include "clock.h"
+
+/* Pre-declaration of internal function */
+u_int32_t nb_window(struct nb_entry *nb, u_int64_t now, int *slots);
+int nb_cmp_ip(const void *a, const void *b);
+int nb_covers(struct nb_entry *nb, u_int32_t *two, int ntwo, char *covered,
+	      int mark);
+int nb_lists(struct nb_entry *nb, u_int32_t ip);
+
+/*
+ * find_nb
+ *
+ * Description:
+ *   Looks up a neighbour in the neighbour table.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour.
+ *
+ * Return:
+ *   struct nb_entry* - The entry, NULL if ip is no neighbour.
+ */
+struct nb_entry *
+find_nb(struct aodv_node *node, u_int32_t ip)
+{
+  struct nb_entry *nb;
+
+  for (nb = node->nb_list; nb != NULL; nb = nb->next)
+    if (nb->ip == ip)
+      return nb;
+
+  return NULL;
+}
+
+/*
+ * nb_hello
+ *
+ * Description:
+ *   Records a HELLO from a neighbour, entering it in the table if it is
+ *   new. The HELLO interval of the neighbour is taken from the lifetime
+ *   it gives its HELLOs, ALLOWED_HELLO_LOSS intervals. HELLOs whose
+ *   numbers were skipped since the last one are counted as missed.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour.
+ *   u_int32_t lifetime     - Lifetime of the HELLO, ms.
+ *   u_int16_t seq          - Number of the HELLO, HELLO_SEQ_MASK bits.
+ *
+ * Return:
+ *   struct nb_entry* - The entry, NULL if it couldn't be allocated.
+ */
+struct nb_entry *
+nb_hello(struct aodv_node *node, u_int32_t ip, u_int32_t lifetime,
+	 u_int16_t seq)
+{
+  struct nb_entry *nb;
+  u_int64_t now = getcurrtime();
+  int gap;
+
+  if (lifetime == 0)
+    lifetime = ALLOWED_HELLO_LOSS * HELLO_INTERVAL;
+
+  if ((nb = find_nb(node, ip)) == NULL)
+    {
+      if ((nb = (struct nb_entry*)malloc(sizeof(struct nb_entry))) == NULL)
+	return NULL;
+
+      nb->ip = ip;
+      nb->hellos = 0;
+      nb->missed = 0;
+      nb->window = 0;
+      nb->slots = 0;
+      nb->seq = (seq - 1) & HELLO_SEQ_MASK;
+      nb->sent = 0;
+      nb->list = NULL;
+      nb->nlist = 0;
+      nb->relay = 0;
+      nb->selector = 0;
+      nb->next = node->nb_list;
+      node->nb_list = nb;
+    }
+
+  gap = (seq - nb->seq) & HELLO_SEQ_MASK;
+  /* A HELLO heard twice, gap 0, leaves the window as it is */
+  if (gap > HELLO_SEQ_MASK / 2)
+    {
+      /* The numbers went back, the neighbour has restarted */
+      nb->window = 1;
+      nb->slots = 1;
+    }
+  else if (gap > 0)
+    {
+      nb->window = gap >= NB_WINDOW ? 1 : (nb->window << gap) | 1;
+      nb->slots = MIN(nb->slots + gap, NB_WINDOW);
+      nb->missed += gap - 1;
+    }
+
+  nb->seq = seq & HELLO_SEQ_MASK;
+  nb->interval = MAX(lifetime / ALLOWED_HELLO_LOSS, 1);
+  nb->due = now + nb->interval;
+  nb->heard = now;
+  nb->expire = now + lifetime;
+  nb->hellos++;
+
+  return nb;
+}
+
+/*
+ * nb_heard
+ *
+ * Description:
+ *   Any message from a neighbour shows the link is up. Keeps the entry
+ *   of a known neighbour for ALLOWED_HELLO_LOSS more intervals, others
+ *   are not entered.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the sender.
+ *
+ * Return:
+ *   struct nb_entry* - The entry, NULL if ip is no neighbour.
+ */
+struct nb_entry *
+nb_heard(struct aodv_node *node, u_int32_t ip)
+{
+  struct nb_entry *nb;
+
+  if ((nb = find_nb(node, ip)) != NULL)
+    {
+      nb->heard = getcurrtime();
+      nb->expire = MAX(nb->expire,
+		       nb->heard + ALLOWED_HELLO_LOSS * nb->interval);
+    }
+
+  return nb;
+}
+
+/*
+ * nb_sent
+ *
+ * Description:
+ *   Notes that the node sent a neighbour something it will take as a
+ *   HELLO, a broadcast reaches all of them.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour, or broadcast.
+ *
+ * Return: None
+ */
+void
+nb_sent(struct aodv_node *node, u_int32_t ip)
+{
+  struct nb_entry *nb;
+  u_int64_t now = getcurrtime();
+
+  for (nb = node->nb_list; nb != NULL; nb = nb->next)
+    if (nb->ip == ip || ip == inet_addr("255.255.255.255"))
+      nb->sent = now;
+}
+
+/*
+ * nb_silent
+ *
+ * Description:
+ *   Counts the neighbours the node has sent nothing for half a HELLO
+ *   interval. The half leaves a neighbour that gets its HELLO an
+ *   interval late time to the end of ALLOWED_HELLO_LOSS intervals.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   int - The number of such neighbours.
+ */
+int
+nb_silent(struct aodv_node *node)
+{
+  struct nb_entry *nb;
+  u_int64_t now = getcurrtime();
+  int silent = 0;
+
+  for (nb = node->nb_list; nb != NULL; nb = nb->next)
+    if (nb->sent + HELLO_INTERVAL / 2 < now)
+      silent++;
+
+  return silent;
+}
+
+/*
+ * nb_count
+ *
+ * Description:
+ *   Counts the neighbours in the table.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   int - The number of neighbours.
+ */
+int
+nb_count(struct aodv_node *node)
+{
+  struct nb_entry *nb;
+  int count = 0;
+
+  for (nb = node->nb_list; nb != NULL; nb = nb->next)
+    count++;
+
+  return count;
+}
+
+/*
+ * nb_set_list
+ *
+ * Description:
+ *   Keeps the neighbours a neighbour listed in its HELLO, sorted. The
+ *   first relays of them are the ones it elected as relays, if the
+ *   node is one of them it rebroadcasts RREQs for the neighbour.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour.
+ *   u_int32_t *list        - Its neighbours.
+ *   int n                  - Number of them.
+ *   int relays             - Number of relays first in the list.
+ *
+ * Return:
+ *   int - 0, -1 if ip is no neighbour or the list couldn't be allocated
+ */
+int
+nb_set_list(struct aodv_node *node, u_int32_t ip, u_int32_t *list, int n,
+	    int relays)
+{
+  struct nb_entry *nb;
+  u_int32_t *copy;
+  int i;
+
+  if ((nb = find_nb(node, ip)) == NULL)
+    return -1;
+
+  if (n != nb->nlist || nb->list == NULL)
+    {
+      /* An empty list is kept too, the neighbour lists its neighbours */
+      if ((copy = (u_int32_t*)malloc(MAX(n, 1) * sizeof(u_int32_t))) == NULL)
+	return -1;
+      free(nb->list);
+      nb->list = copy;
+    }
+
+  memcpy(nb->list, list, n * sizeof(u_int32_t));
+  nb->nlist = n;
+
+  nb->selector = 0;
+  for (i = 0; i < relays && i < n; i++)
+    if (list[i] == node->my_ip)
+      nb->selector = 1;
+
+  qsort(nb->list, n, sizeof(u_int32_t), nb_cmp_ip);
+
+  return 0;
+}
+
+/*
+ * nb_cmp_ip
+ *
+ * Description:
+ *   Compares two addresses for qsort and bsearch.
+ *
+ * Arguments:
+ *   const void *a - The first address.
+ *   const void *b - The second.
+ *
+ * Return:
+ *   int - Less than, equal to or greater than 0.
+ */
+int
+nb_cmp_ip(const void *a, const void *b)
+{
+  u_int32_t x = *(const u_int32_t*)a;
+  u_int32_t y = *(const u_int32_t*)b;
+
+  return x < y ? -1 : x > y;
+}
+
+/*
+ * nb_lists
+ *
+ * Description:
+ *   Tells if a neighbour listed an address in its last HELLO.
+ *
+ * Arguments:
+ *   struct nb_entry *nb - The neighbour.
+ *   u_int32_t ip        - The address.
+ *
+ * Return:
+ *   int - 1 if it did, else 0
+ */
+int
+nb_lists(struct nb_entry *nb, u_int32_t ip)
+{
+  if (nb->list == NULL)
+    return 0;
+
+  return bsearch(&ip, nb->list, nb->nlist, sizeof(u_int32_t),
+		 nb_cmp_ip) != NULL;
+}
+
+/*
+ * nb_covers
+ *
+ * Description:
+ *   Counts the nodes two hops away a neighbour reaches that aren't
+ *   reached yet, and marks them reached if asked to.
+ *
+ * Arguments:
+ *   struct nb_entry *nb - The neighbour.
+ *   u_int32_t *two      - The nodes two hops away, sorted.
+ *   int ntwo            - Number of them.
+ *   char *covered       - 1 for each of them reached.
+ *   int mark            - 1 to mark those the neighbour reaches.
+ *
+ * Return:
+ *   int - The number of nodes it reaches that weren't reached.
+ */
+int
+nb_covers(struct nb_entry *nb, u_int32_t *two, int ntwo, char *covered,
+	  int mark)
+{
+  u_int32_t *x;
+  int count = 0;
+  int i;
+
+  for (i = 0; i < nb->nlist; i++)
+    if ((x = bsearch(&nb->list[i], two, ntwo, sizeof(u_int32_t),
+		     nb_cmp_ip)) != NULL && !covered[x - two])
+      {
+	count++;
+	if (mark)
+	  covered[x - two] = 1;
+      }
+
+  return count;
+}
+
+/*
+ * nb_select_relays
+ *
+ * Description:
+ *   Elects the relays of the node among the neighbours that list it,
+ *   so every node two hops away is a neighbour of a relay. First the
+ *   neighbours that are the only way to some node two hops away, then
+ *   greedily the one that reaches the most nodes not reached yet, as
+ *   the OLSR heuristic does.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   int - The number of relays, -1 if memory couldn't be allocated.
+ */
+int
+nb_select_relays(struct aodv_node *node)
+{
+  struct nb_entry *nb;
+  struct nb_entry *only;
+  struct nb_entry *best;
+  u_int32_t *two;
+  char *covered;
+  int ntwo = 0;
+  int relays = 0;
+  int count;
+  int most;
+  int i;
+  int j;
+
+  for (nb = node->nb_list; nb != NULL; nb = nb->next)
+    {
+      nb->relay = 0;
+      ntwo += nb->nlist;
+    }
+
+  if ((two = (u_int32_t*)malloc(MAX(ntwo, 1) * sizeof(u_int32_t))) == NULL)
+    return -1;
+
+  /* The nodes two hops away: listed by a neighbour that lists the node
+     too, and neither the node nor one of its neighbours */
+  ntwo = 0;
+  for (nb = node->nb_list; nb != NULL; nb = nb->next)
+    if (nb_lists(nb, node->my_ip))
+      for (i = 0; i < nb->nlist; i++)
+	if (nb->list[i] != node->my_ip && find_nb(node, nb->list[i]) == NULL)
+	  two[ntwo++] = nb->list[i];
+
+  qsort(two, ntwo, sizeof(u_int32_t), nb_cmp_ip);
+  for (i = 0, j = 0; i < ntwo; i++)
+    if (j == 0 || two[i] != two[j - 1])
+      two[j++] = two[i];
+  ntwo = j;
+
+  if ((covered = (char*)calloc(MAX(ntwo, 1), 1)) == NULL)
+    {
+      free(two);
+      return -1;
+    }
+
+  /* A node two hops away that only one neighbour reaches makes it a
+     relay */
+  for (i = 0; i < ntwo; i++)
+    {
+      count = 0;
+      only = NULL;
+      for (nb = node->nb_list; nb != NULL && count < 2; nb = nb->next)
+	if (nb_lists(nb, node->my_ip) && nb_lists(nb, two[i]))
+	  {
+	    count++;
+	    only = nb;
+	  }
+
+      if (count == 1 && !only->relay)
+	{
+	  only->relay = 1;
+	  relays++;
+	}
+    }
+
+  for (nb = node->nb_list; nb != NULL; nb = nb->next)
+    if (nb->relay)
+      nb_covers(nb, two, ntwo, covered, 1);
+
+  /* Then the neighbour that reaches the most of the rest, until all
+     are reached */
+  for (;;)
+    {
+      best = NULL;
+      most = 0;
+      for (nb = node->nb_list; nb != NULL; nb = nb->next)
+	if (!nb->relay && nb_lists(nb, node->my_ip) &&
+	    (count = nb_covers(nb, two, ntwo, covered, 0)) > most)
+	  {
+	    best = nb;
+	    most = count;
+	  }
+
+      if (best == NULL)
+	break;
+
+      best->relay = 1;
+      relays++;
+      nb_covers(best, two, ntwo, covered, 1);
+    }
+
+  free(covered);
+  free(two);
+
+  return relays;
+}
+
+/*
+ * nb_relay
+ *
+ * Description:
+ *   Tells if the node rebroadcasts a flood that came first from a
+ *   neighbour. It does if the neighbour elected it as relay, and if
+ *   the neighbour is not known or doesn't list its neighbours.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour.
+ *
+ * Return:
+ *   int - 1 if the node rebroadcasts, else 0
+ */
+int
+nb_relay(struct aodv_node *node, u_int32_t ip)
+{
+  struct nb_entry *nb;
+
+  if ((nb = find_nb(node, ip)) == NULL || nb->list == NULL)
+    return 1;
+
+  return nb->selector;
+}
+
+/*
+ * nb_lost
+ *
+ * Description:
+ *   Takes the first neighbour that has been silent too long out of the
+ *   table.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   u_int32_t - Address of the lost neighbour, 0 if there is none.
+ */
+u_int32_t
+nb_lost(struct aodv_node *node)
+{
+  struct nb_entry **p;
+  struct nb_entry *nb;
+  u_int64_t now = getcurrtime();
+  u_int32_t ip;
+
+  for (p = &node->nb_list; (nb = *p) != NULL; p = &nb->next)
+    if (nb->expire < now)
+      {
+	ip = nb->ip;
+	*p = nb->next;
+	free(nb->list);
+	free(nb);
+	return ip;
+      }
+
+  return 0;
+}
+
+/*
+ * nb_window
+ *
+ * Description:
+ *   The HELLO window of a neighbour as it stands now. A neighbour that
+ *   has been silent for more than an interval should have sent HELLOs
+ *   meanwhile, all but the one that may be on its way are counted as
+ *   lost.
+ *
+ * Arguments:
+ *   struct nb_entry *nb - The neighbour.
+ *   u_int64_t now       - The time.
+ *   int *slots          - Where the number of HELLOs the window covers
+ *                         is put.
+ *
+ * Return:
+ *   u_int32_t - The window, bit 0 the last HELLO.
+ */
+u_int32_t
+nb_window(struct nb_entry *nb, u_int64_t now, int *slots)
+{
+  u_int64_t late = 0;
+
+  if (now > nb->heard + nb->interval)
+    late = (now - nb->heard) / nb->interval - 1;
+
+  *slots = MIN(nb->slots + late, NB_WINDOW);
+  if (late >= NB_WINDOW)
+    return 0;
+
+  return nb->window << late;
+}
+
+/*
+ * nb_etx
+ *
+ * Description:
+ *   The expected transmission count of the link from a neighbour: the
+ *   HELLOs it sent in the window over the ones that came. HELLOs that
+ *   should have come since the neighbour was last heard count as lost.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour.
+ *
+ * Return:
+ *   int - ETX in ETX_SCALE units, ETX_MAX if nothing came. ETX_SCALE
+ *         for a node that is not in the table, it doesn't say HELLO.
+ */
+int
+nb_etx(struct aodv_node *node, u_int32_t ip)
+{
+  struct nb_entry *nb;
+  u_int32_t window;
+  int slots;
+  int got = 0;
+  int i;
+
+  if ((nb = find_nb(node, ip)) == NULL)
+    return ETX_SCALE;
+
+  window = nb_window(nb, getcurrtime(), &slots);
+  for (i = 0; i < slots; i++)
+    if (window & (1U << i))
+      got++;
+
+  if (got == 0)
+    return ETX_MAX;
+
+  return MIN(slots * ETX_SCALE / got, ETX_MAX);
+}
+
+/*
+ * nb_cost
+ *
+ * Description:
+ *   Cost of a route for comparing it with another to the same
+ *   destination. The hop count with METRIC_HOPS, else the hops after
+ *   the first plus the ETX of the first.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t nxt_hop      - Next hop of the route.
+ *   int hop_cnt            - Hops of the route, 1 or more.
+ *
+ * Return:
+ *   int - The cost, ETX_SCALE units with METRIC_ETX.
+ */
+int
+nb_cost(struct aodv_node *node, u_int32_t nxt_hop, int hop_cnt)
+{
+  if (node->metric != METRIC_ETX)
+    return hop_cnt;
+
+  return (hop_cnt - 1) * ETX_SCALE + nb_etx(node, nxt_hop);
+}
+
+/*
+ * print_nb
+ *
+ * Description:
+ *   Prints the neighbour table. Relay says if the node elected the
+ *   neighbour as relay (mine) and if the neighbour elected the node
+ *   (its).
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return: None
+ */
+void
+print_nb(struct aodv_node *node)
+{
+  struct nb_entry *nb;
+  struct in_addr addr;
+  u_int64_t now = getcurrtime();
+  u_int32_t window;
+  int slots;
+  int got;
+  int etx;
+  int i;
+
+  printf("Neighbour\tHELLOs\tMissed\tDelivery\tETX\tHeard\tExpires\t"
+	 "Relay\n");
+  for (nb = node->nb_list; nb != NULL; nb = nb->next)
+    {
+      window = nb_window(nb, now, &slots);
+      for (i = 0, got = 0; i < slots; i++)
+	if (window & (1U << i))
+	  got++;
+
+      addr.s_addr = nb->ip;
+      etx = nb_etx(node, nb->ip);
+      printf("%-15s\t%u\t%u\t%d/%d\t\t%d.%02d\t%llu\t%lld\t%s%s\n",
+	     inet_ntoa(addr), nb->hellos, nb->missed, got, slots,
+	     etx / ETX_SCALE, etx % ETX_SCALE,
+	     (unsigned long long)(now - nb->heard),
+	     (long long)(nb->expire - now), nb->relay ? "mine " : "",
+	     nb->selector ? "its" : "");
+    }
+}
+
+/*
+ * free_nb_list
+ *
+ * Description:
+ *   Frees every entry of the neighbour table.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return: None
+ */
+void
+free_nb_list(struct aodv_node *node)
+{
+  struct nb_entry *nb;
+
+  while ((nb = node->nb_list) != NULL)
+    {
+      node->nb_list = nb->next;
+      free(nb->list);
+      free(nb);
+    }
+}
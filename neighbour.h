@@ -0,0 +1,353 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The neighbour table of a node. A neighbour is entered when
+ *        its first HELLO arrives and is kept as long as HELLOs or other
+ *        AODV messages keep coming from it. The table knows when the
+ *        next HELLO of each neighbour is due and gives up on the link
+ *        when a neighbour has been silent for ALLOWED_HELLO_LOSS of its
+ *        HELLO intervals.
+ *
+ *        HELLOs are numbered, so the table also knows which of the last
+ *        NB_WINDOW HELLOs of a neighbour got through. The share that
+ *        did is the delivery ratio of the link, its inverse the
+ *        expected transmission count (ETX) of the link. Only the
+ *        direction from the neighbour is measured, a HELLO has no room
+ *        to report the other. With METRIC_ETX route selection adds the
+ *        ETX of the first hop to the hop count, so a route over a good
+ *        link wins over an equally long or slightly shorter one over a
+ *        poor link. The messages don't carry the ETX of the rest of
+ *        the path.
+ *
+ *        Traffic stands in for HELLOs both ways. Anything heard from a
+ *        neighbour keeps its entry, and the table notes when the node
+ *        last sent each neighbour something, so hello_resend can skip a
+ *        HELLO that all neighbours would hear as nothing new.
+ *
+ *        In relay mode the HELLOs list the neighbours of the sender, so
+ *        the table also knows the neighbours two hops away. A node
+ *        elects as few neighbours as it can as relays, multipoint relays
+ *        as in OLSR, so that every node two hops away is a neighbour of
+ *        a relay. The HELLO names the relays, and a node only
+ *        rebroadcasts a RREQ whose first copy came from a neighbour that
+ *        elected it.
+ *
+ *	Internal procedures:
+ *        nb_window
+ *
+ *	External procedures:
+ *        find_nb
+ *        nb_hello
+ *        nb_heard
+ *        nb_sent
+ *        nb_silent
+ *        nb_count
+ *        nb_set_list
+ *        nb_select_relays
+ *        nb_relay
+ *        nb_lost
+ *        nb_etx
+ *        nb_cost
+ *        print_nb
+ *        free_nb_list
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef NEIGHBOUR_H
+#define NEIGHBOUR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <arpa/inet.h>
+
+#include "aodv.h"
+#include "node.h"
+
+#define NB_WINDOW   32           /* HELLOs the delivery ratio is taken
+				    over, bits in a window */
+#define ETX_SCALE   100          /* ETX of a link that loses nothing */
+#define ETX_MAX     (NB_WINDOW * ETX_SCALE)  /* Nothing got through */
+
+#define METRIC_HOPS 0            /* Routes are chosen by hop count */
+#define METRIC_ETX  1            /* and by the ETX of the first hop */
+
+struct nb_entry
+{
+  u_int32_t ip;              /* Address of the neighbour */
+  u_int64_t interval;        /* Its HELLO interval, ms */
+  u_int64_t due;             /* When its next HELLO should arrive */
+  u_int64_t heard;           /* When a message last came from it */
+  u_int64_t sent;            /* When the node last sent it something */
+  u_int64_t expire;          /* The link is lost if nothing comes until */
+  u_int32_t hellos;          /* HELLOs received */
+  u_int32_t missed;          /* HELLOs whose numbers were skipped */
+  u_int16_t seq;             /* Number of the last HELLO */
+  u_int32_t window;          /* Last NB_WINDOW HELLOs, bit 0 the last
+				one, 1 if it came */
+  int slots;                 /* HELLOs the window covers */
+  u_int32_t *list;           /* Its neighbours from its last HELLO, NULL
+				if its HELLOs list none */
+  int nlist;                 /* Number of them */
+  int relay;                 /* 1 if the node elected it as relay */
+  int selector;              /* 1 if it elected the node as relay */
+  struct nb_entry *next;
+};
+
+/*
+ * find_nb
+ *
+ * Description:
+ *   Looks up a neighbour in the neighbour table.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour.
+ *
+ * Return:
+ *   struct nb_entry* - The entry, NULL if ip is no neighbour.
+ */
+struct nb_entry *find_nb(struct aodv_node *node, u_int32_t ip);
+
+/*
+ * nb_hello
+ *
+ * Description:
+ *   Records a HELLO from a neighbour, entering it in the table if it is
+ *   new. The HELLO interval of the neighbour is taken from the lifetime
+ *   it gives its HELLOs, ALLOWED_HELLO_LOSS intervals. HELLOs whose
+ *   numbers were skipped since the last one are counted as missed.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour.
+ *   u_int32_t lifetime     - Lifetime of the HELLO, ms.
+ *   u_int16_t seq          - Number of the HELLO, HELLO_SEQ_MASK bits.
+ *
+ * Return:
+ *   struct nb_entry* - The entry, NULL if it couldn't be allocated.
+ */
+struct nb_entry *nb_hello(struct aodv_node *node, u_int32_t ip,
+			  u_int32_t lifetime, u_int16_t seq);
+
+/*
+ * nb_heard
+ *
+ * Description:
+ *   Any message from a neighbour shows the link is up. Keeps the entry
+ *   of a known neighbour for ALLOWED_HELLO_LOSS more intervals, others
+ *   are not entered.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the sender.
+ *
+ * Return:
+ *   struct nb_entry* - The entry, NULL if ip is no neighbour.
+ */
+struct nb_entry *nb_heard(struct aodv_node *node, u_int32_t ip);
+
+/*
+ * nb_sent
+ *
+ * Description:
+ *   Notes that the node sent a neighbour something it will take as a
+ *   HELLO, a broadcast reaches all of them.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour, or broadcast.
+ *
+ * Return: None
+ */
+void nb_sent(struct aodv_node *node, u_int32_t ip);
+
+/*
+ * nb_silent
+ *
+ * Description:
+ *   Counts the neighbours the node has sent nothing for half a HELLO
+ *   interval. The half leaves a neighbour that gets its HELLO an
+ *   interval late time to the end of ALLOWED_HELLO_LOSS intervals.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   int - The number of such neighbours.
+ */
+int nb_silent(struct aodv_node *node);
+
+/*
+ * nb_count
+ *
+ * Description:
+ *   Counts the neighbours in the table.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   int - The number of neighbours.
+ */
+int nb_count(struct aodv_node *node);
+
+/*
+ * nb_set_list
+ *
+ * Description:
+ *   Keeps the neighbours a neighbour listed in its HELLO, sorted. The
+ *   first relays of them are the ones it elected as relays, if the
+ *   node is one of them it rebroadcasts RREQs for the neighbour.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour.
+ *   u_int32_t *list        - Its neighbours.
+ *   int n                  - Number of them.
+ *   int relays             - Number of relays first in the list.
+ *
+ * Return:
+ *   int - 0, -1 if ip is no neighbour or the list couldn't be allocated
+ */
+int nb_set_list(struct aodv_node *node, u_int32_t ip, u_int32_t *list, int n,
+		int relays);
+
+/*
+ * nb_select_relays
+ *
+ * Description:
+ *   Elects the relays of the node among the neighbours that list it,
+ *   so every node two hops away is a neighbour of a relay. First the
+ *   neighbours that are the only way to some node two hops away, then
+ *   greedily the one that reaches the most nodes not reached yet, as
+ *   the OLSR heuristic does.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   int - The number of relays, -1 if memory couldn't be allocated.
+ */
+int nb_select_relays(struct aodv_node *node);
+
+/*
+ * nb_relay
+ *
+ * Description:
+ *   Tells if the node rebroadcasts a flood that came first from a
+ *   neighbour. It does if the neighbour elected it as relay, and if
+ *   the neighbour is not known or doesn't list its neighbours.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour.
+ *
+ * Return:
+ *   int - 1 if the node rebroadcasts, else 0
+ */
+int nb_relay(struct aodv_node *node, u_int32_t ip);
+
+/*
+ * nb_lost
+ *
+ * Description:
+ *   Takes the first neighbour that has been silent too long out of the
+ *   table.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   u_int32_t - Address of the lost neighbour, 0 if there is none.
+ */
+u_int32_t nb_lost(struct aodv_node *node);
+
+/*
+ * nb_etx
+ *
+ * Description:
+ *   The expected transmission count of the link from a neighbour: the
+ *   HELLOs it sent in the window over the ones that came. HELLOs that
+ *   should have come since the neighbour was last heard count as lost.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t ip           - Address of the neighbour.
+ *
+ * Return:
+ *   int - ETX in ETX_SCALE units, ETX_MAX if nothing came. ETX_SCALE
+ *         for a node that is not in the table, it doesn't say HELLO.
+ */
+int nb_etx(struct aodv_node *node, u_int32_t ip);
+
+/*
+ * nb_cost
+ *
+ * Description:
+ *   Cost of a route for comparing it with another to the same
+ *   destination. The hop count with METRIC_HOPS, else the hops after
+ *   the first plus the ETX of the first.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int32_t nxt_hop      - Next hop of the route.
+ *   int hop_cnt            - Hops of the route, 1 or more.
+ *
+ * Return:
+ *   int - The cost, ETX_SCALE units with METRIC_ETX.
+ */
+int nb_cost(struct aodv_node *node, u_int32_t nxt_hop, int hop_cnt);
+
+/*
+ * print_nb
+ *
+ * Description:
+ *   Prints the neighbour table. Relay says if the node elected the
+ *   neighbour as relay (mine) and if the neighbour elected the node
+ *   (its).
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return: None
+ */
+void print_nb(struct aodv_node *node);
+
+/*
+ * free_nb_list
+ *
+ * Description:
+ *   Frees every entry of the neighbour table.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return: None
+ */
+void free_nb_list(struct aodv_node *node);
+
+#endif
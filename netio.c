@@ -0,0 +1,112 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Puts AODV messages on the network. net_send is the only place
+ *        the protocol code reaches the socket layer, aodv_sim links its
+ *        own net_send that hands the message to the simulated medium.
+ *
+ *	Internal procedures:
+ *
+ *	External procedures:
+ *        net_send
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "netio.h"
+
+/* 
+ *   net_send
+ *
+ *   Description: 
+ *     Sends a datagram to the AODV port of its destination and logs it.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The sending node.
+ *     struct info *pktinfo   - Destination and ttl, see send_datagram.
+ *     void *data             - The data to be sent.
+ *     int datalen            - The length of the data to be sent.
+ *
+ *   Return: 
+ *     int - On error -1 is returned else 0 is returned.
+ */
+int
+net_send(struct aodv_node *node, struct info *pktinfo, void *data,
+	 int datalen)
+{
+  struct sockaddr_in their_addr;
+  int sockfd;
+  int on = 1;
+
+#ifdef LOGMSG
+  logmsg(data, datalen, pktinfo, LOG_DIR_OUT);
+#endif
+
+  if ((sockfd = socket(AF_INET, SOCK_DGRAM,0)) < 0)
+    /* Error creating socket */
+    return -1;
+  
+  /* Fill in destination of the package */
+  their_addr.sin_family = AF_INET;
+  their_addr.sin_port = htons(AODVPORT);
+  their_addr.sin_addr.s_addr = pktinfo->ip_pkt_dst_ip;
+  bzero(&(their_addr.sin_zero), 8);
+  
+  /* Is destination broadcast ? */
+  if (their_addr.sin_addr.s_addr == inet_addr("255.255.255.255"))
+    {
+      if (setsockopt(sockfd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on)) < 0)
+	{
+	  /* Error setting socket options */
+	  close(sockfd);
+	  return -1;
+	}
+    }
+  
+  /* Set the TTL ? */
+  if (pktinfo->ip_pkt_ttl != 0 && pktinfo->ip_pkt_ttl < 256)
+    {
+      if (setsockopt(sockfd, SOL_IP, IP_TTL, &(pktinfo->ip_pkt_ttl),
+		     sizeof(pktinfo->ip_pkt_ttl)) < 0)
+	{
+	  /* Error setting socket options */
+	  close(sockfd);
+	  return -1;
+	}
+    }
+  
+  /* Send package */
+  if (sendto(sockfd, data, datalen, 0, (struct sockaddr *)&their_addr,
+	     sizeof(struct sockaddr)) < 0)
+    {
+      /* Failed to send datagram */
+      close(sockfd);
+      return -1;
+    }
+  
+  close(sockfd);
+  
+  return 0;
+}
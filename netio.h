@@ -0,0 +1,71 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Puts AODV messages on the network. net_send is the only place
+ *        the protocol code reaches the socket layer, aodv_sim links its
+ *        own net_send that hands the message to the simulated medium.
+ *
+ *	Internal procedures:
+ *
+ *	External procedures:
+ *        net_send
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef NETIO_H
+#define NETIO_H
+
+#include <unistd.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "info.h"
+#include "aodv.h"
+#include "logmsg.h"
+
+struct aodv_node;
+
+
+/* 
+ *   net_send
+ *
+ *   Description: 
+ *     Sends a datagram to the AODV port of its destination and logs it.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The sending node.
+ *     struct info *pktinfo   - Destination and ttl, see send_datagram.
+ *     void *data             - The data to be sent.
+ *     int datalen            - The length of the data to be sent.
+ *
+ *   Return: 
+ *     int - On error -1 is returned else 0 is returned.
+ */
+int net_send(struct aodv_node *node, struct info *pktinfo, void *data,
+	     int datalen);
+
+#endif
@@ -0,0 +1,389 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The protocol state of one AODV node: its address, routing
+ *        table, timer queue, route request list, neighbour table and
+ *        the hop distances it learnt.
+ *        Every protocol function takes the node it works on as its first
+ *        argument, so a process can run any number of nodes. The daemon
+ *        runs one, aodv_sim runs many.
+ *
+ *        Received messages, timeouts and the start of the HELLOs enter
+ *        the protocol code through node_recv, node_timer and node_hello.
+ *
+ *	Internal procedures:
+ *        check_packet
+ *
+ *	External procedures:
+ *        node_init
+ *        node_free
+ *        node_recv
+ *        node_timer
+ *        node_hello
+ *        node_random
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "node.h"
+#include "RT.h"
+#include "rreq_list.h"
+#include "to_rreq.h"
+#include "rreq.h"
+#include "rrep.h"
+#include "rerr.h"
+#include "hello.h"
+#include "neighbour.h"
+#include "dist.h"
+
+/* Pre-declaration of internal function */
+int check_packet(int numbytes, int type, int errcount);
+
+/*
+ *   node_init
+ *
+ *   Description:
+ *     Creates the routing table with the entry to the node itself, the
+ *     route request list and an empty timer queue. The timer queue is
+ *     not tied to SIGALRM, see pq_new.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node to initialize.
+ *     u_int32_t my_ip        - Address of the node.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+node_init(struct aodv_node *node, u_int32_t my_ip)
+{
+  struct artentry *rte;
+
+  memset(node, 0, sizeof(struct aodv_node));
+  node->my_ip = my_ip;
+  node->rng = ((u_int64_t)my_ip * 0x9e3779b97f4a7c15ULL) | 1;
+  pq_init(&node->pq);
+
+  if (init_rt(node) == -1)
+    /* Failed to initialize the routing table */
+    return -1;
+
+  if (init_rreq_list(node) == -1)
+    /* Failed to initialize the RREQ list */
+    return -1;
+
+  if ((rte = insert_entry(node)) == NULL)
+    /* Couldn't create a new entry in the routing table */
+    return -1;
+
+  /* The destination sequence number of this entry is used as source
+     sequence number, the lifetime is infinite */
+  rte->dst_ip = my_ip;
+  rte->dst_seq = 1;
+  rte->broadcast_id = 1;
+  rte->hop_cnt = 0;
+  rte->lst_hop_cnt = 0;
+  rte->nxt_hop = my_ip;
+  rte->lifetime = -1;
+  rte->rt_flags = 0;
+  flight_event(FLIGHT_RT_INSERT, rte->dst_ip, rte->nxt_hop, 0, rte->dst_seq);
+
+  node->my_entry = rte;
+
+  return 0;
+}
+
+/*
+ *   node_free
+ *
+ *   Description:
+ *     Frees the routing table, the route request list, the neighbour
+ *     and distance tables and the queued timers of a node. Kernel
+ *     routes are left alone.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node.
+ *
+ *   Return: None
+ */
+void
+node_free(struct aodv_node *node)
+{
+  struct prioqent *pqe;
+  struct rreq_tdata *trd;
+
+  /* RREQ timers own their message */
+  for (pqe = pq_getfirst(&node->pq); pqe != NULL; pqe = pqe->pqe)
+    if (pqe->flags == PQ_PACKET_RREQ)
+      {
+	trd = pqe->data;
+	free(trd->rd);
+	free(trd);
+      }
+    else if (pqe->flags == PQ_PACKET_FWD)
+      free(pqe->data);
+
+  pq_free(&node->pq);
+  free_rreq_list(node);
+  free_nb_list(node);
+  free_dist(node);
+  free_rt(node);
+}
+
+/*
+ *   check_packet
+ *
+ *   Description:
+ *     Checks the size of incoming packets and matches this with the stated 
+ *     message type, and in the case of RERR with the number of error
+ *     messages.
+ *
+ *   Arguments:
+ *     int numbytes - The number of bytes received.
+ *     int type     - The message type.
+ *     int errcount - The number of unreachable destinations in a RERR,
+ *                    the bytes of the extension of a HELLO.
+ *
+ *   Return:
+ *     int - 0 if the packet is correct
+ *          -1 if it's not.
+ */
+int 
+check_packet(int numbytes, int type, int errcount)
+{
+  switch (type) 
+    {
+    case RREQ: 
+      if (numbytes == 24)
+	return 0;
+      break;
+      
+    case RREP:
+      if (numbytes == 20 + errcount)
+	return 0;
+      break;
+      
+    case RERR: 
+      if (numbytes == (4 + 8 * errcount)) 
+	return 0;
+      break;
+    
+    default: 
+      break;
+    }
+
+  return -1;
+}
+
+/*
+ *   node_recv
+ *
+ *   Description:
+ *     Checks the size of a received AODV message and hands it to
+ *     rec_rreq, rec_rrep, rec_hello or rec_rerr. Malformed messages
+ *     are dropped, the others show the sender is still a neighbour,
+ *     see hello_heard.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The receiving node.
+ *     struct info *inf       - Sender, destination and ttl of the packet.
+ *     char *buf              - The message.
+ *     int len                - Its length.
+ *
+ *   Return:
+ *     int - -1 if the message was dropped else 0
+ */
+int
+node_recv(struct aodv_node *node, struct info *inf, char *buf, int len)
+{
+  struct rerrhdr rerrhdr_msg;
+  struct rerr_unr_dst *tp;
+  int rerri;
+  int ext;
+
+  if (len < 1)
+    return -1;
+
+  /* What type of aodv message? */
+  switch ((u_int8_t)buf[0])
+    {
+    case RREQ:
+      if (check_packet(len, RREQ, 0) == -1)
+	return -1;
+
+      rec_rreq(node, inf, (struct rreq*)buf);
+      break;
+
+    case RREP:
+      /* A HELLO in relay mode carries the neighbour list, see gen_hello */
+      ext = 0;
+      if (len >= 24 && RREP_IS_HELLO((struct rrep*)buf) &&
+	  (u_int8_t)buf[20] == HELLO_EXT_NB && (u_int8_t)buf[21] % 4 == 0)
+	ext = 4 + (u_int8_t)buf[21];
+      if (check_packet(len, RREP, ext) == -1)
+	return -1;
+
+      if (RREP_IS_HELLO((struct rrep*)buf))
+	rec_hello(node, inf, (struct rrep*)buf, len);
+      else
+	rec_rrep(node, inf, (struct rrep*)buf);
+      break;
+
+    case RERR:
+      /* Must know the number of unreachable destinations before
+	 checking! */
+      if (len < 4)
+	return -1;
+
+      rerrhdr_msg.type = (u_int8_t)buf[0];
+      rerrhdr_msg.reserved = (u_int16_t)buf[1];
+      rerrhdr_msg.dst_cnt = (u_int8_t)buf[3];
+      if (check_packet(len, RERR, rerrhdr_msg.dst_cnt) == -1)
+	return -1;
+
+      /* Make space for dest_count structs, and assign them. This is a
+	 linked list of structs. */
+      rerrhdr_msg.unr_dst = NULL;
+      for (rerri = 0; rerri < rerrhdr_msg.dst_cnt; rerri++)
+	{
+	  if ((tp = (struct rerr_unr_dst*) 
+	       malloc(sizeof(struct rerr_unr_dst))) == NULL)
+	    break;
+
+	  tp->next = rerrhdr_msg.unr_dst;
+	  rerrhdr_msg.unr_dst = tp;
+	  memcpy(&(tp->unr_dst_ip), &(buf[4 + rerri * 8]), 4);
+	  memcpy(&(tp->unr_dst_seq), &(buf[4 + rerri * 8 + 4]), 4);
+	}
+
+      /* Only the destinations that could be allocated are handled */
+      rerrhdr_msg.dst_cnt = rerri;
+      rec_rerr(node, inf, &rerrhdr_msg);
+
+      /* Free the list of structs that was sent to rec_rerr() */
+      while ((tp = rerrhdr_msg.unr_dst) != NULL)
+	{
+	  rerrhdr_msg.unr_dst = tp->next;
+	  free(tp);
+	}
+      break;
+
+    default:
+      /* Unknown message received on aodv-port */
+      return -1;
+    }
+
+  hello_heard(node, inf->ip_pkt_src_ip);
+
+  return 0;
+}
+
+/*
+ *   node_timer
+ *
+ *   Description:
+ *     Handles a timer that is due, a RREQ to resend or to forward or a
+ *     HELLO to send. The entry must already be taken off the queue, it
+ *     is freed.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node.
+ *     struct prioqent *pqe   - The timer.
+ *
+ *   Return: None
+ */
+void
+node_timer(struct aodv_node *node, struct prioqent *pqe)
+{
+  if (pqe == NULL)
+    return;
+
+  flight_event(FLIGHT_TIMER, pqe->id, pqe->flags, 0, 0);
+
+  switch (pqe->flags)
+    {
+    case PQ_PACKET_RREQ:
+      rreq_timeout(node, pqe->data);
+      break;
+
+    case PQ_PACKET_HELLO:
+      hello_resend(node);
+      break;
+
+    case PQ_PACKET_FWD:
+      rreq_forward(node, pqe->data);
+      break;
+
+    default:
+      break;
+    }
+
+  /* The data lives on in a new entry or was freed by rreq_timeout or
+     rreq_forward */
+  free(pqe);
+}
+
+/*
+ *   node_hello
+ *
+ *   Description:
+ *     Sends the first HELLO and queues the next, see hello_resend.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node.
+ *
+ *   Return:
+ *     int - Returns 0 if the HELLO was sent
+ *         else return -1.
+ */
+int
+node_hello(struct aodv_node *node)
+{
+  return hello_resend(node);
+}
+
+/*
+ *   node_random
+ *
+ *   Description:
+ *     Returns the next number of the generator of the node (xorshift64*).
+ *     node_init seeds it from the address, so neighbours draw different
+ *     numbers and a simulation is repeatable.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node.
+ *
+ *   Return:
+ *     u_int64_t - The number.
+ */
+u_int64_t
+node_random(struct aodv_node *node)
+{
+  node->rng ^= node->rng >> 12;
+  node->rng ^= node->rng << 25;
+  node->rng ^= node->rng >> 27;
+
+  return node->rng * 2685821657736338717ULL;
+}
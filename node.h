@@ -0,0 +1,198 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The protocol state of one AODV node: its address, routing
+ *        table, timer queue, route request list, neighbour table and
+ *        the hop distances it learnt.
+ *        Every protocol function takes the node it works on as its first
+ *        argument, so a process can run any number of nodes. The daemon
+ *        runs one, aodv_sim runs many.
+ *
+ *        Received messages, timeouts and the start of the HELLOs enter
+ *        the protocol code through node_recv, node_timer and node_hello.
+ *
+ *	Internal procedures:
+ *        check_packet
+ *
+ *	External procedures:
+ *        node_init
+ *        node_free
+ *        node_recv
+ *        node_timer
+ *        node_hello
+ *        node_random
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef NODE_H
+#define NODE_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "info.h"
+#include "rt_entry_list.h"
+#include "timer.h"
+
+struct rreq_entry;
+struct nb_entry;
+struct dist_entry;
+
+struct aodv_node
+{
+  u_int32_t my_ip;                 /* Address of the node */
+  struct artentry *my_entry;       /* Routing table entry to the node */
+  struct rt_entry_list *rt;        /* Head of the routing table */
+  struct prioq pq;                 /* Timer queue */
+  struct rreq_entry *rreq_header;  /* Head of the route request list */
+  struct nb_entry *nb_list;        /* The neighbour table */
+  struct dist_entry *dist;         /* Hop distances learnt, see dist.h */
+  u_int16_t hello_seq;             /* Number of the next HELLO */
+  int hello_skip;                  /* HELLOs skipped since the last */
+  int metric;                      /* METRIC_HOPS or METRIC_ETX */
+  int repair_ttl;                  /* Routes at most this many hops long
+				      are repaired locally, 0 none */
+  int multipath;                   /* Keep alternate next hops, see
+				      add_alt_hop */
+  int fwd_limit;                   /* A RREQ is not rebroadcast after
+				      this many copies, 0 sends at once */
+  u_int64_t fwd_sent;              /* Delayed rebroadcasts sent */
+  u_int64_t fwd_suppressed;        /* and dropped, see rreq_forward */
+  int gossip;                      /* Percent of RREQs rebroadcast with
+				      GOSSIP_DEGREE neighbours, 0 all */
+  u_int64_t gossip_held;           /* RREQs held, see gossip_hold */
+  u_int64_t gossip_dropped;        /* and not rebroadcast after all */
+  int mpr;                         /* Only relays rebroadcast RREQs, see
+				      nb_select_relays */
+  u_int64_t mpr_dropped;           /* RREQs left to the relays */
+  int rtt_mean;                    /* Smoothed time per hop and */
+  int rtt_dev;                     /* its deviation in 1/8 ms, see rtt.h */
+  u_int64_t rtt_samples;           /* RREQ round trips measured */
+  u_int64_t rng;                   /* State of node_random */
+};
+
+
+/*
+ *   node_init
+ *
+ *   Description:
+ *     Creates the routing table with the entry to the node itself, the
+ *     route request list and an empty timer queue. The timer queue is
+ *     not tied to SIGALRM, see pq_new.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node to initialize.
+ *     u_int32_t my_ip        - Address of the node.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int node_init(struct aodv_node *node, u_int32_t my_ip);
+
+/*
+ *   node_free
+ *
+ *   Description:
+ *     Frees the routing table, the route request list, the neighbour
+ *     and distance tables and the queued timers of a node. Kernel
+ *     routes are left alone.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node.
+ *
+ *   Return: None
+ */
+void node_free(struct aodv_node *node);
+
+/*
+ *   node_recv
+ *
+ *   Description:
+ *     Checks the size of a received AODV message and hands it to
+ *     rec_rreq, rec_rrep, rec_hello or rec_rerr. Malformed messages
+ *     are dropped, the others show the sender is still a neighbour,
+ *     see hello_heard.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The receiving node.
+ *     struct info *inf       - Sender, destination and ttl of the packet.
+ *     char *buf              - The message.
+ *     int len                - Its length.
+ *
+ *   Return:
+ *     int - -1 if the message was dropped else 0
+ */
+int node_recv(struct aodv_node *node, struct info *inf, char *buf, int len);
+
+/*
+ *   node_timer
+ *
+ *   Description:
+ *     Handles a timer that is due, a RREQ to resend or to forward or a
+ *     HELLO to send. The entry must already be taken off the queue, it
+ *     is freed.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node.
+ *     struct prioqent *pqe   - The timer.
+ *
+ *   Return: None
+ */
+void node_timer(struct aodv_node *node, struct prioqent *pqe);
+
+/*
+ *   node_hello
+ *
+ *   Description:
+ *     Sends the first HELLO and queues the next, see hello_resend.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node.
+ *
+ *   Return:
+ *     int - Returns 0 if the HELLO was sent
+ *         else return -1.
+ */
+int node_hello(struct aodv_node *node);
+
+/*
+ *   node_random
+ *
+ *   Description:
+ *     Returns the next number of the generator of the node (xorshift64*).
+ *     node_init seeds it from the address, so neighbours draw different
+ *     numbers and a simulation is repeatable.
+ *
+ *   Arguments:
+ *     struct aodv_node *node - The node.
+ *
+ *   Return:
+ *     u_int64_t - The number.
+ */
+u_int64_t node_random(struct aodv_node *node);
+
+#endif
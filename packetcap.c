@@ -20,20 +20,29 @@
  ********************************
  *
  *	General description:
- *        Forks of a process scanning the device in use with AODV for
- *        incoming and outgoing packets. Information from these packets
- *        are sent to a pipe listened to by the main aodv_daemon process.
+ *        Starts the capture stage, a thread scanning the device in use
+ *        with AODV for incoming and outgoing packets. Information from
+ *        these packets is put in a ring read by the protocol stage, the
+ *        main loop of aodv_daemon.
  *
  *        Uses the libpcap module.
  *
+ *        With implicit HELLOs the stage also reports, at most once a
+ *        second per neighbour, frames from and to the neighbours. The
+ *        MAC address of a neighbour is learnt from its AODV messages.
+ *
  *	Internal procedures:
  *        packetcapture()
- *        send_to_pipe()
+ *        send_to_ring()
  *	  scan_packets()
+ *        cap_implicit_hello()
  *
  *	
  *	External procedures:
  *        packetcaptureinit()
+ *        packetcapturewait()
+ *        packetcaptureread()
+ *        packetcapturestop()
  *
  ********************************
  *
@@ -44,34 +53,46 @@
 #include "packetcap.h"
 
 /* Predeclaration of internal procedures */
-int packetcapture(int maxpackets);
-void send_to_pipe(struct scanpac *sp);
+void *packetcapture(void *arg);
+void send_to_ring(struct scanpac *sp);
 void scan_packets(u_char *unused, const struct pcap_pkthdr *hdr, 
 		  const u_char *data);
+void cap_implicit_hello(struct ether_header *eptr, struct ip *ip,
+			time_t sec);
 
-extern u_int32_t g_my_ip;
-extern int scanner_pid;
 
 static pcap_t *pd;
 static int datalink;
-static int my_pipe[2];
+static struct ring cap_ring;  /* capture -> protocol */
+static pthread_t cap_tid;
+static u_int32_t cap_my_ip;   /* Address of the node */
+static int cap_implicit;      /* Report frames of the neighbours */
+static u_int8_t cap_my_mac[ETH_ALEN];
+static struct cap_mac cap_macs[CAP_MACS];
 
 /* 
  *   packetcaptureinit
  *
  *   Description: 
  *     Initializes the interface to scan in promiscous mode. Several calls
- *     to libpcap are made, and a pipe is opened. A scanning process is
- *     forked  off, and the control is returned to the aodv_daemon process.  
+ *     to libpcap are made and the capture ring is created. The capture
+ *     thread is started, and the control is returned to the protocol
+ *     stage.
  *
  *   Arguments:
  *     char *interface - The name of the interface to scan for packets.
+ *     u_int32_t my_ip - Address of the node, its own ARP requests are
+ *                       ignored.
+ *     int implicit    - 1 to report frames from and to neighbours as
+ *                       SP_TYPE_HEARD and SP_TYPE_SENT.
  *
  *   Return:
- *     int - Returns 0 if sucessful. -1 if lib_pcap fails. -2 if fork fails.
+ *     int - A file descriptor that becomes readable when scanned packets
+ *           are queued. -1 if lib_pcap fails. -2 if the thread can't be
+ *           started.
  */
 int
-packetcaptureinit(char *interface) 
+packetcaptureinit(char *interface, u_int32_t my_ip, int implicit) 
 {
   int snaplen = 100;
 
@@ -80,75 +101,123 @@ packetcaptureinit(char *interface)
   struct bpf_program fcode;
   bpf_u_int32 localnet;
   bpf_u_int32 netmask;
-  int s1;
 
-  s1 = pipe(my_pipe);
+  cap_my_ip = my_ip;
+  cap_implicit = implicit;
 
-  switch ( scanner_pid = fork() ) 
-    {
-    case 0: /* packet capturer. child */
-      signal(SIGINT, NULL);
-      
-      close(READ);      
-      close(my_pipe[READ]);
-      
-      /* Opens the interface for capture */
-      if((pd = pcap_open_live(interface, snaplen, 1, 0, errbuf)) == NULL)
-	return(-1);
-      
-      /* Can the interface/network really be used to scan packets? */
-      if (pcap_lookupnet(interface, &localnet, &netmask, errbuf) < 0)
-	return(-1);
+  /* Opens the interface for capture. The timeout lets the capture
+     loop notice packetcapturestop on an idle interface. */
+  if((pd = pcap_open_live(interface, snaplen, 1, CAP_TIMEOUT, 
+			  errbuf)) == NULL)
+    return(-1);
       
-      /* Only listen to ARP and IP */
-      snprintf(cmd, sizeof(cmd),"arp or ip");
+  /* Can the interface/network really be used to scan packets? */
+  if (pcap_lookupnet(interface, &localnet, &netmask, errbuf) < 0)
+    return(-1);
       
-      /* Compile the filter to be used. */
-      if (pcap_compile(pd, &fcode, cmd, 0, netmask) < 0)
-	return(-1);
+  /* Only listen to ARP and IP */
+  snprintf(cmd, sizeof(cmd),"arp or ip");
       
-      /* Run the compiled filter */
-      if (pcap_setfilter(pd, &fcode) < 0)
-	return(-1);
+  /* Compile the filter to be used. */
+  if (pcap_compile(pd, &fcode, cmd, 0, netmask) < 0)
+    return(-1);
       
-      if ((datalink = pcap_datalink(pd)) < 0)
-	return(-1);
+  /* Run the compiled filter */
+  if (pcap_setfilter(pd, &fcode) < 0)
+    return(-1);
       
-      packetcapture(-1);
-      /* If this function call returns, an error has occured. Exit! */
-      exit(-1);
-      break;
-      
-    case -1: /* Fork failed */
-      return(-2);
-      break;
-      
-    default: /* Daemon process. Parent. */
-      close(my_pipe[WRITE]);
-      
-      return (my_pipe[READ]);
-      break;
-    }
+  if ((datalink = pcap_datalink(pd)) < 0)
+    return(-1);
+
+  if (ring_init(&cap_ring, "capture", CAP_RING_SLOTS,
+		sizeof(struct scanpac)) == -1)
+    return(-1);
 
-  return(-1);
+  stage_register(&cap_ring);
+
+  if (stage_spawn(&cap_tid, packetcapture, NULL) == -1)
+    /* Couldn't start the capture stage */
+    return(-2);
+
+  return ring_notifyfd(&cap_ring);
+}
+
+/* 
+ *   packetcapturewait
+ *
+ *   Description: 
+ *     Must be called before the protocol stage sleeps on the descriptor
+ *     returned by packetcaptureinit.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     int - 0 if it is ok to sleep, -1 if scanned packets are waiting.
+ */
+int
+packetcapturewait()
+{
+  return ring_prepare_wait(&cap_ring);
+}
+
+/* 
+ *   packetcaptureread
+ *
+ *   Description: 
+ *     Takes the oldest scanned packet from the capture ring.
+ *
+ *   Arguments:
+ *     struct scanpac *sp - Where to put the scanned packet.
+ *
+ *   Return:
+ *     int - 0 if a packet was read, -1 if the ring was empty.
+ */
+int
+packetcaptureread(struct scanpac *sp)
+{
+  if (ring_pop(&cap_ring, sp) == 0)
+    return 0;
+
+  /* Empty, forget about old wakeups */
+  ring_drainnotify(&cap_ring);
+
+  return ring_pop(&cap_ring, sp);
+}
+
+/* 
+ *   packetcapturestop
+ *
+ *   Description: 
+ *     Makes the capture thread leave its capture loop.
+ *
+ *   Arguments: None
+ *
+ *   Return: None
+ */
+void
+packetcapturestop()
+{
+  if (pd != NULL)
+    pcap_breakloop(pd);
 }
 
 /*
- *  send_to_pipe
+ *  send_to_ring
  *
  *  Description:
- *    Sends structure scanned packat to pipe 
+ *    Puts a scanned packet in the capture ring. The packet is dropped,
+ *    and counted, if the protocol stage lags behind.
  *
  *  Arguments:
  *    struct scanpac *sp - Structure with the scanned packet to send to 
- *                         the pipe
+ *                         the protocol stage
  *
  *  Return:  Void
  */
 void
-send_to_pipe(struct scanpac *sp) 
+send_to_ring(struct scanpac *sp) 
 {
-  write(my_pipe[WRITE], sp, sizeof(struct scanpac));
+  ring_push(&cap_ring, sp);
 }
 
 /* 
@@ -160,7 +229,7 @@ send_to_pipe(struct scanpac *sp)
  *
  *     Information about IP packets, normal IP-data and ICMPs, and ARP
  *     packets is collected.This information is put into a struct, that is
- *     passed to send_to_pipe(). IP packets increase lifetime of existing
+ *     passed to send_to_ring(). IP packets increase lifetime of existing
  *     routes. ICMP host unreachable and network result in RERR. ARPs result
  *     in RREQ.
  *
@@ -193,6 +262,9 @@ scan_packets(u_char *unused, const struct pcap_pkthdr *hdr,
 	  /* IP? */
 	case ETHERTYPE_IP:
 	  ip = (struct ip*)(data + 14);
+	  if (cap_implicit)
+	    cap_implicit_hello(eptr, ip, hdr->ts.tv_sec);
+
 	  switch (ip->ip_p)
 	    {
 	      /* IP of ICMP type? */
@@ -205,7 +277,7 @@ scan_packets(u_char *unused, const struct pcap_pkthdr *hdr,
 		  ip = (struct ip*)(data + 14 + 20 + 8);
 		  sp.ip = ip->ip_dst.s_addr;
 		  sp.type = SP_TYPE_ICMP;
-		  send_to_pipe(&sp);
+		  send_to_ring(&sp);
 		  break;
 		}
 	      
@@ -213,9 +285,10 @@ scan_packets(u_char *unused, const struct pcap_pkthdr *hdr,
 	    default:
 	      sp.ip = ip->ip_dst.s_addr;
 	      sp.type = SP_TYPE_IP;
-	      send_to_pipe(&sp);
+	      send_to_ring(&sp);
 	      break;
 	    }
+	  break;
 	  
 	  /* ARP packet? */
 	case ETHERTYPE_ARP:
@@ -225,11 +298,11 @@ scan_packets(u_char *unused, const struct pcap_pkthdr *hdr,
 	      ntohs((arp->ea_hdr).ar_hrd) == ARPHRD_ETHER && 
 	      ntohs((arp->ea_hdr).ar_pro) == ETHERTYPE_IP) 
 	    {
-	      if ( (*((u_int32_t*)arp->arp_spa)) == g_my_ip )
+	      if ( (*((u_int32_t*)arp->arp_spa)) == cap_my_ip )
 		{
 		  sp.ip = *((u_int32_t*)arp->arp_tpa);
 		  sp.type = SP_TYPE_ARP;
-		  send_to_pipe(&sp);
+		  send_to_ring(&sp);
 		  break;
 		}
 	    }
@@ -241,38 +314,88 @@ scan_packets(u_char *unused, const struct pcap_pkthdr *hdr,
  *   packetcapture
  *
  *   Description: 
- *     This function is called to initialize lib_pcap: scan_packets() is 
- *     set to be the packet handling function. The pcap_loop call should
- *     never return.
+ *     Body of the capture stage: scan_packets() is set to be the packet
+ *     handling function. The pcap_loop call only returns on errors or
+ *     after packetcapturestop.
  *
  *   Arguments:
- *     int maxpackets Always set to -1, which indicates "Scan forever".
+ *     void *arg - Unused.
  *
  *   Return:
- *     int - Returns -1 if lip_pcap fails or exits. Should never return if
- *           all is ok.
+ *     void* - NULL
  */
-int
-packetcapture(int maxpackets)
+void *
+packetcapture(void *arg)
 {
-  int packets = 0;
+  pcap_loop(pd, -1, scan_packets, NULL);
 
-  packets = pcap_loop(pd, maxpackets, scan_packets, NULL);
-
-  return -1;
+  return NULL;
 }
 
+/*
+ *  cap_implicit_hello
+ *
+ *  Description:
+ *    Learns the MAC address of neighbours from their AODV messages, and
+ *    of the node from its own. Frames from a neighbour, and frames the
+ *    node sends to one, are then reported once a second, the protocol
+ *    stage takes them as HELLOs.
+ *
+ *  Arguments:
+ *    struct ether_header *eptr - Ethernet header of the frame.
+ *    struct ip *ip             - The IP packet in it.
+ *    time_t sec                - Second the frame was captured.
+ *
+ *  Return:  Void
+ */
+void
+cap_implicit_hello(struct ether_header *eptr, struct ip *ip, time_t sec)
+{
+  struct udphdr *udp;
+  struct cap_mac *cm;
+  struct scanpac sp;
 
+  udp = (struct udphdr*)((u_char*)ip + ip->ip_hl * 4);
+  if (ip->ip_p == IPPROTO_UDP && ntohs(udp->dest) == AODVPORT)
+    {
+      if (ip->ip_src.s_addr == cap_my_ip)
+	memcpy(cap_my_mac, eptr->ether_shost, ETH_ALEN);
+      else
+	{
+	  cm = &cap_macs[eptr->ether_shost[ETH_ALEN - 1] % CAP_MACS];
+	  if (cm->ip != ip->ip_src.s_addr ||
+	      memcmp(cm->mac, eptr->ether_shost, ETH_ALEN) != 0)
+	    {
+	      memcpy(cm->mac, eptr->ether_shost, ETH_ALEN);
+	      cm->ip = ip->ip_src.s_addr;
+	      cm->heard = 0;
+	      cm->sent = 0;
+	    }
+	}
+    }
 
+  if (memcmp(eptr->ether_shost, cap_my_mac, ETH_ALEN) == 0)
+    {
+      /* Sent by the node */
+      cm = &cap_macs[eptr->ether_dhost[ETH_ALEN - 1] % CAP_MACS];
+      if (cm->ip == 0 || cm->sent == sec ||
+	  memcmp(cm->mac, eptr->ether_dhost, ETH_ALEN) != 0)
+	return;
 
+      cm->sent = sec;
+      sp.type = SP_TYPE_SENT;
+    }
+  else
+    {
+      cm = &cap_macs[eptr->ether_shost[ETH_ALEN - 1] % CAP_MACS];
+      if (cm->ip == 0 || cm->heard == sec ||
+	  memcmp(cm->mac, eptr->ether_shost, ETH_ALEN) != 0)
+	return;
 
+      cm->heard = sec;
+      sp.type = SP_TYPE_HEARD;
+    }
 
-
-
-
-
-
-
-
-
-
+  sp.ip = cm->ip;
+  send_to_ring(&sp);
+}
@@ -20,20 +20,29 @@
  ********************************
  *
  *	General description:
- *        Forks of a process scanning the device in use with AODV for
- *        incoming and outgoing packets. Information from these packets
- *        are sent to a pipe listened to by the main aodv_daemon process.
+ *        Starts the capture stage, a thread scanning the device in use
+ *        with AODV for incoming and outgoing packets. Information from
+ *        these packets is put in a ring read by the protocol stage, the
+ *        main loop of aodv_daemon.
  *
  *        Uses the libpcap module.
  *
+ *        With implicit HELLOs the stage also reports, at most once a
+ *        second per neighbour, frames from and to the neighbours. The
+ *        MAC address of a neighbour is learnt from its AODV messages.
+ *
  *	Internal procedures:
  *        packetcapture()
- *        send_to_pipe()
+ *        send_to_ring()
  *	  scan_packets()
+ *        cap_implicit_hello()
  *
  *	
  *	External procedures:
  *        packetcaptureinit()
+ *        packetcapturewait()
+ *        packetcaptureread()
+ *        packetcapturestop()
  *
  ********************************
  *
@@ -51,20 +60,34 @@
 #include <net/ethernet.h>
 #include <netinet/ip.h>
 #include <netinet/ip_icmp.h>
+#include <netinet/udp.h>
 #include <arpa/inet.h>
 #include <netinet/if_ether.h>
 #include <fcntl.h>
+#include <string.h>
+#include <time.h>
 
 #include "utils.h"
 #include "RT.h"
+#include "ring.h"
+#include "stage.h"
 
 #define SP_TYPE_IP   1
 #define SP_TYPE_ARP  2
 #define SP_TYPE_ICMP 3
+#define SP_TYPE_HEARD 4          /* A frame from neighbour ip */
+#define SP_TYPE_SENT  5          /* A frame to neighbour ip */
 
 #define MAXLINE   4096
-#define READ         0
-#define WRITE        1
+
+/* Neighbours whose MAC address is kept, hashed on its last byte */
+#define CAP_MACS 256
+
+/* Number of slots in the capture ring */
+#define CAP_RING_SLOTS 1024
+
+/* Timeout in ms for pcap reads, bounds the time to stop the capture */
+#define CAP_TIMEOUT  100
 
 struct scanpac
 {
@@ -72,36 +95,76 @@ struct scanpac
   u_int32_t ip;
 };
 
+struct cap_mac
+{
+  u_int8_t mac[ETH_ALEN];
+  u_int32_t ip;                  /* Address of the neighbour, 0 if free */
+  time_t heard;                  /* Second a frame from it was reported */
+  time_t sent;                   /* Second a frame to it was reported */
+};
+
 
 /* 
  *   packetcaptureinit
  *
  *   Description: 
  *     Initializes the interface to scan in promiscous mode. Several calls
- *     to libpcap are made, and a pipe is opened. A scanning process is
- *     forked  off, and the control is returned to the aodv_daemon process.  
+ *     to libpcap are made and the capture ring is created. The capture
+ *     thread is started, and the control is returned to the protocol
+ *     stage.
  *
  *   Arguments:
  *     char *interface - The name of the interface to scan for packets.
+ *     u_int32_t my_ip - Address of the node, its own ARP requests are
+ *                       ignored.
+ *     int implicit    - 1 to report frames from and to neighbours as
+ *                       SP_TYPE_HEARD and SP_TYPE_SENT.
  *
  *   Return:
- *     int - Returns 0 if sucessful. -1 if lib_pcap fails. -2 if fork fails.
+ *     int - A file descriptor that becomes readable when scanned packets
+ *           are queued. -1 if lib_pcap fails. -2 if the thread can't be
+ *           started.
  */
-int packetcaptureinit(char *interface);
-
-#endif
-
-
-
-
-
-
-
-
-
-
-
+int packetcaptureinit(char *interface, u_int32_t my_ip, int implicit);
 
+/* 
+ *   packetcapturewait
+ *
+ *   Description: 
+ *     Must be called before the protocol stage sleeps on the descriptor
+ *     returned by packetcaptureinit.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     int - 0 if it is ok to sleep, -1 if scanned packets are waiting.
+ */
+int packetcapturewait();
 
+/* 
+ *   packetcaptureread
+ *
+ *   Description: 
+ *     Takes the oldest scanned packet from the capture ring.
+ *
+ *   Arguments:
+ *     struct scanpac *sp - Where to put the scanned packet.
+ *
+ *   Return:
+ *     int - 0 if a packet was read, -1 if the ring was empty.
+ */
+int packetcaptureread(struct scanpac *sp);
 
+/* 
+ *   packetcapturestop
+ *
+ *   Description: 
+ *     Makes the capture thread leave its capture loop.
+ *
+ *   Arguments: None
+ *
+ *   Return: None
+ */
+void packetcapturestop();
 
+#endif
@@ -27,12 +27,20 @@
  *        or when it receives a RERR message from another node. The module
  *        handles the receiption and generation of RERR messages.
  *
+ *        A node that sets repair_ttl may first try to repair a broken
+ *        route that others use and that was at most that many hops long.
+ *        When data for the destination arrives it sends one RREQ for it,
+ *        a little past the old distance, and only sends the RERR if no
+ *        RREP comes back.
+ *
  *	Internal procedures: 
  *        free_rerrhdr
  *        send_rerrhdr
  *
  *	External procedures: 
  *        link_break
+ *        local_repair
+ *        repair_failed
  *        host_unr
  *        rec_rerr
  *        create_rerrhdr
@@ -49,8 +57,8 @@
 #include "rerr.h"
 
 void free_rerrhdr(struct rerrhdr *tmp_rerrhdr);
-int send_rerr(struct info *tmp_info, struct rerrhdr *tmp_rerrhdr);
-extern u_int32_t g_my_ip;
+int send_rerr(struct aodv_node *node, struct info *tmp_info,
+	      struct rerrhdr *tmp_rerrhdr);
 
 /*
  * link_break
@@ -60,9 +68,13 @@ extern u_int32_t g_my_ip;
  *   is detected. All active routes that have the unreachable node as next
  *   hop are invalidated. All precursors for this entry are removed. The
  *   RERR meassage including the unreachable destinations and their
- *   incremented seq numbers is finally rebroadcast.
+ *   incremented seq numbers is finally rebroadcast. Routes that can be
+ *   repaired locally are marked RT_REPAIR, keep their precursors and are
+ *   left out of the RERR, see local_repair. Routes with an alternate next
+ *   hop switch to it and stay valid, see switch_alt_hop.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   struct info *tmp_info - info structure
  *   u_int32_t brk_dst_ip -  IPaddress of the lost neighbour
  *
@@ -71,14 +83,15 @@ extern u_int32_t g_my_ip;
  *        -1 on failure
  */
 int
-link_break(struct info *tmp_info, u_int32_t brk_dst_ip)
+link_break(struct aodv_node *node, struct info *tmp_info, u_int32_t brk_dst_ip)
 {
   struct rt_entry_list *tmp_rt_entry_list;
   struct rerrhdr *new_rerrhdr = NULL;
   struct artentry *tmp_rtentry;
   int rerrhdr_created = 0;
 
-  for(tmp_rt_entry_list = get_first_entry();
+  delete_alt_hop_from_all(node, brk_dst_ip);
+  for(tmp_rt_entry_list = get_first_entry(node);
       tmp_rt_entry_list->ishead != 1;
       tmp_rt_entry_list = tmp_rt_entry_list->next)
     {
@@ -86,9 +99,24 @@ link_break(struct info *tmp_info, u_int32_t brk_dst_ip)
 	 tmp_rt_entry_list->entry->hop_cnt != 255) /* thus active */
 	{
 	  tmp_rtentry = tmp_rt_entry_list->entry;
+	  if(switch_alt_hop(tmp_rtentry) == 0)
+	    /* Another next hop took over */
+	    continue;
 	  
 	  route_expiry(tmp_rtentry);
-	  delete_precursor_from_all(tmp_rt_entry_list->entry->nxt_hop);
+	  flight_event(FLIGHT_RT_BROKEN, tmp_rtentry->dst_ip,
+		       tmp_rtentry->nxt_hop, tmp_rtentry->lst_hop_cnt,
+		       tmp_rtentry->dst_seq);
+	  delete_precursor_from_all(node, tmp_rt_entry_list->entry->nxt_hop);
+	  if(tmp_rtentry->lst_hop_cnt <= node->repair_ttl &&
+	     tmp_rtentry->precursors->next->ishead != 1)
+	    {
+	      /* Repaired when data for it comes, the RERR waits, see
+		 local_repair */
+	      tmp_rtentry->rt_flags |= RT_REPAIR;
+	      continue;
+	    }
+
 	  if(!rerrhdr_created)
 	    { 
 	      if((new_rerrhdr =
@@ -110,13 +138,98 @@ link_break(struct info *tmp_info, u_int32_t brk_dst_ip)
   
   if(rerrhdr_created)
     {
-      send_rerr(tmp_info, new_rerrhdr);
+      send_rerr(node, tmp_info, new_rerrhdr);
       free_rerrhdr(new_rerrhdr);
     }
   
   return 0;
 }
 
+/*
+ * local_repair
+ *
+ * Description: 
+ *   Called when data for a destination arrives. If the route to it is
+ *   marked RT_REPAIR by link_break, and no RREQ for it is under way,
+ *   gen_rreq sends a single RREQ with the TTL of the last hop count plus
+ *   LOCAL_ADD_TTL. The mark is removed when a RREP or HELLO from the
+ *   destination comes, or by repair_failed.
+ *
+ * Arguments: 
+ *   struct aodv_node *node - The node.
+ *   u_int32_t dst_ip - Destination of the data.
+ *
+ * Returns: 
+ *   int - 0 if the route is being repaired, the data should wait
+ *        -1 if not
+ */
+int
+local_repair(struct aodv_node *node, u_int32_t dst_ip)
+{
+  struct artentry *tmp_rtentry;
+  struct info tmp_info;
+
+  if((tmp_rtentry = getentry(node, dst_ip)) == NULL ||
+     tmp_rtentry->hop_cnt != 255 ||
+     !(tmp_rtentry->rt_flags & RT_REPAIR))
+    return -1;
+
+  if(pq_getfirstofidflags(&node->pq, dst_ip, PQ_PACKET_RREQ) != NULL)
+    /* Already under way */
+    return 0;
+
+  tmp_info.ip_pkt_dst_ip = dst_ip;
+  tmp_info.ip_pkt_src_ip = node->my_ip;
+  tmp_info.ip_pkt_my_ip = node->my_ip;
+  tmp_info.ip_pkt_ttl = 1;
+  if(gen_rreq(node, &tmp_info) == -1)
+    {
+      repair_failed(node, tmp_rtentry);
+      return -1;
+    }
+
+  return 0;
+}
+
+/*
+ * repair_failed
+ *
+ * Description: 
+ *   Ends the local repair of a route when its RREQ has timed out. If
+ *   the route is still broken a RERR for it is sent to its precursors,
+ *   as link_break would have done.
+ *
+ * Arguments: 
+ *   struct aodv_node *node - The node.
+ *   struct artentry *rt - The route.
+ *
+ * Returns: 
+ *   int - 0 on success
+ *        -1 on failure
+ */
+int
+repair_failed(struct aodv_node *node, struct artentry *rt)
+{
+  struct rerrhdr *new_rerrhdr;
+  struct info tmp_info;
+
+  rt->rt_flags &= ~RT_REPAIR;
+  if(rt->hop_cnt != 255 || rt->precursors->next->ishead == 1)
+    /* Found in some other way, or nobody left to tell */
+    return 0;
+
+  if((new_rerrhdr = create_rerrhdr(rt->dst_ip, rt->dst_seq)) == NULL)
+    return -1;
+
+  tmp_info.ip_pkt_my_ip = node->my_ip;
+  tmp_info.ip_pkt_ttl = 1;
+  send_rerr(node, &tmp_info, new_rerrhdr);
+  free_rerrhdr(new_rerrhdr);
+  clear_precursors(rt);
+
+  return 0;
+}
+
 /*
  * host_unr
  *
@@ -126,6 +239,7 @@ link_break(struct info *tmp_info, u_int32_t brk_dst_ip)
  *   message is created to inform neighbours.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   struct info *tmp_info - info structure
  *   u_int32_t brk_dst_ip - IPaddress of the unreachable destination
  *
@@ -134,42 +248,50 @@ link_break(struct info *tmp_info, u_int32_t brk_dst_ip)
  *        -1 on failure
  */
 int
-host_unr(struct info *tmp_info, u_int32_t brk_dst_ip)
+host_unr(struct aodv_node *node, struct info *tmp_info, u_int32_t brk_dst_ip)
 {
   struct rerrhdr *new_rerrhdr = NULL;
   struct artentry *tmp_rtentry;
 
-  tmp_rtentry = getentry(brk_dst_ip);
+  tmp_rtentry = getentry(node, brk_dst_ip);
   if(tmp_rtentry != NULL &&
-     brk_dst_ip != g_my_ip)
+     brk_dst_ip != node->my_ip)
     {
       if(tmp_rtentry->hop_cnt != 255) /* thus active route exists in RT */
 	{
 	  tmp_rtentry->dst_seq++;
 	  tmp_rtentry->lst_hop_cnt = tmp_rtentry->hop_cnt;
 	  tmp_rtentry->hop_cnt = 255;
+	  clear_alt_hops(tmp_rtentry);
+	  flight_event(FLIGHT_RT_BROKEN, tmp_rtentry->dst_ip,
+		       tmp_rtentry->nxt_hop, tmp_rtentry->lst_hop_cnt,
+		       tmp_rtentry->dst_seq);
 	  if((new_rerrhdr = create_rerrhdr(brk_dst_ip, 
 					   tmp_rtentry->dst_seq)) == NULL)
 	    return -1;
 	  
 	  if(tmp_rtentry->nxt_hop == tmp_rtentry->dst_ip) 
 	    /* neighbouring node */
-	    delete_precursor_from_all(tmp_rtentry->nxt_hop);
+	    delete_precursor_from_all(node, tmp_rtentry->nxt_hop);
 	  
 	  clear_precursors(tmp_rtentry);
 	}
+      else if((new_rerrhdr = create_rerrhdr(brk_dst_ip,
+					    tmp_rtentry->dst_seq)) == NULL)
+	/* The route is already broken, report it as it stands */
+	return -1;
       
-      send_rerr(tmp_info, new_rerrhdr);
+      send_rerr(node, tmp_info, new_rerrhdr);
       free_rerrhdr(new_rerrhdr);
     }
   
-  else if(tmp_rtentry != NULL && brk_dst_ip == g_my_ip)
+  else if(tmp_rtentry != NULL && brk_dst_ip == node->my_ip)
     {
-      if((new_rerrhdr = create_rerrhdr(g_my_ip,
+      if((new_rerrhdr = create_rerrhdr(node->my_ip,
 				       tmp_rtentry->dst_seq)) == NULL)
 	return -1;
       
-      send_rerr(tmp_info, new_rerrhdr);
+      send_rerr(node, tmp_info, new_rerrhdr);
       free_rerrhdr(new_rerrhdr);
     }
   
@@ -178,7 +300,7 @@ host_unr(struct info *tmp_info, u_int32_t brk_dst_ip)
       if((new_rerrhdr = create_rerrhdr(brk_dst_ip, 1)) == NULL)
 	return -1;
       
-      send_rerr(tmp_info, new_rerrhdr);
+      send_rerr(node, tmp_info, new_rerrhdr);
       free_rerrhdr(new_rerrhdr);
     }
   
@@ -192,9 +314,12 @@ host_unr(struct info *tmp_info, u_int32_t brk_dst_ip)
  * Description: 
  *   rec_rerr is called when the node receives a RERR packet from
  *   another node. If the precursor list for a broken destinations is
- *   not empty a new RERR is created for that destination.
+ *   not empty a new RERR is created for that destination. The sender is
+ *   no longer an alternate next hop to the destinations, and a route
+ *   with an alternate left switches to it instead of breaking.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   struct info *tmp_info - info structure
  *   struct rrerhdr *tmp_rerrhdr - pointer to the incoming RERR message
  *
@@ -203,7 +328,8 @@ host_unr(struct info *tmp_info, u_int32_t brk_dst_ip)
  *        -1 on failure
  */
 int
-rec_rerr(struct info *tmp_info, struct rerrhdr *tmp_rerrhdr)
+rec_rerr(struct aodv_node *node, struct info *tmp_info,
+	 struct rerrhdr *tmp_rerrhdr)
 {
   struct rerrhdr *new_rerrhdr = NULL;
   struct rerr_unr_dst *tmp_unr_dst;
@@ -215,16 +341,26 @@ rec_rerr(struct info *tmp_info, struct rerrhdr *tmp_rerrhdr)
       i < tmp_rerrhdr->dst_cnt;
       i++, tmp_unr_dst = tmp_unr_dst->next)
     {
-      tmp_rtentry = getentry(tmp_unr_dst->unr_dst_ip);
+      tmp_rtentry = getentry(node, tmp_unr_dst->unr_dst_ip);
+      if(tmp_rtentry != NULL)
+	delete_alt_hop(tmp_rtentry, tmp_info->ip_pkt_src_ip);
+
       /*Is the sender of the rerr the next hop for a
 	broken destination for the current node? */
       if(tmp_rtentry != NULL && 
-	 tmp_rtentry->dst_ip != g_my_ip && /* not the route to myself */
+	 tmp_rtentry->dst_ip != node->my_ip && /* not the route to myself */
 	 tmp_rtentry->nxt_hop == tmp_info->ip_pkt_src_ip)
 	{
+	  if(tmp_rtentry->hop_cnt != 255 && switch_alt_hop(tmp_rtentry) == 0)
+	    /* Another next hop took over */
+	    continue;
+
 	  tmp_rtentry->dst_seq = tmp_unr_dst->unr_dst_seq;
 	  tmp_rtentry->lst_hop_cnt = tmp_rtentry->hop_cnt;
 	  tmp_rtentry->hop_cnt = 255;
+	  flight_event(FLIGHT_RT_BROKEN, tmp_rtentry->dst_ip,
+		       tmp_rtentry->nxt_hop, tmp_rtentry->lst_hop_cnt,
+		       tmp_rtentry->dst_seq);
 	  if(tmp_rtentry->precursors->next->ishead != 1) 
 	    {
 	      /* precursors exist */
@@ -249,7 +385,7 @@ rec_rerr(struct info *tmp_info, struct rerrhdr *tmp_rerrhdr)
   
   if(new_rerr_created)
     {
-      send_rerr(tmp_info, new_rerrhdr);
+      send_rerr(node, tmp_info, new_rerrhdr);
       free_rerrhdr(new_rerrhdr);
     }
 
@@ -365,7 +501,7 @@ free_rerrhdr(struct rerrhdr *tmp_rerrhdr)
  *
  * Description: 
  *   route_expiry invalidates an active route, i e an entry
- *   in the routing table.
+ *   in the routing table. Its alternate next hops are dropped.
  *
  * Arguments: 
  *   struct artentry *tmp_rtentry - Pointer to the entry
@@ -379,6 +515,7 @@ route_expiry(struct artentry *tmp_rtentry)
   tmp_rtentry->lst_hop_cnt = tmp_rtentry->hop_cnt;
   tmp_rtentry->hop_cnt = 255;
   tmp_rtentry->lifetime = (getcurrtime() + DELETE_PERIOD);
+  clear_alt_hops(tmp_rtentry);
   
   del_kroute(tmp_rtentry->dst_ip, tmp_rtentry->nxt_hop);
 }
@@ -392,6 +529,7 @@ route_expiry(struct artentry *tmp_rtentry)
  *   data area, which is a suitable format for the function send_datagram.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   struct info *tmp_info - info structure
  *   struct rrerhdr *tmp_rerrhdr - pointer to the rerrhdr to broadcast.
  *
@@ -400,7 +538,8 @@ route_expiry(struct artentry *tmp_rtentry)
  *        -1 on failure.
  */
 int
-send_rerr(struct info *tmp_info, struct rerrhdr *tmp_rerrhdr)
+send_rerr(struct aodv_node *node, struct info *tmp_info,
+	  struct rerrhdr *tmp_rerrhdr)
 {
   struct rerr_unr_dst *tmp_unr_dst;
   int datalen, i;
@@ -425,7 +564,7 @@ send_rerr(struct info *tmp_info, struct rerrhdr *tmp_rerrhdr)
       memcpy(data + 8 + i * 8, &(tmp_unr_dst->unr_dst_seq), 4);
     }
 
-  send_datagram(tmp_info, data, datalen);
+  send_datagram(node, tmp_info, data, datalen);
 
   free(data);
 
@@ -27,12 +27,20 @@
  *        or when it receives a RERR message from another node. The module
  *        handles the receiption and generation of RERR messages.
  *
+ *        A node that sets repair_ttl may first try to repair a broken
+ *        route that others use and that was at most that many hops long.
+ *        When data for the destination arrives it sends one RREQ for it,
+ *        a little past the old distance, and only sends the RERR if no
+ *        RREP comes back.
+ *
  *	Internal procedures: 
  *        free_rerrhdr
  *        send_rerrhdr
  *
  *	External procedures: 
  *        link_break
+ *        local_repair
+ *        repair_failed
  *        host_unr
  *        rec_rerr
  *        create_rerrhdr
@@ -61,6 +69,7 @@
 #include "rt_entry.h"
 #include "info.h"
 #include "RT.h"
+#include "gen_rreq.h"
 
 /*
  * link_break
@@ -70,9 +79,13 @@
  *   is detected. All active routes that have the unreachable node as next
  *   hop are invalidated. All precursors for this entry are removed. The
  *   RERR meassage including the unreachable destinations and their
- *   incremented seq numbers is finally rebroadcast.
+ *   incremented seq numbers is finally rebroadcast. Routes that can be
+ *   repaired locally are marked RT_REPAIR, keep their precursors and are
+ *   left out of the RERR, see local_repair. Routes with an alternate next
+ *   hop switch to it and stay valid, see switch_alt_hop.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   struct info *tmp_info - info structure
  *   u_int32_t brk_dst_ip -  IPaddress of the lost neighbour
  *
@@ -80,7 +93,46 @@
  *   int - 0 on success
  *        -1 on failure
  */
-int link_break(struct info* tmp_info, u_int32_t brk_dst_ip);
+int link_break(struct aodv_node *node, struct info* tmp_info,
+	       u_int32_t brk_dst_ip);
+
+/*
+ * local_repair
+ *
+ * Description: 
+ *   Called when data for a destination arrives. If the route to it is
+ *   marked RT_REPAIR by link_break, and no RREQ for it is under way,
+ *   gen_rreq sends a single RREQ with the TTL of the last hop count plus
+ *   LOCAL_ADD_TTL. The mark is removed when a RREP or HELLO from the
+ *   destination comes, or by repair_failed.
+ *
+ * Arguments: 
+ *   struct aodv_node *node - The node.
+ *   u_int32_t dst_ip - Destination of the data.
+ *
+ * Returns: 
+ *   int - 0 if the route is being repaired, the data should wait
+ *        -1 if not
+ */
+int local_repair(struct aodv_node *node, u_int32_t dst_ip);
+
+/*
+ * repair_failed
+ *
+ * Description: 
+ *   Ends the local repair of a route when its RREQ has timed out. If
+ *   the route is still broken a RERR for it is sent to its precursors,
+ *   as link_break would have done.
+ *
+ * Arguments: 
+ *   struct aodv_node *node - The node.
+ *   struct artentry *rt - The route.
+ *
+ * Returns: 
+ *   int - 0 on success
+ *        -1 on failure
+ */
+int repair_failed(struct aodv_node *node, struct artentry *rt);
 
 /*
  * host_unr
@@ -91,6 +143,7 @@ int link_break(struct info* tmp_info, u_int32_t brk_dst_ip);
  *   message is created to inform neighbours.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   struct info *tmp_info - info structure
  *   u_int32_t brk_dst_ip - IPaddress of the unreachable destination
  *
@@ -98,7 +151,8 @@ int link_break(struct info* tmp_info, u_int32_t brk_dst_ip);
  *   int - 0 on success
  *        -1 on failure
  */
-int host_unr(struct info* tmp_info, u_int32_t brk_dst_ip);
+int host_unr(struct aodv_node *node, struct info* tmp_info,
+	     u_int32_t brk_dst_ip);
 
 /*
  * rec_rerr
@@ -106,9 +160,12 @@ int host_unr(struct info* tmp_info, u_int32_t brk_dst_ip);
  * Description: 
  *   rec_rerr is called when the node receives a RERR packet from
  *   another node. If the precursor list for a broken destinations is
- *   not empty a new RERR is created for that destination.
+ *   not empty a new RERR is created for that destination. The sender is
+ *   no longer an alternate next hop to the destinations, and a route
+ *   with an alternate left switches to it instead of breaking.
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   struct info *tmp_info - info structure
  *   struct rrerhdr *tmp_rerrhdr - pointer to the incoming RERR message
  *
@@ -116,7 +173,8 @@ int host_unr(struct info* tmp_info, u_int32_t brk_dst_ip);
  *   int - 0 on success
  *        -1 on failure
  */
-int rec_rerr(struct info *tmp_info, struct rerrhdr *tmp_rerrhdr);
+int rec_rerr(struct aodv_node *node, struct info *tmp_info,
+	     struct rerrhdr *tmp_rerrhdr);
 
 /*
  * create_rerrhdr
@@ -158,7 +216,7 @@ int append_unr_dst(struct rerrhdr *tmp_rerrhdr,
  *
  * Description: 
  *   route_expiry invalidates an active route, i e an entry
- *   in the routing table.
+ *   in the routing table. Its alternate next hops are dropped.
  *
  * Arguments: 
  *   struct artentry *tmp_rtentry - Pointer to the entry
@@ -0,0 +1,332 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *	  Bounded single-producer/single-consumer ring of fixed size
+ *        elements. Exactly one thread may push and exactly one thread may
+ *        pop, no locks are taken on either side. A consumer that wants to
+ *        sleep announces it with ring_prepare_wait and then waits on the
+ *        file descriptor from ring_notifyfd, the producer only writes to
+ *        that pipe when the consumer actually sleeps.
+ *
+ *	Internal procedures:
+ *
+ *	External procedures:
+ *	  ring_init
+ *	  ring_push
+ *	  ring_reserve
+ *	  ring_commit
+ *	  ring_pop
+ *	  ring_occupancy
+ *	  ring_notifyfd
+ *	  ring_prepare_wait
+ *	  ring_drainnotify
+ *	  ring_print
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "ring.h"
+
+/*
+ *   ring_init
+ *
+ *   Description:
+ *     Allocates the slots of a ring and creates the wakeup pipe.
+ *
+ *   Arguments:
+ *     struct ring *r      - The ring to initialize.
+ *     const char *name    - Name of the ring, used by ring_print.
+ *     u_int32_t nslots    - Number of slots, must be a power of two.
+ *     u_int32_t elemsz    - Size in bytes of one element.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+ring_init(struct ring *r, const char *name, u_int32_t nslots,
+	  u_int32_t elemsz)
+{
+  /* The index arithmetic needs a power of two */
+  if (nslots == 0 || (nslots & (nslots - 1)) != 0)
+    return -1;
+
+  memset(r, 0, sizeof(struct ring));
+
+  if ((r->slots = malloc(nslots * elemsz)) == NULL)
+    /* Failed to allocate memory */
+    return -1;
+
+  if (pipe(r->notify) < 0)
+    return -1;
+
+  /* Neither end may block, a full pipe already means "wake up" */
+  fcntl(r->notify[0], F_SETFL, O_NONBLOCK);
+  fcntl(r->notify[1], F_SETFL, O_NONBLOCK);
+
+  r->mask = nslots - 1;
+  r->elemsz = elemsz;
+  r->name = name;
+
+  return 0;
+}
+
+/*
+ *   ring_push
+ *
+ *   Description:
+ *     Copies an element into the ring and wakes the consumer if it
+ *     sleeps. May only be called from the producer thread.
+ *
+ *   Arguments:
+ *     struct ring *r   - The ring.
+ *     const void *elem - The element to copy in (elemsz bytes).
+ *
+ *   Return:
+ *     int - 0 if the element was queued, -1 if the ring was full and the
+ *           element was dropped.
+ */
+int
+ring_push(struct ring *r, const void *elem)
+{
+  void *slot;
+
+  if ((slot = ring_reserve(r)) == NULL)
+    return -1;
+
+  memcpy(slot, elem, r->elemsz);
+  ring_commit(r);
+
+  return 0;
+}
+
+/*
+ *   ring_reserve
+ *
+ *   Description:
+ *     Returns the next free slot so the producer can fill it in place.
+ *     The slot is not visible to the consumer until ring_commit is
+ *     called. May only be called from the producer thread.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return:
+ *     void* - Pointer to the slot (elemsz bytes), NULL if the ring was
+ *             full. A full ring counts as a drop.
+ */
+void *
+ring_reserve(struct ring *r)
+{
+  u_int32_t head;
+  u_int32_t tail;
+
+  tail = r->tail;
+  head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+  if (tail - head > r->mask)
+    {
+      /* Full, drop the element */
+      r->drops++;
+      return NULL;
+    }
+
+  return r->slots + (tail & r->mask) * r->elemsz;
+}
+
+/*
+ *   ring_commit
+ *
+ *   Description:
+ *     Publishes the slot returned by the last ring_reserve and wakes the
+ *     consumer if it sleeps.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return: None
+ */
+void
+ring_commit(struct ring *r)
+{
+  u_int32_t head;
+  u_int32_t tail;
+  char wake = 0;
+
+  tail = r->tail + 1;
+
+  /* Publish the slot. This store and the load of waiting below must not
+     be reordered, or a consumer going to sleep could miss it */
+  __atomic_store_n(&r->tail, tail, __ATOMIC_SEQ_CST);
+
+  head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+  r->pushed++;
+  if (tail - head > r->hiwater)
+    r->hiwater = tail - head;
+
+  if (__atomic_load_n(&r->waiting, __ATOMIC_SEQ_CST) &&
+      __atomic_exchange_n(&r->waiting, 0, __ATOMIC_SEQ_CST))
+    write(r->notify[1], &wake, 1);
+}
+
+/*
+ *   ring_pop
+ *
+ *   Description:
+ *     Copies the oldest element out of the ring. May only be called
+ *     from the consumer thread.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *     void *elem     - Where to copy the element (elemsz bytes).
+ *
+ *   Return:
+ *     int - 0 if an element was popped, -1 if the ring was empty.
+ */
+int
+ring_pop(struct ring *r, void *elem)
+{
+  u_int32_t head;
+  u_int32_t tail;
+
+  head = r->head;
+  tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+
+  if (head == tail)
+    /* Empty */
+    return -1;
+
+  memcpy(elem, r->slots + (head & r->mask) * r->elemsz, r->elemsz);
+
+  /* Give the slot back to the producer */
+  __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+
+  return 0;
+}
+
+/*
+ *   ring_occupancy
+ *
+ *   Description:
+ *     Returns the number of elements currently queued.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return:
+ *     u_int32_t - Number of queued elements.
+ */
+u_int32_t
+ring_occupancy(struct ring *r)
+{
+  return __atomic_load_n(&r->tail, __ATOMIC_SEQ_CST) -
+    __atomic_load_n(&r->head, __ATOMIC_SEQ_CST);
+}
+
+/*
+ *   ring_notifyfd
+ *
+ *   Description:
+ *     Returns the file descriptor that becomes readable when the
+ *     producer wakes the consumer. Suitable for select.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return:
+ *     int - The read end of the wakeup pipe.
+ */
+int
+ring_notifyfd(struct ring *r)
+{
+  return r->notify[0];
+}
+
+/*
+ *   ring_prepare_wait
+ *
+ *   Description:
+ *     Tells the producer that the consumer is going to sleep on the
+ *     notify descriptor. Must be called by the consumer before it
+ *     blocks. If elements arrived in the meantime the wait is cancelled.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return:
+ *     int - 0 if it is safe to sleep, -1 if the ring is not empty.
+ */
+int
+ring_prepare_wait(struct ring *r)
+{
+  __atomic_store_n(&r->waiting, 1, __ATOMIC_SEQ_CST);
+
+  if (ring_occupancy(r) != 0)
+    {
+      /* Something arrived before the producer could see the flag */
+      __atomic_store_n(&r->waiting, 0, __ATOMIC_SEQ_CST);
+      return -1;
+    }
+
+  return 0;
+}
+
+/*
+ *   ring_drainnotify
+ *
+ *   Description:
+ *     Empties the wakeup pipe after the consumer has woken up.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return: None
+ */
+void
+ring_drainnotify(struct ring *r)
+{
+  char buf[64];
+
+  while (read(r->notify[0], buf, sizeof(buf)) > 0)
+    ;
+}
+
+/*
+ *   ring_print
+ *
+ *   Description:
+ *     Prints occupancy, high water mark and drop counters of a ring.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return: None
+ */
+void
+ring_print(struct ring *r)
+{
+  printf("%-10s %5u/%-5u hiwater: %-5u pushed: %-10lu drops: %lu\n",
+	 r->name, ring_occupancy(r), r->mask + 1, r->hiwater,
+	 r->pushed, r->drops);
+}
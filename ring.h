@@ -0,0 +1,241 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *	  Bounded single-producer/single-consumer ring of fixed size
+ *        elements. Exactly one thread may push and exactly one thread may
+ *        pop, no locks are taken on either side. A consumer that wants to
+ *        sleep announces it with ring_prepare_wait and then waits on the
+ *        file descriptor from ring_notifyfd, the producer only writes to
+ *        that pipe when the consumer actually sleeps.
+ *
+ *	Internal procedures:
+ *
+ *	External procedures:
+ *	  ring_init
+ *	  ring_push
+ *	  ring_reserve
+ *	  ring_commit
+ *	  ring_pop
+ *	  ring_occupancy
+ *	  ring_notifyfd
+ *	  ring_prepare_wait
+ *	  ring_drainnotify
+ *	  ring_print
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+
+/* Size of a cache line, keeps producer and consumer indexes apart */
+#define RING_CACHELINE 64
+
+/* The ring */
+struct ring
+{
+  /* Written by the consumer */
+  volatile u_int32_t head;    /* Next slot to pop */
+  volatile int waiting;       /* Set when the consumer is about to sleep */
+  char pad1[RING_CACHELINE - sizeof(u_int32_t) - sizeof(int)];
+
+  /* Written by the producer */
+  volatile u_int32_t tail;    /* Next slot to push */
+  u_int32_t hiwater;          /* Highest occupancy seen */
+  unsigned long pushed;       /* Number of pushed elements */
+  unsigned long drops;        /* Number of elements dropped on full ring */
+  char pad2[RING_CACHELINE - 2 * sizeof(u_int32_t) -
+	    2 * sizeof(unsigned long)];
+
+  /* Set by ring_init, read only after that */
+  u_int32_t mask;             /* Number of slots - 1 */
+  u_int32_t elemsz;           /* Size of one element */
+  int notify[2];              /* Pipe used to wake a sleeping consumer */
+  const char *name;           /* Name used when printing statistics */
+  char *slots;                /* The element storage */
+};
+
+
+/*
+ *   ring_init
+ *
+ *   Description:
+ *     Allocates the slots of a ring and creates the wakeup pipe.
+ *
+ *   Arguments:
+ *     struct ring *r      - The ring to initialize.
+ *     const char *name    - Name of the ring, used by ring_print.
+ *     u_int32_t nslots    - Number of slots, must be a power of two.
+ *     u_int32_t elemsz    - Size in bytes of one element.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int ring_init(struct ring *r, const char *name, u_int32_t nslots,
+	      u_int32_t elemsz);
+
+/*
+ *   ring_push
+ *
+ *   Description:
+ *     Copies an element into the ring and wakes the consumer if it
+ *     sleeps. May only be called from the producer thread.
+ *
+ *   Arguments:
+ *     struct ring *r   - The ring.
+ *     const void *elem - The element to copy in (elemsz bytes).
+ *
+ *   Return:
+ *     int - 0 if the element was queued, -1 if the ring was full and the
+ *           element was dropped.
+ */
+int ring_push(struct ring *r, const void *elem);
+
+/*
+ *   ring_reserve
+ *
+ *   Description:
+ *     Returns the next free slot so the producer can fill it in place.
+ *     The slot is not visible to the consumer until ring_commit is
+ *     called. May only be called from the producer thread.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return:
+ *     void* - Pointer to the slot (elemsz bytes), NULL if the ring was
+ *             full. A full ring counts as a drop.
+ */
+void *ring_reserve(struct ring *r);
+
+/*
+ *   ring_commit
+ *
+ *   Description:
+ *     Publishes the slot returned by the last ring_reserve and wakes the
+ *     consumer if it sleeps.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return: None
+ */
+void ring_commit(struct ring *r);
+
+/*
+ *   ring_pop
+ *
+ *   Description:
+ *     Copies the oldest element out of the ring. May only be called
+ *     from the consumer thread.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *     void *elem     - Where to copy the element (elemsz bytes).
+ *
+ *   Return:
+ *     int - 0 if an element was popped, -1 if the ring was empty.
+ */
+int ring_pop(struct ring *r, void *elem);
+
+/*
+ *   ring_occupancy
+ *
+ *   Description:
+ *     Returns the number of elements currently queued.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return:
+ *     u_int32_t - Number of queued elements.
+ */
+u_int32_t ring_occupancy(struct ring *r);
+
+/*
+ *   ring_notifyfd
+ *
+ *   Description:
+ *     Returns the file descriptor that becomes readable when the
+ *     producer wakes the consumer. Suitable for select.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return:
+ *     int - The read end of the wakeup pipe.
+ */
+int ring_notifyfd(struct ring *r);
+
+/*
+ *   ring_prepare_wait
+ *
+ *   Description:
+ *     Tells the producer that the consumer is going to sleep on the
+ *     notify descriptor. Must be called by the consumer before it
+ *     blocks. If elements arrived in the meantime the wait is cancelled.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return:
+ *     int - 0 if it is safe to sleep, -1 if the ring is not empty.
+ */
+int ring_prepare_wait(struct ring *r);
+
+/*
+ *   ring_drainnotify
+ *
+ *   Description:
+ *     Empties the wakeup pipe after the consumer has woken up.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return: None
+ */
+void ring_drainnotify(struct ring *r);
+
+/*
+ *   ring_print
+ *
+ *   Description:
+ *     Prints occupancy, high water mark and drop counters of a ring.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return: None
+ */
+void ring_print(struct ring *r);
+
+#endif
@@ -23,6 +23,7 @@
  *          Receives Route Reply
  *
  *      Internal procedures:
+ *          forward_alt_rrep(struct rrep, struct artentry)
  *      
  *      External procedures:
  *          rec_rrep(struct info, struct rrep)
@@ -34,13 +35,22 @@
  */
 #include "rrep.h"
 
+/* Pre-declaration of internal function */
+int forward_alt_rrep(struct aodv_node *node, struct info *my_info,
+		     struct rrep *my_rrep, struct artentry *rt);
+
 /*
  * rec_rrep
  *
  * Description:  
- *   Receives and handles RREP
+ *   Receives and handles RREP. In multipath mode a RREP that loses
+ *   to the route, or the next hop it replaces, is kept as an alternate
+ *   next hop, see add_alt_hop. The distance to the destination is
+ *   noted even if the RREP loses, see dist_learn. The source of the
+ *   RREQ measures its round trip, see rtt_sample.
  *
  * Arguments:    
+ *   struct aodv_node *node - The node.
  *   struct info *my_info - Pointer to the received information structure
  *   struct rrep *my_rrep - Pointer to the received route reply structure
  *
@@ -48,17 +58,36 @@
  *   int - 0 
  */
 int
-rec_rrep(struct info *my_info, struct rrep *my_rrep)
+rec_rrep(struct aodv_node *node, struct info *my_info, struct rrep *my_rrep)
 {
   u_int64_t        curr_time;
   struct artentry  *rt_src; 
   struct artentry  *rt;
+  struct rt_alt    old;         /* The route before, in multipath mode */
+  int              event = FLIGHT_RT_UPDATE;
+  struct prioqent  *pqe;
+  struct rreq_tdata *trd;
   
-  /* Remove RREQ from resend-queue */
-  pq_deleteidflags(my_rrep->dst_ip, PQ_PACKET_RREQ);
+  dist_learn(node, my_rrep->dst_ip, my_rrep->hop_cnt + 1);
+
+  /* Remove RREQ from resend-queue, the queue doesn't free the RREQ.
+     The source measures the round trip of a RREQ sent once, when the
+     destination answered it */
+  while ((pqe = pq_getfirstofidflags(&node->pq, my_rrep->dst_ip,
+				     PQ_PACKET_RREQ)) != NULL)
+    {
+      trd = pqe->data;
+      if (trd->sent != 0 && my_rrep->src_ip == my_info->ip_pkt_my_ip &&
+	  (my_rrep->reserved & RREP_FROM_DST))
+	rtt_sample(node, getcurrtime() - trd->sent, my_rrep->hop_cnt + 1);
+      free(trd->rd);
+      free(trd);
+      pq_deleteent(&node->pq, pqe);
+    }
 
   /* Get entry from Routing Table */
-  rt = getentry(my_rrep->dst_ip); 
+  rt = getentry(node, my_rrep->dst_ip); 
+  memset(&old, 0, sizeof(struct rt_alt));
 
   /* Check if there were an entry in the RT */
   if (rt != NULL)
@@ -69,15 +98,34 @@ rec_rrep(struct info *my_info, struct rrep *my_rrep)
 	  if(rt->dst_seq != my_rrep->dst_seq)
 	    return 0;
 
-	  else if(my_rrep->hop_cnt > rt->hop_cnt)
-	    return 0;
+	  /* Cost of the routes on, the hop count unless the node uses
+	     METRIC_ETX */
+	  else if(nb_cost(node, my_info->ip_pkt_src_ip, my_rrep->hop_cnt + 1)
+		  > nb_cost(node, rt->nxt_hop, rt->hop_cnt + 1))
+	    {
+	      /* In multipath mode kept as an alternate, and passed on
+		 over another way back to the source */
+	      if (node->multipath &&
+		  add_alt_hop(rt, my_info->ip_pkt_src_ip, my_rrep->hop_cnt + 1,
+			      getcurrtime() + my_rrep->lifetime) == 0)
+		forward_alt_rrep(node, my_info, my_rrep, rt);
+	      return 0;
+	    }
+
+	  /* The replaced next hop may still serve as an alternate */
+	  old.nxt_hop = rt->nxt_hop;
+	  old.hop_cnt = rt->hop_cnt;
+	  old.lifetime = rt->lifetime;
 	}
+      else
+	clear_alt_hops(rt);
       del_kroute(rt->dst_ip, rt->nxt_hop);
     }
   else
     {
       /* No entry in RT found, generate a new */
-      rt = insert_entry();
+      rt = insert_entry(node);
+      event = FLIGHT_RT_INSERT;
       rt->dst_ip = my_rrep->dst_ip;
       rt->dst_seq = 0;
       rt->broadcast_id = 0;
@@ -93,6 +141,11 @@ rec_rrep(struct info *my_info, struct rrep *my_rrep)
   curr_time = getcurrtime();    /* Get current time */
   rt->lifetime = curr_time + my_rrep->lifetime;
   rt->dst_seq = my_rrep->dst_seq;
+  rt->rt_flags &= ~RT_REPAIR;   /* A local repair is over */
+  trim_alt_hops(rt);
+  if (node->multipath && old.nxt_hop != 0)
+    add_alt_hop(rt, old.nxt_hop, old.hop_cnt, old.lifetime);
+  flight_event(event, rt->dst_ip, rt->nxt_hop, rt->hop_cnt, rt->dst_seq);
   
   if(add_kroute(rt->dst_ip, rt->nxt_hop))
     {
@@ -108,7 +161,10 @@ rec_rrep(struct info *my_info, struct rrep *my_rrep)
       my_rrep->hop_cnt = my_rrep->hop_cnt + 1;
       
       /* Get the entry to the source from RT */
-      rt_src = getentry(my_rrep->src_ip); 
+      rt_src = getentry(node, my_rrep->src_ip); 
+      if (rt_src == NULL)
+	/* The reverse route is gone, the source will resend its RREQ */
+	return 0;
 
       /* Add to precursors... */
       if (add_precursor(rt, rt_src->nxt_hop) == -1)
@@ -118,7 +174,7 @@ rec_rrep(struct info *my_info, struct rrep *my_rrep)
       rt->lifetime = curr_time + ACTIVE_ROUTE_TIMEOUT;
       my_info->ip_pkt_dst_ip = rt_src->nxt_hop;
 
-      if (send_datagram(my_info, my_rrep, sizeof(struct rrep)) == -1)
+      if (send_datagram(node, my_info, my_rrep, sizeof(struct rrep)) == -1)
 	{
 	  /* Couldn't send RREP. Ignore and let source resend RREQ */
 	}
@@ -126,3 +182,58 @@ rec_rrep(struct info *my_info, struct rrep *my_rrep)
   
   return 0;
 }
+
+/*
+ * forward_alt_rrep
+ *
+ * Description:  
+ *   Forwards a RREP that gave a new alternate next hop over an
+ *   alternate way back to the source, as the RREP that set up the route
+ *   went over the first. The nodes on it learn the alternate too, the
+ *   k:th alternate of the route goes over the k:th way back.
+ *
+ * Arguments:    
+ *   struct aodv_node *node - The node.
+ *   struct info *my_info - Pointer to the received information structure
+ *   struct rrep *my_rrep - Pointer to the received route reply structure
+ *   struct artentry *rt - The route the RREP is for
+ *
+ * Return:
+ *   int - 0 if the RREP was forwarded
+ *        -1 if there was no way to forward it
+ */
+int
+forward_alt_rrep(struct aodv_node *node, struct info *my_info,
+		 struct rrep *my_rrep, struct artentry *rt)
+{
+  struct artentry  *rt_src;
+  u_int32_t        via;
+
+  if (my_rrep->src_ip == my_info->ip_pkt_my_ip)
+    /* The source itself */
+    return -1;
+
+  rt_src = getentry(node, my_rrep->src_ip);
+  if (rt_src == NULL || rt_src->hop_cnt == 255 || rt_src->alt_cnt == 0)
+    return -1;
+
+  via = rt_src->alt[(rt->alt_cnt - 1) % rt_src->alt_cnt].nxt_hop;
+  if (via == my_info->ip_pkt_src_ip)
+    /* Would go back where it came from */
+    return -1;
+
+  if (add_precursor(rt, via) == -1)
+    {
+      /* Couldn't add precursor. Ignore and continue */
+    }
+
+  my_info->ip_pkt_ttl = 1;
+  my_info->ip_pkt_src_ip = my_info->ip_pkt_my_ip;
+  my_info->ip_pkt_dst_ip = via;
+
+  /* The hop count of the route, never less than that of any of its
+     next hops, so no loop is formed */
+  my_rrep->hop_cnt = rt->hop_cnt;
+
+  return send_datagram(node, my_info, my_rrep, sizeof(struct rrep));
+}
@@ -23,6 +23,7 @@
  *          Receives Route Reply
  *
  *      Internal procedures:
+ *          forward_alt_rrep(struct rrep, struct artentry)
  *      
  *      External procedures:
  *          rec_rrep(struct info, struct rrep)
@@ -49,21 +50,31 @@
 #include "aodv.h"
 #include "utils.h"
 #include "timer.h"
+#include "to_rreq.h"
 #include "krtable.h"
+#include "neighbour.h"
+#include "dist.h"
+#include "rtt.h"
 
 /*
  * rec_rrep
  *
  * Description:  
- *   Receives and handles RREP
+ *   Receives and handles RREP. In multipath mode a RREP that loses
+ *   to the route, or the next hop it replaces, is kept as an alternate
+ *   next hop, see add_alt_hop. The distance to the destination is
+ *   noted even if the RREP loses, see dist_learn. The source of the
+ *   RREQ measures its round trip, see rtt_sample.
  *
  * Arguments:    
+ *   struct aodv_node *node - The node.
  *   struct info *my_info - Pointer to the received information structure
  *   struct rrep *my_rrep - Pointer to the received route reply structure
  *
  * Return:
  *   int - 0 
  */
-int rec_rrep(struct info *my_info, struct rrep *my_rrep);
+int rec_rrep(struct aodv_node *node, struct info *my_info,
+	     struct rrep *my_rrep);
 
 #endif
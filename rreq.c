@@ -26,11 +26,26 @@
  *        is for it self, or it has an active route, it sends
  *        back a reply. Otherwise it forwards to requst to a
  *        new broadcast. 
+ *        With a forward limit the broadcast waits a random jitter and
+ *        is dropped if enough copies from other neighbours arrive
+ *        meanwhile.
+ *        In gossip mode a node further than GOSSIP_HOPS from the source
+ *        rebroadcasts with a probability that falls with the number of
+ *        its neighbours.
+ *        In relay mode only the relays a neighbour elected from its
+ *        two-hop neighbours rebroadcast what it sends, see
+ *        nb_select_relays.
  *
  *      Internal procedures:
+ *        forward_rreq(struct aodv_node*, struct info*, struct rreq*,
+ *                     struct artentry*)
+ *        queue_forward(struct aodv_node*, struct info*, struct rreq*, int)
+ *        gossip_hold(struct aodv_node*, int)
  *      
  *      External procedures:
  *        rec_rreq(struct info, struct rreq)
+ *        rreq_forward(struct aodv_node*, struct rreq_fdata*)
+ *        print_fwd(struct aodv_node*)
  *
  ********************************
  *
@@ -40,6 +55,13 @@
 
 #include "rreq.h"
 
+/* Pre-declaration of internal functions */
+int forward_rreq(struct aodv_node *node, struct info *inf,
+		 struct rreq *in_rreq, struct artentry *rte);
+int queue_forward(struct aodv_node *node, struct info *inf,
+		  struct rreq *out_rreq, int held);
+int gossip_hold(struct aodv_node *node, int hop_cnt);
+
 /*
  * rec_rreq
  *
@@ -50,9 +72,16 @@
  *   it self, or a destination that there already exists
  *   a route that isn't too old.
  *   It then calls the right functions, either a route reply
- *   or retransmits the route request in broadcast.
+ *   or retransmits the route request in broadcast, with a forward
+ *   limit after a jitter (see queue_forward). Each copy seen before is
+ *   counted against the limit. In multipath mode a copy seen before
+ *   can still give another way back to the source, see
+ *   update_reverse_alt. In relay mode a RREQ is rebroadcast only from
+ *   a neighbour that elected the node (see nb_relay), the first such
+ *   copy counts.
  *
  * Arguments:    
+ *   struct aodv_node *node - The node.
  *   struct info *inf - The information structure containing information on
  *                      IP-level such as IP-addresses.
  *   struct rreq *in_rreq - Structure that contains the informations about
@@ -63,12 +92,10 @@
  *        -1 - if memory couldn't be allocated
  */
 int
-rec_rreq(struct info *inf, struct rreq *in_rreq)
+rec_rreq(struct aodv_node *node, struct info *inf, struct rreq *in_rreq)
 {
-  struct rreq       *out_rreq;  /* Forwarded RREQ */
   struct artentry   *rte;       /* Routing table entry */
   struct rreq_entry *tmp_rreq_entry; /* Routing request list entry */
-  struct info       *out_info;  /* Outgoing information struct */
   u_int32_t          source_ip = in_rreq->src_ip;  /* RREQ sender IP */
   u_int32_t          dest_ip = in_rreq->dst_ip;    /* RREQ destination IP */
   u_int32_t          broadc_id = in_rreq->broadcast_id; /* Broadcast id */
@@ -77,22 +104,23 @@ rec_rreq(struct info *inf, struct rreq *in_rreq)
   /* Update the hop count */
   in_rreq->hop_cnt++;
 
-  /* This code takes care of HELLO messages.
-   * If the destination ip in the RREQ is broadcast, change it to my ip 
-   * and reply */
+  /* This code takes care of the HELLO messages of older versions, which
+   * sent a RREQ for the broadcast address and took the answers of their
+   * neighbours. If the destination ip in the RREQ is broadcast, change
+   * it to my ip and reply */
 
   if (dest_ip == inet_addr("255.255.255.255"))
     {
       in_rreq->dst_ip = inf->ip_pkt_my_ip;
-      update_reverse(inf, in_rreq);
+      update_reverse(node, inf, in_rreq);
       
-      gen_rrep(inf, in_rreq);
+      gen_rrep(node, inf, in_rreq);
       return(0);
     }
   
   /* Look in the route request list to see if the node has 
      already received this request. */
-  tmp_rreq_entry = find_rreq(source_ip, broadc_id);
+  tmp_rreq_entry = find_rreq(node, source_ip, broadc_id);
   
   current_time = getcurrtime(); /* Get the current time */
   
@@ -102,40 +130,29 @@ rec_rreq(struct info *inf, struct rreq *in_rreq)
   if (!((tmp_rreq_entry != NULL) && 
 	(tmp_rreq_entry->lifetime > current_time)))
     { 
-      /* Have not received this RREQ within BCAST_ID_SAVE time */
+      /* Have not received this RREQ within broadcast_record_time */
 
       /* Add this RREQ to the list for further checks */
-      if (add_rreq(source_ip, broadc_id, current_time + BCAST_ID_SAVE) == -1)
+      if (add_rreq(node, source_ip, broadc_id,
+		   current_time + broadcast_record_time(node)) == -1)
 	{	
 	  /* Couldn't add the entry, ignore and continue */
 	}
       
       /* Look up in the routing table if there already is a route 
          to this destination */
-      rte = getentry(dest_ip);
+      rte = getentry(node, dest_ip);
       
       /* UPDATE REVERSE */
-      update_reverse(inf, in_rreq);
-      
-      /* Allocate memory for the info struct to the outgoing package */
-      if ((out_info = (struct info*) malloc(sizeof (struct info))) == NULL)
-	/* Failed to allocate memory for out_info. */
-	return -1;
-      
-      /* Set the informtion struct */
-      out_info->ip_pkt_my_ip = inf->ip_pkt_my_ip;
-      out_info->ip_pkt_src_ip = inf->ip_pkt_my_ip;
-      out_info->ip_pkt_dst_ip = inf->ip_pkt_src_ip;
-      out_info->ip_pkt_ttl = inf->ip_pkt_ttl;
+      update_reverse(node, inf, in_rreq);
       
       /* Check if the request was for this node */
       if (dest_ip == inf->ip_pkt_my_ip) 
 	{ 
 	  /* The RREQ was destined to this node */
 	  /* Call for gen_rrep to send a Route Reply */
-	  gen_rrep(inf, in_rreq);
+	  gen_rrep(node, inf, in_rreq);
 	  
-	  free(out_info);
 	  return 0;
 	}
       else
@@ -153,60 +170,353 @@ rec_rreq(struct info *inf, struct rreq *in_rreq)
 	      /* The node already had a valid route to the destination */
 
 	      /* Call for gen_rrep to send a Route Reply */
-	      gen_rrep(inf, in_rreq);
+	      gen_rrep(node, inf, in_rreq);
+
+	      return 0;
+	    }
+	  else if (node->mpr && inf->ip_pkt_ttl > 1 &&
+		   !nb_relay(node, inf->ip_pkt_src_ip))
+	    {
+	      /* In relay mode the node leaves it to the relays of the
+		 neighbour, unless a copy from one that elected it comes */
+	      if ((tmp_rreq_entry = find_rreq(node, source_ip,
+					      broadc_id)) != NULL)
+		tmp_rreq_entry->relay = 1;
+	      node->mpr_dropped++;
 
-	      free(out_info);
 	      return 0;
 	    }
 	  else
+	    /* The node didn't have a valid route to the destination */
+	    return forward_rreq(node, inf, in_rreq, rte) == -1 ? -1 : 0;
+	}
+    }
+  else
+    {
+      /* Seen within broadcast_record_time, dropped. The copy counts against
+	 a rebroadcast still waiting in queue_forward. If it came a
+	 shorter way the rebroadcast takes its ttl and hop count, or the
+	 jitter would shrink the ring of an expanding ring search */
+      tmp_rreq_entry->copies++;
+      if (tmp_rreq_entry->ttl >= 0 &&
+	  inf->ip_pkt_ttl - 1 > tmp_rreq_entry->ttl)
+	{
+	  tmp_rreq_entry->ttl = inf->ip_pkt_ttl - 1;
+	  tmp_rreq_entry->hop_cnt = in_rreq->hop_cnt;
+	  update_reverse(node, inf, in_rreq);
+	}
+      flight_event(FLIGHT_RREQ_DUP, source_ip, dest_ip, broadc_id, 0);
+
+      /* The first copy came from a neighbour that didn't elect this
+	 node, this one from a neighbour that did. It counts as dropped
+	 until it is sent or queued, a later copy may still have ttl */
+      if (tmp_rreq_entry->relay && nb_relay(node, inf->ip_pkt_src_ip))
+	{
+	  update_reverse(node, inf, in_rreq);
+	  if (forward_rreq(node, inf, in_rreq, getentry(node, dest_ip)) == 0)
 	    {
-	      /* The node didn't have a valid route to the destination */
-
-	      /* Decreas the ttl and check if it reaches 0.
-	         If so, throw the request */
-	      if ((out_info->ip_pkt_ttl = inf->ip_pkt_ttl - 1) == 0)
-		{
-		  free(out_info);
-		  
-		  return 0;
-		}
-	      
-	      /* Allocate memory for a new RREQ */
-	      if ((out_rreq = (struct rreq*) 
-		   malloc(sizeof (struct rreq))) == NULL)
-		/* Failed to allocate memory for forwarded RREQ */
-		return -1;
+	      tmp_rreq_entry->relay = 0;
+	      node->mpr_dropped--;
+	    }
+	}
+
+      /* In multipath mode the copy may show another way back to the
+	 source. The destination answers over each such way, so the
+	 source learns routes through different neighbours */
+      if (node->multipath && update_reverse_alt(node, inf, in_rreq) == 0 &&
+	  dest_ip == inf->ip_pkt_my_ip)
+	gen_rrep(node, inf, in_rreq);
+    }
+  
+  return 0;
+}
+
+/*
+ * forward_rreq
+ *
+ * Description:
+ *   Rebroadcasts a RREQ the node has no route for, with one hop more and
+ *   one ttl less. With a forward limit or held by gossip it is queued,
+ *   see queue_forward.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   struct info *inf       - The information struct of the RREQ.
+ *   struct rreq *in_rreq   - The RREQ, its hop count already increased.
+ *   struct artentry *rte   - The route to the destination or NULL.
+ *
+ * Return:
+ *   int - 0 if the RREQ was sent or queued
+ *         1 if its ttl ran out
+ *        -1 if memory couldn't be allocated
+ */
+int
+forward_rreq(struct aodv_node *node, struct info *inf, struct rreq *in_rreq,
+	     struct artentry *rte)
+{
+  struct rreq       *out_rreq;  /* Forwarded RREQ */
+  struct info       *out_info;  /* Outgoing information struct */
+  int                held;      /* Left to the neighbours by gossip */
+  int                ret = 0;
+
+  /* Decreas the ttl and check if it reaches 0. If so, throw the
+     request. A rebroadcast that waits may still get ttl from a later
+     copy, see rreq_forward */
+  if (inf->ip_pkt_ttl - 1 == 0 && node->fwd_limit == 0)
+    return 1;
+
+  /* Allocate memory for the info struct to the outgoing package */
+  if ((out_info = (struct info*) malloc(sizeof (struct info))) == NULL)
+    /* Failed to allocate memory for out_info. */
+    return -1;
+      
+  /* Set the informtion struct, the destination IP to broadcast */
+  out_info->ip_pkt_my_ip = inf->ip_pkt_my_ip;
+  out_info->ip_pkt_src_ip = inf->ip_pkt_my_ip;
+  out_info->ip_pkt_dst_ip = inet_addr("255.255.255.255");
+  out_info->ip_pkt_ttl = inf->ip_pkt_ttl - 1;
+
+  /* In gossip mode the node may leave it to its neighbours */
+  held = node->gossip > 0 && gossip_hold(node, in_rreq->hop_cnt);
 	      
-	      /* Set the RREQ structure */
-	      out_rreq->type = 1;
-	      out_rreq->j = 0;
-	      out_rreq->r = 0;
-	      out_rreq->reserved = 0;
-	      out_rreq->hop_cnt = in_rreq->hop_cnt; /* Increased hopcount */
-	      out_rreq->broadcast_id = broadc_id;
-	      out_rreq->dst_ip = dest_ip;
-	      /* Set the right sequence number */
-	      if (rte)
-		out_rreq->dst_seq = MAX (in_rreq->dst_seq, rte->dst_seq);
-	      else
-		out_rreq->dst_seq = in_rreq->dst_seq;
-
-	      out_rreq->src_ip = source_ip;
-	      out_rreq->src_seq = in_rreq->src_seq;
+  /* Allocate memory for a new RREQ */
+  if ((out_rreq = (struct rreq*) malloc(sizeof (struct rreq))) == NULL)
+    {
+      /* Failed to allocate memory for forwarded RREQ */
+      free(out_info);
+      return -1;
+    }
 	      
-	      /* Set the destination IP to broadcast */
-	      out_info->ip_pkt_dst_ip = inet_addr("255.255.255.255");
+  /* Set the RREQ structure */
+  out_rreq->type = 1;
+  out_rreq->j = 0;
+  out_rreq->r = 0;
+  out_rreq->reserved = 0;
+  out_rreq->hop_cnt = in_rreq->hop_cnt; /* Increased hopcount */
+  out_rreq->broadcast_id = in_rreq->broadcast_id;
+  out_rreq->dst_ip = in_rreq->dst_ip;
+  /* Set the right sequence number */
+  if (rte)
+    out_rreq->dst_seq = MAX (in_rreq->dst_seq, rte->dst_seq);
+  else
+    out_rreq->dst_seq = in_rreq->dst_seq;
+
+  out_rreq->src_ip = in_rreq->src_ip;
+  out_rreq->src_seq = in_rreq->src_seq;
 	      
-	      /* Call send_datagram to send and forward the RREQ */
-	      send_datagram(out_info, out_rreq, sizeof(struct rreq)); 
+  /* A RREQ held by gossip or with a forward limit waits for the copies
+     of the other neighbours, see rreq_forward. Otherwise call
+     send_datagram to send and forward the RREQ */
+  if (held)
+    {
+      if (queue_forward(node, out_info, out_rreq, 1) == -1)
+	ret = -1;
+    }
+  else if (node->fwd_limit == 0 ||
+	   queue_forward(node, out_info, out_rreq, 0) == -1)
+    send_datagram(node, out_info, out_rreq, sizeof(struct rreq)); 
 
-	      free(out_rreq);
-	      free(out_info);
+  free(out_rreq);
+  free(out_info);
   
-	      return 0;
-	    }
-	}
+  return ret;
+}
+
+/*
+ * queue_forward
+ *
+ * Description:
+ *   Queues a RREQ to rebroadcast after a random jitter of up to
+ *   RREQ_JITTER ms, so that neighbours which got the same copy don't
+ *   send at once, and a node that hears enough copies from the others
+ *   meanwhile can drop its own. The ttl may be 0, a later copy can
+ *   still raise it. A RREQ held by gossip waits RREQ_JITTER ms more,
+ *   so the neighbours that rebroadcast at once are heard, and goes out
+ *   only if none is.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   struct info *inf       - The information struct of the broadcast.
+ *   struct rreq *out_rreq  - The RREQ to rebroadcast.
+ *   int held               - 1 if gossip_hold held it, else 0.
+ *
+ * Return:
+ *   int - 0 if queued
+ *        -1 if memory couldn't be allocated
+ */
+int
+queue_forward(struct aodv_node *node, struct info *inf, struct rreq *out_rreq,
+	      int held)
+{
+  struct rreq_fdata *fd;
+  struct rreq_entry *entry;
+
+  if ((fd = (struct rreq_fdata*) malloc(sizeof(struct rreq_fdata))) == NULL)
+    return -1;
+
+  memcpy(&fd->inf, inf, sizeof(struct info));
+  memcpy(&fd->rreq, out_rreq, sizeof(struct rreq));
+  fd->held = held;
+  fd->limit = held ? 1 : node->fwd_limit;
+
+  if (pq_insert(&node->pq, getcurrtime() + held * RREQ_JITTER +
+		node_random(node) % RREQ_JITTER,
+		fd, out_rreq->src_ip, PQ_PACKET_FWD) == -1)
+    {
+      free(fd);
+      return -1;
     }
-  
+
+  /* Later copies that came a shorter way raise these, see rec_rreq */
+  if ((entry = find_rreq(node, out_rreq->src_ip,
+			 out_rreq->broadcast_id)) != NULL)
+    {
+      entry->ttl = inf->ip_pkt_ttl;
+      entry->hop_cnt = out_rreq->hop_cnt;
+    }
+
+  return 0;
+}
+
+/*
+ * gossip_hold
+ *
+ * Description:
+ *   Decides if a node in gossip mode leaves a RREQ to its neighbours.
+ *   Within GOSSIP_HOPS of the source a RREQ is always rebroadcast.
+ *   Further out a node with GOSSIP_DEGREE neighbours rebroadcasts
+ *   gossip percent of the RREQs, one with more or fewer neighbours
+ *   scales that down or up (at most all), so about as many nodes
+ *   rebroadcast a RREQ in each neighbourhood. A node without known
+ *   neighbours always rebroadcasts. A held RREQ still goes out if no
+ *   neighbour rebroadcasts it, see queue_forward.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   int hop_cnt            - Hops from the source to the node.
+ *
+ * Return:
+ *   int - 1 if the RREQ is held
+ *         0 if it is rebroadcast
+ */
+int
+gossip_hold(struct aodv_node *node, int hop_cnt)
+{
+  int nbs;
+  int p;
+
+  if (hop_cnt <= GOSSIP_HOPS || (nbs = nb_count(node)) == 0)
+    return 0;
+
+  p = MIN(100, node->gossip * GOSSIP_DEGREE / nbs);
+  if (node_random(node) % 100 < (u_int64_t)p)
+    return 0;
+
+  node->gossip_held++;
+  return 1;
+}
+
+/*
+ * rreq_forward
+ *
+ * Description:
+ *   Rebroadcasts a RREQ queued by queue_forward, unless fwd_limit
+ *   copies of it, or one if gossip held it, were heard while it waited
+ *   (see find_rreq). It goes out with the ttl and hop count of the copy
+ *   that came the shortest way. Counts the rebroadcasts sent and
+ *   dropped.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   struct rreq_fdata *fd  - The RREQ and its information struct, freed.
+ *
+ * Return:
+ *   int - 0 if the RREQ was sent
+ *         1 if it was dropped
+ */
+int
+rreq_forward(struct aodv_node *node, struct rreq_fdata *fd)
+{
+  struct rreq_entry *entry;
+
+  entry = find_rreq(node, fd->rreq.src_ip, fd->rreq.broadcast_id);
+  if (entry != NULL && entry->ttl >= 0)
+    {
+      /* The best copy heard while waiting */
+      fd->inf.ip_pkt_ttl = entry->ttl;
+      fd->rreq.hop_cnt = entry->hop_cnt;
+      entry->ttl = -1;
+    }
+
+  if (fd->inf.ip_pkt_ttl == 0)
+    {
+      /* No copy left ttl to rebroadcast */
+      free(fd);
+      return 1;
+    }
+
+  if (entry != NULL && entry->copies >= fd->limit)
+    {
+      /* Enough neighbours rebroadcast it already */
+      flight_event(FLIGHT_RREQ_SUPP, fd->rreq.src_ip, fd->rreq.dst_ip,
+		   fd->rreq.broadcast_id, entry->copies);
+      if (fd->held)
+	node->gossip_dropped++;
+      else
+	node->fwd_suppressed++;
+      free(fd);
+      return 1;
+    }
+
+  send_datagram(node, &fd->inf, &fd->rreq, sizeof(struct rreq));
+  if (!fd->held)
+    node->fwd_sent++;
+  free(fd);
+
   return 0;
 }
+
+/*
+ * print_fwd
+ *
+ * Description:
+ *   Prints the relays and the RREQs left to them in relay mode, the
+ *   gossip percent and the RREQs gossip left to the neighbours, the
+ *   forward limit and the number of delayed rebroadcasts sent and
+ *   dropped.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return: None
+ */
+void
+print_fwd(struct aodv_node *node)
+{
+  struct nb_entry *nb;
+  int relays = 0;
+
+  if (node->mpr)
+    {
+      for (nb = node->nb_list; nb != NULL; nb = nb->next)
+	relays += nb->relay;
+      printf("Relay mode: %d relays, %llu RREQs left to the relays\n",
+	     relays, (unsigned long long)node->mpr_dropped);
+    }
+
+  if (node->gossip > 0)
+    printf("Gossip (%d%% at %d neighbours): %llu RREQs held, %llu not "
+	   "rebroadcast\n", node->gossip, GOSSIP_DEGREE,
+	   (unsigned long long)node->gossip_held,
+	   (unsigned long long)node->gossip_dropped);
+
+  if (node->fwd_limit == 0)
+    {
+      printf("RREQs are rebroadcast at once\n");
+      return;
+    }
+
+  printf("RREQ rebroadcasts (limit %d copies): %llu sent, %llu suppressed\n",
+	 node->fwd_limit, (unsigned long long)node->fwd_sent,
+	 (unsigned long long)node->fwd_suppressed);
+}
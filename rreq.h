@@ -26,11 +26,26 @@
  *          is for it self, or it has an active route, it sends
  *          back a reply. Otherwise it forwards to requst to a
  *          new broadcast. 
+ *          With a forward limit the broadcast waits a random jitter and
+ *          is dropped if enough copies from other neighbours arrive
+ *          meanwhile.
+ *          In gossip mode a node further than GOSSIP_HOPS from the source
+ *          rebroadcasts with a probability that falls with the number of
+ *          its neighbours.
+ *          In relay mode only the relays a neighbour elected from its
+ *          two-hop neighbours rebroadcast what it sends, see
+ *          nb_select_relays.
  *
  *      Internal procedures:
+ *          forward_rreq(struct aodv_node*, struct info*, struct rreq*,
+ *                       struct artentry*)
+ *          queue_forward(struct aodv_node*, struct info*, struct rreq*, int)
+ *          gossip_hold(struct aodv_node*, int)
  *      
  *      External procedures:
  *          rec_rreq(struct info, struct rreq)
+ *          rreq_forward(struct aodv_node*, struct rreq_fdata*)
+ *          print_fwd(struct aodv_node*)
  *
  ********************************
  *
@@ -52,6 +67,18 @@
 #include "gen_rrep.h"
 #include "rreq_list.h"
 #include "update_reverse.h"
+#include "neighbour.h"
+#include "node.h"
+#include "rtt.h"
+
+/* A RREQ waiting to be rebroadcast, see rreq_forward */
+struct rreq_fdata
+{
+  struct info inf;   /* Information struct of the broadcast */
+  struct rreq rreq;  /* The RREQ */
+  int limit;         /* Copies that stop it */
+  int held;          /* 1 if held by gossip_hold */
+};
 
 /*
  * rec_rreq
@@ -63,9 +90,16 @@
  *   it self, or a destination that there already exists
  *   a route that isn't too old.
  *   It then calls the right functions, either a route reply
- *   or retransmits the route request in broadcast.
+ *   or retransmits the route request in broadcast, with a forward
+ *   limit after a jitter (see queue_forward). Each copy seen before is
+ *   counted against the limit. In multipath mode a copy seen before
+ *   can still give another way back to the source, see
+ *   update_reverse_alt. In relay mode a RREQ is rebroadcast only from
+ *   a neighbour that elected the node (see nb_relay), the first such
+ *   copy counts.
  *
  * Arguments:    
+ *   struct aodv_node *node - The node.
  *   struct info *inf - The information structure containing information on
  *                      IP-level such as IP-addresses.
  *   struct rreq *in_rreq - Structure that contains the informations about
@@ -75,6 +109,42 @@
  *   int - 0 - if succesful
  *        -1 - if memory couldn't be allocated
  */
-int rec_rreq(struct info *inf, struct rreq *in_rreq);
+int rec_rreq(struct aodv_node *node, struct info *inf, struct rreq *in_rreq);
+
+/*
+ * rreq_forward
+ *
+ * Description:
+ *   Rebroadcasts a RREQ queued by queue_forward, unless fwd_limit
+ *   copies of it, or one if gossip held it, were heard while it waited
+ *   (see find_rreq). It goes out with the ttl and hop count of the copy
+ *   that came the shortest way. Counts the rebroadcasts sent and
+ *   dropped.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   struct rreq_fdata *fd  - The RREQ and its information struct, freed.
+ *
+ * Return:
+ *   int - 0 if the RREQ was sent
+ *         1 if it was dropped
+ */
+int rreq_forward(struct aodv_node *node, struct rreq_fdata *fd);
+
+/*
+ * print_fwd
+ *
+ * Description:
+ *   Prints the relays and the RREQs left to them in relay mode, the
+ *   gossip percent and the RREQs gossip left to the neighbours, the
+ *   forward limit and the number of delayed rebroadcasts sent and
+ *   dropped.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return: None
+ */
+void print_fwd(struct aodv_node *node);
 
 #endif
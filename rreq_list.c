@@ -25,12 +25,13 @@
  *          entered, looked up and removed here.
  * 
  *      Internal procedures:
- *          check_lifetime(struct rreq_entry)
+ *          check_lifetime(struct aodv_node*, struct rreq_entry*)
  *      
  *      External procedures:
- *          init_rreq_list()
- *          find_rreq(u_int32_t, u_int32_t)
- *          add_rreq(u_int32_t, u_int32_t, u_int64_t)
+ *          init_rreq_list(struct aodv_node*)
+ *          free_rreq_list(struct aodv_node*)
+ *          find_rreq(struct aodv_node*, u_int32_t, u_int32_t)
+ *          add_rreq(struct aodv_node*, u_int32_t, u_int32_t, u_int64_t)
  *
  ********************************
  *
@@ -40,11 +41,8 @@
 
 #include "rreq_list.h"
 
-struct rreq_entry    *rreq_header;  /* Global pointer to the list's head */
-int   list_is_init = 0; /* Set to 1 when the list has been initialized */
-
 /* Pre-declaration of internal function */
-int check_lifetime(struct rreq_entry *in_entry);
+int check_lifetime(struct aodv_node *node, struct rreq_entry *in_entry);
 
 /*
  * init_rreq_list
@@ -52,38 +50,63 @@ int check_lifetime(struct rreq_entry *in_entry);
  * Description:  
  *   Creates and initializes the list for route requests
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *   
  * Returns: 
  *   int - 0 if succesfull
  *        -1 if failed to allocate memory for list header
  */
 int
-init_rreq_list()
+init_rreq_list(struct aodv_node *node)
 {
   /* Check if the list already has been initialzed */
-  if (!list_is_init)
+  if (node->rreq_header == NULL)
     {
       /* Allocate memory for the head of the list */
-      if ((rreq_header = (struct rreq_entry*)
+      if ((node->rreq_header = (struct rreq_entry*)
 	   malloc(sizeof(struct rreq_entry))) == NULL)
 	/* Failed to allocate memory for list-header */
 	return -1;
     }
   
   /* Set to variables in the head to zero values */
-  rreq_header->src_ip = 0;
-  rreq_header->broadcast_id = 0;
-  rreq_header->lifetime = 0;
-  rreq_header->prev = NULL;
-  rreq_header->next = NULL;
-
-  /* The list has now been initialzed */
-  list_is_init = 1;
+  node->rreq_header->src_ip = 0;
+  node->rreq_header->broadcast_id = 0;
+  node->rreq_header->lifetime = 0;
+  node->rreq_header->copies = 0;
+  node->rreq_header->ttl = -1;
+  node->rreq_header->hop_cnt = 0;
+  node->rreq_header->relay = 0;
+  node->rreq_header->prev = NULL;
+  node->rreq_header->next = NULL;
 
   return 0;
 }
 
+/*
+ * free_rreq_list
+ *
+ * Description:  
+ *   Frees every entry of the route request list and its header
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   
+ * Returns: void
+ */
+void
+free_rreq_list(struct aodv_node *node)
+{
+  struct rreq_entry  *tmp_entry; /* Pointer to the working entry */
+
+  while ((tmp_entry = node->rreq_header) != NULL)
+    {
+      node->rreq_header = tmp_entry->next;
+      free(tmp_entry);
+    }
+}
+
 /*
  * find_rreq
  *
@@ -91,6 +114,7 @@ init_rreq_list()
  *   Searches for an entry in the route request list.
  *
  * Arguments:
+ *   struct aodv_node *node - The node.
  *   u_int32_t scr_ip - The IP address of the sender of the RREQ
  *   u_int32_t bc_id - The broadcast ID of the RREQ
  *
@@ -99,13 +123,13 @@ init_rreq_list()
  *                        If no entry found, NULL
  */
 struct rreq_entry*
-find_rreq(u_int32_t src_ip, u_int32_t bc_id)
+find_rreq(struct aodv_node *node, u_int32_t src_ip, u_int32_t bc_id)
 {
   struct rreq_entry  *tmp_entry;  /* Working entry in the RREQ list */
   struct rreq_entry  *prev_entry; /* Entry previous to the working entry */
   struct rreq_entry  *tmp_ptr = NULL; /* Pointer to an entry in RREQ list */
 
-  tmp_entry = rreq_header; /* Start at the header */
+  tmp_entry = node->rreq_header; /* Start at the header */
   prev_entry = NULL;
 
   /* Check each entry in the list if it's a desired entry, starting with 
@@ -116,7 +140,7 @@ find_rreq(u_int32_t src_ip, u_int32_t bc_id)
       tmp_ptr = tmp_entry->next;
 
     /* Check if the current entry is still valid */
-    if (check_lifetime(tmp_entry) == 0)
+    if (check_lifetime(node, tmp_entry) == 0)
       {	
 	/* Entry was valid */
 
@@ -129,10 +153,11 @@ find_rreq(u_int32_t src_ip, u_int32_t bc_id)
 	tmp_entry = tmp_entry->next;
       }
     else
-      /* Entry wasn't valid, step to the next entry */
-      if (tmp_entry != rreq_header)
+      /* Entry wasn't valid, step to the next entry. An old header was
+	 replaced by the next entry, which is checked in its place */
+      if (tmp_entry != node->rreq_header)
 	tmp_entry = tmp_ptr;
-      else
+      else if (node->rreq_header->src_ip == 0)
 	tmp_entry = NULL;
     
   } while (tmp_entry != NULL);/* Continue until the entire list is checked */
@@ -147,6 +172,7 @@ find_rreq(u_int32_t src_ip, u_int32_t bc_id)
  *   Adds a new entry to the route request list
  *
  * Arguments:
+ *   struct aodv_node *node - The node.
  *   u_int32_t ip - IP address of the sender of the RREQ
  *   u_in32_t  id - Broadcast ID of the RREQ
  *   u_int65_t lt - Lifetime of the RREQ
@@ -156,12 +182,12 @@ find_rreq(u_int32_t src_ip, u_int32_t bc_id)
  *       -1 if failed to allocate memory for a new entry
  */
 int
-add_rreq(u_int32_t ip, u_int32_t id, u_int64_t lt)
+add_rreq(struct aodv_node *node, u_int32_t ip, u_int32_t id, u_int64_t lt)
 {
   struct rreq_entry  *tmp_entry; /* Pointer to the working entry */
   struct rreq_entry  *new_entry; /* The new entry to be added */
 
-  tmp_entry = rreq_header;
+  tmp_entry = node->rreq_header;
 
   /* Check if the header is empty. If so, add the info in the header */
   if (tmp_entry->src_ip == 0) 
@@ -169,6 +195,10 @@ add_rreq(u_int32_t ip, u_int32_t id, u_int64_t lt)
       tmp_entry->src_ip = ip;
       tmp_entry->broadcast_id = id;
       tmp_entry->lifetime = lt;
+      tmp_entry->copies = 0;
+      tmp_entry->ttl = -1;
+      tmp_entry->hop_cnt = 0;
+      tmp_entry->relay = 0;
     }
   else
     {
@@ -186,6 +216,10 @@ add_rreq(u_int32_t ip, u_int32_t id, u_int64_t lt)
       new_entry->src_ip = ip;
       new_entry->broadcast_id = id;
       new_entry->lifetime = lt;
+      new_entry->copies = 0;
+      new_entry->ttl = -1;
+      new_entry->hop_cnt = 0;
+      new_entry->relay = 0;
       new_entry->prev = tmp_entry;
       new_entry->next = NULL;
       
@@ -205,6 +239,7 @@ add_rreq(u_int32_t ip, u_int32_t id, u_int64_t lt)
  *   If not valid, the entry is removed
  *
  * Arguments: 
+ *   struct aodv_node *node - The node.
  *   struct rreq_entry *in_entry - The RREQ entry to be checked
  * 
  * Return:
@@ -212,29 +247,46 @@ add_rreq(u_int32_t ip, u_int32_t id, u_int64_t lt)
  *        -1 if the entry was old
  */
 int
-check_lifetime(struct rreq_entry *in_entry)
+check_lifetime(struct aodv_node *node, struct rreq_entry *in_entry)
 {
   u_int64_t  curr_time = getcurrtime(); /* Current time */
+  struct rreq_entry *next_entry;
 
   /* Check if the entry is valid */
   if (curr_time > in_entry->lifetime)
     { 
       /* The entry was old - remove it */
 
-      /* Set the previous and next pointers */
-      if (in_entry->next != NULL)
-	(in_entry->next)->prev = in_entry->prev;
-
-      if (in_entry->prev != NULL)
-	(in_entry->prev)->next = in_entry->next;
-      
-      /* If the list only consists of header, reset the list
-	 else free the memory of the entry */
-      if (in_entry == rreq_header)
-	/* Call init_rreq_list to reinitialize the list */
-	init_rreq_list();
+      if (in_entry == node->rreq_header)
+	{
+	  /* The header can't be freed. Move the second entry into it, or
+	     reset the list if there is none */
+	  if ((next_entry = in_entry->next) == NULL)
+	    init_rreq_list(node);
+	  else
+	    {
+	      in_entry->src_ip = next_entry->src_ip;
+	      in_entry->broadcast_id = next_entry->broadcast_id;
+	      in_entry->lifetime = next_entry->lifetime;
+	      in_entry->copies = next_entry->copies;
+	      in_entry->ttl = next_entry->ttl;
+	      in_entry->hop_cnt = next_entry->hop_cnt;
+	      in_entry->relay = next_entry->relay;
+	      in_entry->next = next_entry->next;
+	      if (in_entry->next != NULL)
+		(in_entry->next)->prev = in_entry;
+	      free(next_entry);
+	    }
+	}
       else
-	free (in_entry);
+	{
+	  /* Set the previous and next pointers */
+	  if (in_entry->next != NULL)
+	    (in_entry->next)->prev = in_entry->prev;
+
+	  (in_entry->prev)->next = in_entry->next;
+	  free(in_entry);
+	}
 
       return -1;
     }
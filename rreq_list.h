@@ -25,12 +25,13 @@
  *          entered, looked up and removed here.
  * 
  *      Internal procedures:
- *          check_lifetime(struct rreq_entry)
+ *          check_lifetime(struct aodv_node*, struct rreq_entry*)
  *      
  *      External procedures:
- *          init_rreq_list()
- *          find_rreq(u_int32_t, u_int32_t)
- *          add_rreq(u_int32_t, u_int32_t, u_int64_t)
+ *          init_rreq_list(struct aodv_node*)
+ *          free_rreq_list(struct aodv_node*)
+ *          find_rreq(struct aodv_node*, u_int32_t, u_int32_t)
+ *          add_rreq(struct aodv_node*, u_int32_t, u_int32_t, u_int64_t)
  *
  ********************************
  *
@@ -45,12 +46,17 @@
 #include <stdlib.h>
 
 #include "utils.h"
+#include "node.h"
 
 struct rreq_entry
 {
   u_int32_t          src_ip;
   u_int32_t          broadcast_id;
   u_int64_t          lifetime;
+  int                copies;   /* Copies heard after the first */
+  int                ttl;      /* ttl of a waiting rebroadcast, else -1 */
+  u_int8_t           hop_cnt;  /* and its hop count, see rreq_forward */
+  int                relay;    /* 1 while left to the relays, see rec_rreq */
   struct rreq_entry *prev;
   struct rreq_entry *next;
 };
@@ -61,13 +67,27 @@ struct rreq_entry
  * Description:  
  *   Creates and initializes the list for route requests
  *
- * Arguments: void
+ * Arguments:
+ *   struct aodv_node *node - The node.
  *   
  * Returns: 
  *   int - 0 if succesfull
  *        -1 if failed to allocate memory for list header
  */
-int init_rreq_list();
+int init_rreq_list(struct aodv_node *node);
+
+/*
+ * free_rreq_list
+ *
+ * Description:  
+ *   Frees every entry of the route request list and its header
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   
+ * Returns: void
+ */
+void free_rreq_list(struct aodv_node *node);
 
 /*
  * find_rreq
@@ -76,6 +96,7 @@ int init_rreq_list();
  *   Searches for an entry in the route request list.
  *
  * Arguments:
+ *   struct aodv_node *node - The node.
  *   u_int32_t scr_ip - The IP address of the sender of the RREQ
  *   u_int32_t bc_id - The broadcast ID of the RREQ
  *
@@ -83,7 +104,8 @@ int init_rreq_list();
  *   struct rreq_entry* - Pointer to the found entry.
  *                        If no entry found, NULL
  */
-struct rreq_entry *find_rreq(u_int32_t src_ip, u_int32_t bc_id);
+struct rreq_entry *find_rreq(struct aodv_node *node, u_int32_t src_ip,
+			     u_int32_t bc_id);
 
 /*
  * add_rreq
@@ -92,6 +114,7 @@ struct rreq_entry *find_rreq(u_int32_t src_ip, u_int32_t bc_id);
  *   Adds a new entry to the route request list
  *
  * Arguments:
+ *   struct aodv_node *node - The node.
  *   u_int32_t ip - IP address of the sender of the RREQ
  *   u_in32_t  id - Broadcast ID of the RREQ
  *   u_int65_t lt - Lifetime of the RREQ
@@ -100,6 +123,7 @@ struct rreq_entry *find_rreq(u_int32_t src_ip, u_int32_t bc_id);
  *   int- 0 if succesful
  *       -1 if failed to allocate memory for a new entry
  */
-int add_rreq(u_int32_t src_ip, u_int32_t bd_id, u_int64_t lifetime);
+int add_rreq(struct aodv_node *node, u_int32_t src_ip, u_int32_t bd_id,
+	     u_int64_t lifetime);
 
 #endif
@@ -3,6 +3,19 @@
 
 #include "precursor.h"
 
+#define RT_REPAIR 0x8000  /* rt_flags: the route is being repaired locally */
+
+#define RT_ALT_HOPS 3     /* Alternate next hops kept in multipath mode */
+
+/* A next hop that can take over when the one in use breaks, see
+   add_alt_hop in RT.h */
+struct rt_alt
+{
+  u_int32_t nxt_hop;
+  u_int8_t hop_cnt;
+  u_int64_t lifetime;  /* ms, see getcurrtime */
+};
+
 struct artentry
 {
   u_int32_t dst_ip;
@@ -12,8 +25,10 @@ struct artentry
   u_int8_t lst_hop_cnt;
   u_int32_t nxt_hop;   
   struct precursor *precursors; /* formerly u_int_32_t* */
-  u_int64_t lifetime;
+  u_int64_t lifetime;  /* ms, see getcurrtime. -1 = never expires */
   unsigned short int rt_flags;
+  struct rt_alt alt[RT_ALT_HOPS];  /* Alternate next hops, never nxt_hop */
+  int alt_cnt;
 };
 
 #endif
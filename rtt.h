@@ -0,0 +1,173 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The node traversal time a node measures, and the times that
+ *        follow from it. A source takes the time from its RREQ to the
+ *        RREP that answers it, over twice the hops to the destination,
+ *        as a sample of the time per hop. Only a RREP sent by the
+ *        destination itself gives a sample, one from an intermediate
+ *        node crossed part of the hops only. A RREQ that was resent
+ *        gives no sample, the RREP may answer an earlier one (Karn). The
+ *        samples are smoothed as TCP does with round trip times: an
+ *        EWMA of the samples with gain 1/8 and one of their deviation
+ *        with gain 1/4. The traversal time is the mean plus four
+ *        deviations, within NODE_TRAVERSAL_MIN and NODE_TRAVERSAL_MAX.
+ *        Until the first sample it is NODE_TRAVERSAL_TIME.
+ *        Reverse routes and RREQs are kept at least RREP_WAIT_TIME, so a
+ *        low estimate only shortens the waits for RREPs.
+ *
+ *        HELLOs give no samples, nobody answers them and the skipped
+ *        and postponed ones leave their spacing without meaning.
+ *
+ *	Internal procedures:
+ *
+ *	External procedures:
+ *        rtt_sample
+ *        node_traversal_time
+ *        ring_traversal_time
+ *        rrep_wait_time
+ *        rev_route_life
+ *        broadcast_record_time
+ *        print_rtt
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef RTT_H
+#define RTT_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "aodv.h"
+#include "node.h"
+
+/*
+ * rtt_sample
+ *
+ * Description:
+ *   Adds the round trip time of a RREQ to the smoothed node traversal
+ *   time.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   u_int64_t rtt          - Time from the RREQ to its RREP in ms.
+ *   int hops               - Hops to the destination.
+ *
+ * Return: None
+ */
+void rtt_sample(struct aodv_node *node, u_int64_t rtt, int hops);
+
+/*
+ * node_traversal_time
+ *
+ * Description:
+ *   The time a message takes for one hop, NODE_TRAVERSAL_TIME until the
+ *   first sample.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   u_int64_t - The time in ms
+ */
+u_int64_t node_traversal_time(struct aodv_node *node);
+
+/*
+ * ring_traversal_time
+ *
+ * Description:
+ *   The time a RREQ with a TTL waits for its RREP, there and back over
+ *   ttl hops.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *   int ttl                - The TTL of the RREQ.
+ *
+ * Return:
+ *   u_int64_t - The time in ms
+ */
+u_int64_t ring_traversal_time(struct aodv_node *node, int ttl);
+
+/*
+ * rrep_wait_time
+ *
+ * Description:
+ *   The time for a RREP to cross the network and a half, 3/2 of
+ *   NET_DIAMETER hops.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   u_int64_t - The time in ms
+ */
+u_int64_t rrep_wait_time(struct aodv_node *node);
+
+/*
+ * rev_route_life
+ *
+ * Description:
+ *   The lifetime of a reverse route set up by a RREQ, rrep_wait_time
+ *   but not less than RREP_WAIT_TIME.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   u_int64_t - The time in ms
+ */
+u_int64_t rev_route_life(struct aodv_node *node);
+
+/*
+ * broadcast_record_time
+ *
+ * Description:
+ *   How long a RREQ is remembered to drop its copies, rrep_wait_time
+ *   but not less than RREP_WAIT_TIME.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return:
+ *   u_int64_t - The time in ms
+ */
+u_int64_t broadcast_record_time(struct aodv_node *node);
+
+/*
+ * print_rtt
+ *
+ * Description:
+ *   Prints the node traversal time, its smoothed mean and deviation and
+ *   the number of samples.
+ *
+ * Arguments:
+ *   struct aodv_node *node - The node.
+ *
+ * Return: None
+ */
+void print_rtt(struct aodv_node *node);
+
+#endif
@@ -0,0 +1,342 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Link flap scenarios for aodv_sim. A scenario cuts and restores
+ *        given links at given times while flows of data packets run at
+ *        a constant rate between given nodes. It is a text file, one
+ *        statement per line, times in seconds from the start of the
+ *        run, nodes by their index in aodv_sim:
+ *
+ *          name <word>                          Named in the results
+ *          cut <time> <a> <b>                   Link a - b goes down
+ *          restore <time> <a> <b>               and comes up again
+ *          flow <src> <dst> <rate> <start> <stop>   Packets per second
+ *
+ *        Blank lines and lines starting with # are skipped.
+ *
+ *        The results of each cut and each flow are taken from the
+ *        packets the flow got through and the times aodv_sim records
+ *        here: when an end of the cut link first marks a route over
+ *        it broken (link_break or host_unr), when the source of the
+ *        flow sees its route break and when it gets a new one.
+ *
+ *	Internal procedures:
+ *        scen_error
+ *
+ *	External procedures:
+ *        scen_load
+ *        scen_last
+ *        scen_result
+ *        scen_free
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "scen.h"
+
+/* Pre-declaration of internal function */
+int scen_error(char *file, int line, char *msg);
+
+/*
+ *   scen_error
+ *
+ *   Description:
+ *     Prints an error in a scenario.
+ *
+ *   Arguments:
+ *     char *file - The scenario.
+ *     int line   - Line of the error.
+ *     char *msg  - What is wrong.
+ *
+ *   Return:
+ *     int - Always -1
+ */
+int
+scen_error(char *file, int line, char *msg)
+{
+  fprintf(stderr, "%s:%d: %s\n", file, line, msg);
+
+  return -1;
+}
+
+/*
+ *   scen_load
+ *
+ *   Description:
+ *     Reads a scenario. An error is printed to stderr with the line it
+ *     was found on.
+ *
+ *   Arguments:
+ *     struct scen *s   - The scenario.
+ *     char *file       - The file.
+ *     int nnodes       - Number of nodes of the run.
+ *     u_int64_t span   - Length of the run, us.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+scen_load(struct scen *s, char *file, int nnodes, u_int64_t span)
+{
+  struct scen_link *link;
+  struct scen_link tmp;
+  struct scen_flow *flow;
+  FILE *fp;
+  char buf[256];
+  char word[SCEN_NAMELEN];
+  double t0;
+  double t1;
+  double rate;
+  int lineno = 0;
+  int ret = 0;
+  int a;
+  int b;
+  int i;
+  int j;
+
+  memset(s, 0, sizeof(struct scen));
+  strcpy(s->name, "unnamed");
+
+  if ((fp = fopen(file, "r")) == NULL)
+    {
+      perror(file);
+      return -1;
+    }
+
+  while (ret == 0 && fgets(buf, sizeof(buf), fp) != NULL)
+    {
+      lineno++;
+      if (sscanf(buf, "%63s", word) != 1 || word[0] == '#')
+	continue;
+
+      if (strcmp(word, "name") == 0)
+	{
+	  if (sscanf(buf, "%*s %63s", s->name) != 1)
+	    ret = scen_error(file, lineno, "name needs a word");
+	}
+      else if (strcmp(word, "cut") == 0 || strcmp(word, "restore") == 0)
+	{
+	  if (sscanf(buf, "%*s %lf %d %d", &t0, &a, &b) != 3 ||
+	      t0 < 0 || t0 * 1e6 >= span || a < 0 || b < 0 ||
+	      a >= nnodes || b >= nnodes || a == b)
+	    {
+	      ret = scen_error(file, lineno, "needs a time within the run "
+			       "and two different nodes");
+	      continue;
+	    }
+
+	  if ((link = realloc(s->link, (s->nlink + 1) *
+			      sizeof(struct scen_link))) == NULL)
+	    {
+	      ret = scen_error(file, lineno, "out of memory");
+	      continue;
+	    }
+	  s->link = link;
+
+	  link = &s->link[s->nlink++];
+	  memset(link, 0, sizeof(struct scen_link));
+	  link->time = t0 * 1e6;
+	  link->what = word[0] == 'c' ? SCEN_CUT : SCEN_RESTORE;
+	  link->a = a;
+	  link->b = b;
+	}
+      else if (strcmp(word, "flow") == 0)
+	{
+	  if (sscanf(buf, "%*s %d %d %lf %lf %lf", &a, &b, &rate, &t0,
+		     &t1) != 5 || a < 0 || b < 0 || a >= nnodes ||
+	      b >= nnodes || a == b || rate <= 0 || rate > 1e6 ||
+	      t0 < 0 || t1 <= t0 || t1 * 1e6 > span)
+	    {
+	      ret = scen_error(file, lineno, "needs two different nodes, "
+			       "a rate above 0 and a time within the run");
+	      continue;
+	    }
+
+	  if ((flow = realloc(s->flow, (s->nflow + 1) *
+			      sizeof(struct scen_flow))) == NULL)
+	    {
+	      ret = scen_error(file, lineno, "out of memory");
+	      continue;
+	    }
+	  s->flow = flow;
+
+	  flow = &s->flow[s->nflow++];
+	  memset(flow, 0, sizeof(struct scen_flow));
+	  flow->src = a;
+	  flow->dst = b;
+	  flow->start = t0 * 1e6;
+	  flow->interval = 1e6 / rate;
+	  flow->npkts = (t1 - t0) * rate;
+	  if ((flow->got = calloc(flow->npkts + 1, 1)) == NULL)
+	    ret = scen_error(file, lineno, "out of memory");
+	}
+      else
+	ret = scen_error(file, lineno, "unknown statement");
+    }
+
+  fclose(fp);
+  if (ret == -1)
+    {
+      scen_free(s);
+      return -1;
+    }
+
+  /* By time, events at the same time stay in the order of the file */
+  for (i = 1; i < s->nlink; i++)
+    {
+      tmp = s->link[i];
+      for (j = i; j > 0 && s->link[j - 1].time > tmp.time; j--)
+	s->link[j] = s->link[j - 1];
+      s->link[j] = tmp;
+    }
+
+  for (i = 0; i < s->nflow; i++)
+    {
+      flow = &s->flow[i];
+      flow->broken = calloc(s->nlink + 1, sizeof(u_int64_t));
+      flow->rerouted = calloc(s->nlink + 1, sizeof(u_int64_t));
+      if (flow->broken == NULL || flow->rerouted == NULL)
+	{
+	  scen_free(s);
+	  return scen_error(file, lineno, "out of memory");
+	}
+    }
+
+  return 0;
+}
+
+/*
+ *   scen_last
+ *
+ *   Description:
+ *     Finds the last link event at or before a time.
+ *
+ *   Arguments:
+ *     struct scen *s   - The scenario.
+ *     u_int64_t time   - us from the start.
+ *
+ *   Return:
+ *     int - Its index, -1 if there is none.
+ */
+int
+scen_last(struct scen *s, u_int64_t time)
+{
+  int i;
+
+  for (i = s->nlink - 1; i >= 0; i--)
+    if (s->link[i].time <= time)
+      return i;
+
+  return -1;
+}
+
+/*
+ *   scen_result
+ *
+ *   Description:
+ *     Works out how a flow fared from a link event to the next one, or
+ *     to the end of the run. Packets sent in the last second of the
+ *     run may still be on their way and are left out.
+ *
+ *   Arguments:
+ *     struct scen *s       - The scenario.
+ *     int l                - Index of the link event.
+ *     int f                - Index of the flow.
+ *     u_int64_t span       - Length of the run, us.
+ *     struct scen_res *res - Where the results go.
+ *
+ *   Return: None
+ */
+void
+scen_result(struct scen *s, int l, int f, u_int64_t span,
+	    struct scen_res *res)
+{
+  struct scen_flow *flow = &s->flow[f];
+  u_int64_t from = s->link[l].time;
+  u_int64_t to;
+  u_int64_t t;
+  u_int32_t run = 0;
+  u_int32_t k;
+  int arrived = 0;
+
+  memset(res, 0, sizeof(struct scen_res));
+
+  to = l + 1 < s->nlink ? s->link[l + 1].time : span;
+  to = span > 1000000 ? MIN(to, span - 1000000) : 0;
+
+  for (k = 0; k < flow->npkts; k++)
+    {
+      t = flow->start + k * flow->interval;
+      if (t < from)
+	continue;
+      if (t >= to)
+	break;
+
+      res->sent++;
+      if (flow->got[k])
+	{
+	  if (!arrived)
+	    res->outage = t - from;
+	  arrived = 1;
+	  run = 0;
+	  continue;
+	}
+
+      res->lost++;
+      run++;
+      res->window = MAX(res->window, run * flow->interval);
+    }
+
+  /* Nothing arrived, the outage lasted as long as the flow was seen */
+  if (!arrived && res->sent > 0)
+    res->outage = to - from;
+}
+
+/*
+ *   scen_free
+ *
+ *   Description:
+ *     Frees a scenario.
+ *
+ *   Arguments:
+ *     struct scen *s - The scenario.
+ *
+ *   Return: None
+ */
+void
+scen_free(struct scen *s)
+{
+  int i;
+
+  for (i = 0; i < s->nflow; i++)
+    {
+      free(s->flow[i].got);
+      free(s->flow[i].broken);
+      free(s->flow[i].rerouted);
+    }
+  free(s->flow);
+  free(s->link);
+  memset(s, 0, sizeof(struct scen));
+}
@@ -0,0 +1,187 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Link flap scenarios for aodv_sim. A scenario cuts and restores
+ *        given links at given times while flows of data packets run at
+ *        a constant rate between given nodes. It is a text file, one
+ *        statement per line, times in seconds from the start of the
+ *        run, nodes by their index in aodv_sim:
+ *
+ *          name <word>                          Named in the results
+ *          cut <time> <a> <b>                   Link a - b goes down
+ *          restore <time> <a> <b>               and comes up again
+ *          flow <src> <dst> <rate> <start> <stop>   Packets per second
+ *
+ *        Blank lines and lines starting with # are skipped.
+ *
+ *        The results of each cut and each flow are taken from the
+ *        packets the flow got through and the times aodv_sim records
+ *        here: when an end of the cut link first marks a route over
+ *        it broken (link_break or host_unr), when the source of the
+ *        flow sees its route break and when it gets a new one.
+ *
+ *	Internal procedures:
+ *        scen_error
+ *
+ *	External procedures:
+ *        scen_load
+ *        scen_last
+ *        scen_result
+ *        scen_free
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef SCEN_H
+#define SCEN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "aodv.h"
+
+/* What happens to a link */
+#define SCEN_CUT      0
+#define SCEN_RESTORE  1
+
+/* Longest scenario name */
+#define SCEN_NAMELEN  64
+
+/* A cut or a restore */
+struct scen_link
+{
+  u_int64_t time;               /* us from the start */
+  int what;                     /* SCEN_CUT or SCEN_RESTORE */
+  int a;                        /* The two ends */
+  int b;
+  u_int64_t detect_a;           /* First route over the link marked */
+  u_int64_t detect_b;           /* broken by a or b after the cut, us
+				   from the start, 0 = never */
+};
+
+/* A constant rate flow */
+struct scen_flow
+{
+  int src;
+  int dst;
+  u_int64_t start;              /* us from the start */
+  u_int64_t interval;           /* us between two packets */
+  u_int32_t npkts;              /* Packets it sends */
+  u_int32_t next;               /* Next packet to send */
+  u_int8_t *got;                /* 1 for each packet that arrived */
+  u_int64_t *broken;            /* Per link event: when src saw its route
+				   break after it, us, 0 = never */
+  u_int64_t *rerouted;          /* and when it had a new one */
+};
+
+/* Results of a flow over the time from a cut to the next link event */
+struct scen_res
+{
+  u_int32_t sent;
+  u_int32_t lost;
+  u_int64_t outage;             /* From the cut to the first packet sent
+				   that arrived, us */
+  u_int64_t window;             /* Longest run of lost packets, us */
+};
+
+struct scen
+{
+  char name[SCEN_NAMELEN];
+  struct scen_link *link;       /* By time */
+  int nlink;
+  struct scen_flow *flow;
+  int nflow;
+};
+
+
+/*
+ *   scen_load
+ *
+ *   Description:
+ *     Reads a scenario. An error is printed to stderr with the line it
+ *     was found on.
+ *
+ *   Arguments:
+ *     struct scen *s   - The scenario.
+ *     char *file       - The file.
+ *     int nnodes       - Number of nodes of the run.
+ *     u_int64_t span   - Length of the run, us.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int scen_load(struct scen *s, char *file, int nnodes, u_int64_t span);
+
+/*
+ *   scen_last
+ *
+ *   Description:
+ *     Finds the last link event at or before a time.
+ *
+ *   Arguments:
+ *     struct scen *s   - The scenario.
+ *     u_int64_t time   - us from the start.
+ *
+ *   Return:
+ *     int - Its index, -1 if there is none.
+ */
+int scen_last(struct scen *s, u_int64_t time);
+
+/*
+ *   scen_result
+ *
+ *   Description:
+ *     Works out how a flow fared from a link event to the next one, or
+ *     to the end of the run. Packets sent in the last second of the
+ *     run may still be on their way and are left out.
+ *
+ *   Arguments:
+ *     struct scen *s       - The scenario.
+ *     int l                - Index of the link event.
+ *     int f                - Index of the flow.
+ *     u_int64_t span       - Length of the run, us.
+ *     struct scen_res *res - Where the results go.
+ *
+ *   Return: None
+ */
+void scen_result(struct scen *s, int l, int f, u_int64_t span,
+		 struct scen_res *res);
+
+/*
+ *   scen_free
+ *
+ *   Description:
+ *     Frees a scenario.
+ *
+ *   Arguments:
+ *     struct scen *s - The scenario.
+ *
+ *   Return: None
+ */
+void scen_free(struct scen *s);
+
+#endif
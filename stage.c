@@ -0,0 +1,405 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The daemon runs as three stages joined by single-producer/
+ *        single-consumer rings:
+ *
+ *          capture  - packetcap.c, parses captured frames
+ *          protocol - aodv_daemon.c main loop, owns all AODV state
+ *          sync     - this module, applies kernel route changes and
+ *                     writes the message log
+ *
+ *        The protocol stage is the only writer of the routing table.
+ *        It hands kernel route updates and log records to the sync
+ *        stage instead of doing the ioctl/write calls itself.
+ *
+ *	Internal procedures:
+ *        sync_thread
+ *
+ *	External procedures:
+ *        stage_spawn
+ *        stage_register
+ *        stage_sync_start
+ *        stage_sync_stop
+ *        stage_running
+ *        stage_kroute
+ *        stage_log_reserve
+ *        stage_log_commit
+ *        stage_print
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "stage.h"
+#include "krtable.h"
+#include "logmsg.h"
+
+static struct ring krt_ring;   /* protocol -> sync, kernel route changes */
+static struct ring log_ring;   /* protocol -> sync, log records */
+static pthread_t sync_tid;
+static volatile int sync_running = 0;
+static volatile int sync_stop = 0;
+
+/* Statistics, written by the owning stage only */
+static unsigned long krt_stalls = 0;   /* Waits for a free krt slot */
+static unsigned long krt_failed = 0;   /* Failed route ioctls */
+
+static struct ring *rings[STAGE_MAX_RINGS];
+static int nrings = 0;
+
+/* Pre-declaration of internal function */
+void *sync_thread(void *arg);
+
+/*
+ *   stage_spawn
+ *
+ *   Description:
+ *     Creates a stage thread. All signals are blocked in the new thread
+ *     so that SIGALRM and SIGINT are always handled by the protocol
+ *     stage. Faults are left unblocked so that a crash in any stage
+ *     reaches the flight recorder.
+ *
+ *   Arguments:
+ *     pthread_t *tid         - Where to store the thread id.
+ *     void *(*fn)(void *)    - The thread function.
+ *     void *arg              - Argument to the thread function.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+stage_spawn(pthread_t *tid, void *(*fn)(void *), void *arg)
+{
+  sigset_t all;
+  sigset_t old;
+  int rc;
+
+  /* The new thread inherits the signal mask of its creator */
+  sigfillset(&all);
+  sigdelset(&all, SIGSEGV);
+  sigdelset(&all, SIGBUS);
+  sigdelset(&all, SIGFPE);
+  sigdelset(&all, SIGILL);
+  sigdelset(&all, SIGABRT);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+  rc = pthread_create(tid, NULL, fn, arg);
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  if (rc != 0)
+    return -1;
+
+  return 0;
+}
+
+/*
+ *   stage_register
+ *
+ *   Description:
+ *     Adds a ring to the set printed by stage_print.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return: None
+ */
+void
+stage_register(struct ring *r)
+{
+  if (nrings < STAGE_MAX_RINGS)
+    rings[nrings++] = r;
+}
+
+/*
+ *   stage_sync_start
+ *
+ *   Description:
+ *     Creates the rings of the sync stage and starts its thread. From
+ *     now on add_kroute, del_kroute and logmsg only queue their work.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+stage_sync_start()
+{
+  if (ring_init(&krt_ring, "krt", STAGE_KRT_SLOTS,
+		sizeof(struct krt_op)) == -1)
+    return -1;
+
+  if (ring_init(&log_ring, "log", STAGE_LOG_SLOTS,
+		sizeof(struct logrec)) == -1)
+    return -1;
+
+  stage_register(&krt_ring);
+  stage_register(&log_ring);
+
+  sync_stop = 0;
+  if (stage_spawn(&sync_tid, sync_thread, NULL) == -1)
+    return -1;
+
+  sync_running = 1;
+
+  return 0;
+}
+
+/*
+ *   stage_sync_stop
+ *
+ *   Description:
+ *     Lets the sync stage finish all queued work and joins its thread.
+ *     Kernel route changes are done synchronously again afterwards.
+ *
+ *   Arguments: None
+ *
+ *   Return: None
+ */
+void
+stage_sync_stop()
+{
+  char wake = 0;
+
+  if (!sync_running)
+    return;
+
+  sync_running = 0;
+  __atomic_store_n(&sync_stop, 1, __ATOMIC_SEQ_CST);
+
+  /* Wake the thread if it sleeps */
+  write(krt_ring.notify[1], &wake, 1);
+
+  pthread_join(sync_tid, NULL);
+}
+
+/*
+ *   stage_running
+ *
+ *   Description:
+ *     Tells if the sync stage is running.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     int - 1 if the sync stage takes work, 0 otherwise.
+ */
+int
+stage_running()
+{
+  return sync_running;
+}
+
+/*
+ *   stage_kroute
+ *
+ *   Description:
+ *     Queues a kernel route change for the sync stage. Kernel routes
+ *     are never dropped, if the ring is full the caller waits for a
+ *     free slot. The change is made later, the sync stage counts a
+ *     failure and logs it to the trace unless logging is off.
+ *
+ *   Arguments:
+ *     int req          - SIOCADDRT or SIOCDELRT
+ *     u_int32_t dst_ip - IP address to the destination
+ *     u_int32_t gw_ip  - IP address to the gateway of the route
+ *
+ *   Return:
+ *     int - 0, the change is queued. It says nothing about the change
+ *           itself.
+ */
+int
+stage_kroute(int req, u_int32_t dst_ip, u_int32_t gw_ip)
+{
+  struct krt_op op;
+
+  op.req = req;
+  op.dst_ip = dst_ip;
+  op.gw_ip = gw_ip;
+  /* The log level belongs to the protocol stage */
+  op.log = logmsg_getlevel() != LOG_LEVEL_OFF;
+
+  /* Order matters for the kernel table, so wait instead of dropping */
+  while (ring_occupancy(&krt_ring) > krt_ring.mask)
+    {
+      krt_stalls++;
+      sched_yield();
+    }
+
+  ring_push(&krt_ring, &op);
+
+  return 0;
+}
+
+/*
+ *   stage_log_reserve
+ *
+ *   Description:
+ *     Returns the next free slot of the log ring so that logmsg can
+ *     fill in the record in place.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     struct logrec* - The slot, NULL if the ring is full and the record
+ *                      has to be dropped.
+ */
+struct logrec *
+stage_log_reserve()
+{
+  return ring_reserve(&log_ring);
+}
+
+/*
+ *   stage_log_commit
+ *
+ *   Description:
+ *     Hands the record filled in after stage_log_reserve to the sync
+ *     stage.
+ *
+ *   Arguments: None
+ *
+ *   Return: None
+ */
+void
+stage_log_commit()
+{
+  ring_commit(&log_ring);
+}
+
+/*
+ *   stage_print
+ *
+ *   Description:
+ *     Prints occupancy and drop counters for all stage rings.
+ *
+ *   Arguments: None
+ *
+ *   Return: None
+ */
+void
+stage_print()
+{
+  int i;
+
+  printf("Ring       Used/Slots\n");
+  for (i = 0; i < nrings; i++)
+    ring_print(rings[i]);
+
+  printf("krt stalls: %lu  krt failed: %lu\n", krt_stalls, krt_failed);
+}
+
+/*
+ *   sync_thread
+ *
+ *   Description:
+ *     Body of the sync stage. Applies queued kernel route changes and
+ *     collects queued log records into blocks. A failed route change
+ *     is logged right into the block, see logmsg_krt. Kernel routes have
+ *     priority, at most STAGE_LOG_BATCH log records are collected
+ *     between two checks of the route ring. Sleeps when both rings are
+ *     empty, but not longer than until the current log block is due.
+ *
+ *   Arguments:
+ *     void *arg - Unused
+ *
+ *   Return:
+ *     void* - NULL
+ */
+void *
+sync_thread(void *arg)
+{
+  struct logrec rec;
+  struct krt_op op;
+  struct timeval tv;
+  fd_set readfds;
+  int maxfd;
+  int work;
+  int wait;
+  int i;
+
+  maxfd = MAX(ring_notifyfd(&krt_ring), ring_notifyfd(&log_ring));
+
+  while (1)
+    {
+      work = 0;
+
+      while (ring_pop(&krt_ring, &op) == 0)
+	{
+	  if (krt_ioctl(op.req, op.dst_ip, op.gw_ip) == -1)
+	    {
+	      krt_failed++;
+	      if (op.log)
+		logmsg_krt(op.req == SIOCADDRT ? TRACE_KRT_ADD : TRACE_KRT_DEL,
+			   op.dst_ip, op.gw_ip, errno);
+	    }
+	  work = 1;
+	}
+
+      for (i = 0; i < STAGE_LOG_BATCH && ring_pop(&log_ring, &rec) == 0; i++)
+	{
+	  logmsg_write(&rec);
+	  work = 1;
+	}
+
+      if ((wait = logmsg_flushwait()) == 0)
+	{
+	  logmsg_flush();
+	  wait = -1;
+	}
+
+      if (work)
+	continue;
+
+      /* Both rings were empty */
+      if (__atomic_load_n(&sync_stop, __ATOMIC_SEQ_CST))
+	{
+	  logmsg_flush();
+	  break;
+	}
+
+      if (ring_prepare_wait(&krt_ring) == -1 ||
+	  ring_prepare_wait(&log_ring) == -1)
+	continue;
+
+      FD_ZERO(&readfds);
+      FD_SET(ring_notifyfd(&krt_ring), &readfds);
+      FD_SET(ring_notifyfd(&log_ring), &readfds);
+
+      if (wait > 0)
+	{
+	  /* Wake up in time to write the log block */
+	  tv.tv_sec = wait / 1000;
+	  tv.tv_usec = (wait % 1000) * 1000;
+	  select(maxfd + 1, &readfds, NULL, NULL, &tv);
+	}
+      else
+	select(maxfd + 1, &readfds, NULL, NULL, NULL);
+
+      ring_drainnotify(&krt_ring);
+      ring_drainnotify(&log_ring);
+    }
+
+  return NULL;
+}
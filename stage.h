@@ -0,0 +1,220 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The daemon runs as three stages joined by single-producer/
+ *        single-consumer rings:
+ *
+ *          capture  - packetcap.c, parses captured frames
+ *          protocol - aodv_daemon.c main loop, owns all AODV state
+ *          sync     - this module, applies kernel route changes and
+ *                     writes the message log
+ *
+ *        The protocol stage is the only writer of the routing table.
+ *        It hands kernel route updates and log records to the sync
+ *        stage instead of doing the ioctl/write calls itself.
+ *
+ *	Internal procedures:
+ *        sync_thread
+ *
+ *	External procedures:
+ *        stage_spawn
+ *        stage_register
+ *        stage_sync_start
+ *        stage_sync_stop
+ *        stage_running
+ *        stage_kroute
+ *        stage_log_reserve
+ *        stage_log_commit
+ *        stage_print
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef STAGE_H
+#define STAGE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/select.h>
+
+#include "ring.h"
+
+/* Number of slots in the rings of the sync stage */
+#define STAGE_KRT_SLOTS 256
+#define STAGE_LOG_SLOTS 4096
+
+/* Max number of rings that can be registered for statistics */
+#define STAGE_MAX_RINGS 8
+
+/* Max number of log records collected before kernel routes are checked */
+#define STAGE_LOG_BATCH 256
+
+/* A kernel route change queued for the sync stage */
+struct krt_op
+{
+  int req;          /* SIOCADDRT or SIOCDELRT */
+  u_int32_t dst_ip; /* Destination of the route */
+  u_int32_t gw_ip;  /* Gateway of the route */
+  int log;          /* Log it if it fails, see logmsg_krt */
+};
+
+struct logrec;
+
+/*
+ *   stage_spawn
+ *
+ *   Description:
+ *     Creates a stage thread. All signals are blocked in the new thread
+ *     so that SIGALRM and SIGINT are always handled by the protocol
+ *     stage.
+ *
+ *   Arguments:
+ *     pthread_t *tid         - Where to store the thread id.
+ *     void *(*fn)(void *)    - The thread function.
+ *     void *arg              - Argument to the thread function.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int stage_spawn(pthread_t *tid, void *(*fn)(void *), void *arg);
+
+/*
+ *   stage_register
+ *
+ *   Description:
+ *     Adds a ring to the set printed by stage_print.
+ *
+ *   Arguments:
+ *     struct ring *r - The ring.
+ *
+ *   Return: None
+ */
+void stage_register(struct ring *r);
+
+/*
+ *   stage_sync_start
+ *
+ *   Description:
+ *     Creates the rings of the sync stage and starts its thread. From
+ *     now on add_kroute, del_kroute and logmsg only queue their work.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int stage_sync_start();
+
+/*
+ *   stage_sync_stop
+ *
+ *   Description:
+ *     Lets the sync stage finish all queued work and joins its thread.
+ *     Kernel route changes are done synchronously again afterwards.
+ *
+ *   Arguments: None
+ *
+ *   Return: None
+ */
+void stage_sync_stop();
+
+/*
+ *   stage_running
+ *
+ *   Description:
+ *     Tells if the sync stage is running.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     int - 1 if the sync stage takes work, 0 otherwise.
+ */
+int stage_running();
+
+/*
+ *   stage_kroute
+ *
+ *   Description:
+ *     Queues a kernel route change for the sync stage. Kernel routes
+ *     are never dropped, if the ring is full the caller waits for a
+ *     free slot. The change is made later, the sync stage counts a
+ *     failure and logs it to the trace unless logging is off.
+ *
+ *   Arguments:
+ *     int req          - SIOCADDRT or SIOCDELRT
+ *     u_int32_t dst_ip - IP address to the destination
+ *     u_int32_t gw_ip  - IP address to the gateway of the route
+ *
+ *   Return:
+ *     int - 0, the change is queued. It says nothing about the change
+ *           itself.
+ */
+int stage_kroute(int req, u_int32_t dst_ip, u_int32_t gw_ip);
+
+/*
+ *   stage_log_reserve
+ *
+ *   Description:
+ *     Returns the next free slot of the log ring so that logmsg can
+ *     fill in the record in place.
+ *
+ *   Arguments: None
+ *
+ *   Return:
+ *     struct logrec* - The slot, NULL if the ring is full and the record
+ *                      has to be dropped.
+ */
+struct logrec *stage_log_reserve();
+
+/*
+ *   stage_log_commit
+ *
+ *   Description:
+ *     Hands the record filled in after stage_log_reserve to the sync
+ *     stage.
+ *
+ *   Arguments: None
+ *
+ *   Return: None
+ */
+void stage_log_commit();
+
+/*
+ *   stage_print
+ *
+ *   Description:
+ *     Prints occupancy and drop counters for all stage rings.
+ *
+ *   Arguments: None
+ *
+ *   Return: None
+ */
+void stage_print();
+
+#endif
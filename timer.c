@@ -28,7 +28,9 @@
  *	Internal procedures:
  *
  *	External procedures:
+ *	  pq_init
  *	  pq_new
+ *	  pq_free
  *	  pq_updatetimer
  *	  pq_signal
  *	  pq_readpipe
@@ -54,16 +56,39 @@
 #include "timer.h"
 
 /* 
- *   pq
+ *   pq_alarm
  *
  *   Description: 
- *     A global pointer to the one and only prioqueue
+ *     The queue that owns the real time timer and SIGALRM, set by
+ *     pq_new. Other queues are run by their owner with pq_getfirstdue.
  *
  *   Arguments: N/A
  *
  *   Return: N/A
 */
-struct prioq *pq;
+struct prioq *pq_alarm = NULL;
+
+/* 
+ *   pq_init
+ *
+ *   Description: 
+ *     Initialize an empty prioqueue that is not tied to the
+ *     timer. Its owner takes the due entries with pq_getfirstdue
+ *     and pq_unqueuefirstent.
+ *
+ *   Arguments:
+ *     struct prioq *pq - The queue.
+ *
+ *   Return: None
+*/
+void
+pq_init(struct prioq *pq)
+{
+  pq->pqe = NULL;
+  pq->tpipe[0] = -1;
+  pq->tpipe[1] = -1;
+}
+
 
 /* 
  *   pq_new
@@ -71,9 +96,11 @@ struct prioq *pq;
  *   Description: 
  *     Initialize the prioqueue and set the
  *     function which will handel the timer
- *     interrupt.
+ *     interrupt. Only one queue in the process
+ *     can own the timer.
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  *
  *   Return: 
  *     A file descriptor on which addresses to a 
@@ -83,24 +110,52 @@ struct prioq *pq;
 */
 
 int
-pq_new()
+pq_new(struct prioq *pq)
 {
-
-  if (pq != NULL || 
-      (pq = (struct prioq*)malloc(sizeof(struct prioq))) == NULL)
+  if (pq_alarm != NULL)
+    /* The timer is already taken */
     return -1;
 
+  pq_init(pq);
+
   /* Get the pipe */
   if (pipe(pq->tpipe) < 0)
     return -1;
   
   /* Register signal handler */
+  pq_alarm = pq;
   signal(SIGALRM,(void*)pq_signal);
   
   return pq->tpipe[0];
 }
 
 
+/* 
+ *   pq_free
+ *
+ *   Description: 
+ *     Frees all entries in the queue, but not their data.
+ *
+ *   Arguments:
+ *     struct prioq *pq - The queue.
+ *
+ *   Return: None
+*/
+void
+pq_free(struct prioq *pq)
+{
+  struct prioqent *pqe;
+
+  while ((pqe = pq->pqe) != NULL)
+    {
+      pq->pqe = pqe->pqe;
+      free(pqe);
+    }
+
+  pq_updatetimer(pq);
+}
+
+
 /* 
  *   pq_updatetimer
  *
@@ -108,18 +163,23 @@ pq_new()
  *     Update the timer to the value of the event which
  *     is most recent. 
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  *
  *   Return: None
 */
 void
-pq_updatetimer()
+pq_updatetimer(struct prioq *pq)
 {
   struct itimerval ovalue;
   struct itimerval value;
   u_int64_t currtime;
   u_int64_t tv;
 
+  if (pq != pq_alarm)
+    /* The queue has no timer */
+    return;
+
   /* Init timer values to zero */
   (ovalue.it_interval).tv_sec = 0;
   (ovalue.it_interval).tv_usec = 0;
@@ -184,25 +244,28 @@ pq_signal(int signal)
   struct prioqent *pqe;
   u_int64_t currtime;
   
+  /* The main loop may be blocked, take a tick of our own */
+  clock_tick();
+
   /* Get the first due entry in the queue */
   currtime = getcurrtime();
-  pqe = pq_getfirstdue(currtime);
+  pqe = pq_getfirstdue(pq_alarm, currtime);
   
   /* While there is still events that has timed out */
   while (pqe != NULL)
     {
       /* Write the address of the entry to the pipe */
-      if(write (pq->tpipe[1], &pqe, sizeof(struct prioqent*)) < 0)
+      if(write (pq_alarm->tpipe[1], &pqe, sizeof(struct prioqent*)) < 0)
 	/* Error writing to the pipe */
 	return;
 
       /* Dequeue the entry so that it will not happened again */
-      pq_unqueuefirstent();
+      pq_unqueuefirstent(pq_alarm);
       
       /* Get new time and check for more timedout entrys */
       currtime = getcurrtime();
       
-      pqe = pq_getfirstdue(currtime);
+      pqe = pq_getfirstdue(pq_alarm, currtime);
     }
   
 }
@@ -216,7 +279,8 @@ pq_signal(int signal)
  *     Caution - If the function is called and the
  *		 pipe is empty the function WILL block.
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  * 
  *  Return: 
  *    struct prioqent* - This is the pointer to the prio queue entry that has
@@ -225,7 +289,7 @@ pq_signal(int signal)
  *		         done with it.
 */
 struct prioqent*
-pq_readpipe()
+pq_readpipe(struct prioq *pq)
 {
   struct prioqent **pqe;
   struct prioqent *tpqe;
@@ -255,7 +319,8 @@ pq_readpipe()
  *     Inserts an entry into the prioqueue.
  *
  *   Arguments: 
- *     u_int64_t msec  - The time in milliseconds (msec from 1 jan 1970) of 
+ *     struct prioq *pq - The queue.
+ *     u_int64_t msec  - The time in milliseconds (see getcurrtime) of 
  *                       which the event shall occur.
  *     void *data  - Pointer to the data that shall be stored.
  *     u_int32_t id  - A number to identyfy the stored data (like an 
@@ -267,7 +332,8 @@ pq_readpipe()
  *     int   - On error returns -1 else 0
 */
 int 
-pq_insert(u_int64_t msec,void *data,u_int32_t id,unsigned char flags)
+pq_insert(struct prioq *pq, u_int64_t msec, void *data, u_int32_t id,
+	  unsigned char flags)
 {
   struct prioqent *next_pqe;
   struct prioqent *prev_pqe;
@@ -321,7 +387,7 @@ pq_insert(u_int64_t msec,void *data,u_int32_t id,unsigned char flags)
       
     }
   /* Update the timer to reflect the new situation */
-  pq_updatetimer();
+  pq_updatetimer(pq);
   
   return 0;
 }
@@ -333,14 +399,15 @@ pq_insert(u_int64_t msec,void *data,u_int32_t id,unsigned char flags)
  *   Description: 
  *     Returns a pointer to the first entry in the queue.
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  *
  *   Return: 
  *     struct prioqent* - A ponter to the first entry in the queue.
  *                        Can be NULL if the queue is empty.
 */
 struct prioqent * 
-pq_getfirst()
+pq_getfirst(struct prioq *pq)
 {
   return pq->pqe;
 }
@@ -354,6 +421,7 @@ pq_getfirst()
  *     that matches the id.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int32_t id - The id to be matched by the entry
  * 
  *   Return: 
@@ -363,7 +431,7 @@ pq_getfirst()
  *		          entry with that id.
 */
 struct prioqent * 
-pq_getfirstofid(u_int32_t id)
+pq_getfirstofid(struct prioq *pq, u_int32_t id)
 {
   struct prioqent *pqe;
   
@@ -384,6 +452,7 @@ pq_getfirstofid(u_int32_t id)
  *     that matches the id.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int32_t id        - The id to be matched by the entry
  *     unsigned char flags - The flags to be matched
  *
@@ -394,7 +463,7 @@ pq_getfirstofid(u_int32_t id)
  *		          entry with that id.
 */
 struct prioqent * 
-pq_getfirstofidflags(u_int32_t id, unsigned char flags)
+pq_getfirstofidflags(struct prioq *pq, u_int32_t id, unsigned char flags)
 {
   struct prioqent *pqe;
   
@@ -415,13 +484,14 @@ pq_getfirstofidflags(u_int32_t id, unsigned char flags)
  *     that matches the id and flags.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int32_t id        - The id to be matched by the entry
  *     unsigned char flags - The flags to be matched
  *
  *   Return: Void 
 */
 void
-pq_unqueueidflags(u_int32_t id, unsigned char flags)
+pq_unqueueidflags(struct prioq *pq, u_int32_t id, unsigned char flags)
 {
   struct prioqent *pqe_next;
   struct prioqent *pqe_prev;
@@ -461,7 +531,7 @@ pq_unqueueidflags(u_int32_t id, unsigned char flags)
 	}
     }
   /* Change the timer to reflect the new chenges */
-  pq_updatetimer();
+  pq_updatetimer(pq);
   
 }
 
@@ -473,12 +543,13 @@ pq_unqueueidflags(u_int32_t id, unsigned char flags)
  *     by the argument. The entry is freed.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     struct prioqent *pqed - A pointer to the entry that shall be deleted.
  *
  *   Return: None
 */
 void
-pq_deleteent(struct prioqent *pqed)
+pq_deleteent(struct prioq *pq, struct prioqent *pqed)
 {
   struct prioqent *pqe;
   
@@ -502,7 +573,7 @@ pq_deleteent(struct prioqent *pqed)
 	}
     }
   
-  pq_updatetimer();
+  pq_updatetimer(pq);
 }
 
 
@@ -514,6 +585,7 @@ pq_deleteent(struct prioqent *pqed)
  *     flag given as arguments. The entrys are freed.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int32_t id        - The id that shall be matched. 
  *     unsigned char flags - The flags that shall be matched 
  *                           (Can be PQ_FLAGS_ALLL for all flags). 
@@ -523,7 +595,7 @@ pq_deleteent(struct prioqent *pqed)
  *         Possible bug deleting entrys but they could be set as timers
  */
 void
-pq_deleteidflags(u_int32_t id, unsigned char flags)
+pq_deleteidflags(struct prioq *pq, u_int32_t id, unsigned char flags)
 {
   struct prioqent *pqe_next;
   struct prioqent *pqe_prev;
@@ -565,7 +637,7 @@ pq_deleteidflags(u_int32_t id, unsigned char flags)
 	}
     }
   /* Change the timer to reflect the new chenges */
-  pq_updatetimer();
+  pq_updatetimer(pq);
 }
 
 
@@ -575,12 +647,13 @@ pq_deleteidflags(u_int32_t id, unsigned char flags)
  *   Description: 
  *     Remove but no delete the first entry in the queue. (not freed)
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  *
  *   Return: None
 */
 void
-pq_unqueuefirstent()
+pq_unqueuefirstent(struct prioq *pq)
 {
   struct prioqent *pqe;
 
@@ -590,7 +663,7 @@ pq_unqueuefirstent()
       pq->pqe = pqe->pqe;
     }
 
-  pq_updatetimer();
+  pq_updatetimer(pq);
 }
 
 /* 
@@ -599,12 +672,13 @@ pq_unqueuefirstent()
  *   Description: 
  *     Deletes the first entry in the queue. 
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  *
  *   Return: None
 */
 void
-pq_deletefirstent()
+pq_deletefirstent(struct prioq *pq)
 {
   struct prioqent *pqe;
 
@@ -615,7 +689,7 @@ pq_deletefirstent()
       free(pqe);
     }
   
-  pq_updatetimer();
+  pq_updatetimer(pq);
 }
 
 /* 
@@ -627,6 +701,7 @@ pq_deletefirstent()
  *     if the argument is greater than its tv value.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int64_t tv - the time that the elment to be returned shall be 
  *                    lower than. This is not quite true due to the real
  *                    time timer vs. the timeslice for the process the value
@@ -638,7 +713,7 @@ pq_deletefirstent()
  *                        right else NULL is returned.
 */
 struct prioqent *
-pq_getfirstdue(u_int64_t tv)
+pq_getfirstdue(struct prioq *pq, u_int64_t tv)
 {
   struct prioqent *pqe;
   
@@ -661,6 +736,7 @@ pq_getfirstdue(u_int64_t tv)
  *     matches the id given as argument.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int64_t tv - Same as pq_getfirstdue.
  *     u_int32_t id - The id that shall be matched.
  *
@@ -670,11 +746,11 @@ pq_getfirstdue(u_int64_t tv)
  *                        NULL is returned.
 */
 struct prioqent *
-pq_getfirstdueofid(u_int64_t tv, u_int32_t id)
+pq_getfirstdueofid(struct prioq *pq, u_int64_t tv, u_int32_t id)
 {
   struct prioqent *pqe;
   
-  if ((pqe = pq_getfirstofid(id)) != NULL)
+  if ((pqe = pq_getfirstofid(pq, id)) != NULL)
     {
       if ((pqe->tv) < tv + TIME_DIV || (pqe->tv) < tv - TIME_DIV)
 	return pqe;
@@ -690,12 +766,13 @@ pq_getfirstdueofid(u_int64_t tv, u_int32_t id)
  *   Description: 
  *     Prints the prio queue.
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  * 
  *  Return: None
 */
 void
-pq_print()
+pq_print(struct prioq *pq)
 {
   struct prioqent *pqe;
 
@@ -28,7 +28,9 @@
  *	Internal procedures:
  *
  *	External procedures:
+ *	  pq_init
  *	  pq_new
+ *	  pq_free
  *	  pq_updatetimer
  *	  pq_signal
  *	  pq_readpipe
@@ -71,13 +73,14 @@
 #define PQ_PACKET_RREP 2
 #define PQ_PACKET_RERR 3
 #define PQ_PACKET_HELLO 4
+#define PQ_PACKET_FWD 5
 #define PQ_FLAGS_ALL 255
 
 
 /* prio queue entry */
 struct prioqent
 {
-  u_int64_t tv;  /* Time the event should happend in ms since 1 jan 1970 */
+  u_int64_t tv;  /* Time the event should happend in ms, see getcurrtime */
   void *data;    /* Data stored in the entry */
   u_int32_t id;  /* An id used to match one or a group of entrys */
   unsigned char flags;  /* Flag which represents what's in the dataportion */
@@ -92,15 +95,32 @@ struct prioq
 };
 
 
+/* 
+ *   pq_init
+ *
+ *   Description: 
+ *     Initialize an empty prioqueue that is not tied to the
+ *     timer. Its owner takes the due entries with pq_getfirstdue
+ *     and pq_unqueuefirstent.
+ *
+ *   Arguments:
+ *     struct prioq *pq - The queue.
+ *
+ *   Return: None
+ */
+void pq_init(struct prioq *pq);
+
 /* 
  *   pq_new
  *
  *   Description: 
  *     Initialize the prioqueue and set the
  *     function which will handel the timer
- *     interrupt.
+ *     interrupt. Only one queue in the process
+ *     can own the timer.
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  *
  *   Return: 
  *     A file descriptor on which addresses to a 
@@ -108,7 +128,20 @@ struct prioq
  *     when an queued event has expired.
  *     On error -1 is returned.
  */
-int pq_new();
+int pq_new(struct prioq *pq);
+
+/* 
+ *   pq_free
+ *
+ *   Description: 
+ *     Frees all entries in the queue, but not their data.
+ *
+ *   Arguments:
+ *     struct prioq *pq - The queue.
+ *
+ *   Return: None
+ */
+void pq_free(struct prioq *pq);
 
 /* 
  *   pq_updatetimer
@@ -117,11 +150,12 @@ int pq_new();
  *     Update the timer to the value of the event which
  *     is most recent. 
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  *
  *   Return: None
  */
-void pq_updatetimer();
+void pq_updatetimer(struct prioq *pq);
 
 /* 
  *   pq_signal
@@ -146,7 +180,8 @@ void pq_signal(int signal);
  *     Caution - If the function is called and the
  *		 pipe is empty the function WILL block.
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  * 
  *  Return: 
  *    struct prioqent* - This is the pointer to the prio queue entry that has
@@ -154,7 +189,7 @@ void pq_signal(int signal);
  *		         This is the pointer which shall be freed when one is
  *		         done with it.
 */
-struct prioqent *pq_readpipe();
+struct prioqent *pq_readpipe(struct prioq *pq);
 
 /* 
  *   pq_insert
@@ -163,7 +198,8 @@ struct prioqent *pq_readpipe();
  *     Inserts an entry into the prioqueue.
  *
  *   Arguments: 
- *     u_int64_t msec  - The time in milliseconds (msec from 1 jan 1970) of 
+ *     struct prioq *pq - The queue.
+ *     u_int64_t msec  - The time in milliseconds (see getcurrtime) of 
  *                       which the event shall occur.
  *     void *data  - Pointer to the data that shall be stored.
  *     u_int32_t id  - A number to identyfy the stored data (like an 
@@ -174,7 +210,8 @@ struct prioqent *pq_readpipe();
  *   Return: 
  *     int   - On error returns -1 else 0
  */
-int  pq_insert(u_int64_t msec,void *data,u_int32_t id,unsigned char flags);
+int  pq_insert(struct prioq *pq, u_int64_t msec, void *data, u_int32_t id,
+	       unsigned char flags);
 
 /* 
  *   pq_getfirst
@@ -182,13 +219,14 @@ int  pq_insert(u_int64_t msec,void *data,u_int32_t id,unsigned char flags);
  *   Description: 
  *     Returns a pointer to the first entry in the queue.
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  *
  *   Return: 
  *     struct prioqent* - A ponter to the first entry in the queue.
  *                        Can be NULL if the queue is empty.
  */
-struct prioqent *pq_getfirst();
+struct prioqent *pq_getfirst(struct prioq *pq);
 
 /* 
  *   pq_getfirstofid
@@ -198,6 +236,7 @@ struct prioqent *pq_getfirst();
  *     that matches the id.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int32_t id - The id to be matched by the entry
  * 
  *   Return: 
@@ -206,7 +245,7 @@ struct prioqent *pq_getfirst();
  *                        Can be NULL if the queue is empty or there is no
  *		          entry with that id.
  */
-struct prioqent *pq_getfirstofid(u_int32_t id);
+struct prioqent *pq_getfirstofid(struct prioq *pq, u_int32_t id);
 
 /* 
  *   pq_getfirstofidflags
@@ -216,6 +255,7 @@ struct prioqent *pq_getfirstofid(u_int32_t id);
  *     that matches the id.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int32_t id        - The id to be matched by the entry
  *     unsigned char flags - The flags to be matched
  *
@@ -225,7 +265,8 @@ struct prioqent *pq_getfirstofid(u_int32_t id);
  *                        Can be NULL if the queue is empty or there is no
  *		          entry with that id.
  */
-struct prioqent *pq_getfirstofidflags(u_int32_t id,unsigned char flags);
+struct prioqent *pq_getfirstofidflags(struct prioq *pq, u_int32_t id,
+				      unsigned char flags);
 
 /* 
  *   pq_deleteent
@@ -235,11 +276,12 @@ struct prioqent *pq_getfirstofidflags(u_int32_t id,unsigned char flags);
  *     by the argument. The entry is freed.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     struct prioqent *pqed - A pointer to the entry that shall be deleted.
  *
  *   Return: None
  */
-void pq_deleteent(struct prioqent *pqed);
+void pq_deleteent(struct prioq *pq, struct prioqent *pqed);
 
 /* 
  *   pq_deleteidflags
@@ -249,6 +291,7 @@ void pq_deleteent(struct prioqent *pqed);
  *     flag given as arguments. The entrys are freed.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int32_t id        - The id that shall be matched. 
  *     unsigned char flags - The flags that shall be matched 
  *                           (Can be PQ_FLAGS_ALLL for all flags). 
@@ -257,7 +300,7 @@ void pq_deleteent(struct prioqent *pqed);
  *   Note: Possible memory leak here, deleting entrys but not the data 
  *         Possible bug deleting entrys but they could be set as timers
  */
-void pq_deleteidflags(u_int32_t id,unsigned char flags);
+void pq_deleteidflags(struct prioq *pq, u_int32_t id,unsigned char flags);
 
 /* 
  *   pq_unqueuefirstent
@@ -265,11 +308,12 @@ void pq_deleteidflags(u_int32_t id,unsigned char flags);
  *   Description: 
  *     Remove but no delete the first entry in the queue. (not freed)
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  *
  *   Return: None
  */
-void pq_unqueuefirstent();
+void pq_unqueuefirstent(struct prioq *pq);
 
 /* 
  *   pq_unqueueidflags
@@ -279,12 +323,13 @@ void pq_unqueuefirstent();
  *     that matches the id and flags.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int32_t id        - The id to be matched by the entry
  *     unsigned char flags - The flags to be matched
  *
  *   Return: Void 
  */
-void pq_unqueueidflags(u_int32_t id,unsigned char flags);
+void pq_unqueueidflags(struct prioq *pq, u_int32_t id,unsigned char flags);
 
 /* 
  *   pq_deletefirstent
@@ -292,11 +337,12 @@ void pq_unqueueidflags(u_int32_t id,unsigned char flags);
  *   Description: 
  *     Deletes the first entry in the queue. 
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  *
  *   Return: None
  */
-void pq_deletefirstent();
+void pq_deletefirstent(struct prioq *pq);
 
 /* 
  *   pq_getfirstdue
@@ -307,6 +353,7 @@ void pq_deletefirstent();
  *     if the argument is greater than its tv value.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int64_t tv - the time that the elment to be returned shall be
  *                    lower than. This is not quite true due to the real
  *                    time timer vs. the timeslice for the process the
@@ -317,7 +364,7 @@ void pq_deletefirstent();
  *     struct prioqent* - Pointer to the first entry if the time tv was
  *                        right else NULL is returned.
  */
-struct prioqent *pq_getfirstdue(u_int64_t tv);
+struct prioqent *pq_getfirstdue(struct prioq *pq, u_int64_t tv);
 
 /* 
  *   pq_getfirstdueofid
@@ -327,6 +374,7 @@ struct prioqent *pq_getfirstdue(u_int64_t tv);
  *     matches the id given as argument.
  *
  *   Arguments: 
+ *     struct prioq *pq - The queue.
  *     u_int64_t tv - Same as pq_getfirstdue.
  *     u_int32_t id - The id that shall be matched.
  *
@@ -335,7 +383,8 @@ struct prioqent *pq_getfirstdue(u_int64_t tv);
  *                        id and if the time tv was right else
  *                        NULL is returned.
  */
-struct prioqent *pq_getfirstdueofid(u_int64_t tv,u_int32_t id);
+struct prioqent *pq_getfirstdueofid(struct prioq *pq, u_int64_t tv,
+				    u_int32_t id);
 
 /* 
  *   pq_print
@@ -343,10 +392,11 @@ struct prioqent *pq_getfirstdueofid(u_int64_t tv,u_int32_t id);
  *   Description: 
  *     Prints the prio queue.
  *
- *   Arguments: None
+ *   Arguments:
+ *     struct prioq *pq - The queue.
  * 
  *  Return: None
  */
-void pq_print();
+void pq_print(struct prioq *pq);
 
 #endif
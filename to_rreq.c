@@ -21,13 +21,15 @@
  *
  *	General description:
  *        Resends a queued RREQ if retries is lower than RREQ_RETRIES
- *	  otherwise it throws the package away and returns error
+ *	  otherwise it throws the package away and returns error.
+ *        The rings of the expanding ring search double in TTL up to
+ *        NET_DIAMETER. Only the RREQs over the whole network count as
+ *        retries, and the wait for the RREP doubles with each.
  *
  *	Internal procedures:
  *	
  *	External procedures:
  *        rreq_timeout
- *        hello_resend
  *
  ********************************
  *
@@ -35,6 +37,7 @@
  *
  */
 #include "to_rreq.h"
+#include "rerr.h"
 
 
 /* 
@@ -44,9 +47,14 @@
  *     Resends the RREQ in the input argument while keeping
  *     track of nr of times resent. If maximum times the 
  *     packet is thrown away and an error is returned by the
- *     function.
+ *     function. A route being repaired locally is then given up,
+ *     see repair_failed. Until the TTL reaches NET_DIAMETER each RREQ
+ *     doubles it, past TTL_TRESHOLD it goes to NET_DIAMETER at once.
+ *     The RREQs with NET_DIAMETER are the retries, each waits twice as
+ *     long as the one before (binary exponential backoff).
  *
  *   Arguments:
+ *     struct aodv_node *node - The node.
  *     struct rreq_tdata *rd - The data and the RREQ package that will be 
  *                             resent
  *
@@ -54,7 +62,7 @@
  *     int - Returns -1 on error or maximum retries otherwise 0
 */
 int
-rreq_timeout(struct rreq_tdata *rd)
+rreq_timeout(struct aodv_node *node, struct rreq_tdata *rd)
 {
   struct artentry *rte;
   struct info is;
@@ -65,7 +73,12 @@ rreq_timeout(struct rreq_tdata *rd)
     {
       /* Sent it maximum times */
       
-      /* Do nothing except freeing*/
+      /* A local repair that found nothing is reported now */
+      if ((rte = getentry(node, (rd->rd)->dst_ip)) != NULL &&
+	  (rte->rt_flags & RT_REPAIR))
+	repair_failed(node, rte);
+
+      /* Do nothing else except freeing*/
       free((rd->rd));
       free(rd);
       
@@ -74,18 +87,14 @@ rreq_timeout(struct rreq_tdata *rd)
     }
   else 
     {
-      /* Increment nr of retries */
-      rd->retries++;
-      
-      /* Check new TTL */
-      if (rd->ttl > TTL_TRESHOLD)
+      /* Check new TTL, only the RREQs over the whole network are
+	 retries */
+      if (rd->ttl >= NET_DIAMETER)
+	rd->retries++;
+      else if (rd->ttl > TTL_TRESHOLD)
 	rd->ttl = NET_DIAMETER;
       else
-	rd->ttl += TTL_INCREMENT;
-      
-      /* Update broadcast id if available */
-      if ((rte = getentry(rd->dst_ip)) != NULL)
-	rte->broadcast_id++;
+	rd->ttl = MIN(2 * rd->ttl, NET_DIAMETER);
       
       /* Fill in struct */
       is.ip_pkt_dst_ip = rd->dst_ip;
@@ -93,66 +102,26 @@ rreq_timeout(struct rreq_tdata *rd)
       is.ip_pkt_src_ip = (rd->rd)->src_ip;
       is.ip_pkt_my_ip = (rd->rd)->src_ip;
       
-      /* Update broadcast id */
-      ((rd->rd)->broadcast_id)++;
+      /* A new broadcast id from the source */
+      if ((rte = getentry(node, (rd->rd)->src_ip)) != NULL)
+	(rd->rd)->broadcast_id = (rte->broadcast_id)++;
       
-      if (add_rreq((rd->rd)->src_ip, (rd->rd)->broadcast_id, 
-		   getcurrtime() + BCAST_ID_SAVE) == -1)
+      if (add_rreq(node, (rd->rd)->src_ip, (rd->rd)->broadcast_id, 
+		   getcurrtime() + broadcast_record_time(node)) == -1)
 	  /* Couldn't add to broadcast list */
 	  return -1;
       
       /* Send packet again */
-      send_datagram(&is, rd->rd, sizeof(struct rreq));
+      send_datagram(node, &is, rd->rd, sizeof(struct rreq));
       
-      /* Set a new timer */
+      /* Set a new timer, it doubles with each retry. A RREP may now
+	 answer either RREQ, it gives no round trip time */
       currtime = getcurrtime();
-      pq_insert(currtime + 2 * rd->ttl * NODE_TRAVERSAL_TIME, rd, 
-		(rd->rd)->dst_ip, PQ_PACKET_RREQ);
+      rd->sent = 0;
+      pq_insert(&node->pq,
+		currtime + (ring_traversal_time(node, rd->ttl) << rd->retries),
+		rd, (rd->rd)->dst_ip, PQ_PACKET_RREQ);
     }
   
   return 0;
 }
-
-/* 
- *   hello_resend
- *
- *   Description: 
- *     Resends the HELLO message and puts it back in the timer queue.
- *
- *   Arguments:
- *     struct rreq_tdata *rd - The data and the HELLO package that will
- *                             be resent.
- *
- *   Return: None
- */
-void
-hello_resend(struct rreq_tdata *rd)
-{
-  struct artentry *rte;
-  struct info is;
-  u_int64_t currtime;
-  
-  /* Fill in struct */
-  is.ip_pkt_dst_ip = rd->dst_ip;
-  is.ip_pkt_ttl = rd->ttl;
-  is.ip_pkt_src_ip = (rd->rd)->src_ip;
-  is.ip_pkt_my_ip = (rd->rd)->src_ip;
-
-  if ((rte = getentry((rd->rd)->src_ip)) != NULL)
-    {
-      (rd->rd)->src_seq = rte->dst_seq;
-      (rd->rd)->broadcast_id = rte->broadcast_id;
-      (rd->rd)->hop_cnt = rte->hop_cnt;
-      (rd->rd)->dst_seq = 0;
-    }
-  
-  
-  /* Send packet again */
-  send_datagram(&is, rd->rd, sizeof(struct rreq));
-  
-  /* Set a new timer */
-  currtime = getcurrtime();
-  pq_insert(currtime + HELLO_INTERVAL, rd, (rd->rd)->dst_ip, 
-	    PQ_PACKET_HELLO);
-  
-}
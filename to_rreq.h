@@ -21,13 +21,15 @@
  *
  *	General description:
  *        Resends a queued RREQ if retries is lower than RREQ_RETRIES
- *	  otherwise it throws the package away and returns error
+ *	  otherwise it throws the package away and returns error.
+ *        The rings of the expanding ring search double in TTL up to
+ *        NET_DIAMETER. Only the RREQs over the whole network count as
+ *        retries, and the wait for the RREP doubles with each.
  *
  *	Internal procedures:
  *	
  *	External procedures:
  *        rreq_timeout
- *        hello_resend
  *
  ********************************
  *
@@ -41,14 +43,16 @@
 #include "timer.h"
 #include "RT.h"
 #include "rreq_list.h"
+#include "rtt.h"
 
 /* A structure for packets in the data field */
 struct rreq_tdata
 {
   struct rreq *rd; /* Pointer to a RREQ packet */
-  int retries;     /* Number of times resent */
+  int retries;     /* Number of times resent with NET_DIAMETER */
   int ttl;         /* The last sent TTL */
   u_int32_t dst_ip;/* The destination to send the RREQ to */
+  u_int64_t sent;  /* When it was sent, 0 once resent, see rtt_sample */
 };
 
 /* 
@@ -58,30 +62,21 @@ struct rreq_tdata
  *     Resends the RREQ in the input argument while keeping
  *     track of nr of times resent. If maximum times the 
  *     packet is thrown away and an error is returned by the
- *     function.
+ *     function. A route being repaired locally is then given up,
+ *     see repair_failed. Until the TTL reaches NET_DIAMETER each RREQ
+ *     doubles it, past TTL_TRESHOLD it goes to NET_DIAMETER at once.
+ *     The RREQs with NET_DIAMETER are the retries, each waits twice as
+ *     long as the one before (binary exponential backoff).
  *
  *   Arguments:
+ *     struct aodv_node *node - The node.
  *     struct rreq_tdata *rd - The data and the RREQ package that will be 
  *                             resent
  *
  *   Return:
  *     int - Returns -1 on error or maximum retries otherwise 0
  */
-int rreq_timeout(struct rreq_tdata *rd);
-
-/*  
- *   hello_resend
- *
- *   Description: 
- *     Resends the HELLO message and puts it back in the timer queue.
- *
- *   Arguments:
- *     struct rreq_tdata *rd - The data and the HELLO package that will be
- *                             resent.
- *
- *   Return: None
- */
-void hello_resend(struct rreq_tdata *rd);
+int rreq_timeout(struct aodv_node *node, struct rreq_tdata *rd);
 
 #endif
 
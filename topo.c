@@ -0,0 +1,1009 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Node placement and movement for aodv_sim. Generates a grid, a
+ *        line, a random geometric graph or clusters, or loads the
+ *        positions and moves of an ns-2 setdest scenario. Moves the
+ *        nodes by random waypoint, Gauss-Markov or reference point group
+ *        mobility, or by the setdest commands. Two nodes are neighbours
+ *        when they are within radio range of each other.
+ *
+ *        Nodes are numbered so that nearby nodes have nearby numbers,
+ *        a block of consecutive nodes then covers an area of its own.
+ *        All randomness comes from the seed given to topo_init, so the
+ *        same seed and options give the same positions and moves.
+ *
+ *	Internal procedures:
+ *        topo_random
+ *        topo_uniform
+ *        topo_gauss
+ *        topo_cmp
+ *        topo_renumber
+ *        topo_target
+ *        topo_toward
+ *        topo_waypoint
+ *        topo_gaussmarkov
+ *        topo_group
+ *        topo_advance
+ *
+ *	External procedures:
+ *        topo_init
+ *        topo_load
+ *        topo_mobility
+ *        topo_step
+ *        topo_links
+ *        topo_free
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "topo.h"
+
+char *topo_kinds[] = { "grid", "line", "rgg", "cluster", "file", NULL };
+char *topo_models[] = { "none", "waypoint", "gauss", "group", "file", NULL };
+
+/* Pre-declaration of internal functions */
+u_int64_t topo_random(struct topo *t);
+double topo_uniform(struct topo *t);
+double topo_gauss(struct topo *t);
+int topo_cmp(const void *a, const void *b);
+int topo_renumber(struct topo *t, int *map);
+void topo_target(struct topo *t, struct topo_node *nd);
+double topo_toward(double *x, double *y, double tx, double ty, double speed,
+		   double dt);
+void topo_waypoint(struct topo *t, struct topo_node *nd, double dt);
+void topo_gaussmarkov(struct topo *t, struct topo_node *nd, double dt);
+void topo_group(struct topo *t, double dt);
+void topo_advance(struct topo *t, double dt);
+
+/*
+ *   topo_random
+ *
+ *   Description:
+ *     Returns the next number of the generator (xorshift64*).
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *
+ *   Return:
+ *     u_int64_t - The number.
+ */
+u_int64_t
+topo_random(struct topo *t)
+{
+  t->rng ^= t->rng >> 12;
+  t->rng ^= t->rng << 25;
+  t->rng ^= t->rng >> 27;
+
+  return t->rng * 2685821657736338717ULL;
+}
+
+/*
+ *   topo_uniform
+ *
+ *   Description:
+ *     Returns a random number, uniform in [0, 1).
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *
+ *   Return:
+ *     double - The number.
+ */
+double
+topo_uniform(struct topo *t)
+{
+  return (topo_random(t) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ *   topo_gauss
+ *
+ *   Description:
+ *     Returns a random number with the standard normal distribution
+ *     (Box-Muller).
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *
+ *   Return:
+ *     double - The number.
+ */
+double
+topo_gauss(struct topo *t)
+{
+  double u;
+  double v;
+
+  u = 1.0 - topo_uniform(t);
+  v = topo_uniform(t);
+
+  return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/*
+ *   topo_cmp
+ *
+ *   Description:
+ *     Orders the sort keys of two nodes from west to east, then from
+ *     south to north.
+ *
+ *   Arguments:
+ *     const void *a - A struct topo_key.
+ *     const void *b - A struct topo_key.
+ *
+ *   Return:
+ *     int - Less than, equal to or greater than 0 as for qsort.
+ */
+int
+topo_cmp(const void *a, const void *b)
+{
+  const struct topo_key *ka = a;
+  const struct topo_key *kb = b;
+
+  if (ka->x != kb->x)
+    return ka->x < kb->x ? -1 : 1;
+  if (ka->y != kb->y)
+    return ka->y < kb->y ? -1 : 1;
+
+  return ka->old - kb->old;
+}
+
+/*
+ *   topo_renumber
+ *
+ *   Description:
+ *     Numbers the nodes from west to east, so that a block of
+ *     consecutive nodes is a strip of the area.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *     int *map       - Where the new number of each old one is put, or
+ *                      NULL.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+topo_renumber(struct topo *t, int *map)
+{
+  struct topo_node *node;
+  struct topo_key *key;
+  int i;
+
+  if ((key = malloc(t->n * sizeof(struct topo_key))) == NULL)
+    return -1;
+
+  if ((node = malloc(t->n * sizeof(struct topo_node))) == NULL)
+    {
+      free(key);
+      return -1;
+    }
+
+  for (i = 0; i < t->n; i++)
+    {
+      key[i].x = t->node[i].x;
+      key[i].y = t->node[i].y;
+      key[i].old = i;
+    }
+  qsort(key, t->n, sizeof(struct topo_key), topo_cmp);
+
+  for (i = 0; i < t->n; i++)
+    {
+      node[i] = t->node[key[i].old];
+      if (map != NULL)
+	map[key[i].old] = i;
+    }
+
+  free(t->node);
+  t->node = node;
+  free(key);
+
+  return 0;
+}
+
+/*
+ *   topo_init
+ *
+ *   Description:
+ *     Places the nodes. A random geometric graph and the clusters are
+ *     spread over a square just large enough for the mean number of
+ *     neighbours asked for. The links are not made, see topo_links.
+ *
+ *   Arguments:
+ *     struct topo *t  - The topology.
+ *     int kind        - TOPO_GRID, TOPO_LINE, TOPO_RGG or TOPO_CLUSTER.
+ *     int n           - Number of nodes.
+ *     double range    - Radio range, m.
+ *     double degree   - Mean number of neighbours of TOPO_RGG and
+ *                       TOPO_CLUSTER.
+ *     u_int64_t seed  - Seed of the placement and the mobility.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+topo_init(struct topo *t, int kind, int n, double range, double degree,
+	  u_int64_t seed)
+{
+  struct topo_node *nd;
+  double *cx;
+  double *cy;
+  double spacing;
+  double side;
+  double sigma;
+  int nclusters;
+  int cols;
+  int i;
+
+  memset(t, 0, sizeof(struct topo));
+  if (n < 1 || range <= 0 || degree <= 0)
+    return -1;
+
+  t->kind = kind;
+  t->n = n;
+  t->range = range;
+  /* A zero state would stay zero */
+  t->rng = seed * 0x9e3779b97f4a7c15ULL + 2;
+
+  if ((t->node = calloc(n, sizeof(struct topo_node))) == NULL)
+    return -1;
+
+  spacing = TOPO_SPACING * range;
+  side = sqrt(n * M_PI * range * range / degree);
+
+  switch (kind)
+    {
+    case TOPO_GRID:
+      /* Row by row, the rows are strips already */
+      cols = (int)ceil(sqrt(n));
+      for (i = 0; i < n; i++)
+	{
+	  t->node[i].x = (i % cols) * spacing;
+	  t->node[i].y = (i / cols) * spacing;
+	}
+      t->width = (cols - 1) * spacing;
+      t->height = ((n - 1) / cols) * spacing;
+      return 0;
+
+    case TOPO_LINE:
+      for (i = 0; i < n; i++)
+	t->node[i].x = i * spacing;
+      t->width = (n - 1) * spacing;
+      return 0;
+
+    case TOPO_RGG:
+      for (nd = t->node; nd < t->node + n; nd++)
+	{
+	  nd->x = topo_uniform(t) * side;
+	  nd->y = topo_uniform(t) * side;
+	}
+      break;
+
+    case TOPO_CLUSTER:
+      nclusters = MAX(1, (n + TOPO_CLUSTER_SIZE / 2) / TOPO_CLUSTER_SIZE);
+      sigma = MIN(range, side / 4);
+      cx = malloc(nclusters * sizeof(double));
+      cy = malloc(nclusters * sizeof(double));
+      if (cx == NULL || cy == NULL)
+	{
+	  free(cx);
+	  free(cy);
+	  return -1;
+	}
+
+      for (i = 0; i < nclusters; i++)
+	{
+	  cx[i] = sigma + topo_uniform(t) * (side - 2 * sigma);
+	  cy[i] = sigma + topo_uniform(t) * (side - 2 * sigma);
+	}
+
+      for (i = 0; i < n; i++)
+	{
+	  nd = &t->node[i];
+	  nd->x = cx[i % nclusters] + topo_gauss(t) * sigma;
+	  nd->y = cy[i % nclusters] + topo_gauss(t) * sigma;
+	  nd->x = MIN(MAX(nd->x, 0), side);
+	  nd->y = MIN(MAX(nd->y, 0), side);
+	}
+
+      free(cx);
+      free(cy);
+      break;
+
+    default:
+      return -1;
+    }
+
+  t->width = side;
+  t->height = side;
+
+  return topo_renumber(t, NULL);
+}
+
+/*
+ *   topo_load
+ *
+ *   Description:
+ *     Places the nodes as in an ns-2 setdest scenario, and keeps its
+ *     setdest commands for MOB_FILE. Other lines are skipped. The
+ *     nodes are renumbered, see above.
+ *
+ *   Arguments:
+ *     struct topo *t  - The topology.
+ *     char *file      - The scenario.
+ *     double range    - Radio range, m.
+ *     u_int64_t seed  - Seed of other mobility models.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+topo_load(struct topo *t, char *file, double range, u_int64_t seed)
+{
+  struct topo_node *node;
+  struct topo_cmd *cmd;
+  struct topo_cmd tmp;
+  char line[256];
+  double v;
+  FILE *fp;
+  int *map;
+  int maxcmd = 0;
+  int max = 0;
+  int i;
+  int j;
+  char c;
+
+  memset(t, 0, sizeof(struct topo));
+  t->kind = TOPO_FILE;
+  t->range = range;
+  t->rng = seed * 0x9e3779b97f4a7c15ULL + 2;
+
+  if (range <= 0 || (fp = fopen(file, "r")) == NULL)
+    return -1;
+
+  while (fgets(line, sizeof(line), fp) != NULL)
+    {
+      if (sscanf(line, " $node_(%d) set %c_ %lf", &i, &c, &v) == 3)
+	tmp.node = i;
+      else if (sscanf(line, " $ns_ at %lf \"$node_(%d) setdest %lf %lf %lf",
+		      &tmp.time, &tmp.node, &tmp.x, &tmp.y, &tmp.speed) == 5)
+	c = 0;
+      else
+	continue;
+
+      if (tmp.node < 0 || tmp.node >= 0xffffff)
+	continue;
+
+      if (tmp.node >= max)
+	{
+	  max = MAX(2 * max, tmp.node + 1);
+	  if ((node = realloc(t->node, max * sizeof(struct topo_node)))
+	      == NULL)
+	    goto fail;
+	  memset(node + t->n, 0, (max - t->n) * sizeof(struct topo_node));
+	  t->node = node;
+	}
+      t->n = MAX(t->n, tmp.node + 1);
+
+      if (c == 'X')
+	t->node[tmp.node].x = v;
+      else if (c == 'Y')
+	t->node[tmp.node].y = v;
+      else if (c == 0 && tmp.time >= 0 && tmp.speed >= 0)
+	{
+	  if (t->ncmd == maxcmd)
+	    {
+	      maxcmd = maxcmd ? 2 * maxcmd : 1024;
+	      if ((cmd = realloc(t->cmd, maxcmd * sizeof(struct topo_cmd)))
+		  == NULL)
+		goto fail;
+	      t->cmd = cmd;
+	    }
+	  t->cmd[t->ncmd++] = tmp;
+	}
+    }
+  fclose(fp);
+
+  if (t->n == 0)
+    return -1;
+
+  for (i = 0; i < t->n; i++)
+    {
+      t->width = MAX(t->width, t->node[i].x);
+      t->height = MAX(t->height, t->node[i].y);
+    }
+
+  if ((map = malloc(t->n * sizeof(int))) == NULL ||
+      topo_renumber(t, map) == -1)
+    {
+      free(map);
+      return -1;
+    }
+
+  for (i = 0; i < t->ncmd; i++)
+    {
+      t->cmd[i].node = map[t->cmd[i].node];
+      t->width = MAX(t->width, t->cmd[i].x);
+      t->height = MAX(t->height, t->cmd[i].y);
+    }
+  free(map);
+
+  /* In time order, ties as in the file. Scenarios mostly are in order
+     already, so this is about linear */
+  for (i = 1; i < t->ncmd; i++)
+    {
+      tmp = t->cmd[i];
+      for (j = i; j > 0 && t->cmd[j - 1].time > tmp.time; j--)
+	t->cmd[j] = t->cmd[j - 1];
+      t->cmd[j] = tmp;
+    }
+
+  return 0;
+
+ fail:
+  fclose(fp);
+  return -1;
+}
+
+/*
+ *   topo_target
+ *
+ *   Description:
+ *     Gives a node a new random waypoint and speed.
+ *
+ *   Arguments:
+ *     struct topo *t         - The topology.
+ *     struct topo_node *nd   - The node, or reference point.
+ *
+ *   Return: None
+ */
+void
+topo_target(struct topo *t, struct topo_node *nd)
+{
+  nd->tx = topo_uniform(t) * t->width;
+  nd->ty = topo_uniform(t) * t->height;
+  if (t->vmax > TOPO_MINSPEED)
+    nd->speed = TOPO_MINSPEED + topo_uniform(t) * (t->vmax - TOPO_MINSPEED);
+  else
+    nd->speed = t->vmax;
+}
+
+/*
+ *   topo_toward
+ *
+ *   Description:
+ *     Moves a point in a straight line toward a target.
+ *
+ *   Arguments:
+ *     double *x     - The point, m.
+ *     double *y
+ *     double tx     - The target, m.
+ *     double ty
+ *     double speed  - m/s.
+ *     double dt     - For how long, s.
+ *
+ *   Return:
+ *     double - The time left when the target was reached, else -1.
+ */
+double
+topo_toward(double *x, double *y, double tx, double ty, double speed,
+	    double dt)
+{
+  double dist;
+  double left;
+
+  dist = hypot(tx - *x, ty - *y);
+  if (speed <= 0)
+    return dist == 0 ? dt : -1;
+
+  left = dt - dist / speed;
+  if (left >= 0)
+    {
+      *x = tx;
+      *y = ty;
+      return left;
+    }
+
+  *x += (tx - *x) * speed * dt / dist;
+  *y += (ty - *y) * speed * dt / dist;
+
+  return -1;
+}
+
+/*
+ *   topo_waypoint
+ *
+ *   Description:
+ *     Random waypoint: a node goes to a random point at a random speed,
+ *     pauses and goes on to the next.
+ *
+ *   Arguments:
+ *     struct topo *t         - The topology.
+ *     struct topo_node *nd   - The node, or reference point.
+ *     double dt              - For how long, s.
+ *
+ *   Return: None
+ */
+void
+topo_waypoint(struct topo *t, struct topo_node *nd, double dt)
+{
+  double left;
+
+  while (dt > 0)
+    {
+      if (nd->pause > 0)
+	{
+	  left = MIN(nd->pause, dt);
+	  nd->pause -= left;
+	  dt -= left;
+	  continue;
+	}
+
+      if ((left = topo_toward(&nd->x, &nd->y, nd->tx, nd->ty, nd->speed, dt))
+	  < 0)
+	break;
+
+      dt = left;
+      nd->pause = t->pause;
+      topo_target(t, nd);
+      if (nd->speed <= 0)
+	break;
+    }
+}
+
+/*
+ *   topo_gaussmarkov
+ *
+ *   Description:
+ *     Gauss-Markov: speed and heading drift around their means, with
+ *     memory TOPO_GM_ALPHA per second. Near the edge of the area the
+ *     mean heading turns to its centre.
+ *
+ *   Arguments:
+ *     struct topo *t         - The topology.
+ *     struct topo_node *nd   - The node.
+ *     double dt              - For how long, s.
+ *
+ *   Return: None
+ */
+void
+topo_gaussmarkov(struct topo *t, struct topo_node *nd, double dt)
+{
+  double a;
+  double b;
+
+  a = pow(TOPO_GM_ALPHA, dt);
+  b = sqrt(1 - a * a);
+
+  if (nd->x < t->range || nd->x > t->width - t->range ||
+      nd->y < t->range || nd->y > t->height - t->range)
+    nd->mdir = atan2(t->height / 2 - nd->y, t->width / 2 - nd->x);
+
+  nd->speed = a * nd->speed + (1 - a) * t->vmax / 2 +
+    b * topo_gauss(t) * t->vmax / 4;
+  nd->speed = MIN(MAX(nd->speed, 0), t->vmax);
+  nd->dir = a * nd->dir + (1 - a) * nd->mdir + b * topo_gauss(t) * M_PI / 4;
+
+  nd->x += nd->speed * cos(nd->dir) * dt;
+  nd->y += nd->speed * sin(nd->dir) * dt;
+  nd->x = MIN(MAX(nd->x, 0), t->width);
+  nd->y = MIN(MAX(nd->y, 0), t->height);
+}
+
+/*
+ *   topo_group
+ *
+ *   Description:
+ *     Reference point group mobility: each group of TOPO_GROUP_SIZE
+ *     consecutive nodes follows a reference point that moves by random
+ *     waypoint. Each member strays around it, within the group radius.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *     double dt      - For how long, s.
+ *
+ *   Return: None
+ */
+void
+topo_group(struct topo *t, double dt)
+{
+  struct topo_node *ref;
+  struct topo_node *nd;
+  double radius;
+  double r;
+  double a;
+  int i;
+
+  radius = TOPO_GROUP_RADIUS * t->range;
+
+  for (i = 0; i < t->nref; i++)
+    topo_waypoint(t, &t->ref[i], dt);
+
+  for (i = 0; i < t->n; i++)
+    {
+      nd = &t->node[i];
+      ref = &t->ref[i / TOPO_GROUP_SIZE];
+
+      if (topo_toward(&nd->ox, &nd->oy, nd->tx, nd->ty, nd->speed, dt) >= 0)
+	{
+	  /* A new offset, uniform in the disc */
+	  r = radius * sqrt(topo_uniform(t));
+	  a = 2 * M_PI * topo_uniform(t);
+	  nd->tx = r * cos(a);
+	  nd->ty = r * sin(a);
+	}
+
+      nd->x = MIN(MAX(ref->x + nd->ox, 0), t->width);
+      nd->y = MIN(MAX(ref->y + nd->oy, 0), t->height);
+    }
+}
+
+/*
+ *   topo_mobility
+ *
+ *   Description:
+ *     Chooses how the nodes move. MOB_FILE needs a scenario loaded
+ *     with topo_load.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *     int model      - MOB_ constant.
+ *     double vmax    - Highest speed, m/s.
+ *     double pause   - Pause at each random waypoint, s.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+topo_mobility(struct topo *t, int model, double vmax, double pause)
+{
+  struct topo_node *nd;
+  struct topo_node *ref;
+  int i;
+
+  if (model < MOB_NONE || model > MOB_FILE ||
+      (model == MOB_FILE && t->kind != TOPO_FILE) ||
+      (model != MOB_NONE && model != MOB_FILE && vmax <= 0) || pause < 0)
+    return -1;
+
+  t->model = model;
+  t->vmax = vmax;
+  t->pause = pause;
+
+  switch (model)
+    {
+    case MOB_WAYPOINT:
+      for (nd = t->node; nd < t->node + t->n; nd++)
+	topo_target(t, nd);
+      break;
+
+    case MOB_GAUSS:
+      for (nd = t->node; nd < t->node + t->n; nd++)
+	{
+	  nd->speed = vmax / 2;
+	  nd->dir = 2 * M_PI * topo_uniform(t);
+	  nd->mdir = nd->dir;
+	}
+      break;
+
+    case MOB_GROUP:
+      t->nref = (t->n + TOPO_GROUP_SIZE - 1) / TOPO_GROUP_SIZE;
+      if ((t->ref = calloc(t->nref, sizeof(struct topo_node))) == NULL)
+	return -1;
+
+      /* The reference point starts in the middle of its group */
+      for (i = 0; i < t->n; i++)
+	{
+	  ref = &t->ref[i / TOPO_GROUP_SIZE];
+	  ref->x += t->node[i].x / MIN(TOPO_GROUP_SIZE,
+				       t->n - i / TOPO_GROUP_SIZE *
+				       TOPO_GROUP_SIZE);
+	  ref->y += t->node[i].y / MIN(TOPO_GROUP_SIZE,
+				       t->n - i / TOPO_GROUP_SIZE *
+				       TOPO_GROUP_SIZE);
+	}
+      for (i = 0; i < t->nref; i++)
+	topo_target(t, &t->ref[i]);
+
+      for (i = 0; i < t->n; i++)
+	{
+	  nd = &t->node[i];
+	  ref = &t->ref[i / TOPO_GROUP_SIZE];
+	  nd->ox = nd->x - ref->x;
+	  nd->oy = nd->y - ref->y;
+	  nd->tx = 0;
+	  nd->ty = 0;
+	  nd->speed = MIN(TOPO_MINSPEED, vmax);
+	}
+      break;
+
+    case MOB_FILE:
+      for (nd = t->node; nd < t->node + t->n; nd++)
+	{
+	  nd->tx = nd->x;
+	  nd->ty = nd->y;
+	  nd->speed = 0;
+	}
+      break;
+    }
+
+  return 0;
+}
+
+/*
+ *   topo_advance
+ *
+ *   Description:
+ *     Moves all nodes by the mobility model.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *     double dt      - For how long, s.
+ *
+ *   Return: None
+ */
+void
+topo_advance(struct topo *t, double dt)
+{
+  struct topo_node *nd;
+
+  if (dt <= 0)
+    return;
+
+  switch (t->model)
+    {
+    case MOB_WAYPOINT:
+      for (nd = t->node; nd < t->node + t->n; nd++)
+	topo_waypoint(t, nd, dt);
+      break;
+
+    case MOB_GAUSS:
+      for (nd = t->node; nd < t->node + t->n; nd++)
+	topo_gaussmarkov(t, nd, dt);
+      break;
+
+    case MOB_GROUP:
+      topo_group(t, dt);
+      break;
+
+    case MOB_FILE:
+      /* A node stops at its destination */
+      for (nd = t->node; nd < t->node + t->n; nd++)
+	if (topo_toward(&nd->x, &nd->y, nd->tx, nd->ty, nd->speed, dt) >= 0)
+	  nd->speed = 0;
+      break;
+    }
+
+  t->now += dt;
+}
+
+/*
+ *   topo_step
+ *
+ *   Description:
+ *     Moves the nodes forward to a later time. Setdest commands take
+ *     effect at their time.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *     double now     - The time, s since the start.
+ *
+ *   Return: None
+ */
+void
+topo_step(struct topo *t, double now)
+{
+  struct topo_cmd *c;
+
+  if (t->model == MOB_FILE)
+    while (t->nextcmd < t->ncmd && t->cmd[t->nextcmd].time <= now)
+      {
+	c = &t->cmd[t->nextcmd++];
+	topo_advance(t, c->time - t->now);
+	t->node[c->node].tx = c->x;
+	t->node[c->node].ty = c->y;
+	t->node[c->node].speed = c->speed;
+      }
+
+  topo_advance(t, now - t->now);
+}
+
+/*
+ *   topo_links
+ *
+ *   Description:
+ *     Finds the neighbours of all nodes at their positions and counts
+ *     the links that changed since the last time.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int
+topo_links(struct topo *t)
+{
+  struct topo_node *a;
+  struct topo_node *b;
+  double minx;
+  double miny;
+  double maxx;
+  double maxy;
+  double cell;
+  int *first;
+  int *head;
+  int *next;
+  int *nbr;
+  int *grown;
+  int nbrmax;
+  int ncx;
+  int ncy;
+  int cx;
+  int cy;
+  int x;
+  int y;
+  int i;
+  int j;
+  int k;
+  int m = 0;
+  int n = 0;
+
+  minx = maxx = t->node[0].x;
+  miny = maxy = t->node[0].y;
+  for (a = t->node; a < t->node + t->n; a++)
+    {
+      minx = MIN(minx, a->x);
+      maxx = MAX(maxx, a->x);
+      miny = MIN(miny, a->y);
+      maxy = MAX(maxy, a->y);
+    }
+
+  /* Cells no smaller than the range, a neighbour is then in the same
+     or the next cell. Sparse areas get larger cells */
+  cell = t->range;
+  while ((double)((maxx - minx) / cell + 1) * ((maxy - miny) / cell + 1) >
+	 4.0 * t->n + 16)
+    cell *= 2;
+  ncx = (int)((maxx - minx) / cell) + 1;
+  ncy = (int)((maxy - miny) / cell) + 1;
+
+  nbrmax = MAX(t->nbrmax, 16);
+  head = malloc(ncx * ncy * sizeof(int));
+  next = malloc(t->n * sizeof(int));
+  first = malloc((t->n + 1) * sizeof(int));
+  nbr = malloc(nbrmax * sizeof(int));
+  if (head == NULL || next == NULL || first == NULL || nbr == NULL)
+    goto fail;
+
+  for (i = 0; i < ncx * ncy; i++)
+    head[i] = -1;
+  for (i = t->n - 1; i >= 0; i--)
+    {
+      k = (int)((t->node[i].y - miny) / cell) * ncx +
+	(int)((t->node[i].x - minx) / cell);
+      next[i] = head[k];
+      head[k] = i;
+    }
+
+  for (i = 0; i < t->n; i++)
+    {
+      a = &t->node[i];
+      cx = (int)((a->x - minx) / cell);
+      cy = (int)((a->y - miny) / cell);
+      first[i] = n;
+
+      for (y = MAX(cy - 1, 0); y <= MIN(cy + 1, ncy - 1); y++)
+	for (x = MAX(cx - 1, 0); x <= MIN(cx + 1, ncx - 1); x++)
+	  for (j = head[y * ncx + x]; j != -1; j = next[j])
+	    {
+	      b = &t->node[j];
+	      if (j == i || (a->x - b->x) * (a->x - b->x) +
+		  (a->y - b->y) * (a->y - b->y) > t->range * t->range)
+		continue;
+
+	      if (n == nbrmax)
+		{
+		  nbrmax *= 2;
+		  if ((grown = realloc(nbr, nbrmax * sizeof(int))) == NULL)
+		    goto fail;
+		  nbr = grown;
+		}
+
+	      /* Kept in increasing order */
+	      for (k = n++; k > first[i] && nbr[k - 1] > j; k--)
+		nbr[k] = nbr[k - 1];
+	      nbr[k] = j;
+	    }
+    }
+  first[t->n] = n;
+
+  /* Compare with the last links, both lists are in order */
+  if (t->first != NULL)
+    for (i = 0; i < t->n; i++)
+      {
+	j = t->first[i];
+	k = first[i];
+	while (j < t->first[i + 1] || k < first[i + 1])
+	  {
+	    if (k == first[i + 1] ||
+		(j < t->first[i + 1] && t->nbr[j] < nbr[k]))
+	      j++;
+	    else if (j == t->first[i + 1] || nbr[k] < t->nbr[j])
+	      k++;
+	    else
+	      {
+		j++;
+		k++;
+		continue;
+	      }
+	    m++;
+	  }
+      }
+  /* Each link is seen from both ends */
+  t->changes += m / 2;
+
+  free(t->first);
+  free(t->nbr);
+  t->first = first;
+  t->nbr = nbr;
+  t->nbrmax = nbrmax;
+  t->nlinks = n / 2;
+
+  free(head);
+  free(next);
+
+  return 0;
+
+ fail:
+  free(head);
+  free(next);
+  free(first);
+  free(nbr);
+  return -1;
+}
+
+/*
+ *   topo_free
+ *
+ *   Description:
+ *     Frees the nodes, commands and links.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *
+ *   Return: None
+ */
+void
+topo_free(struct topo *t)
+{
+  free(t->node);
+  free(t->ref);
+  free(t->cmd);
+  free(t->first);
+  free(t->nbr);
+  memset(t, 0, sizeof(struct topo));
+}
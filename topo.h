@@ -0,0 +1,274 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Node placement and movement for aodv_sim. Generates a grid, a
+ *        line, a random geometric graph or clusters, or loads the
+ *        positions and moves of an ns-2 setdest scenario. Moves the
+ *        nodes by random waypoint, Gauss-Markov or reference point group
+ *        mobility, or by the setdest commands. Two nodes are neighbours
+ *        when they are within radio range of each other.
+ *
+ *        Nodes are numbered so that nearby nodes have nearby numbers,
+ *        a block of consecutive nodes then covers an area of its own.
+ *        All randomness comes from the seed given to topo_init, so the
+ *        same seed and options give the same positions and moves.
+ *
+ *	Internal procedures:
+ *        topo_random
+ *        topo_uniform
+ *        topo_gauss
+ *        topo_cmp
+ *        topo_renumber
+ *        topo_target
+ *        topo_toward
+ *        topo_waypoint
+ *        topo_gaussmarkov
+ *        topo_group
+ *        topo_advance
+ *
+ *	External procedures:
+ *        topo_init
+ *        topo_load
+ *        topo_mobility
+ *        topo_step
+ *        topo_links
+ *        topo_free
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef TOPO_H
+#define TOPO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/types.h>
+
+#include "aodv.h"
+
+/* Placements */
+#define TOPO_GRID     0         /* Square grid, links to the 4 nearest */
+#define TOPO_LINE     1         /* Chain */
+#define TOPO_RGG      2         /* Uniform in a square */
+#define TOPO_CLUSTER  3         /* Gaussian clusters in a square */
+#define TOPO_FILE     4         /* From a setdest scenario */
+
+/* Mobility models */
+#define MOB_NONE      0
+#define MOB_WAYPOINT  1         /* Random waypoint */
+#define MOB_GAUSS     2         /* Gauss-Markov */
+#define MOB_GROUP     3         /* Reference point group mobility */
+#define MOB_FILE      4         /* The setdest commands */
+
+/* Grid and line spacing, as a part of the radio range */
+#define TOPO_SPACING      0.9
+
+/* Mean number of nodes per cluster */
+#define TOPO_CLUSTER_SIZE 50
+
+/* Nodes per group, and how far they stray from the reference point, as
+   a part of the radio range */
+#define TOPO_GROUP_SIZE   10
+#define TOPO_GROUP_RADIUS 0.5
+
+/* Lowest random waypoint speed, m/s. Keeps the mean speed from
+   decaying towards zero */
+#define TOPO_MINSPEED     1.0
+
+/* Memory of the Gauss-Markov model per second, 0 to 1 */
+#define TOPO_GM_ALPHA     0.75
+
+/* Names of the placements and the models, indexed by the constants
+   above, ending with NULL */
+extern char *topo_kinds[];
+extern char *topo_models[];
+
+struct topo_node
+{
+  double x;                     /* Position, m */
+  double y;
+  double tx;                    /* Where it is heading, m. A group */
+  double ty;                    /* member heads for an offset */
+  double speed;                 /* m/s */
+  double dir;                   /* Heading, rad (Gauss-Markov) */
+  double mdir;                  /* Mean heading, rad (Gauss-Markov) */
+  double pause;                 /* Seconds left standing still */
+  double ox;                    /* Offset from the reference point of */
+  double oy;                    /* the group, m */
+};
+
+/* Sort key of a node when they are renumbered */
+struct topo_key
+{
+  double x;
+  double y;
+  int old;                      /* Number before */
+};
+
+/* A setdest command */
+struct topo_cmd
+{
+  double time;                  /* s */
+  int node;
+  double x;                     /* Destination, m */
+  double y;
+  double speed;                 /* m/s */
+};
+
+struct topo
+{
+  int kind;                     /* TOPO_ constant */
+  int model;                    /* MOB_ constant */
+  int n;                        /* Number of nodes */
+  struct topo_node *node;
+  struct topo_node *ref;        /* Reference points of the groups */
+  int nref;
+  struct topo_cmd *cmd;         /* Setdest commands, by time */
+  int ncmd;
+  int nextcmd;                  /* First command not done */
+  double range;                 /* Radio range, m */
+  double width;                 /* The area, m */
+  double height;
+  double vmax;                  /* Highest speed, m/s */
+  double pause;                 /* Pause at a waypoint, s */
+  double now;                   /* Time of the positions, s */
+  u_int64_t rng;
+
+  /* Neighbours of node i are nbr[first[i]] ... nbr[first[i + 1] - 1],
+     in increasing order */
+  int *first;
+  int *nbr;
+  int nbrmax;
+  int nlinks;
+  u_int64_t changes;            /* Links that came up or went down */
+};
+
+
+/*
+ *   topo_init
+ *
+ *   Description:
+ *     Places the nodes. A random geometric graph and the clusters are
+ *     spread over a square just large enough for the mean number of
+ *     neighbours asked for. The links are not made, see topo_links.
+ *
+ *   Arguments:
+ *     struct topo *t  - The topology.
+ *     int kind        - TOPO_GRID, TOPO_LINE, TOPO_RGG or TOPO_CLUSTER.
+ *     int n           - Number of nodes.
+ *     double range    - Radio range, m.
+ *     double degree   - Mean number of neighbours of TOPO_RGG and
+ *                       TOPO_CLUSTER.
+ *     u_int64_t seed  - Seed of the placement and the mobility.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int topo_init(struct topo *t, int kind, int n, double range, double degree,
+	      u_int64_t seed);
+
+/*
+ *   topo_load
+ *
+ *   Description:
+ *     Places the nodes as in an ns-2 setdest scenario, and keeps its
+ *     setdest commands for MOB_FILE. Other lines are skipped. The
+ *     nodes are renumbered, see above.
+ *
+ *   Arguments:
+ *     struct topo *t  - The topology.
+ *     char *file      - The scenario.
+ *     double range    - Radio range, m.
+ *     u_int64_t seed  - Seed of other mobility models.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int topo_load(struct topo *t, char *file, double range, u_int64_t seed);
+
+/*
+ *   topo_mobility
+ *
+ *   Description:
+ *     Chooses how the nodes move. MOB_FILE needs a scenario loaded
+ *     with topo_load.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *     int model      - MOB_ constant.
+ *     double vmax    - Highest speed, m/s.
+ *     double pause   - Pause at each random waypoint, s.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int topo_mobility(struct topo *t, int model, double vmax, double pause);
+
+/*
+ *   topo_step
+ *
+ *   Description:
+ *     Moves the nodes forward to a later time. Setdest commands take
+ *     effect at their time.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *     double now     - The time, s since the start.
+ *
+ *   Return: None
+ */
+void topo_step(struct topo *t, double now);
+
+/*
+ *   topo_links
+ *
+ *   Description:
+ *     Finds the neighbours of all nodes at their positions and counts
+ *     the links that changed since the last time.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *
+ *   Return:
+ *     int - On error -1 is returned else 0
+ */
+int topo_links(struct topo *t);
+
+/*
+ *   topo_free
+ *
+ *   Description:
+ *     Frees the nodes, commands and links.
+ *
+ *   Arguments:
+ *     struct topo *t - The topology.
+ *
+ *   Return: None
+ */
+void topo_free(struct topo *t);
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        Creates and reads the headers and records of the control
+ *        traffic trace format described in trace.h. Shared by the daemon,
+ *        which writes traces, and the tools reading them.
+ *
+ *	Internal procedures:
+ *
+ *	External procedures:
+ *        trace_inithdr
+ *        trace_open
+ *        trace_read
+ *        trace_realtime
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#include "trace.h"
+
+/*
+ *   trace_inithdr
+ *
+ *   Description:
+ *     Fills in a trace header for a trace starting now.
+ *
+ *   Arguments:
+ *     struct trace_hdr *hdr - The header to fill in.
+ *     char *ifname          - Name of the interface.
+ *     u_int32_t my_ip       - Address of the node.
+ *
+ *   Return: None
+ */
+void
+trace_inithdr(struct trace_hdr *hdr, char *ifname, u_int32_t my_ip)
+{
+  struct timespec ts;
+  struct timeval tv;
+
+  memset(hdr, 0, sizeof(struct trace_hdr));
+
+  hdr->magic = TRACE_MAGIC;
+  hdr->version = TRACE_VERSION;
+  hdr->hdrlen = sizeof(struct trace_hdr);
+  hdr->my_ip = my_ip;
+  strncpy(hdr->ifname, ifname, TRACE_IFNAMSIZ - 1);
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  gettimeofday(&tv, NULL);
+  hdr->start_mono = (u_int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+  hdr->start_real = (u_int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/*
+ *   trace_open
+ *
+ *   Description:
+ *     Opens a trace file and reads its header.
+ *
+ *   Arguments:
+ *     char *path            - The file, "-" for stdin.
+ *     struct trace_hdr *hdr - Where to store the header.
+ *
+ *   Return:
+ *     FILE* - The trace positioned at the first record, NULL on error.
+ *             An error message has then been printed to stderr.
+ */
+FILE *
+trace_open(char *path, struct trace_hdr *hdr)
+{
+  FILE *fp;
+  int i;
+
+  if (strcmp(path, "-") == 0)
+    fp = stdin;
+  else if ((fp = fopen(path, "r")) == NULL)
+    {
+      perror(path);
+      return NULL;
+    }
+
+  /* The fixed part of the header, version 1 */
+  if (fread(hdr, sizeof(struct trace_hdr), 1, fp) != 1)
+    {
+      fprintf(stderr, "%s: not a trace file\n", path);
+      goto error;
+    }
+
+  if (hdr->magic != TRACE_MAGIC)
+    {
+      if (hdr->magic == TRACE_CIGAM)
+	fprintf(stderr, "%s: trace has foreign byte order\n", path);
+      else
+	fprintf(stderr, "%s: not a trace file\n", path);
+      goto error;
+    }
+
+  if (hdr->hdrlen < sizeof(struct trace_hdr))
+    {
+      fprintf(stderr, "%s: bad header length %u\n", path, hdr->hdrlen);
+      goto error;
+    }
+
+  /* Skip fields added by later versions, stdin can't seek */
+  for (i = sizeof(struct trace_hdr); i < hdr->hdrlen; i++)
+    if (getc(fp) == EOF)
+      {
+	fprintf(stderr, "%s: truncated header\n", path);
+	goto error;
+      }
+
+  return fp;
+
+ error:
+  if (fp != stdin)
+    fclose(fp);
+  return NULL;
+}
+
+/*
+ *   trace_read
+ *
+ *   Description:
+ *     Reads the next record of a trace.
+ *
+ *   Arguments:
+ *     FILE *fp              - The trace.
+ *     struct trace_rec *rec - Where to store the record header.
+ *     void *data            - Where to store the message, at least
+ *                             TRACE_MAXCAP bytes.
+ *
+ *   Return:
+ *     int - 1 if a record was read, 0 at the end of the trace and -1 if
+ *           the trace is corrupt or truncated.
+ */
+int
+trace_read(FILE *fp, struct trace_rec *rec, void *data)
+{
+  char skip[TRACE_MAXCAP];
+  size_t n;
+  size_t rest;
+
+  if ((n = fread(rec, 1, sizeof(struct trace_rec), fp)) == 0)
+    /* Clean end of the trace */
+    return 0;
+
+  if (n != sizeof(struct trace_rec) || rec->caplen > TRACE_MAXCAP ||
+      rec->reclen < TRACE_RECLEN(rec->caplen))
+    return -1;
+
+  if (fread(data, 1, rec->caplen, fp) != rec->caplen)
+    return -1;
+
+  /* Padding and fields added by later versions */
+  rest = rec->reclen - sizeof(struct trace_rec) - rec->caplen;
+  while (rest > 0)
+    {
+      n = rest < sizeof(skip) ? rest : sizeof(skip);
+      if (fread(skip, 1, n, fp) != n)
+	return -1;
+      rest -= n;
+    }
+
+  return 1;
+}
+
+/*
+ *   trace_realtime
+ *
+ *   Description:
+ *     Converts the monotonic time of a record to wall clock time.
+ *
+ *   Arguments:
+ *     struct trace_hdr *hdr - Header of the trace.
+ *     u_int64_t time        - Monotonic time in us.
+ *
+ *   Return:
+ *     u_int64_t - Wall clock time in us.
+ */
+u_int64_t
+trace_realtime(struct trace_hdr *hdr, u_int64_t time)
+{
+  return hdr->start_real + (time - hdr->start_mono);
+}
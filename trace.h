@@ -0,0 +1,193 @@
+/*
+ *	FILE: $RCSFile$
+ *
+ *
+ * Mad-hoc by
+ *
+ * Fredrik Lilieblad
+ * Oskar Mattsson
+ * Petra Nylund
+ * Dan Ouchterlony
+ * Anders Roxenhag
+ *
+ * Released 2000-05-27
+ * This software is Open Source under the GNU General Public Licence.
+ *
+ * Mail : mad-hoc@flyinglinux.net
+ * WWW  : mad-hoc.flyinglinix.net
+ *
+ *
+ ********************************
+ *
+ *	General description:
+ *        The control traffic trace format. A trace file starts with a
+ *        struct trace_hdr, followed by records. Every record is a struct
+ *        trace_rec followed by caplen bytes of the AODV message and
+ *        padding up to reclen, which is always a multiple of 8:
+ *
+ *          +------------+------------------+------+
+ *          | trace_hdr  | trace_rec | data | pad  | trace_rec | ...
+ *          +------------+------------------+------+
+ *
+ *        All fields are in the byte order of the host that wrote the
+ *        trace, except IP addresses and the message itself which are in
+ *        network byte order. Readers detect a foreign byte order by the
+ *        magic. Times are microseconds of CLOCK_MONOTONIC, the header
+ *        holds the wall clock time of one monotonic instant so readers
+ *        can convert.
+ *
+ *        A new version must only add fields at the end of the header or
+ *        of a record. hdrlen and reclen let old readers skip them.
+ *
+ *        A TRACE_DIR_KRT record is no message but a kernel route change
+ *        the sync stage failed to make, from the destination of the
+ *        route to its gateway. Its data is a struct trace_krt.
+ *
+ *	Internal procedures:
+ *
+ *	External procedures:
+ *        trace_inithdr
+ *        trace_open
+ *        trace_read
+ *        trace_realtime
+ *
+ ********************************
+ *
+ * Extendend RCS Info: $Id$
+ *
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/time.h>
+
+#define TRACE_MAGIC    0x54444f41  /* "AODT" when written little endian */
+#define TRACE_CIGAM    0x414f4454  /* The magic in foreign byte order */
+#define TRACE_VERSION  1
+
+/* Max length of the interface name in the header */
+#define TRACE_IFNAMSIZ 16
+
+/* Max number of message bytes in a record */
+#define TRACE_MAXCAP   2048
+
+/* Record directions */
+#define TRACE_DIR_IN   0
+#define TRACE_DIR_OUT  1
+#define TRACE_DIR_KRT  2
+
+/* Kernel route changes */
+#define TRACE_KRT_ADD  1
+#define TRACE_KRT_DEL  2
+
+/* Start of a trace file */
+struct trace_hdr
+{
+  u_int32_t magic;                  /* TRACE_MAGIC */
+  u_int16_t version;                /* TRACE_VERSION */
+  u_int16_t hdrlen;                 /* Size of this header in the file */
+  u_int32_t my_ip;                  /* Address of the tracing node */
+  u_int32_t reserved;
+  u_int64_t start_real;             /* Wall clock time in us ... */
+  u_int64_t start_mono;             /* ... at this monotonic time in us */
+  char      ifname[TRACE_IFNAMSIZ]; /* Interface the node runs on */
+};
+
+/* Start of a record */
+struct trace_rec
+{
+  u_int16_t reclen;                 /* Size of the record incl. data, pad */
+  u_int8_t  dir;                    /* TRACE_DIR_IN, TRACE_DIR_OUT or
+				       TRACE_DIR_KRT */
+  u_int8_t  ttl;                    /* IP ttl */
+  u_int16_t origlen;                /* Length of the AODV message */
+  u_int16_t caplen;                 /* Bytes of the message in the record */
+  u_int64_t time;                   /* Monotonic time in us */
+  u_int32_t src_ip;                 /* Who sent the message */
+  u_int32_t dst_ip;                 /* To whome it was sent */
+};
+
+/* Data of a TRACE_DIR_KRT record */
+struct trace_krt
+{
+  u_int8_t  op;                     /* TRACE_KRT_ADD or TRACE_KRT_DEL */
+  u_int8_t  reserved[3];
+  u_int32_t err;                    /* errno of the failed change */
+};
+
+/* Record length for caplen bytes of message */
+#define TRACE_RECLEN(caplen) \
+  ((sizeof(struct trace_rec) + (caplen) + 7) & ~7)
+
+
+/*
+ *   trace_inithdr
+ *
+ *   Description:
+ *     Fills in a trace header for a trace starting now.
+ *
+ *   Arguments:
+ *     struct trace_hdr *hdr - The header to fill in.
+ *     char *ifname          - Name of the interface.
+ *     u_int32_t my_ip       - Address of the node.
+ *
+ *   Return: None
+ */
+void trace_inithdr(struct trace_hdr *hdr, char *ifname, u_int32_t my_ip);
+
+/*
+ *   trace_open
+ *
+ *   Description:
+ *     Opens a trace file and reads its header.
+ *
+ *   Arguments:
+ *     char *path            - The file, "-" for stdin.
+ *     struct trace_hdr *hdr - Where to store the header.
+ *
+ *   Return:
+ *     FILE* - The trace positioned at the first record, NULL on error.
+ *             An error message has then been printed to stderr.
+ */
+FILE *trace_open(char *path, struct trace_hdr *hdr);
+
+/*
+ *   trace_read
+ *
+ *   Description:
+ *     Reads the next record of a trace.
+ *
+ *   Arguments:
+ *     FILE *fp              - The trace.
+ *     struct trace_rec *rec - Where to store the record header.
+ *     void *data            - Where to store the message, at least
+ *                             TRACE_MAXCAP bytes.
+ *
+ *   Return:
+ *     int - 1 if a record was read, 0 at the end of the trace and -1 if
+ *           the trace is corrupt or truncated.
+ */
+int trace_read(FILE *fp, struct trace_rec *rec, void *data);
+
+/*
+ *   trace_realtime
+ *
+ *   Description:
+ *     Converts the monotonic time of a record to wall clock time.
+ *
+ *   Arguments:
+ *     struct trace_hdr *hdr - Header of the trace.
+ *     u_int64_t time        - Monotonic time in us.
+ *
+ *   Return:
+ *     u_int64_t - Wall clock time in us.
+ */
+u_int64_t trace_realtime(struct trace_hdr *hdr, u_int64_t time);
+
+#endif
@@ -24,9 +24,11 @@
  *        differnet functions in the program.
  *        You can:
  *        Print the routing table
+ *        Print the neighbour table with the link ETX
  *        Add a route to the routing table
  *        Generate a RREQ
  *        Generate a RERR (link break)
+ *        Print the stage ring statistics
  *
  *	Internal procedures:
  *        strcnt
@@ -124,9 +126,11 @@ io_read()
 {
   char *buff;
   
-  printf("\ngen_rreq:xxx.xxx.xxx.xxx\nprint_rt\nadd_rt:dst_ip:" 
+  printf("\ngen_rreq:xxx.xxx.xxx.xxx\nprint_rt\nprint_nb\nadd_rt:dst_ip:" 
 	 "dst_seq:broadcast_id:hop_cnt:lst_hop_cnt:nxt_hop:lifetime:" 
-	 "rt_flags\nlink_break:xxx.xxx.xxx.xxxn\nCommand: ");
+	 "rt_flags\nlink_break:xxx.xxx.xxx.xxxn\nprint_stats\nlog_level:0-3\n"
+	 "dump_events\n"
+	 "Command: ");
   
   if ((buff = malloc(MAXLEN*sizeof(char))) == NULL)
     /* Failed to allocate memory */
@@ -150,8 +154,11 @@ io_read()
  *	Add a route to the routing table
  *	Generate a RREQ
  *	Generate a RERR (link break)
+ *	Print the stage ring statistics
+ *	Set the log level
  *
  *   Arguments: 
+ *     struct aodv_node *node - The node.
  *     char *io_string - The sting to be parsed
  *     struct info *is - Data about the environmens such as my ip.
  *
@@ -159,7 +166,7 @@ io_read()
  *     int - Returns -1 on error otherwise 0
 */
 int
-io_parse(char *io_string, struct info *is)
+io_parse(struct aodv_node *node, char *io_string, struct info *is)
 {
   struct artentry *rte;
   char ipbuff[MAXLEN];
@@ -189,13 +196,43 @@ io_parse(char *io_string, struct info *is)
       is->ip_pkt_dst_ip = inet_addr(ipbuff);
       is->ip_pkt_ttl = 0;
       printf("%s\n", ipbuff);
-      gen_rreq(is);
+      gen_rreq(node, is);
 
       return 0;
     }
   /* Is a print routing table ? */
   else if (strncmp(io_string, IO_PRINT_RT_STR, strlen(IO_PRINT_RT_STR)) == 0)
-    print_rt();
+    print_rt(node);
+  
+  /* Is a print neighbour table ? */
+  else if (strncmp(io_string, IO_PRINT_NB_STR, strlen(IO_PRINT_NB_STR)) == 0)
+    print_nb(node);
+  
+  /* Is a print stage statistics ? */
+  else if (strncmp(io_string, IO_PRINT_STATS_STR, 
+		   strlen(IO_PRINT_STATS_STR)) == 0)
+    {
+      stage_print();
+      print_fwd(node);
+      print_rtt(node);
+    }
+  
+  /* Is a set log level ? */
+  else if (strncmp(io_string, IO_LOG_LEVEL_STR, 
+		   strlen(IO_LOG_LEVEL_STR)) == 0)
+    {
+      if (strlen(io_string) > strlen(IO_LOG_LEVEL_STR) + 1 &&
+	  logmsg_setlevel(atoi(io_string + strlen(IO_LOG_LEVEL_STR) + 1)) == 0)
+	retval = 0;
+
+      printf("Log level: %d\n", logmsg_getlevel());
+    }
+
+  /* Is a dump of the flight recorder ? */
+  else if (strncmp(io_string, IO_DUMP_EVENTS_STR,
+		   strlen(IO_DUMP_EVENTS_STR)) == 0)
+    printf("%d events dumped to %s\n", flight_dump("dump_events"),
+	   FLIGHT_FILE);
   
   /* Is an add to routing table ? */
   else if (strncmp(io_string, IO_ADD_RT_STR, strlen(IO_ADD_RT_STR)) == 0)
@@ -206,7 +243,7 @@ io_parse(char *io_string, struct info *is)
 	  strrep(io_string, ':', '\0');
 	  
 	  /* Fill in the struct */
-	  rte = insert_entry();
+	  rte = insert_entry(node);
 	  
 	  io_p = strchr(io_string, '\0');
 	  rte->dst_ip = inet_addr(++io_p);
@@ -231,6 +268,8 @@ io_parse(char *io_string, struct info *is)
 	  
 	  io_p = strchr(io_p, '\0');
 	  rte->rt_flags = atol(++io_p);
+	  flight_event(FLIGHT_RT_INSERT, rte->dst_ip, rte->nxt_hop,
+		       rte->hop_cnt, rte->dst_seq);
 	  /* add route to kernel's rtable */
 	  if(add_kroute(rte->dst_ip, rte->nxt_hop))
 	    {
@@ -244,7 +283,7 @@ io_parse(char *io_string, struct info *is)
       if (sscanf(io_string + strlen(IO_GEN_RERR_STR) + 1, "%s", ipbuff) != 1)
 	retval = -1;
       
-      link_break(is,inet_addr(ipbuff));
+      link_break(node, is,inet_addr(ipbuff));
       return 0;
     }
     
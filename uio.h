@@ -24,6 +24,7 @@
  *        differnet functions in the program.
  *        You can:
  *        Print the routing table
+ *        Print the neighbour table with the link ETX
  *        Add a route to the routing table
  *        Generate a RREQ
  *        Generate a RERR (link break)
@@ -56,15 +57,25 @@
 #include "info.h"
 #include "gen_rreq.h"
 #include "RT.h"
+#include "neighbour.h"
 #include "rerr.h"
+#include "rreq.h"
+#include "rtt.h"
+#include "stage.h"
+#include "logmsg.h"
+#include "flight.h"
 
 
 #define IO_FD 0
 /* Constant strings to match in the menu commands */
 #define IO_GEN_RREQ_STR  "gen_rreq"
 #define IO_PRINT_RT_STR  "print_rt"
+#define IO_PRINT_NB_STR  "print_nb"
 #define IO_ADD_RT_STR    "add_rt"
 #define IO_GEN_RERR_STR  "link_break"
+#define IO_PRINT_STATS_STR "print_stats"
+#define IO_LOG_LEVEL_STR "log_level"
+#define IO_DUMP_EVENTS_STR "dump_events"
 
 #define MAXLEN 255
 
@@ -98,14 +109,17 @@ char *io_read();
  *	Add a route to the routing table
  *	Generate a RREQ
  *	Generate a RERR (link break)
+ *	Print the stage ring statistics
+ *	Set the log level
  *
  *   Arguments: 
+ *     struct aodv_node *node - The node.
  *     char *io_string - The sting to be parsed
  *     struct info *is - Data about the environmens such as my ip.
  *
  *   Return: 
  *     int - Returns -1 on error otherwise 0
 */
-int io_parse(char *io_string, struct info *is);
+int io_parse(struct aodv_node *node, char *io_string, struct info *is);
 
 #endif
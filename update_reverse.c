@@ -20,12 +20,15 @@
  ********************************
  *
  *      General description:
- *          Updates the routing table when receiving RREQ
+ *          Updates the routing table when receiving RREQ. In multipath
+ *          mode the copies of a RREQ that come later over other
+ *          neighbours give alternate next hops to its source.
  *
  *      Internal procedures:
  *      
  *      External procedures:
  *          update_reverse(struct info *my_info, struct rreq *my_rreq)
+ *          update_reverse_alt(struct info *my_info, struct rreq *my_rreq)
  *
  ********************************
  *
@@ -39,9 +42,12 @@
  *  update_reverse
  * 
  *  Description:  
- *    Updates the RT
+ *    Updates the RT. In multipath mode a replaced next hop is kept as
+ *    an alternate, see add_alt_hop. The hop count of the RREQ is noted
+ *    as the distance to its source, see dist_learn.
  *
  *  Arguments:    
+ *    struct aodv_node *node - The node.
  *    struct info *my_info - Contains the IP informtion about the RREQ
  *    struct rreq *my_rreq -  Contains the RRQ
  *
@@ -49,23 +55,32 @@
  *    int - 0
 */
 int
-update_reverse(struct info *my_info, struct rreq *my_rreq)
+update_reverse(struct aodv_node *node, struct info *my_info,
+	       struct rreq *my_rreq)
 {
   struct artentry  *rt_src;
+  struct rt_alt    old;         /* The route before, in multipath mode */
   u_int64_t        curr_time;
+  int              event = FLIGHT_RT_UPDATE;
   
   curr_time = getcurrtime(); /* Get current time */
-  rt_src = getentry(my_rreq->src_ip); /* Get entry from RT if there is one */
+  dist_learn(node, my_rreq->src_ip, my_rreq->hop_cnt);
+
+  /* Get entry from RT if there is one */
+  rt_src = getentry(node, my_rreq->src_ip);
+  memset(&old, 0, sizeof(struct rt_alt));
   
   if ((rt_src == NULL) || (my_rreq->src_seq > rt_src->dst_seq) ||
       ((my_rreq->src_seq == rt_src->dst_seq) &&
-       (my_rreq->hop_cnt < rt_src->hop_cnt)))
+       (nb_cost(node, my_info->ip_pkt_src_ip, my_rreq->hop_cnt)
+	< nb_cost(node, rt_src->nxt_hop, rt_src->hop_cnt))))
     {
       
       /* If there didn't exist an entry in RT to the source, create it */
       if (rt_src == NULL)
 	{
-	  rt_src = insert_entry();
+	  rt_src = insert_entry(node);
+	  event = FLIGHT_RT_INSERT;
 	  rt_src->dst_ip = my_rreq->src_ip;
 	  rt_src->broadcast_id = 0;
 	  rt_src->lst_hop_cnt = 0;
@@ -73,12 +88,28 @@ update_reverse(struct info *my_info, struct rreq *my_rreq)
 	}
       
       else /*Since the entry existed we might want to change krt*/
-	del_kroute(rt_src->dst_ip, rt_src->nxt_hop);
+	{
+	  if (my_rreq->src_seq == rt_src->dst_seq)
+	    {
+	      /* The replaced next hop may still serve as an alternate */
+	      old.nxt_hop = rt_src->nxt_hop;
+	      old.hop_cnt = rt_src->hop_cnt;
+	      old.lifetime = rt_src->lifetime;
+	    }
+	  else
+	    clear_alt_hops(rt_src);
+	  del_kroute(rt_src->dst_ip, rt_src->nxt_hop);
+	}
 
       /* Update values in the RT entry */
       rt_src->dst_seq = my_rreq->src_seq;
       rt_src->nxt_hop = my_info->ip_pkt_src_ip;
       rt_src->hop_cnt = my_rreq->hop_cnt;
+      trim_alt_hops(rt_src);
+      if (node->multipath && old.nxt_hop != 0)
+	add_alt_hop(rt_src, old.nxt_hop, old.hop_cnt, old.lifetime);
+      flight_event(event, rt_src->dst_ip, rt_src->nxt_hop, rt_src->hop_cnt,
+		   rt_src->dst_seq);
       if(add_kroute(rt_src->dst_ip, rt_src->nxt_hop))
 	{
 	  /* add_kroute failed, ignore and continue */
@@ -86,8 +117,43 @@ update_reverse(struct info *my_info, struct rreq *my_rreq)
     }
   
   /* Check if the lifetime in RT is valid, if not update it */
-  if (rt_src->lifetime < (REV_ROUTE_LIFE + curr_time))
-    rt_src->lifetime = REV_ROUTE_LIFE + curr_time;
+  if (rt_src->lifetime < (rev_route_life(node) + curr_time))
+    rt_src->lifetime = rev_route_life(node) + curr_time;
   
   return 0;
 }
+
+/* 
+ *  update_reverse_alt
+ * 
+ *  Description:  
+ *    Called in multipath mode for a copy of a RREQ that was seen
+ *    before. The neighbour it came from is kept as an alternate next
+ *    hop to the source if the copy is as fresh as the route and no
+ *    longer, see add_alt_hop.
+ *
+ *  Arguments:    
+ *    struct aodv_node *node - The node.
+ *    struct info *my_info - Contains the IP informtion about the RREQ
+ *    struct rreq *my_rreq -  Contains the RRQ, its hop count increased
+ *
+ *  Return:
+ *    int - 0 if the neighbour is a new alternate
+ *         -1 if not
+*/
+int
+update_reverse_alt(struct aodv_node *node, struct info *my_info,
+		   struct rreq *my_rreq)
+{
+  struct artentry  *rt_src;
+
+  rt_src = getentry(node, my_rreq->src_ip);
+  if (rt_src == NULL || my_rreq->src_seq != rt_src->dst_seq)
+    return -1;
+
+  if (add_alt_hop(rt_src, my_info->ip_pkt_src_ip, my_rreq->hop_cnt,
+		  getcurrtime() + rev_route_life(node)) != 0)
+    return -1;
+
+  return 0;
+}
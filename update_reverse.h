@@ -20,12 +20,15 @@
  ********************************
  *
  *      General description:
- *          Updates the routing table when receiving RREQ
+ *          Updates the routing table when receiving RREQ. In multipath
+ *          mode the copies of a RREQ that come later over other
+ *          neighbours give alternate next hops to its source.
  *
  *      Internal procedures:
  *      
  *      External procedures:
  *          update_reverse(struct info *my_info, struct rreq *my_rreq)
+ *          update_reverse_alt(struct info *my_info, struct rreq *my_rreq)
  *
  ********************************
  *
@@ -49,22 +52,50 @@
 #include "aodv.h"
 #include "utils.h"
 #include "krtable.h"
+#include "neighbour.h"
+#include "dist.h"
+#include "rtt.h"
 
 
 /* 
  *  update_reverse
  * 
  *  Description:  
- *    Updates the RT
+ *    Updates the RT. In multipath mode a replaced next hop is kept as
+ *    an alternate, see add_alt_hop. The hop count of the RREQ is noted
+ *    as the distance to its source, see dist_learn.
  *
  *  Arguments:    
+ *    struct aodv_node *node - The node.
  *    struct info *my_info - Contains the IP informtion about the RREQ
  *    struct rreq *my_rreq -  Contains the RRQ
  *
  *  Return:
  *    int - 0
 */
-int update_reverse(struct info *my_info, struct rreq *my_rreq);
+int update_reverse(struct aodv_node *node, struct info *my_info,
+		   struct rreq *my_rreq);
+
+/* 
+ *  update_reverse_alt
+ * 
+ *  Description:  
+ *    Called in multipath mode for a copy of a RREQ that was seen
+ *    before. The neighbour it came from is kept as an alternate next
+ *    hop to the source if the copy is as fresh as the route and no
+ *    longer, see add_alt_hop.
+ *
+ *  Arguments:    
+ *    struct aodv_node *node - The node.
+ *    struct info *my_info - Contains the IP informtion about the RREQ
+ *    struct rreq *my_rreq -  Contains the RRQ, its hop count increased
+ *
+ *  Return:
+ *    int - 0 if the neighbour is a new alternate
+ *         -1 if not
+*/
+int update_reverse_alt(struct aodv_node *node, struct info *my_info,
+		       struct rreq *my_rreq);
 
 #endif
 
@@ -26,7 +26,6 @@
  *	
  *	External procedures:
  *        send_datagram
- *        getcurrtime
  *
  *
  ********************************
@@ -36,14 +35,21 @@
  */
 
 #include "utils.h"
+#include "node.h"
+#include "neighbour.h"
+#include "netio.h"
 
 /* 
  *   send_datagram
  *
  *   Description: 
- *     Sends a datagram with the given input.
+ *     Sends a datagram with the given input. A broadcast also postpones
+ *     the next HELLO by HELLO_INTERVAL, except in relay mode. The
+ *     datagram itself is sent by net_send, the neighbours it reaches
+ *     are noted with nb_sent.
  *
  *   Arguments:
+ *     struct aodv_node *node - The node.
  *     struct info *pktinfo - Includes the address info needed to send the
  *                            package.
  *       pktinfo->ip_pkt_src_ip = pktinfo->ip_pkt_my_ip = The hosts own ip
@@ -59,101 +65,31 @@
  *     int - On error -1 is returned else 0 is returned.
 */
 int
-send_datagram(struct info *pktinfo, void *data, int datalen)
+send_datagram(struct aodv_node *node, struct info *pktinfo, void *data,
+	      int datalen)
 {
-  /* Keep the socket open */
-  struct sockaddr_in their_addr;
-  int sentbytes;
-  int sockfd;
-  int on = 1;
-  
   struct prioqent *my_pqe;
-  struct rreq_tdata *trd;
-
-#ifdef LOGMSG
-	logmsg(data, datalen, pktinfo);
-#endif
-  
 
-  if ((sockfd = socket(AF_INET, SOCK_DGRAM,0)) < 0)
-    /* Error creating socket */
-    return -1;
-  
-  /* Fill in destination of the package */
-  their_addr.sin_family = AF_INET;
-  their_addr.sin_port = htons(AODVPORT);
-  their_addr.sin_addr.s_addr = pktinfo->ip_pkt_dst_ip;
-  bzero(&(their_addr.sin_zero), 8);
-  
-  /* Is destination broadcast ? */
-  if (their_addr.sin_addr.s_addr == inet_addr("255.255.255.255"))
+  /* Is destination broadcast ? In relay mode only a HELLO has the
+     neighbour list */
+  if (pktinfo->ip_pkt_dst_ip == inet_addr("255.255.255.255") && !node->mpr)
     {
       /* We are sending broadcasts so dont send a hello until 
 	 HELLO_INTERVAL later */
-      my_pqe = pq_getfirstofidflags(inet_addr("255.255.255.255"), 
+      my_pqe = pq_getfirstofidflags(&node->pq, inet_addr("255.255.255.255"), 
 				    PQ_PACKET_HELLO);
       if (my_pqe != NULL)
 	{
-	  trd = (struct rreq_tdata*)my_pqe->data;
-	  pq_deleteent(my_pqe);
-	  pq_insert(getcurrtime() + HELLO_INTERVAL, trd, 
+	  pq_deleteent(&node->pq, my_pqe);
+	  pq_insert(&node->pq, getcurrtime() + HELLO_INTERVAL, NULL, 
 		    inet_addr("255.255.255.255"), PQ_PACKET_HELLO);
 	}
-      if (setsockopt(sockfd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on)) < 0)
-	{
-	  /* Error setting socket options */
-	  close(sockfd);
-	  return -1;
-	}
     }
   
-  /* Set the TTL ? */
-  if (pktinfo->ip_pkt_ttl != 0 && pktinfo->ip_pkt_ttl < 256)
-    {
-      if (setsockopt(sockfd, SOL_IP, IP_TTL, &(pktinfo->ip_pkt_ttl),
-		     sizeof(pktinfo->ip_pkt_ttl)) < 0)
-	{
-	  /* Error setting socket options */
-	  close(sockfd);
-	  return -1;
-	}
-    }
-  
-  /* Send package */
-  if ((sentbytes = sendto(sockfd, data, datalen, 0, 
-			  (struct sockaddr *)&their_addr,
-			  sizeof(struct sockaddr))) < 0)
-    {
-      /* Failed to send datagram */
-      close(sockfd);
-      return -1;
-    }
-  
-  close(sockfd);
-  
-  return 0;
-}
-
-/* 
- *   getcurrtime
- *
- *   Description: 
- *     Gets the current time in milliseconds since 1 jan 1970
- *
- *   Arguments: None
- *
- *   Return: 
- *     u_int64_t - On error -1 is returned otherwise the time.
- */
-u_int64_t
-getcurrtime()
-{
-  struct timezone tz;
-  struct timeval tv;
-  
-  if (gettimeofday(&tv, &tz) < 0)
-    /* Couldn't get time of day */
+  if (net_send(node, pktinfo, data, datalen) == -1)
     return -1;
-  
-  return ((u_int64_t)tv.tv_sec) * 1000 + ((u_int64_t)tv.tv_usec) / 1000;
+
+  nb_sent(node, pktinfo->ip_pkt_dst_ip);
+
+  return 0;
 }
@@ -26,7 +26,6 @@
  *	
  *	External procedures:
  *        send_datagram
- *        getcurrtime
  *
  *
  ********************************
@@ -49,15 +48,22 @@
 #include "aodv.h"
 #include "timer.h"
 #include "logmsg.h"
+#include "clock.h"
+
+/* Defined in node.h, which can't be included here as it needs timer.h */
+struct aodv_node;
 
 
 /* 
  *   send_datagram
  *
  *   Description: 
- *     Sends a datagram with the given input.
+ *     Sends a datagram with the given input. A broadcast also postpones
+ *     the next HELLO by HELLO_INTERVAL, except in relay mode. The
+ *     datagram itself is sent by net_send.
  *
  *   Arguments:
+ *     struct aodv_node *node - The node.
  *     struct info *pktinfo - Includes the address info needed to send the
  *                            package.
  *       pktinfo->ip_pkt_src_ip = pktinfo->ip_pkt_my_ip = The hosts own ip
@@ -72,19 +78,7 @@
  *   Return: 
  *     int - On error -1 is returned else 0 is returned.
  */
-int send_datagram(struct info *pktinfo,void *data,int datalen);
-
-/* 
- *   getcurrtime
- *
- *   Description: 
- *     Gets the current time in milliseconds since 1 jan 1970
- *
- *   Arguments: None
- *
- *   Return: 
- *     u_int64_t - On error -1 is returned otherwise the time.
- */
-u_int64_t getcurrtime();
+int send_datagram(struct aodv_node *node, struct info *pktinfo, void *data,
+		  int datalen);
 
 #endif